@@ -0,0 +1,429 @@
+#include "AABBTree.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace DirectX;
+
+static inline void DXTBoundsUnion(const DXTBounds& a, const DXTBounds& b, DXTBounds* boundsOut)
+{
+	boundsOut->Lower = XMFLOAT3(min(a.Lower.x, b.Lower.x), min(a.Lower.y, b.Lower.y), min(a.Lower.z, b.Lower.z));
+	boundsOut->Upper = XMFLOAT3(max(a.Upper.x, b.Upper.x), max(a.Upper.y, b.Upper.y), max(a.Upper.z, b.Upper.z));
+}
+
+static inline float DXTBoundsSurfaceArea(const DXTBounds& bounds)
+{
+	float x = bounds.Upper.x - bounds.Lower.x;
+	float y = bounds.Upper.y - bounds.Lower.y;
+	float z = bounds.Upper.z - bounds.Lower.z;
+	return 2.0f * (x * y + y * z + z * x);
+}
+
+static inline bool DXTBoundsContains(const DXTBounds& outer, const DXTBounds& inner)
+{
+	return outer.Lower.x <= inner.Lower.x && outer.Lower.y <= inner.Lower.y && outer.Lower.z <= inner.Lower.z &&
+		outer.Upper.x >= inner.Upper.x && outer.Upper.y >= inner.Upper.y && outer.Upper.z >= inner.Upper.z;
+}
+
+static inline bool DXTBoundsOverlap(const DXTBounds& a, const DXTBounds& b)
+{
+	return a.Lower.x <= b.Upper.x && a.Lower.y <= b.Upper.y && a.Lower.z <= b.Upper.z &&
+		a.Upper.x >= b.Lower.x && a.Upper.y >= b.Lower.y && a.Upper.z >= b.Lower.z;
+}
+
+DXTAABBTree::DXTAABBTree() :
+	DXTAABBTree(DXT_AABB_TREE_DEFAULT_FAT_MARGIN)
+{
+}
+
+DXTAABBTree::DXTAABBTree(const float fatMargin) :
+	FatMargin(fatMargin),
+	root(DXT_AABB_TREE_NULL_NODE),
+	freeList(DXT_AABB_TREE_NULL_NODE),
+	proxyCount(0)
+{
+}
+
+int DXTAABBTree::AllocateNode()
+{
+	int node;
+
+	if (freeList != DXT_AABB_TREE_NULL_NODE)
+	{
+		node = freeList;
+		freeList = nodes[node].Parent;
+	}
+	else
+	{
+		node = static_cast<int>(nodes.size());
+		nodes.push_back(DXTAABBTreeNode());
+	}
+
+	nodes[node].Parent = DXT_AABB_TREE_NULL_NODE;
+	nodes[node].Left = DXT_AABB_TREE_NULL_NODE;
+	nodes[node].Right = DXT_AABB_TREE_NULL_NODE;
+	nodes[node].Height = 0;
+	nodes[node].UserData = 0;
+	return node;
+}
+
+void DXTAABBTree::FreeNode(const int node)
+{
+	nodes[node].Parent = freeList;
+	nodes[node].Height = -1;
+	freeList = node;
+}
+
+int DXTAABBTree::CreateProxy(const DXTBounds& bounds, const UINT userData)
+{
+	int proxy = AllocateNode();
+
+	nodes[proxy].Bounds.Lower = XMFLOAT3(bounds.Lower.x - FatMargin, bounds.Lower.y - FatMargin, bounds.Lower.z - FatMargin);
+	nodes[proxy].Bounds.Upper = XMFLOAT3(bounds.Upper.x + FatMargin, bounds.Upper.y + FatMargin, bounds.Upper.z + FatMargin);
+	nodes[proxy].UserData = userData;
+
+	InsertLeaf(proxy);
+	++proxyCount;
+
+	return proxy;
+}
+
+void DXTAABBTree::DestroyProxy(const int proxy)
+{
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	--proxyCount;
+}
+
+bool DXTAABBTree::MoveProxy(const int proxy, const DXTBounds& bounds, const XMFLOAT3& displacement)
+{
+	// Nothing to do while the tight bounds still fit inside the fat bounds
+	if (DXTBoundsContains(nodes[proxy].Bounds, bounds))
+		return false;
+
+	RemoveLeaf(proxy);
+
+	DXTBounds fatBounds;
+	fatBounds.Lower = XMFLOAT3(bounds.Lower.x - FatMargin, bounds.Lower.y - FatMargin, bounds.Lower.z - FatMargin);
+	fatBounds.Upper = XMFLOAT3(bounds.Upper.x + FatMargin, bounds.Upper.y + FatMargin, bounds.Upper.z + FatMargin);
+
+	// Extend the bounds in the direction of movement to predict where the proxy is going
+	float dx = DXT_AABB_TREE_DISPLACEMENT_MULTIPLIER * displacement.x;
+	float dy = DXT_AABB_TREE_DISPLACEMENT_MULTIPLIER * displacement.y;
+	float dz = DXT_AABB_TREE_DISPLACEMENT_MULTIPLIER * displacement.z;
+
+	if (dx < 0.0f)
+		fatBounds.Lower.x += dx;
+	else
+		fatBounds.Upper.x += dx;
+	if (dy < 0.0f)
+		fatBounds.Lower.y += dy;
+	else
+		fatBounds.Upper.y += dy;
+	if (dz < 0.0f)
+		fatBounds.Lower.z += dz;
+	else
+		fatBounds.Upper.z += dz;
+
+	nodes[proxy].Bounds = fatBounds;
+
+	InsertLeaf(proxy);
+	return true;
+}
+
+void DXTAABBTree::Clear()
+{
+	nodes.clear();
+	root = DXT_AABB_TREE_NULL_NODE;
+	freeList = DXT_AABB_TREE_NULL_NODE;
+	proxyCount = 0;
+}
+
+void DXTAABBTree::InsertLeaf(const int leaf)
+{
+	if (root == DXT_AABB_TREE_NULL_NODE)
+	{
+		root = leaf;
+		nodes[root].Parent = DXT_AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	// Find the best sibling by descending the tree with the surface area heuristic
+	DXTBounds leafBounds = nodes[leaf].Bounds;
+	int index = root;
+
+	while (!nodes[index].IsLeaf())
+	{
+		int left = nodes[index].Left;
+		int right = nodes[index].Right;
+
+		float area = DXTBoundsSurfaceArea(nodes[index].Bounds);
+
+		DXTBounds combinedBounds;
+		DXTBoundsUnion(nodes[index].Bounds, leafBounds, &combinedBounds);
+		float combinedArea = DXTBoundsSurfaceArea(combinedBounds);
+
+		// Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		DXTBounds leftBounds;
+		DXTBoundsUnion(leafBounds, nodes[left].Bounds, &leftBounds);
+		float leftCost = DXTBoundsSurfaceArea(leftBounds) + inheritanceCost;
+		if (!nodes[left].IsLeaf())
+			leftCost -= DXTBoundsSurfaceArea(nodes[left].Bounds);
+
+		DXTBounds rightBounds;
+		DXTBoundsUnion(leafBounds, nodes[right].Bounds, &rightBounds);
+		float rightCost = DXTBoundsSurfaceArea(rightBounds) + inheritanceCost;
+		if (!nodes[right].IsLeaf())
+			rightCost -= DXTBoundsSurfaceArea(nodes[right].Bounds);
+
+		if (cost < leftCost && cost < rightCost)
+			break;
+
+		index = leftCost < rightCost ? left : right;
+	}
+
+	int sibling = index;
+
+	// Create a new parent for the sibling and the leaf
+	int oldParent = nodes[sibling].Parent;
+	int newParent = AllocateNode();
+	nodes[newParent].Parent = oldParent;
+	DXTBoundsUnion(leafBounds, nodes[sibling].Bounds, &nodes[newParent].Bounds);
+	nodes[newParent].Height = nodes[sibling].Height + 1;
+	nodes[newParent].Left = sibling;
+	nodes[newParent].Right = leaf;
+	nodes[sibling].Parent = newParent;
+	nodes[leaf].Parent = newParent;
+
+	if (oldParent != DXT_AABB_TREE_NULL_NODE)
+	{
+		if (nodes[oldParent].Left == sibling)
+			nodes[oldParent].Left = newParent;
+		else
+			nodes[oldParent].Right = newParent;
+	}
+	else
+		root = newParent;
+
+	RefitAncestors(newParent);
+}
+
+void DXTAABBTree::RemoveLeaf(const int leaf)
+{
+	if (leaf == root)
+	{
+		root = DXT_AABB_TREE_NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].Parent;
+	int grandParent = nodes[parent].Parent;
+	int sibling = nodes[parent].Left == leaf ? nodes[parent].Right : nodes[parent].Left;
+
+	if (grandParent != DXT_AABB_TREE_NULL_NODE)
+	{
+		// Replace the parent with the sibling and refit the path up to the root
+		if (nodes[grandParent].Left == parent)
+			nodes[grandParent].Left = sibling;
+		else
+			nodes[grandParent].Right = sibling;
+
+		nodes[sibling].Parent = grandParent;
+		FreeNode(parent);
+
+		RefitAncestors(grandParent);
+	}
+	else
+	{
+		root = sibling;
+		nodes[sibling].Parent = DXT_AABB_TREE_NULL_NODE;
+		FreeNode(parent);
+	}
+}
+
+void DXTAABBTree::RefitAncestors(int node)
+{
+	while (node != DXT_AABB_TREE_NULL_NODE)
+	{
+		node = Balance(node);
+
+		int left = nodes[node].Left;
+		int right = nodes[node].Right;
+
+		nodes[node].Height = 1 + max(nodes[left].Height, nodes[right].Height);
+		DXTBoundsUnion(nodes[left].Bounds, nodes[right].Bounds, &nodes[node].Bounds);
+
+		node = nodes[node].Parent;
+	}
+}
+
+// Performs a left or right rotation if node A is imbalanced and returns the new subtree root
+int DXTAABBTree::Balance(const int iA)
+{
+	DXTAABBTreeNode* A = &nodes[iA];
+	if (A->IsLeaf() || A->Height < 2)
+		return iA;
+
+	int iB = A->Left;
+	int iC = A->Right;
+	DXTAABBTreeNode* B = &nodes[iB];
+	DXTAABBTreeNode* C = &nodes[iC];
+
+	int balance = C->Height - B->Height;
+
+	// Rotate C up
+	if (balance > 1)
+	{
+		int iF = C->Left;
+		int iG = C->Right;
+		DXTAABBTreeNode* F = &nodes[iF];
+		DXTAABBTreeNode* G = &nodes[iG];
+
+		C->Left = iA;
+		C->Parent = A->Parent;
+		A->Parent = iC;
+
+		if (C->Parent != DXT_AABB_TREE_NULL_NODE)
+		{
+			if (nodes[C->Parent].Left == iA)
+				nodes[C->Parent].Left = iC;
+			else
+				nodes[C->Parent].Right = iC;
+		}
+		else
+			root = iC;
+
+		if (F->Height > G->Height)
+		{
+			C->Right = iF;
+			A->Right = iG;
+			G->Parent = iA;
+			DXTBoundsUnion(B->Bounds, G->Bounds, &A->Bounds);
+			DXTBoundsUnion(A->Bounds, F->Bounds, &C->Bounds);
+			A->Height = 1 + max(B->Height, G->Height);
+			C->Height = 1 + max(A->Height, F->Height);
+		}
+		else
+		{
+			C->Right = iG;
+			A->Right = iF;
+			F->Parent = iA;
+			DXTBoundsUnion(B->Bounds, F->Bounds, &A->Bounds);
+			DXTBoundsUnion(A->Bounds, G->Bounds, &C->Bounds);
+			A->Height = 1 + max(B->Height, F->Height);
+			C->Height = 1 + max(A->Height, G->Height);
+		}
+
+		return iC;
+	}
+
+	// Rotate B up
+	if (balance < -1)
+	{
+		int iD = B->Left;
+		int iE = B->Right;
+		DXTAABBTreeNode* D = &nodes[iD];
+		DXTAABBTreeNode* E = &nodes[iE];
+
+		B->Left = iA;
+		B->Parent = A->Parent;
+		A->Parent = iB;
+
+		if (B->Parent != DXT_AABB_TREE_NULL_NODE)
+		{
+			if (nodes[B->Parent].Left == iA)
+				nodes[B->Parent].Left = iB;
+			else
+				nodes[B->Parent].Right = iB;
+		}
+		else
+			root = iB;
+
+		if (D->Height > E->Height)
+		{
+			B->Right = iD;
+			A->Left = iE;
+			E->Parent = iA;
+			DXTBoundsUnion(C->Bounds, E->Bounds, &A->Bounds);
+			DXTBoundsUnion(A->Bounds, D->Bounds, &B->Bounds);
+			A->Height = 1 + max(C->Height, E->Height);
+			B->Height = 1 + max(A->Height, D->Height);
+		}
+		else
+		{
+			B->Right = iE;
+			A->Left = iD;
+			D->Parent = iA;
+			DXTBoundsUnion(C->Bounds, D->Bounds, &A->Bounds);
+			DXTBoundsUnion(A->Bounds, E->Bounds, &B->Bounds);
+			A->Height = 1 + max(C->Height, D->Height);
+			B->Height = 1 + max(A->Height, E->Height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+void DXTAABBTree::Query(const DXTFrustum& frustum, std::vector<UINT>* userDataOut)
+{
+	if (root == DXT_AABB_TREE_NULL_NODE)
+		return;
+
+	// Each entry carries the planes its parent still intersects, once a subtree is
+	// fully inside the mask is empty and its leaves are gathered without plane tests
+	queryStack.clear();
+	queryStack.push_back({ root, DXT_FRUSTUM_PLANE_MASK_ALL });
+
+	while (!queryStack.empty())
+	{
+		DXTAABBTreeQueryEntry entry = queryStack.back();
+		queryStack.pop_back();
+
+		const DXTAABBTreeNode& node = nodes[entry.Node];
+		UINT planeMask = entry.PlaneMask;
+
+		if (DXTClassifyBounds(node.Bounds, frustum, &planeMask) == DXTFrustumTestOutside)
+			continue;
+
+		if (node.IsLeaf())
+			userDataOut->push_back(node.UserData);
+		else
+		{
+			queryStack.push_back({ node.Left, planeMask });
+			queryStack.push_back({ node.Right, planeMask });
+		}
+	}
+}
+
+void DXTAABBTree::Query(const DXTBounds& bounds, std::vector<UINT>* userDataOut)
+{
+	if (root == DXT_AABB_TREE_NULL_NODE)
+		return;
+
+	queryStack.clear();
+	queryStack.push_back({ root, 0 });
+
+	while (!queryStack.empty())
+	{
+		const DXTAABBTreeNode& node = nodes[queryStack.back().Node];
+		queryStack.pop_back();
+
+		if (!DXTBoundsOverlap(node.Bounds, bounds))
+			continue;
+
+		if (node.IsLeaf())
+			userDataOut->push_back(node.UserData);
+		else
+		{
+			queryStack.push_back({ node.Left, 0 });
+			queryStack.push_back({ node.Right, 0 });
+		}
+	}
+}
\ No newline at end of file
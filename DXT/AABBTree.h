@@ -0,0 +1,107 @@
+#pragma once
+
+#include "DirectXToolbox.h"
+
+#include <vector>
+
+#define DXT_AABB_TREE_NULL_NODE -1
+#define DXT_AABB_TREE_DEFAULT_FAT_MARGIN 0.5f
+#define DXT_AABB_TREE_DISPLACEMENT_MULTIPLIER 2.0f
+
+struct DXTAABBTreeNode
+{
+	// Leaves store fattened bounds so that small movements don't require reinsertion
+	DXTBounds Bounds;
+	UINT UserData;
+
+	// Doubles as the next free node when the node is on the free list
+	int Parent;
+	int Left;
+	int Right;
+
+	// Leaves have height 0, free nodes have height -1
+	int Height;
+
+	inline bool IsLeaf() const;
+};
+
+// Pending node of a query with the frustum planes its parent still intersects
+struct DXTAABBTreeQueryEntry
+{
+	int Node;
+	UINT PlaneMask;
+};
+
+// Dynamic bounding volume hierarchy. Proxies are inserted using the surface area heuristic
+// and the tree is kept balanced with rotations, so queries stay logarithmic and the cost of
+// moving a proxy only depends on the depth of the tree, not the number of proxies in it.
+class DXTAABBTree
+{
+public:
+	DXTAABBTree();
+	DXTAABBTree(const float fatMargin);
+
+	float FatMargin;
+
+	int CreateProxy(const DXTBounds& bounds, const UINT userData);
+	void DestroyProxy(const int proxy);
+	bool MoveProxy(const int proxy, const DXTBounds& bounds, const DirectX::XMFLOAT3& displacement);
+	void Clear();
+
+	// Both queries test the fat bounds of the proxies, so besides every proxy whose bounds pass they may return some
+	// whose bounds lie just outside, within the fat margin and predicted movement. Culling the tight bounds, as
+	// DXTCullBoundsStreamParallel does, returns a subset. Results are appended to userDataOut.
+	// The traversal stack is kept between calls, so a tree can't be queried from several threads at once.
+	void Query(const DXTFrustum& frustum, std::vector<UINT>* userDataOut);
+	void Query(const DXTBounds& bounds, std::vector<UINT>* userDataOut);
+
+	inline UINT GetUserData(const int proxy) const;
+	inline void SetUserData(const int proxy, const UINT userData);
+	inline const DXTBounds& GetFatBounds(const int proxy) const;
+	inline size_t GetProxyCount() const;
+	inline int GetHeight() const;
+
+private:
+	std::vector<DXTAABBTreeNode> nodes;
+	int root;
+	int freeList;
+	size_t proxyCount;
+	std::vector<DXTAABBTreeQueryEntry> queryStack;
+
+	int AllocateNode();
+	void FreeNode(const int node);
+	void InsertLeaf(const int leaf);
+	void RemoveLeaf(const int leaf);
+	void RefitAncestors(int node);
+	int Balance(const int node);
+};
+
+inline bool DXTAABBTreeNode::IsLeaf() const
+{
+	return Left == DXT_AABB_TREE_NULL_NODE;
+}
+
+inline UINT DXTAABBTree::GetUserData(const int proxy) const
+{
+	return nodes[proxy].UserData;
+}
+
+inline void DXTAABBTree::SetUserData(const int proxy, const UINT userData)
+{
+	nodes[proxy].UserData = userData;
+}
+
+inline const DXTBounds& DXTAABBTree::GetFatBounds(const int proxy) const
+{
+	return nodes[proxy].Bounds;
+}
+
+inline size_t DXTAABBTree::GetProxyCount() const
+{
+	return proxyCount;
+}
+
+inline int DXTAABBTree::GetHeight() const
+{
+	return root == DXT_AABB_TREE_NULL_NODE ? 0 : nodes[root].Height;
+}
\ No newline at end of file
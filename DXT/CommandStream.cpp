@@ -0,0 +1,221 @@
+#include "CommandStream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace std;
+
+#define DXT_COMMAND_ALIGNMENT 8
+
+DXTCommandList::DXTCommandList() :
+	size(0),
+	commandCount(0)
+{
+}
+
+void DXTCommandList::SetPipeline(DXTCommandHandle pipeline)
+{
+	auto command = static_cast<DXTSetPipelineCommand*>(Write(DXTCommandSetPipeline, sizeof(DXTSetPipelineCommand)));
+	command->Pipeline = pipeline;
+}
+
+void DXTCommandList::SetVertexBuffer(const uint32_t slot, DXTCommandHandle buffer, const uint32_t stride, const uint32_t offset)
+{
+	auto command = static_cast<DXTSetVertexBufferCommand*>(Write(DXTCommandSetVertexBuffer, sizeof(DXTSetVertexBufferCommand)));
+	command->Buffer = buffer;
+	command->Slot = slot;
+	command->Stride = stride;
+	command->Offset = offset;
+}
+
+void DXTCommandList::SetIndexBuffer(DXTCommandHandle buffer, const DXTIndexType indexType, const uint32_t offset)
+{
+	auto command = static_cast<DXTSetIndexBufferCommand*>(Write(DXTCommandSetIndexBuffer, sizeof(DXTSetIndexBufferCommand)));
+	command->Buffer = buffer;
+	command->IndexType = indexType;
+	command->Offset = offset;
+}
+
+void DXTCommandList::SetConstantBuffer(const uint32_t slot, DXTCommandHandle buffer, const uint32_t firstConstant, const uint32_t constantCount)
+{
+	auto command = static_cast<DXTSetConstantBufferCommand*>(Write(DXTCommandSetConstantBuffer, sizeof(DXTSetConstantBufferCommand)));
+	command->Buffer = buffer;
+	command->Slot = slot;
+	command->FirstConstant = firstConstant;
+	command->ConstantCount = constantCount;
+}
+
+void DXTCommandList::UpdateConstants(DXTCommandHandle buffer, const void* data, const uint32_t dataSize)
+{
+	auto command = static_cast<DXTUpdateConstantsCommand*>(Write(DXTCommandUpdateConstants, sizeof(DXTUpdateConstantsCommand) + dataSize));
+	command->Buffer = buffer;
+	command->DataSize = dataSize;
+	memcpy(command + 1, data, dataSize);
+}
+
+void DXTCommandList::DrawIndexed(const uint32_t indexCount, const uint32_t startIndex, const int32_t baseVertex)
+{
+	auto command = static_cast<DXTDrawIndexedCommand*>(Write(DXTCommandDrawIndexed, sizeof(DXTDrawIndexedCommand)));
+	command->IndexCount = indexCount;
+	command->StartIndex = startIndex;
+	command->BaseVertex = baseVertex;
+}
+
+void DXTCommandList::DrawIndexedInstanced(const uint32_t indexCount, const uint32_t instanceCount, const uint32_t startIndex,
+	const int32_t baseVertex, const uint32_t startInstance)
+{
+	auto command = static_cast<DXTDrawIndexedInstancedCommand*>(Write(DXTCommandDrawIndexedInstanced, sizeof(DXTDrawIndexedInstancedCommand)));
+	command->IndexCount = indexCount;
+	command->InstanceCount = instanceCount;
+	command->StartIndex = startIndex;
+	command->BaseVertex = baseVertex;
+	command->StartInstance = startInstance;
+}
+
+void DXTCommandList::Clear()
+{
+	size = 0;
+	commandCount = 0;
+}
+
+void* DXTCommandList::Write(const DXTCommandType type, const size_t payloadSize)
+{
+	size_t paddedSize = (payloadSize + DXT_COMMAND_ALIGNMENT - 1) / DXT_COMMAND_ALIGNMENT * DXT_COMMAND_ALIGNMENT;
+	size_t offset = size;
+	size += sizeof(DXTCommandHeader) + paddedSize;
+
+	// Doubled so growth is amortized, lists are reused from frame to frame and stop growing once warm
+	if (size > data.size())
+		data.resize(max(size, data.size() * 2));
+
+	auto header = reinterpret_cast<DXTCommandHeader*>(data.data() + offset);
+	header->Type = type;
+	header->Size = static_cast<uint32_t>(paddedSize);
+
+	++commandCount;
+	return header + 1;
+}
+
+DXTNullCommandBackend::DXTNullCommandBackend()
+{
+	Reset();
+}
+
+void DXTNullCommandBackend::Reset()
+{
+	for (auto& count : CommandCounts)
+		count = 0;
+
+	ConstantBytes = 0;
+	IndexCount = 0;
+	InstanceCount = 0;
+}
+
+void DXTNullCommandBackend::SetPipeline(const DXTSetPipelineCommand& command)
+{
+	CommandCounts[DXTCommandSetPipeline]++;
+}
+
+void DXTNullCommandBackend::SetVertexBuffer(const DXTSetVertexBufferCommand& command)
+{
+	CommandCounts[DXTCommandSetVertexBuffer]++;
+}
+
+void DXTNullCommandBackend::SetIndexBuffer(const DXTSetIndexBufferCommand& command)
+{
+	CommandCounts[DXTCommandSetIndexBuffer]++;
+}
+
+void DXTNullCommandBackend::SetConstantBuffer(const DXTSetConstantBufferCommand& command)
+{
+	CommandCounts[DXTCommandSetConstantBuffer]++;
+}
+
+void DXTNullCommandBackend::UpdateConstants(const DXTUpdateConstantsCommand& command, const void* data)
+{
+	CommandCounts[DXTCommandUpdateConstants]++;
+	ConstantBytes += command.DataSize;
+}
+
+void DXTNullCommandBackend::DrawIndexed(const DXTDrawIndexedCommand& command)
+{
+	CommandCounts[DXTCommandDrawIndexed]++;
+	IndexCount += command.IndexCount;
+	InstanceCount++;
+}
+
+void DXTNullCommandBackend::DrawIndexedInstanced(const DXTDrawIndexedInstancedCommand& command)
+{
+	CommandCounts[DXTCommandDrawIndexedInstanced]++;
+	IndexCount += command.IndexCount * command.InstanceCount;
+	InstanceCount += command.InstanceCount;
+}
+
+void DXTRecordCommandsParallel(DXTWorkerPool* pool, const size_t itemCount, const size_t itemsPerList,
+	vector<DXTCommandList>* listsOut, const DXTRecordCommandsFunc& record)
+{
+	assert(itemsPerList > 0);
+	size_t listCount = (itemCount + itemsPerList - 1) / itemsPerList;
+
+	// Lists are kept around so their storage is reused from frame to frame
+	if (listsOut->size() < listCount)
+		listsOut->resize(listCount);
+
+	for (auto& list : *listsOut)
+		list.Clear();
+
+	pool->ParallelFor(listCount, 1, [itemCount, itemsPerList, listsOut, &record](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			size_t first = i * itemsPerList;
+			record(first, min(first + itemsPerList, itemCount), &(*listsOut)[i]);
+		}
+	});
+}
+
+void DXTReplayCommands(const DXTCommandList* lists, const size_t listCount, DXTCommandBackend* backend)
+{
+	for (size_t i = 0; i < listCount; ++i)
+	{
+		const uint8_t* cursor = lists[i].GetData();
+		const uint8_t* end = cursor + lists[i].GetSize();
+
+		while (cursor < end)
+		{
+			auto header = reinterpret_cast<const DXTCommandHeader*>(cursor);
+			const void* payload = header + 1;
+
+			switch (header->Type)
+			{
+			case DXTCommandSetPipeline:
+				backend->SetPipeline(*static_cast<const DXTSetPipelineCommand*>(payload));
+				break;
+			case DXTCommandSetVertexBuffer:
+				backend->SetVertexBuffer(*static_cast<const DXTSetVertexBufferCommand*>(payload));
+				break;
+			case DXTCommandSetIndexBuffer:
+				backend->SetIndexBuffer(*static_cast<const DXTSetIndexBufferCommand*>(payload));
+				break;
+			case DXTCommandSetConstantBuffer:
+				backend->SetConstantBuffer(*static_cast<const DXTSetConstantBufferCommand*>(payload));
+				break;
+			case DXTCommandUpdateConstants:
+			{
+				auto command = static_cast<const DXTUpdateConstantsCommand*>(payload);
+				backend->UpdateConstants(*command, command + 1);
+				break;
+			}
+			case DXTCommandDrawIndexed:
+				backend->DrawIndexed(*static_cast<const DXTDrawIndexedCommand*>(payload));
+				break;
+			case DXTCommandDrawIndexedInstanced:
+				backend->DrawIndexedInstanced(*static_cast<const DXTDrawIndexedInstancedCommand*>(payload));
+				break;
+			}
+
+			cursor += sizeof(DXTCommandHeader) + header->Size;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "ToolboxTypes.h"
+#include "WorkerPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Pipelines and buffers are opaque to the stream, only the backend knows what they point to
+typedef const void* DXTCommandHandle;
+
+enum DXTCommandType
+{
+	DXTCommandSetPipeline,
+	DXTCommandSetVertexBuffer,
+	DXTCommandSetIndexBuffer,
+	DXTCommandSetConstantBuffer,
+	DXTCommandUpdateConstants,
+	DXTCommandDrawIndexed,
+	DXTCommandDrawIndexedInstanced,
+	DXTCommandTypeCount
+};
+
+// Every command is a header followed by its payload, padded so the next header stays 8 byte aligned
+struct DXTCommandHeader
+{
+	uint32_t Type;
+	uint32_t Size;
+};
+
+struct DXTSetPipelineCommand
+{
+	DXTCommandHandle Pipeline;
+};
+
+struct DXTSetVertexBufferCommand
+{
+	DXTCommandHandle Buffer;
+	uint32_t Slot;
+	uint32_t Stride;
+	uint32_t Offset;
+};
+
+struct DXTSetIndexBufferCommand
+{
+	DXTCommandHandle Buffer;
+	uint32_t IndexType;
+	uint32_t Offset;
+};
+
+// Offset and size are given in 16 byte constants
+struct DXTSetConstantBufferCommand
+{
+	DXTCommandHandle Buffer;
+	uint32_t Slot;
+	uint32_t FirstConstant;
+	uint32_t ConstantCount;
+};
+
+// Followed by DataSize bytes of constants that replace the buffer's contents
+struct DXTUpdateConstantsCommand
+{
+	DXTCommandHandle Buffer;
+	uint32_t DataSize;
+};
+
+struct DXTDrawIndexedCommand
+{
+	uint32_t IndexCount;
+	uint32_t StartIndex;
+	int32_t BaseVertex;
+};
+
+struct DXTDrawIndexedInstancedCommand
+{
+	uint32_t IndexCount;
+	uint32_t InstanceCount;
+	uint32_t StartIndex;
+	int32_t BaseVertex;
+	uint32_t StartInstance;
+};
+
+class DXTCommandList
+{
+public:
+	DXTCommandList();
+
+	void SetPipeline(DXTCommandHandle pipeline);
+	void SetVertexBuffer(const uint32_t slot, DXTCommandHandle buffer, const uint32_t stride, const uint32_t offset);
+	void SetIndexBuffer(DXTCommandHandle buffer, const DXTIndexType indexType, const uint32_t offset);
+	void SetConstantBuffer(const uint32_t slot, DXTCommandHandle buffer, const uint32_t firstConstant, const uint32_t constantCount);
+	void UpdateConstants(DXTCommandHandle buffer, const void* data, const uint32_t dataSize);
+	void DrawIndexed(const uint32_t indexCount, const uint32_t startIndex, const int32_t baseVertex);
+	void DrawIndexedInstanced(const uint32_t indexCount, const uint32_t instanceCount, const uint32_t startIndex,
+		const int32_t baseVertex, const uint32_t startInstance);
+	void Clear();
+
+	inline const uint8_t* GetData() const;
+	inline size_t GetSize() const;
+	inline size_t GetCommandCount() const;
+
+private:
+	std::vector<uint8_t> data;
+	size_t size;
+	size_t commandCount;
+
+	void* Write(const DXTCommandType type, const size_t payloadSize);
+};
+
+class DXTCommandBackend
+{
+public:
+	virtual ~DXTCommandBackend() {}
+
+	virtual void SetPipeline(const DXTSetPipelineCommand& command) = 0;
+	virtual void SetVertexBuffer(const DXTSetVertexBufferCommand& command) = 0;
+	virtual void SetIndexBuffer(const DXTSetIndexBufferCommand& command) = 0;
+	virtual void SetConstantBuffer(const DXTSetConstantBufferCommand& command) = 0;
+	virtual void UpdateConstants(const DXTUpdateConstantsCommand& command, const void* data) = 0;
+	virtual void DrawIndexed(const DXTDrawIndexedCommand& command) = 0;
+	virtual void DrawIndexedInstanced(const DXTDrawIndexedInstancedCommand& command) = 0;
+};
+
+// Decodes the commands without executing them, for measuring recording and decoding throughput
+class DXTNullCommandBackend : public DXTCommandBackend
+{
+public:
+	DXTNullCommandBackend();
+
+	size_t CommandCounts[DXTCommandTypeCount];
+	size_t ConstantBytes;
+	// Indices of instanced draws count once per instance
+	size_t IndexCount;
+	size_t InstanceCount;
+
+	void Reset();
+
+	void SetPipeline(const DXTSetPipelineCommand& command) override;
+	void SetVertexBuffer(const DXTSetVertexBufferCommand& command) override;
+	void SetIndexBuffer(const DXTSetIndexBufferCommand& command) override;
+	void SetConstantBuffer(const DXTSetConstantBufferCommand& command) override;
+	void UpdateConstants(const DXTUpdateConstantsCommand& command, const void* data) override;
+	void DrawIndexed(const DXTDrawIndexedCommand& command) override;
+	void DrawIndexedInstanced(const DXTDrawIndexedInstancedCommand& command) override;
+};
+
+// Records a list per itemsPerList items, so the lists come out in item order whichever thread recorded them.
+// itemsPerList has to be at least 1, lists past the ones recorded are left empty.
+typedef std::function<void(size_t begin, size_t end, DXTCommandList* list)> DXTRecordCommandsFunc;
+void DXTRecordCommandsParallel(DXTWorkerPool* pool, const size_t itemCount, const size_t itemsPerList,
+	std::vector<DXTCommandList>* listsOut, const DXTRecordCommandsFunc& record);
+void DXTReplayCommands(const DXTCommandList* lists, const size_t listCount, DXTCommandBackend* backend);
+
+inline const uint8_t* DXTCommandList::GetData() const
+{
+	return data.data();
+}
+
+inline size_t DXTCommandList::GetSize() const
+{
+	return size;
+}
+
+inline size_t DXTCommandList::GetCommandCount() const
+{
+	return commandCount;
+}
\ No newline at end of file
@@ -1,12 +1,19 @@
 #include "DirectXToolbox.h"
 
 #include <windowsx.h>
+#include <intrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
 #include <fstream>
 #include <limits>
 
+#ifndef DXT_NO_MESH_IMPORT
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#endif
 
 using namespace std;
 using namespace DirectX;
@@ -66,6 +73,483 @@ bool DXTIsOutsideFrustum(const DXTBounds& bounds, const DXTFrustum& frustum)
 	return false;
 }
 
+DXTFrustumTestResult DXTClassifyBounds(const DXTBounds& bounds, const DXTFrustum& frustum, UINT* planeMask)
+{
+	UINT inMask = *planeMask;
+	UINT outMask = 0;
+
+	for (int i = 0; i < 6; ++i)
+	{
+		UINT planeBit = 1u << i;
+		if ((inMask & planeBit) == 0)
+			continue;
+
+		const DXTPlane& plane = frustum.Planes[i];
+
+		// Negative vertex is the corner furthest behind the plane, positive vertex the one furthest in front
+		float negativeX = plane.Normal.x >= 0.0f ? bounds.Lower.x : bounds.Upper.x;
+		float negativeY = plane.Normal.y >= 0.0f ? bounds.Lower.y : bounds.Upper.y;
+		float negativeZ = plane.Normal.z >= 0.0f ? bounds.Lower.z : bounds.Upper.z;
+		float positiveX = plane.Normal.x >= 0.0f ? bounds.Upper.x : bounds.Lower.x;
+		float positiveY = plane.Normal.y >= 0.0f ? bounds.Upper.y : bounds.Lower.y;
+		float positiveZ = plane.Normal.z >= 0.0f ? bounds.Upper.z : bounds.Lower.z;
+
+		if ((negativeX * plane.Normal.x + negativeY * plane.Normal.y + negativeZ * plane.Normal.z) > plane.Distance)
+		{
+			*planeMask = 0;
+			return DXTFrustumTestOutside;
+		}
+
+		if ((positiveX * plane.Normal.x + positiveY * plane.Normal.y + positiveZ * plane.Normal.z) > plane.Distance)
+			outMask |= planeBit;
+	}
+
+	*planeMask = outMask;
+	return outMask == 0 ? DXTFrustumTestInside : DXTFrustumTestIntersecting;
+}
+
+// Each plane of the frustum is tested against the corner of the box that lies furthest
+// along the inverted plane normal. Since that corner is the minimum of all eight dot
+// products, this gives exactly the same result as testing every corner.
+struct DXTStreamPlane
+{
+	const float* X;
+	const float* Y;
+	const float* Z;
+	float NormalX;
+	float NormalY;
+	float NormalZ;
+	float Distance;
+};
+
+typedef UINT32(*DXTCullWordFunc)(const DXTStreamPlane* planes, const size_t first);
+
+static void DXTSetupStreamPlanes(const DXTBoundsStream& bounds, const DXTFrustum& frustum, DXTStreamPlane* planesOut)
+{
+	for (int i = 0; i < 6; ++i)
+	{
+		const DXTPlane& plane = frustum.Planes[i];
+		planesOut[i].X = plane.Normal.x >= 0.0f ? bounds.LowerX : bounds.UpperX;
+		planesOut[i].Y = plane.Normal.y >= 0.0f ? bounds.LowerY : bounds.UpperY;
+		planesOut[i].Z = plane.Normal.z >= 0.0f ? bounds.LowerZ : bounds.UpperZ;
+		planesOut[i].NormalX = plane.Normal.x;
+		planesOut[i].NormalY = plane.Normal.y;
+		planesOut[i].NormalZ = plane.Normal.z;
+		planesOut[i].Distance = plane.Distance;
+	}
+}
+
+static UINT32 DXTCullWordScalar(const DXTStreamPlane* planes, const size_t first, const size_t count)
+{
+	UINT32 visible = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		bool bOutside = false;
+
+		for (int j = 0; j < 6 && !bOutside; ++j)
+		{
+			const DXTStreamPlane& plane = planes[j];
+			bOutside = (plane.X[first + i] * plane.NormalX +
+				plane.Y[first + i] * plane.NormalY +
+				plane.Z[first + i] * plane.NormalZ) > plane.Distance;
+		}
+
+		if (!bOutside)
+			visible |= 1u << i;
+	}
+
+	return visible;
+}
+
+static UINT32 DXTCullWordSSE2(const DXTStreamPlane* planes, const size_t first)
+{
+	__m128 normalX[6];
+	__m128 normalY[6];
+	__m128 normalZ[6];
+	__m128 distance[6];
+
+	for (int j = 0; j < 6; ++j)
+	{
+		normalX[j] = _mm_set1_ps(planes[j].NormalX);
+		normalY[j] = _mm_set1_ps(planes[j].NormalY);
+		normalZ[j] = _mm_set1_ps(planes[j].NormalZ);
+		distance[j] = _mm_set1_ps(planes[j].Distance);
+	}
+
+	UINT32 visible = 0;
+
+	for (size_t i = 0; i < 32; i += 4)
+	{
+		__m128 outside = _mm_setzero_ps();
+
+		for (int j = 0; j < 6; ++j)
+		{
+			__m128 dot = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(planes[j].X + first + i), normalX[j]),
+					_mm_mul_ps(_mm_loadu_ps(planes[j].Y + first + i), normalY[j])),
+				_mm_mul_ps(_mm_loadu_ps(planes[j].Z + first + i), normalZ[j]));
+			outside = _mm_or_ps(outside, _mm_cmpgt_ps(dot, distance[j]));
+		}
+
+		visible |= static_cast<UINT32>(~_mm_movemask_ps(outside) & 0xF) << i;
+	}
+
+	return visible;
+}
+
+static UINT32 DXTCullWordAVX2(const DXTStreamPlane* planes, const size_t first)
+{
+	UINT32 visible = 0;
+
+	for (size_t i = 0; i < 32; i += 8)
+	{
+		__m256 outside = _mm256_setzero_ps();
+
+		for (int j = 0; j < 6; ++j)
+		{
+			__m256 dot = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(planes[j].X + first + i), _mm256_set1_ps(planes[j].NormalX)),
+					_mm256_mul_ps(_mm256_loadu_ps(planes[j].Y + first + i), _mm256_set1_ps(planes[j].NormalY))),
+				_mm256_mul_ps(_mm256_loadu_ps(planes[j].Z + first + i), _mm256_set1_ps(planes[j].NormalZ)));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(dot, _mm256_set1_ps(planes[j].Distance), _CMP_GT_OQ));
+		}
+
+		visible |= static_cast<UINT32>(~_mm256_movemask_ps(outside) & 0xFF) << i;
+	}
+
+	_mm256_zeroupper();
+	return visible;
+}
+
+// Highest level DXTGetSimdLevel reports, lowered to test the narrower paths on wider CPUs
+static DXTSimdLevel simdLevelLimit = DXTSimdLevelAVX2;
+
+void DXTLimitSimdLevel(const DXTSimdLevel level)
+{
+	simdLevelLimit = level;
+}
+
+DXTSimdLevel DXTGetSimdLevel()
+{
+	static DXTSimdLevel level = []()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return DXTSimdLevelSSE2;
+
+		__cpuid(info, 1);
+		bool bOSXSave = (info[2] & (1 << 27)) != 0;
+		bool bAVX = (info[2] & (1 << 28)) != 0;
+		if (!bOSXSave || !bAVX || (_xgetbv(0) & 0x6) != 0x6)
+			return DXTSimdLevelSSE2;
+
+		__cpuidex(info, 7, 0);
+		bool bAVX2 = (info[1] & (1 << 5)) != 0;
+		return bAVX2 ? DXTSimdLevelAVX2 : DXTSimdLevelSSE2;
+	}();
+
+	return min(level, simdLevelLimit);
+}
+
+void DXTCullBoundsStreamMask(const DXTBoundsStream& bounds, const DXTFrustum& frustum, UINT32* visibilityMaskOut)
+{
+	DXTStreamPlane planes[6];
+	DXTSetupStreamPlanes(bounds, frustum, planes);
+
+	DXTCullWordFunc cullWord = DXTGetSimdLevel() == DXTSimdLevelAVX2 ? &DXTCullWordAVX2 : &DXTCullWordSSE2;
+
+	size_t fullWords = bounds.Count / 32;
+	for (size_t i = 0; i < fullWords; ++i)
+		visibilityMaskOut[i] = cullWord(planes, i * 32);
+
+	size_t remainder = bounds.Count % 32;
+	if (remainder != 0)
+		visibilityMaskOut[fullWords] = DXTCullWordScalar(planes, fullWords * 32, remainder);
+}
+
+size_t DXTCullBoundsStreamIndices(const DXTBoundsStream& bounds, const DXTFrustum& frustum, UINT* visibleIndicesOut)
+{
+	DXTStreamPlane planes[6];
+	DXTSetupStreamPlanes(bounds, frustum, planes);
+
+	DXTCullWordFunc cullWord = DXTGetSimdLevel() == DXTSimdLevelAVX2 ? &DXTCullWordAVX2 : &DXTCullWordSSE2;
+
+	size_t visibleCount = 0;
+	size_t wordCount = DXT_BOUNDS_MASK_WORD_COUNT(bounds.Count);
+
+	for (size_t i = 0; i < wordCount; ++i)
+	{
+		size_t first = i * 32;
+		UINT32 word = first + 32 <= bounds.Count ? cullWord(planes, first) :
+			DXTCullWordScalar(planes, first, bounds.Count - first);
+
+		unsigned long bit;
+		while (_BitScanForward(&bit, word))
+		{
+			visibleIndicesOut[visibleCount++] = static_cast<UINT>(first + bit);
+			word &= word - 1;
+		}
+	}
+
+	return visibleCount;
+}
+
+size_t DXTCullBoundsStreamParallel(DXTWorkerPool* pool, const DXTBoundsStream& bounds, const DXTFrustum& frustum,
+	DXTParallelCullScratch* scratch, UINT* visibleIndicesOut)
+{
+	size_t chunkCount = (bounds.Count + DXT_PARALLEL_CULL_CHUNK_SIZE - 1) / DXT_PARALLEL_CULL_CHUNK_SIZE;
+
+	scratch->Chunks.resize(chunkCount);
+	scratch->ThreadIndices.resize(max<size_t>(scratch->ThreadIndices.size(), pool->GetThreadCount()));
+	for (auto& indices : scratch->ThreadIndices)
+		indices.clear();
+
+	// Every chunk is culled into the list of the thread that picked it up
+	pool->ParallelFor(chunkCount, 1, [&bounds, &frustum, scratch](size_t begin, size_t end, size_t threadIndex)
+	{
+		vector<UINT>& indices = scratch->ThreadIndices[threadIndex];
+
+		for (size_t chunk = begin; chunk < end; ++chunk)
+		{
+			size_t first = chunk * DXT_PARALLEL_CULL_CHUNK_SIZE;
+			size_t count = min<size_t>(DXT_PARALLEL_CULL_CHUNK_SIZE, bounds.Count - first);
+
+			DXTBoundsStream slice = { bounds.LowerX + first, bounds.LowerY + first, bounds.LowerZ + first,
+				bounds.UpperX + first, bounds.UpperY + first, bounds.UpperZ + first, count };
+
+			size_t offset = indices.size();
+			indices.resize(offset + count);
+			size_t visibleCount = DXTCullBoundsStreamIndices(slice, frustum, indices.data() + offset);
+			indices.resize(offset + visibleCount);
+
+			for (size_t i = offset; i < offset + visibleCount; ++i)
+				indices[i] += static_cast<UINT>(first);
+
+			DXTCullChunk& info = scratch->Chunks[chunk];
+			info.ThreadIndex = threadIndex;
+			info.ThreadOffset = offset;
+			info.VisibleCount = visibleCount;
+		}
+	});
+
+	// Scanning the per chunk counts keeps the output in stream order no matter which thread culled what. The scan is
+	// one add per DXT_PARALLEL_CULL_CHUNK_SIZE nodes, a few hundred for a million nodes, which costs less on the
+	// calling thread than another round through the pool would.
+	size_t visibleCount = 0;
+	for (auto& chunk : scratch->Chunks)
+	{
+		chunk.OutputOffset = visibleCount;
+		visibleCount += chunk.VisibleCount;
+	}
+
+	pool->ParallelFor(chunkCount, 1, [scratch, visibleIndicesOut](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const DXTCullChunk& chunk = scratch->Chunks[i];
+			const UINT* source = scratch->ThreadIndices[chunk.ThreadIndex].data() + chunk.ThreadOffset;
+			copy(source, source + chunk.VisibleCount, visibleIndicesOut + chunk.OutputOffset);
+		}
+	});
+
+	return visibleCount;
+}
+
+void DXTClassifyShadowCasters(const DXTBoundsStream& bounds, const DXTFrustum* cascadeFrustums, const size_t cascadeCount,
+	const XMFLOAT3& lightDirection, const float extrusionDistance, UINT8* cascadeMasksOut, vector<UINT>* cascadeListsOut)
+{
+	assert(cascadeCount <= DXT_MAX_SHADOW_CASCADES);
+
+	// Sweeping the box by t * lightDirection for t in [0, extrusionDistance], the way its shadow falls, only
+	// lowers its minimum distance to a plane whose outward normal faces the light, so the sweep folds into
+	// the plane distances
+	DXTStreamPlane planes[DXT_MAX_SHADOW_CASCADES][6];
+	for (size_t i = 0; i < cascadeCount; ++i)
+	{
+		DXTSetupStreamPlanes(bounds, cascadeFrustums[i], planes[i]);
+
+		for (int j = 0; j < 6; ++j)
+		{
+			DXTStreamPlane& plane = planes[i][j];
+			float facing = plane.NormalX * lightDirection.x + plane.NormalY * lightDirection.y + plane.NormalZ * lightDirection.z;
+			if (facing < 0.0f)
+				plane.Distance -= facing * extrusionDistance;
+		}
+
+		cascadeListsOut[i].clear();
+	}
+
+	DXTCullWordFunc cullWord = DXTGetSimdLevel() == DXTSimdLevelAVX2 ? &DXTCullWordAVX2 : &DXTCullWordSSE2;
+
+	size_t wordCount = DXT_BOUNDS_MASK_WORD_COUNT(bounds.Count);
+	for (size_t i = 0; i < wordCount; ++i)
+	{
+		size_t first = i * 32;
+		size_t wordSize = min<size_t>(32, bounds.Count - first);
+
+		memset(cascadeMasksOut + first, 0, wordSize);
+
+		for (size_t j = 0; j < cascadeCount; ++j)
+		{
+			UINT32 word = wordSize == 32 ? cullWord(planes[j], first) :
+				DXTCullWordScalar(planes[j], first, wordSize);
+
+			unsigned long bit;
+			while (_BitScanForward(&bit, word))
+			{
+				cascadeMasksOut[first + bit] |= static_cast<UINT8>(1 << j);
+				cascadeListsOut[j].push_back(static_cast<UINT>(first + bit));
+				word &= word - 1;
+			}
+		}
+	}
+}
+
+DXTProjectionScale DXTGetProjectionScale(const float fieldOfView, const DXTExtent2D& viewportSize)
+{
+	DXTProjectionScale scale = { 0.5f * viewportSize.Height / tanf(0.5f * fieldOfView), false };
+	return scale;
+}
+
+DXTProjectionScale DXTGetOrthographicProjectionScale(const float viewHeight, const DXTExtent2D& viewportSize)
+{
+	DXTProjectionScale scale = { viewportSize.Height / viewHeight, true };
+	return scale;
+}
+
+// Same operations in the same order as DXTProjectedSize4, so both paths agree exactly
+float DXTGetProjectedSize(const DXTBounds& bounds, const XMFLOAT3& cameraPosition, const DXTProjectionScale& projectionScale)
+{
+	float halfX = (bounds.Upper.x - bounds.Lower.x) * 0.5f;
+	float halfY = (bounds.Upper.y - bounds.Lower.y) * 0.5f;
+	float halfZ = (bounds.Upper.z - bounds.Lower.z) * 0.5f;
+	float toCenterX = (bounds.Lower.x + halfX) - cameraPosition.x;
+	float toCenterY = (bounds.Lower.y + halfY) - cameraPosition.y;
+	float toCenterZ = (bounds.Lower.z + halfZ) - cameraPosition.z;
+
+	float radiusSquared = (halfX * halfX + halfY * halfY) + halfZ * halfZ;
+	float distanceSquared = (toCenterX * toCenterX + toCenterY * toCenterY) + toCenterZ * toCenterZ;
+
+	if (projectionScale.bOrthographic)
+		return (2.0f * projectionScale.Scale) * sqrtf(radiusSquared);
+
+	// The camera is inside the bounding sphere
+	if (distanceSquared <= radiusSquared)
+		return FLT_MAX;
+
+	return (2.0f * projectionScale.Scale) * sqrtf(radiusSquared / distanceSquared);
+}
+
+// orthographic is all ones to size every lane without dividing by the distance
+static inline __m128 DXTProjectedSize4(const __m128 lowerX, const __m128 lowerY, const __m128 lowerZ,
+	const __m128 upperX, const __m128 upperY, const __m128 upperZ, const __m128* camera, const __m128 diameterScale,
+	const __m128 orthographic)
+{
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 halfX = _mm_mul_ps(_mm_sub_ps(upperX, lowerX), half);
+	__m128 halfY = _mm_mul_ps(_mm_sub_ps(upperY, lowerY), half);
+	__m128 halfZ = _mm_mul_ps(_mm_sub_ps(upperZ, lowerZ), half);
+	__m128 toCenterX = _mm_sub_ps(_mm_add_ps(lowerX, halfX), camera[0]);
+	__m128 toCenterY = _mm_sub_ps(_mm_add_ps(lowerY, halfY), camera[1]);
+	__m128 toCenterZ = _mm_sub_ps(_mm_add_ps(lowerZ, halfZ), camera[2]);
+
+	__m128 radiusSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(halfX, halfX), _mm_mul_ps(halfY, halfY)), _mm_mul_ps(halfZ, halfZ));
+	__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toCenterX, toCenterX), _mm_mul_ps(toCenterY, toCenterY)),
+		_mm_mul_ps(toCenterZ, toCenterZ));
+	distanceSquared = _mm_or_ps(_mm_and_ps(orthographic, _mm_set1_ps(1.0f)), _mm_andnot_ps(orthographic, distanceSquared));
+
+	__m128 size = _mm_mul_ps(diameterScale, _mm_sqrt_ps(_mm_div_ps(radiusSquared, distanceSquared)));
+	__m128 inside = _mm_andnot_ps(orthographic, _mm_cmple_ps(distanceSquared, radiusSquared));
+	return _mm_or_ps(_mm_and_ps(inside, _mm_set1_ps(FLT_MAX)), _mm_andnot_ps(inside, size));
+}
+
+void DXTComputeProjectedSizes(const DXTBoundsStream& bounds, const XMFLOAT3& cameraPosition,
+	const DXTProjectionScale& projectionScale, float* sizesOut)
+{
+	__m128 camera[3] = { _mm_set1_ps(cameraPosition.x), _mm_set1_ps(cameraPosition.y), _mm_set1_ps(cameraPosition.z) };
+	__m128 diameterScale = _mm_set1_ps(2.0f * projectionScale.Scale);
+	__m128 orthographic = _mm_castsi128_ps(_mm_set1_epi32(projectionScale.bOrthographic ? -1 : 0));
+
+	size_t i = 0;
+	for (; i + 4 <= bounds.Count; i += 4)
+	{
+		_mm_storeu_ps(sizesOut + i, DXTProjectedSize4(
+			_mm_loadu_ps(bounds.LowerX + i), _mm_loadu_ps(bounds.LowerY + i), _mm_loadu_ps(bounds.LowerZ + i),
+			_mm_loadu_ps(bounds.UpperX + i), _mm_loadu_ps(bounds.UpperY + i), _mm_loadu_ps(bounds.UpperZ + i),
+			camera, diameterScale, orthographic));
+	}
+
+	for (; i < bounds.Count; ++i)
+	{
+		DXTBounds box = { { bounds.LowerX[i], bounds.LowerY[i], bounds.LowerZ[i] },
+			{ bounds.UpperX[i], bounds.UpperY[i], bounds.UpperZ[i] } };
+		sizesOut[i] = DXTGetProjectedSize(box, cameraPosition, projectionScale);
+	}
+}
+
+size_t DXTCullSmallBounds(const DXTBoundsStream& bounds, const UINT* candidates, const size_t candidateCount,
+	const XMFLOAT3& cameraPosition, const DXTProjectionScale& projectionScale, const float minPixelSize,
+	UINT* visibleIndicesOut)
+{
+	__m128 camera[3] = { _mm_set1_ps(cameraPosition.x), _mm_set1_ps(cameraPosition.y), _mm_set1_ps(cameraPosition.z) };
+	__m128 diameterScale = _mm_set1_ps(2.0f * projectionScale.Scale);
+	__m128 orthographic = _mm_castsi128_ps(_mm_set1_epi32(projectionScale.bOrthographic ? -1 : 0));
+	__m128 minSize = _mm_set1_ps(minPixelSize);
+
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+	// Candidates are scattered across the stream, so gather four at a time. Reading a group before
+	// writing any of it is what makes culling in place safe.
+	for (; i + 4 <= candidateCount; i += 4)
+	{
+		UINT c0 = candidates[i];
+		UINT c1 = candidates[i + 1];
+		UINT c2 = candidates[i + 2];
+		UINT c3 = candidates[i + 3];
+
+		__m128 size = DXTProjectedSize4(
+			_mm_setr_ps(bounds.LowerX[c0], bounds.LowerX[c1], bounds.LowerX[c2], bounds.LowerX[c3]),
+			_mm_setr_ps(bounds.LowerY[c0], bounds.LowerY[c1], bounds.LowerY[c2], bounds.LowerY[c3]),
+			_mm_setr_ps(bounds.LowerZ[c0], bounds.LowerZ[c1], bounds.LowerZ[c2], bounds.LowerZ[c3]),
+			_mm_setr_ps(bounds.UpperX[c0], bounds.UpperX[c1], bounds.UpperX[c2], bounds.UpperX[c3]),
+			_mm_setr_ps(bounds.UpperY[c0], bounds.UpperY[c1], bounds.UpperY[c2], bounds.UpperY[c3]),
+			_mm_setr_ps(bounds.UpperZ[c0], bounds.UpperZ[c1], bounds.UpperZ[c2], bounds.UpperZ[c3]),
+			camera, diameterScale, orthographic);
+
+		int keep = _mm_movemask_ps(_mm_cmpge_ps(size, minSize));
+		if (keep & 1) visibleIndicesOut[visibleCount++] = c0;
+		if (keep & 2) visibleIndicesOut[visibleCount++] = c1;
+		if (keep & 4) visibleIndicesOut[visibleCount++] = c2;
+		if (keep & 8) visibleIndicesOut[visibleCount++] = c3;
+	}
+
+	for (; i < candidateCount; ++i)
+	{
+		UINT candidate = candidates[i];
+		DXTBounds box = { { bounds.LowerX[candidate], bounds.LowerY[candidate], bounds.LowerZ[candidate] },
+			{ bounds.UpperX[candidate], bounds.UpperY[candidate], bounds.UpperZ[candidate] } };
+
+		if (DXTGetProjectedSize(box, cameraPosition, projectionScale) >= minPixelSize)
+			visibleIndicesOut[visibleCount++] = candidate;
+	}
+
+	return visibleCount;
+}
+
+UINT DXTSelectLod(const float projectedSize, const float* lodThresholds, const UINT lodCount)
+{
+	for (UINT i = 0; i < lodCount; ++i)
+	{
+		if (projectedSize >= lodThresholds[i])
+			return i;
+	}
+
+	return lodCount > 0 ? lodCount - 1 : 0;
+}
+
 void DXTConstructFrustum(const float fieldOfView, const float farPlane, const float nearPlane,
 	const DirectX::XMFLOAT3& cameraPosition, const DirectX::XMFLOAT3& cameraTarget,
 	const DirectX::XMFLOAT3& cameraUp, const float aspectRatio, DXTFrustum* frustumOut)
@@ -119,44 +603,234 @@ void DXTConstructFrustum(const float fieldOfView, const float farPlane, const fl
 	DXTConstructPlaneFromPoints(farBottomRight, farTopRight, nearBottomRight, &frustumOut->Planes[5]);
 }
 
+// Clip space planes are given with inward facing normals, flip them to match DXTPlane
+static inline void DXTConstructPlaneFromClipPlane(const XMVECTOR& clipPlane, DXTPlane* planeOut)
+{
+	XMVECTOR plane = clipPlane / XMVector3Length(clipPlane);
+
+	XMStoreFloat3(&planeOut->Normal, -plane);
+	XMStoreFloat(&planeOut->Distance, XMVectorSplatW(plane));
+}
+
+// Extracts the planes from the columns of the view projection matrix (Gribb/Hartmann),
+// this works for perspective and orthographic projections alike
+void DXTConstructFrustumFromMatrix(const XMMATRIX& viewProjection, DXTFrustum* frustumOut)
+{
+	XMMATRIX columns = XMMatrixTranspose(viewProjection);
+
+	// Front plane
+	DXTConstructPlaneFromClipPlane(columns.r[2], &frustumOut->Planes[0]);
+
+	// Back plane
+	DXTConstructPlaneFromClipPlane(columns.r[3] - columns.r[2], &frustumOut->Planes[1]);
+
+	// Top plane
+	DXTConstructPlaneFromClipPlane(columns.r[3] - columns.r[1], &frustumOut->Planes[2]);
+
+	// Bottom plane
+	DXTConstructPlaneFromClipPlane(columns.r[3] + columns.r[1], &frustumOut->Planes[3]);
+
+	// Left plane
+	DXTConstructPlaneFromClipPlane(columns.r[3] + columns.r[0], &frustumOut->Planes[4]);
+
+	// Right plane
+	DXTConstructPlaneFromClipPlane(columns.r[3] - columns.r[0], &frustumOut->Planes[5]);
+}
+
+void DXTConstructFrustumsFromMatrices(const XMFLOAT4X4* viewProjections, const size_t count, DXTFrustum* frustumsOut)
+{
+	for (size_t i = 0; i < count; ++i)
+		DXTConstructFrustumFromMatrix(XMLoadFloat4x4(&viewProjections[i]), &frustumsOut[i]);
+}
+
+// Transforms the center of the bounds and projects the extent onto each world axis with the
+// absolute rotation/scale rows, which gives the same box as transforming all eight corners
+static inline void DXTTransformCenterExtent(const XMMATRIX& matrix, const DXTBounds& bounds,
+	XMVECTOR* lowerOut, XMVECTOR* upperOut)
+{
+	XMVECTOR lower = XMLoadFloat3(&bounds.Lower);
+	XMVECTOR upper = XMLoadFloat3(&bounds.Upper);
+	XMVECTOR center = (upper + lower) * 0.5f;
+	XMVECTOR extent = (upper - lower) * 0.5f;
+
+	XMVECTOR worldCenter = XMVectorMultiplyAdd(XMVectorSplatX(center), matrix.r[0], matrix.r[3]);
+	worldCenter = XMVectorMultiplyAdd(XMVectorSplatY(center), matrix.r[1], worldCenter);
+	worldCenter = XMVectorMultiplyAdd(XMVectorSplatZ(center), matrix.r[2], worldCenter);
+
+	XMVECTOR worldExtent = XMVectorMultiply(XMVectorSplatX(extent), XMVectorAbs(matrix.r[0]));
+	worldExtent = XMVectorMultiplyAdd(XMVectorSplatY(extent), XMVectorAbs(matrix.r[1]), worldExtent);
+	worldExtent = XMVectorMultiplyAdd(XMVectorSplatZ(extent), XMVectorAbs(matrix.r[2]), worldExtent);
+
+	*lowerOut = worldCenter - worldExtent;
+	*upperOut = worldCenter + worldExtent;
+}
+
 void DXTTransformBounds(const XMMATRIX& matrix, const DXTBounds& bounds, DXTBounds* boundsOut)
 {
-	XMVECTOR vecs[8] =
+	XMVECTOR lower;
+	XMVECTOR upper;
+	DXTTransformCenterExtent(matrix, bounds, &lower, &upper);
+
+	XMStoreFloat3(&boundsOut->Lower, lower);
+	XMStoreFloat3(&boundsOut->Upper, upper);
+}
+
+void DXTTransformBoundsBatch(const DXTBounds* bounds, const XMFLOAT4X4* matrices, const size_t count,
+	DXTBoundsStreamBuffer* boundsOut)
+{
+	// Shrinking keeps the capacity, so the stream never carries bounds of an earlier, longer batch
+	boundsOut->Resize(count);
+
+	size_t i = 0;
+
+	// Transform four bounds at a time and transpose the results into the component streams
+	for (; i + 4 <= count; i += 4)
+	{
+		XMMATRIX lowers;
+		XMMATRIX uppers;
+
+		for (size_t j = 0; j < 4; ++j)
+			DXTTransformCenterExtent(XMLoadFloat4x4(&matrices[i + j]), bounds[i + j], &lowers.r[j], &uppers.r[j]);
+
+		lowers = XMMatrixTranspose(lowers);
+		uppers = XMMatrixTranspose(uppers);
+
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&boundsOut->LowerX[i]), lowers.r[0]);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&boundsOut->LowerY[i]), lowers.r[1]);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&boundsOut->LowerZ[i]), lowers.r[2]);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&boundsOut->UpperX[i]), uppers.r[0]);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&boundsOut->UpperY[i]), uppers.r[1]);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&boundsOut->UpperZ[i]), uppers.r[2]);
+	}
+
+	for (; i < count; ++i)
+	{
+		XMVECTOR lower;
+		XMVECTOR upper;
+		DXTTransformCenterExtent(XMLoadFloat4x4(&matrices[i]), bounds[i], &lower, &upper);
+
+		boundsOut->LowerX[i] = XMVectorGetX(lower);
+		boundsOut->LowerY[i] = XMVectorGetY(lower);
+		boundsOut->LowerZ[i] = XMVectorGetZ(lower);
+		boundsOut->UpperX[i] = XMVectorGetX(upper);
+		boundsOut->UpperY[i] = XMVectorGetY(upper);
+		boundsOut->UpperZ[i] = XMVectorGetZ(upper);
+	}
+}
+
+void DXTComputeVertexBounds(const float* vertices, const size_t vertexStride, const size_t vertexCount, DXTBounds* boundsOut)
+{
+	if (vertexCount == 0)
 	{
-		XMVectorSet(bounds.Lower.x, bounds.Lower.y, bounds.Lower.z, 1.0f),
-		XMVectorSet(bounds.Lower.x, bounds.Lower.y, bounds.Upper.z, 1.0f),
-		XMVectorSet(bounds.Lower.x, bounds.Upper.y, bounds.Lower.z, 1.0f),
-		XMVectorSet(bounds.Lower.x, bounds.Upper.y, bounds.Upper.z, 1.0f),
-		XMVectorSet(bounds.Upper.x, bounds.Lower.y, bounds.Lower.z, 1.0f),
-		XMVectorSet(bounds.Upper.x, bounds.Lower.y, bounds.Upper.z, 1.0f),
-		XMVectorSet(bounds.Upper.x, bounds.Upper.y, bounds.Lower.z, 1.0f),
-		XMVectorSet(bounds.Upper.x, bounds.Upper.y, bounds.Upper.z, 1.0f)
-	};
+		boundsOut->Lower = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		boundsOut->Upper = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		return;
+	}
+
+	XMVECTOR lower = XMVectorReplicate(FLT_MAX);
+	XMVECTOR upper = XMVectorReplicate(-FLT_MAX);
+	const BYTE* vertex = reinterpret_cast<const BYTE*>(vertices);
+
+	for (size_t i = 0; i < vertexCount; ++i, vertex += vertexStride)
+	{
+		XMVECTOR position = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(vertex));
+		lower = XMVectorMin(lower, position);
+		upper = XMVectorMax(upper, position);
+	}
+
+	XMStoreFloat3(&boundsOut->Lower, lower);
+	XMStoreFloat3(&boundsOut->Upper, upper);
+}
+
+void DXTGetMeshFileBounds(const DXTMeshFileBounds& bounds, DXTBounds* boundsOut)
+{
+	boundsOut->Lower = XMFLOAT3(bounds.Lower[0], bounds.Lower[1], bounds.Lower[2]);
+	boundsOut->Upper = XMFLOAT3(bounds.Upper[0], bounds.Upper[1], bounds.Upper[2]);
+}
+
+void DXTSetMeshFileBounds(const DXTBounds& bounds, DXTMeshFileBounds* boundsOut)
+{
+	boundsOut->Lower[0] = bounds.Lower.x;
+	boundsOut->Lower[1] = bounds.Lower.y;
+	boundsOut->Lower[2] = bounds.Lower.z;
+	boundsOut->Upper[0] = bounds.Upper.x;
+	boundsOut->Upper[1] = bounds.Upper.y;
+	boundsOut->Upper[2] = bounds.Upper.z;
+}
+
+void DXTGetVertexEncodeParams(const DXTBounds& bounds, DXTVertexEncodeParams* paramsOut)
+{
+	paramsOut->PositionLower[0] = bounds.Lower.x;
+	paramsOut->PositionLower[1] = bounds.Lower.y;
+	paramsOut->PositionLower[2] = bounds.Lower.z;
+	paramsOut->PositionExtent[0] = bounds.Upper.x - bounds.Lower.x;
+	paramsOut->PositionExtent[1] = bounds.Upper.y - bounds.Lower.y;
+	paramsOut->PositionExtent[2] = bounds.Upper.z - bounds.Lower.z;
+}
+
+uint64_t DXTGetVertexFormatHash(const DXTVertexFormat& format)
+{
+	uint64_t hash = DXTHashBytes(format.AttributeChannels, format.AttributeCount * sizeof(UINT));
+	return DXTHashBytes(format.AttributeFormats, format.AttributeCount * sizeof(DXGI_FORMAT), hash);
+}
+
+UINT DXTGetFloatVertexStride(const UINT channelFlags)
+{
+	UINT floatCount = (channelFlags & DXTVertexAttributePosition ? 3 : 0) + (channelFlags & DXTVertexAttributeUV ? 2 : 0) +
+		(channelFlags & DXTVertexAttributeNormal ? 3 : 0) + (channelFlags & DXTVertexAttributeTangent ? 3 : 0) +
+		(channelFlags & DXTVertexAttributeBitangent ? 3 : 0);
+	return floatCount * sizeof(float);
+}
 
-	auto infinity = numeric_limits<float>::infinity();
-	boundsOut->Lower = { infinity, infinity, infinity };
-	boundsOut->Upper = { -infinity, -infinity, -infinity };
+void DXTMeasureVertexEncodeError(const DXTVertexFormat& format, const DXTVertexStream* sources, const void* vertices,
+	const size_t vertexCount, const DXTVertexEncodeParams& params, DXTVertexEncodeError* errorOut)
+{
+	// Every channel decodes to at most three floats, the streams are interleaved in the scratch buffer
+	size_t decodedStride = format.StreamCount * 3;
+	vector<float> decoded(vertexCount * decodedStride);
+	vector<DXTVertexOutputStream> streams(format.StreamCount);
+	for (size_t i = 0; i < format.StreamCount; ++i)
+	{
+		streams[i].Data = decoded.data() + i * 3;
+		streams[i].Stride = decodedStride;
+	}
 
-	XMFLOAT3 vecResult;
+	format.Deinterleave(vertices, vertexCount, params, streams.data());
 
-	for (size_t i = 0; i < 8; ++i)
+	for (size_t i = 0; i < format.StreamCount; ++i)
 	{
-		vecs[i] = XMVector4Transform(vecs[i], matrix);
-		XMStoreFloat3(&vecResult, vecs[i]);
+		UINT channel = format.StreamChannels[i];
+		bool bDirection = channel != DXTVertexAttributePosition && channel != DXTVertexAttributeUV;
+		size_t componentCount = channel == DXTVertexAttributeUV ? 2 : 3;
+		float error = 0.0f;
 
-		if (boundsOut->Lower.x > vecResult.x)
-			boundsOut->Lower.x = vecResult.x;
-		if (boundsOut->Lower.y > vecResult.y)
-			boundsOut->Lower.y = vecResult.y;
-		if (boundsOut->Lower.z > vecResult.z)
-			boundsOut->Lower.z = vecResult.z;
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			const float* source = sources[i].Data + v * sources[i].Stride;
+			const float* result = streams[i].Data + v * streams[i].Stride;
+
+			if (bDirection)
+			{
+				// Sources may be unnormalized, zero length ones have no direction to lose
+				XMVECTOR sourceDirection = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(source));
+				if (XMVectorGetX(XMVector3LengthSq(sourceDirection)) == 0.0f)
+					continue;
+				// atan2 stays accurate for the small angles quantization produces, unlike acos of the dot product
+				XMVECTOR resultDirection = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(result));
+				float sine = XMVectorGetX(XMVector3Length(XMVector3Cross(sourceDirection, resultDirection)));
+				float cosine = XMVectorGetX(XMVector3Dot(sourceDirection, resultDirection));
+				error = max<float>(error, XMConvertToDegrees(atan2(sine, cosine)));
+			}
+			else
+				for (size_t c = 0; c < componentCount; ++c)
+					error = max<float>(error, fabs(source[c] - result[c]));
+		}
 
-		if (boundsOut->Upper.x < vecResult.x)
-			boundsOut->Upper.x = vecResult.x;
-		if (boundsOut->Upper.y < vecResult.y)
-			boundsOut->Upper.y = vecResult.y;
-		if (boundsOut->Upper.z < vecResult.z)
-			boundsOut->Upper.z = vecResult.z;
+		float* channelError = channel == DXTVertexAttributePosition ? &errorOut->Position :
+			channel == DXTVertexAttributeUV ? &errorOut->UV :
+			channel == DXTVertexAttributeNormal ? &errorOut->NormalDegrees :
+			channel == DXTVertexAttributeTangent ? &errorOut->TangentDegrees : &errorOut->BitangentDegrees;
+		*channelError = max<float>(*channelError, error);
 	}
 }
 
@@ -216,23 +890,10 @@ void DXTSphericalCamera::LookAt(const XMFLOAT3& target)
 	Pitch = static_cast<float>(acos(direction.y));
 }
 
-void DXTSphericalCamera::GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize)
-{
-	GetFrustum(frustum, viewportSize, NearPlane, FarPlane);
-}
-
-void DXTSphericalCamera::GetFrustum(DXTFrustum * frustum, const DXTExtent2D & viewportSize, const float nearPlane, const float farPlane)
+void DXTSphericalCamera::GetProjectionMatrix(XMFLOAT4X4* matrixOut, const DXTExtent2D& viewportSize, const float nearPlane, const float farPlane)
 {
-	XMFLOAT3 forward;
-	GetForward(&forward);
-	XMFLOAT3 target;
-	XMStoreFloat3(&target, XMLoadFloat3(&forward) + XMLoadFloat3(&Position));
-
 	float aspectRatio = (float)viewportSize.Width / (float)viewportSize.Height;
-
-	DXTConstructFrustum(FieldOfView, farPlane, nearPlane,
-		Position, target, XMFLOAT3(0.0f, 1.0f, 0.0f),
-		aspectRatio, frustum);
+	XMStoreFloat4x4(matrixOut, XMMatrixPerspectiveFovLH(FieldOfView, aspectRatio, nearPlane, farPlane));
 }
 
 const DXTCameraShadowInfo* DXTSphericalCamera::GetShadowInfo() const
@@ -750,36 +1411,141 @@ HRESULT DXTInitDevice(const DXTRenderParams& params, const DXTWindow* window, ID
 	return S_OK;
 }
 
-HRESULT DXTCreateRasterizerStateSolid(ID3D11Device * device, ID3D11RasterizerState ** output)
+void DXTGetRasterizerDescSolid(D3D11_RASTERIZER_DESC* descOut)
 {
-	D3D11_RASTERIZER_DESC rasterDesc;
-	rasterDesc.AntialiasedLineEnable = false;
-	rasterDesc.CullMode = D3D11_CULL_BACK;
-	rasterDesc.DepthBias = 0;
-	rasterDesc.DepthBiasClamp = 0.0f;
-	rasterDesc.DepthClipEnable = true;
-	rasterDesc.FillMode = D3D11_FILL_SOLID;
-	rasterDesc.FrontCounterClockwise = false;
-	rasterDesc.MultisampleEnable = false;
-	rasterDesc.ScissorEnable = false;
-	rasterDesc.SlopeScaledDepthBias = 0.0f;
-
-	return device->CreateRasterizerState(&rasterDesc, output);
+	descOut->AntialiasedLineEnable = false;
+	descOut->CullMode = D3D11_CULL_BACK;
+	descOut->DepthBias = 0;
+	descOut->DepthBiasClamp = 0.0f;
+	descOut->DepthClipEnable = true;
+	descOut->FillMode = D3D11_FILL_SOLID;
+	descOut->FrontCounterClockwise = false;
+	descOut->MultisampleEnable = false;
+	descOut->ScissorEnable = false;
+	descOut->SlopeScaledDepthBias = 0.0f;
+}
+
+void DXTGetRasterizerDescWireframe(D3D11_RASTERIZER_DESC* descOut)
+{
+	descOut->AntialiasedLineEnable = false;
+	descOut->CullMode = D3D11_CULL_BACK;
+	descOut->DepthBias = 0;
+	descOut->DepthBiasClamp = 0.0f;
+	descOut->DepthClipEnable = true;
+	descOut->FillMode = D3D11_FILL_WIREFRAME;
+	descOut->FrontCounterClockwise = false;
+	descOut->MultisampleEnable = false;
+	descOut->ScissorEnable = false;
+	descOut->SlopeScaledDepthBias = 0.0f;
+}
+
+void DXTGetBlendDescOpaque(D3D11_BLEND_DESC* descOut)
+{
+	ZeroMemory(descOut, sizeof(*descOut));
+	descOut->RenderTarget[0].BlendEnable = false;
+	descOut->RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+	descOut->RenderTarget[0].DestBlend = D3D11_BLEND_ZERO;
+	descOut->RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+	descOut->RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+	descOut->RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+	descOut->RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	descOut->RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+}
+
+void DXTGetSamplerDescLinearClamp(D3D11_SAMPLER_DESC* descOut)
+{
+	ZeroMemory(descOut, sizeof(*descOut));
+	descOut->Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	descOut->AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	descOut->AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	descOut->AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	descOut->ComparisonFunc = D3D11_COMPARISON_NEVER;
+	descOut->MinLOD = 0;
+	descOut->MaxLOD = D3D11_FLOAT32_MAX;
+}
+
+void DXTGetSamplerDescLinearWrap(D3D11_SAMPLER_DESC* descOut)
+{
+	ZeroMemory(descOut, sizeof(*descOut));
+	descOut->Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	descOut->AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+	descOut->AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+	descOut->AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	descOut->ComparisonFunc = D3D11_COMPARISON_NEVER;
+	descOut->MinLOD = 0;
+	descOut->MaxLOD = D3D11_FLOAT32_MAX;
+}
+
+void DXTGetSamplerDescPointClamp(D3D11_SAMPLER_DESC* descOut)
+{
+	ZeroMemory(descOut, sizeof(*descOut));
+	descOut->Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+	descOut->AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	descOut->AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	descOut->AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	descOut->ComparisonFunc = D3D11_COMPARISON_NEVER;
+	descOut->MinLOD = 0;
+	descOut->MaxLOD = D3D11_FLOAT32_MAX;
+}
+
+void DXTGetDepthStencilDescDepthTestEnabled(D3D11_DEPTH_STENCIL_DESC* descOut)
+{
+	ZeroMemory(descOut, sizeof(*descOut));
+
+	descOut->DepthEnable = true;
+	descOut->DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	descOut->DepthFunc = D3D11_COMPARISON_LESS;
+
+	descOut->StencilEnable = true;
+	descOut->StencilReadMask = 0xFF;
+	descOut->StencilWriteMask = 0xFF;
+
+	descOut->FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+	descOut->FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_INCR;
+	descOut->FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	descOut->FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+
+	descOut->BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+	descOut->BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_DECR;
+	descOut->BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	descOut->BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+}
+
+void DXTGetDepthStencilDescDepthTestDisabled(D3D11_DEPTH_STENCIL_DESC* descOut)
+{
+	ZeroMemory(descOut, sizeof(*descOut));
+
+	descOut->DepthEnable = false;
+	descOut->DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	descOut->DepthFunc = D3D11_COMPARISON_ALWAYS;
+
+	descOut->StencilEnable = false;
+	descOut->StencilReadMask = 0xFF;
+	descOut->StencilWriteMask = 0xFF;
+
+	descOut->FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+	descOut->FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_INCR;
+	descOut->FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	descOut->FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+
+	descOut->BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+	descOut->BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_DECR;
+	descOut->BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	descOut->BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+}
+
+HRESULT DXTCreateRasterizerStateSolid(ID3D11Device * device, ID3D11RasterizerState ** output)
+{
+	D3D11_RASTERIZER_DESC rasterDesc;
+	DXTGetRasterizerDescSolid(&rasterDesc);
+
+	return device->CreateRasterizerState(&rasterDesc, output);
 }
 
 HRESULT DXTCreateRasterizerStateWireframe(ID3D11Device * device, ID3D11RasterizerState ** output)
 {
 	D3D11_RASTERIZER_DESC rasterDesc;
-	rasterDesc.AntialiasedLineEnable = false;
-	rasterDesc.CullMode = D3D11_CULL_BACK;
-	rasterDesc.DepthBias = 0;
-	rasterDesc.DepthBiasClamp = 0.0f;
-	rasterDesc.DepthClipEnable = true;
-	rasterDesc.FillMode = D3D11_FILL_WIREFRAME;
-	rasterDesc.FrontCounterClockwise = false;
-	rasterDesc.MultisampleEnable = false;
-	rasterDesc.ScissorEnable = false;
-	rasterDesc.SlopeScaledDepthBias = 0.0f;
+	DXTGetRasterizerDescWireframe(&rasterDesc);
 
 	return device->CreateRasterizerState(&rasterDesc, output);
 }
@@ -787,14 +1553,7 @@ HRESULT DXTCreateRasterizerStateWireframe(ID3D11Device * device, ID3D11Rasterize
 HRESULT DXTCreateSamplerStateLinearClamp(ID3D11Device * device, ID3D11SamplerState ** output)
 {
 	D3D11_SAMPLER_DESC samplerDesc;
-	ZeroMemory(&samplerDesc, sizeof(samplerDesc));
-	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-	samplerDesc.MinLOD = 0;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	DXTGetSamplerDescLinearClamp(&samplerDesc);
 
 	return device->CreateSamplerState(&samplerDesc, output);
 }
@@ -802,14 +1561,7 @@ HRESULT DXTCreateSamplerStateLinearClamp(ID3D11Device * device, ID3D11SamplerSta
 HRESULT DXTCreateSamplerStateLinearWrap(ID3D11Device * device, ID3D11SamplerState ** output)
 {
 	D3D11_SAMPLER_DESC samplerDesc;
-	ZeroMemory(&samplerDesc, sizeof(samplerDesc));
-	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-	samplerDesc.MinLOD = 0;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	DXTGetSamplerDescLinearWrap(&samplerDesc);
 
 	return device->CreateSamplerState(&samplerDesc, output);
 }
@@ -817,14 +1569,7 @@ HRESULT DXTCreateSamplerStateLinearWrap(ID3D11Device * device, ID3D11SamplerStat
 HRESULT DXTCreateSamplerStatePointClamp(ID3D11Device * device, ID3D11SamplerState ** output)
 {
 	D3D11_SAMPLER_DESC samplerDesc;
-	ZeroMemory(&samplerDesc, sizeof(samplerDesc));
-	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-	samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-	samplerDesc.MinLOD = 0;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	DXTGetSamplerDescPointClamp(&samplerDesc);
 
 	return device->CreateSamplerState(&samplerDesc, output);
 }
@@ -832,25 +1577,7 @@ HRESULT DXTCreateSamplerStatePointClamp(ID3D11Device * device, ID3D11SamplerStat
 HRESULT DXTCreateDepthStencilStateDepthTestEnabled(ID3D11Device * device, ID3D11DepthStencilState ** output)
 {
 	D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
-	ZeroMemory(&depthStencilDesc, sizeof(depthStencilDesc));
-
-	depthStencilDesc.DepthEnable = true;
-	depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-	depthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS;
-
-	depthStencilDesc.StencilEnable = true;
-	depthStencilDesc.StencilReadMask = 0xFF;
-	depthStencilDesc.StencilWriteMask = 0xFF;
-
-	depthStencilDesc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
-	depthStencilDesc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_INCR;
-	depthStencilDesc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
-	depthStencilDesc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
-
-	depthStencilDesc.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
-	depthStencilDesc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_DECR;
-	depthStencilDesc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
-	depthStencilDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+	DXTGetDepthStencilDescDepthTestEnabled(&depthStencilDesc);
 
 	return device->CreateDepthStencilState(&depthStencilDesc, output);
 }
@@ -858,38 +1585,12 @@ HRESULT DXTCreateDepthStencilStateDepthTestEnabled(ID3D11Device * device, ID3D11
 HRESULT DXTCreateDepthStencilStateDepthTestDisabled(ID3D11Device * device, ID3D11DepthStencilState ** output)
 {
 	D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
-	ZeroMemory(&depthStencilDesc, sizeof(depthStencilDesc));
-
-	depthStencilDesc.DepthEnable = false;
-	depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-	depthStencilDesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
-
-	depthStencilDesc.StencilEnable = false;
-	depthStencilDesc.StencilReadMask = 0xFF;
-	depthStencilDesc.StencilWriteMask = 0xFF;
-
-	depthStencilDesc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
-	depthStencilDesc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_INCR;
-	depthStencilDesc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
-	depthStencilDesc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
-
-	depthStencilDesc.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
-	depthStencilDesc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_DECR;
-	depthStencilDesc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
-	depthStencilDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+	DXTGetDepthStencilDescDepthTestDisabled(&depthStencilDesc);
 
 	return device->CreateDepthStencilState(&depthStencilDesc, output);
 }
 
-HRESULT DXTVertexShaderFromFile(ID3D11Device* device, const char* path, ID3D11VertexShader** output)
-{
-	DXTBytecodeBlob blob;
-	HRESULT result = DXTVertexShaderFromFile(device, path, output, &blob);
-	blob.Destroy();
-	return result;
-}
-
-HRESULT DXTVertexShaderFromFile(ID3D11Device* device, const char* path, ID3D11VertexShader** output, DXTBytecodeBlob* bytecodeOutput)
+HRESULT DXTBytecodeFromFile(const char* path, DXTBytecodeBlob* bytecodeOutput)
 {
 	OutputDebugString("Loading resource ");
 	OutputDebugString(path);
@@ -909,13 +1610,29 @@ HRESULT DXTVertexShaderFromFile(ID3D11Device* device, const char* path, ID3D11Ve
 	t.read(bytecode, bytecodeLength);
 	t.close();
 
-	HRESULT result = device->CreateVertexShader(bytecode, bytecodeLength, nullptr, output);
 	bytecodeOutput->Bytecode = bytecode;
 	bytecodeOutput->BytecodeLength = bytecodeLength;
 
+	return S_OK;
+}
+
+HRESULT DXTVertexShaderFromFile(ID3D11Device* device, const char* path, ID3D11VertexShader** output)
+{
+	DXTBytecodeBlob blob;
+	HRESULT result = DXTVertexShaderFromFile(device, path, output, &blob);
+	blob.Destroy();
 	return result;
 }
 
+HRESULT DXTVertexShaderFromFile(ID3D11Device* device, const char* path, ID3D11VertexShader** output, DXTBytecodeBlob* bytecodeOutput)
+{
+	HRESULT result = DXTBytecodeFromFile(path, bytecodeOutput);
+	if (FAILED(result))
+		return result;
+
+	return device->CreateVertexShader(bytecodeOutput->Bytecode, bytecodeOutput->BytecodeLength, nullptr, output);
+}
+
 HRESULT DXTPixelShaderFromFile(ID3D11Device * device, const char * path, ID3D11PixelShader ** output)
 {
 	DXTBytecodeBlob blob;
@@ -926,29 +1643,11 @@ HRESULT DXTPixelShaderFromFile(ID3D11Device * device, const char * path, ID3D11P
 
 HRESULT DXTPixelShaderFromFile(ID3D11Device* device, const char* path, ID3D11PixelShader** output, DXTBytecodeBlob* bytecodeOutput)
 {
-	OutputDebugString("Loading resource ");
-	OutputDebugString(path);
-	OutputDebugString("\n");
-
-	char* bytecode = nullptr;
-	size_t bytecodeLength;
-	std::ifstream t(path, std::ios::binary | std::ios::in);
-	if (t.fail())
-		return E_FAIL;
-
-	t.seekg(0, std::ios::end);
-	bytecodeLength = static_cast<size_t>(t.tellg());
-	t.seekg(0, std::ios::beg);
-
-	bytecode = new char[bytecodeLength];
-	t.read(bytecode, bytecodeLength);
-	t.close();
-
-	HRESULT result = device->CreatePixelShader(bytecode, bytecodeLength, nullptr, output);
-	bytecodeOutput->Bytecode = bytecode;
-	bytecodeOutput->BytecodeLength = bytecodeLength;
+	HRESULT result = DXTBytecodeFromFile(path, bytecodeOutput);
+	if (FAILED(result))
+		return result;
 
-	return result;
+	return device->CreatePixelShader(bytecodeOutput->Bytecode, bytecodeOutput->BytecodeLength, nullptr, output);
 }
 
 HRESULT DXTCreateBufferFromData(ID3D11Device * device, const void * data, const size_t dataLength, const UINT bindFlags, const UINT cpuAccessFlags, const D3D11_USAGE usage, ID3D11Buffer ** output)
@@ -1011,98 +1710,137 @@ HRESULT DXTCreateDepthStencilBuffer(ID3D11Device * device, const size_t width, c
 	return device->CreateDepthStencilView(*texture, &viewDesc, depthStencilView);
 }
 
-HRESULT DXTLoadStaticMeshFromFile(const char * path, const UINT channelFlags, const DXTIndexType indexType, 
-	void ** data, size_t * dataLength, void ** indexData, size_t * indexDataLength, size_t* indexCount)
+static void DXTGetStaticMeshStream(const DXTStaticMeshSource& source, const UINT channel, DXTVertexStream* streamOut)
 {
-	if (channelFlags == 0)
-		return E_FAIL;
+	// Missing channels read zeroes, which is more than any attribute has components
+	static const float zeroes[4] = {};
 
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path,
-		aiProcessPreset_TargetRealtime_Fast | aiProcess_PreTransformVertices);
-
-	if (!scene)
-		return E_FAIL;
+	switch (channel)
+	{
+	case DXTVertexAttributePosition:
+		*streamOut = source.Positions;
+		break;
+	case DXTVertexAttributeUV:
+		*streamOut = source.UVs;
+		break;
+	case DXTVertexAttributeNormal:
+		*streamOut = source.Normals;
+		break;
+	case DXTVertexAttributeTangent:
+		*streamOut = source.Tangents;
+		break;
+	case DXTVertexAttributeBitangent:
+		*streamOut = source.Bitangents;
+		break;
+	default:
+		streamOut->Data = nullptr;
+		break;
+	}
 
-	int positionOffset = 0;
-	int uvOffset = positionOffset + (channelFlags & DXTVertexAttributePosition ? 3 : 0);
-	int normalOffset = uvOffset + (channelFlags & DXTVertexAttributeUV ? 2 : 0);
-	int tangentOffset = normalOffset + (channelFlags & DXTVertexAttributeNormal ? 3 : 0);
-	int bitangentOffset = tangentOffset + (channelFlags & DXTVertexAttributeTangent ? 3 : 0);
-	int stride = bitangentOffset + (channelFlags & DXTVertexAttributeBitangent ? 3 : 0);
+	if (!streamOut->Data)
+	{
+		streamOut->Data = zeroes;
+		streamOut->Stride = 0;
+	}
+}
 
-	if (scene->mNumMeshes == 0)
-		return E_FAIL;
+HRESULT DXTPackStaticMesh(const DXTStaticMeshSource* sources, const size_t sourceCount, const DXTVertexFormat& format,
+	const DXTIndexType indexType, void** data, size_t* dataLength, void** indexData, size_t* indexDataLength, size_t* indexCount,
+	vector<DXTMeshFileSubmesh>* submeshesOut, DXTBounds* boundsOut, DXTVertexEncodeError* errorOut)
+{
+	if (sourceCount == 0)
+		return E_INVALIDARG;
 
-	if (scene->mNumMeshes > 1)
-		OutputDebugString("Warning: more than one mesh found... DXTLoadStaticMeshFromFile will only take the first one.");
+	// boundsOut may be null, the bounds are needed for encoding either way
+	DXTBounds fileBounds;
+	size_t vertexCount = 0;
+	size_t indexDataSize = 0;
+	submeshesOut->resize(sourceCount);
 
-	auto mesh = scene->mMeshes[0];
-	auto vertexDataSize = stride * mesh->mNumVertices;
-	auto vertexData = new FLOAT[vertexDataSize];
+	// Indices stay relative to the base vertex of their submesh, so 16 bit indices only limit the size of single meshes
+	for (size_t m = 0; m < sourceCount; ++m)
+	{
+		const DXTStaticMeshSource& source = sources[m];
+		if ((indexType == DXTIndexTypeShort && source.VertexCount > USHRT_MAX + 1) || source.IndexCount % 3 != 0)
+			return E_INVALIDARG;
 
-	if (channelFlags & DXTVertexAttributePosition)
-		for (size_t i = 0, loc = positionOffset; i < mesh->mNumVertices; ++i, loc += stride)
-		{
-			vertexData[loc] = mesh->mVertices[i].x;
-			vertexData[loc + 1] = mesh->mVertices[i].y;
-			vertexData[loc + 2] = mesh->mVertices[i].z;
-		}
-	if ((channelFlags & DXTVertexAttributeUV) && mesh->HasTextureCoords(0))
-		for (size_t i = 0, loc = uvOffset; i < mesh->mNumVertices; ++i, loc += stride)
-		{
-			vertexData[loc] = mesh->mTextureCoords[0][i].x;
-			vertexData[loc + 1] = mesh->mTextureCoords[0][i].y;
-		}
-	if ((channelFlags & DXTVertexAttributeNormal) && mesh->HasNormals())
-		for (size_t i = 0, loc = normalOffset; i < mesh->mNumVertices; ++i, loc += stride)
-		{
-			vertexData[loc] = mesh->mNormals[i].x;
-			vertexData[loc + 1] = mesh->mNormals[i].y;
-			vertexData[loc + 2] = mesh->mNormals[i].z;
-		}
-	if ((channelFlags & DXTVertexAttributeTangent) && mesh->HasTangentsAndBitangents())
-		for (size_t i = 0, loc = tangentOffset; i < mesh->mNumVertices; ++i, loc += stride)
-		{
-			vertexData[loc] = mesh->mTangents[i].x;
-			vertexData[loc + 1] = mesh->mTangents[i].y;
-			vertexData[loc + 2] = mesh->mTangents[i].z;
-		}
-	if ((channelFlags & DXTVertexAttributeBitangent) && mesh->HasTangentsAndBitangents())
-		for (size_t i = 0, loc = bitangentOffset; i < mesh->mNumVertices; ++i, loc += stride)
+		// An index past the vertices of its mesh would read the next submesh or past the end of the buffer
+		for (size_t i = 0; i < source.IndexCount; ++i)
 		{
-			vertexData[loc] = mesh->mBitangents[i].x;
-			vertexData[loc + 1] = mesh->mBitangents[i].y;
-			vertexData[loc + 2] = mesh->mBitangents[i].z;
+			if (source.Indices[i] >= source.VertexCount)
+				return E_INVALIDARG;
 		}
 
-	*data = vertexData;
-	*dataLength = vertexDataSize * sizeof(float);
+		DXTMeshFileSubmesh& submesh = (*submeshesOut)[m];
+		ZeroMemory(&submesh, sizeof(submesh));
+		submesh.StartIndex = static_cast<uint32_t>(indexDataSize);
+		submesh.IndexCount = static_cast<uint32_t>(source.IndexCount);
+		submesh.BaseVertex = static_cast<int32_t>(vertexCount);
+		submesh.VertexCount = static_cast<uint32_t>(source.VertexCount);
+		submesh.MaterialIndex = source.MaterialIndex;
+
+		// Bounds come from the source positions, quantized formats are encoded relative to them
+		DXTVertexStream positions;
+		DXTBounds bounds;
+		DXTGetStaticMeshStream(source, DXTVertexAttributePosition, &positions);
+		DXTComputeVertexBounds(positions.Data, positions.Stride * sizeof(float), source.VertexCount, &bounds);
+		DXTSetMeshFileBounds(bounds, &submesh.Bounds);
+
+		if (m == 0)
+			fileBounds = bounds;
+		XMStoreFloat3(&fileBounds.Lower, XMVectorMin(XMLoadFloat3(&fileBounds.Lower), XMLoadFloat3(&bounds.Lower)));
+		XMStoreFloat3(&fileBounds.Upper, XMVectorMax(XMLoadFloat3(&fileBounds.Upper), XMLoadFloat3(&bounds.Upper)));
+
+		vertexCount += source.VertexCount;
+		indexDataSize += source.IndexCount;
+	}
+
+	DXTVertexEncodeParams params;
+	DXTGetVertexEncodeParams(fileBounds, &params);
+	if (errorOut)
+		ZeroMemory(errorOut, sizeof(*errorOut));
+
+	auto vertexDataSize = format.Stride * vertexCount;
+	auto vertexData = new BYTE[vertexDataSize];
+	UINT16* indexData16 = indexType == DXTIndexTypeShort ? new UINT16[indexDataSize] : nullptr;
+	UINT* indexData32 = indexType == DXTIndexTypeInt ? new UINT[indexDataSize] : nullptr;
+	vector<DXTVertexStream> streams(format.StreamCount);
+
+	for (size_t m = 0; m < sourceCount; ++m)
+	{
+		const DXTStaticMeshSource& source = sources[m];
+		const DXTMeshFileSubmesh& submesh = (*submeshesOut)[m];
+
+		// Sources are picked once per mesh, the interleave itself doesn't branch on the channels
+		for (size_t a = 0; a < format.StreamCount; ++a)
+			DXTGetStaticMeshStream(source, format.StreamChannels[a], &streams[a]);
+		format.Interleave(streams.data(), source.VertexCount, params, vertexData + submesh.BaseVertex * format.Stride);
+
+		if (errorOut)
+			DXTMeasureVertexEncodeError(format, streams.data(), vertexData + submesh.BaseVertex * format.Stride,
+				source.VertexCount, params, errorOut);
+
+		if (indexData16)
+			for (size_t i = 0; i < source.IndexCount; ++i)
+				indexData16[submesh.StartIndex + i] = static_cast<UINT16>(source.Indices[i]);
+		if (indexData32)
+			memcpy(indexData32 + submesh.StartIndex, source.Indices, source.IndexCount * sizeof(UINT));
+	}
+
+	if (boundsOut)
+		*boundsOut = fileBounds;
 
-	auto indexDataSize = mesh->mNumFaces * 3;
+	*data = vertexData;
+	*dataLength = vertexDataSize;
 	*indexCount = indexDataSize;
 
-	if (indexType == DXTIndexTypeShort)
+	if (indexData16)
 	{
-		UINT16* indexData16 = new UINT16[indexDataSize];
-		for (size_t i = 0, loc = 0; i < mesh->mNumFaces; ++i)
-		{
-			indexData16[loc++] = mesh->mFaces[i].mIndices[0];
-			indexData16[loc++] = mesh->mFaces[i].mIndices[1];
-			indexData16[loc++] = mesh->mFaces[i].mIndices[2];
-		}
 		*indexData = indexData16;
 		*indexDataLength = indexDataSize * sizeof(UINT16);
 	}
-	if (indexType == DXTIndexTypeInt)
+	if (indexData32)
 	{
-		UINT* indexData32 = new UINT[indexDataSize];
-		for (size_t i = 0, loc = 0; i < mesh->mNumFaces; ++i)
-		{
-			indexData32[loc++] = mesh->mFaces[i].mIndices[0];
-			indexData32[loc++] = mesh->mFaces[i].mIndices[1];
-			indexData32[loc++] = mesh->mFaces[i].mIndices[2];
-		}
 		*indexData = indexData32;
 		*indexDataLength = indexDataSize * sizeof(UINT);
 	}
@@ -1110,14 +1848,114 @@ HRESULT DXTLoadStaticMeshFromFile(const char * path, const UINT channelFlags, co
 	return S_OK;
 }
 
-HRESULT DXTLoadStaticMeshFromFile(ID3D11Device * device, const char* path, const UINT channelFlags, 
-	const DXTIndexType indexType, ID3D11Buffer ** vertexBuffer, ID3D11Buffer ** indexBuffer, size_t* indexCount)
+#ifndef DXT_NO_MESH_IMPORT
+static void DXTGetMeshFileNodes(const aiScene* scene, vector<DXTMeshFileNode>* nodesOut)
+{
+	nodesOut->clear();
+
+	vector<pair<const aiNode*, uint32_t>> pending;
+	pending.push_back(make_pair(scene->mRootNode, static_cast<uint32_t>(DXT_MESH_FILE_NONE)));
+
+	// Nodes are written when they are taken off the stack, always after their parent
+	while (!pending.empty())
+	{
+		const aiNode* node = pending.back().first;
+		uint32_t parent = pending.back().second;
+		pending.pop_back();
+
+		// Assimp matrices transform column vectors
+		const aiMatrix4x4& m = node->mTransformation;
+		DXTMeshFileNode fileNode =
+		{
+			parent, DXT_MESH_FILE_NONE,
+			{ { m.a1, m.b1, m.c1, m.d1 }, { m.a2, m.b2, m.c2, m.d2 }, { m.a3, m.b3, m.c3, m.d3 }, { m.a4, m.b4, m.c4, m.d4 } }
+		};
+
+		uint32_t index = static_cast<uint32_t>(nodesOut->size());
+		if (node->mNumMeshes > 0)
+			fileNode.Submesh = node->mMeshes[0];
+		nodesOut->push_back(fileNode);
+
+		// Further meshes of the node hang off it untransformed
+		for (unsigned int i = 1; i < node->mNumMeshes; ++i)
+		{
+			DXTMeshFileNode meshNode = { index, node->mMeshes[i], { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f },
+				{ 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } };
+			nodesOut->push_back(meshNode);
+		}
+
+		for (unsigned int i = 0; i < node->mNumChildren; ++i)
+			pending.push_back(make_pair(static_cast<const aiNode*>(node->mChildren[i]), index));
+	}
+}
+
+// Assimp keeps every channel as three floats per vertex and every face as its own index array
+static void DXTGetStaticMeshSources(const aiScene* scene, vector<DXTStaticMeshSource>* sourcesOut, vector<vector<uint32_t>>* indicesOut)
+{
+	sourcesOut->resize(scene->mNumMeshes);
+	indicesOut->resize(scene->mNumMeshes);
+
+	for (size_t m = 0; m < scene->mNumMeshes; ++m)
+	{
+		const aiMesh* mesh = scene->mMeshes[m];
+		vector<uint32_t>& indices = (*indicesOut)[m];
+		indices.resize(mesh->mNumFaces * 3);
+		for (size_t i = 0; i < mesh->mNumFaces; ++i)
+			for (size_t corner = 0; corner < 3; ++corner)
+				indices[i * 3 + corner] = mesh->mFaces[i].mIndices[corner];
+
+		const size_t stride = sizeof(aiVector3D) / sizeof(float);
+		DXTStaticMeshSource& source = (*sourcesOut)[m];
+		source.Positions.Data = mesh->mVertices ? &mesh->mVertices[0].x : nullptr;
+		source.UVs.Data = mesh->mTextureCoords[0] ? &mesh->mTextureCoords[0][0].x : nullptr;
+		source.Normals.Data = mesh->mNormals ? &mesh->mNormals[0].x : nullptr;
+		source.Tangents.Data = mesh->mTangents ? &mesh->mTangents[0].x : nullptr;
+		source.Bitangents.Data = mesh->mBitangents ? &mesh->mBitangents[0].x : nullptr;
+		source.Positions.Stride = source.UVs.Stride = source.Normals.Stride = source.Tangents.Stride = source.Bitangents.Stride = stride;
+		source.VertexCount = mesh->mNumVertices;
+		source.Indices = indices.data();
+		source.IndexCount = indices.size();
+		source.MaterialIndex = mesh->mMaterialIndex;
+	}
+}
+
+HRESULT DXTLoadStaticMeshFromFile(const char * path, const DXTVertexFormat& format, const DXTIndexType indexType, 
+	void ** data, size_t * dataLength, void ** indexData, size_t * indexDataLength, size_t* indexCount,
+	vector<DXTMeshFileSubmesh>* submeshesOut, vector<DXTMeshFileNode>* nodesOut, DXTBounds* boundsOut, DXTVertexEncodeError* errorOut)
+{
+	// Meshes stay in the space of their nodes, the hierarchy goes to nodesOut
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(path, aiProcessPreset_TargetRealtime_Fast);
+
+	if (!scene || scene->mNumMeshes == 0)
+		return E_FAIL;
+
+	vector<DXTStaticMeshSource> sources;
+	vector<vector<uint32_t>> sourceIndices;
+	DXTGetStaticMeshSources(scene, &sources, &sourceIndices);
+
+	HRESULT result = DXTPackStaticMesh(sources.data(), sources.size(), format, indexType, data, dataLength, indexData,
+		indexDataLength, indexCount, submeshesOut, boundsOut, errorOut);
+	if (FAILED(result))
+		return result;
+
+	if (nodesOut)
+		DXTGetMeshFileNodes(scene, nodesOut);
+
+	return S_OK;
+}
+
+HRESULT DXTLoadStaticMeshFromFile(ID3D11Device * device, const char* path, const DXTVertexFormat& format, 
+	const DXTIndexType indexType, ID3D11Buffer ** vertexBuffer, ID3D11Buffer ** indexBuffer, vector<DXTMeshFileSubmesh>* submeshesOut,
+	vector<DXTMeshFileNode>* nodesOut, DXTBounds* boundsOut)
 {
 	void* data = nullptr;
 	size_t dataLength;
 	void* indexData = nullptr;
 	size_t indexDataLength;
-	HRESULT result1 = DXTLoadStaticMeshFromFile(path, channelFlags, indexType, &data, &dataLength, &indexData, &indexDataLength, indexCount);
+	size_t indexCount;
+	HRESULT result1 = DXTLoadStaticMeshFromFile(path, format, indexType, &data, &dataLength, &indexData, &indexDataLength,
+		&indexCount, submeshesOut, nodesOut, boundsOut, nullptr);
 
 	if (FAILED(result1))
 		return result1;
@@ -1125,14 +1963,179 @@ HRESULT DXTLoadStaticMeshFromFile(ID3D11Device * device, const char* path, const
 	HRESULT result2 = DXTCreateBufferFromData(device, data, dataLength, D3D11_BIND_VERTEX_BUFFER, 0, D3D11_USAGE_IMMUTABLE, vertexBuffer);
 	HRESULT result3 = DXTCreateBufferFromData(device, indexData, indexDataLength, D3D11_BIND_INDEX_BUFFER, 0, D3D11_USAGE_IMMUTABLE, indexBuffer);
 
-	delete[] data;
-	delete[] indexData;
+	delete[] static_cast<BYTE*>(data);
+	if (indexType == DXTIndexTypeShort)
+		delete[] static_cast<UINT16*>(indexData);
+	else
+		delete[] static_cast<UINT*>(indexData);
 
 	if (FAILED(result2))
 		return result2;
 	return result3;
 }
 
+#endif
+
+static void DXTOptimizeSubmesh(const DXTMeshFileSubmesh& submesh, const DXTVertexFormat& format, const DXTVertexEncodeParams& params,
+	BYTE* vertexData, vector<uint32_t>* indices, DXTMeshCookReport* report)
+{
+	vector<uint32_t> optimized(indices->size());
+	vector<uint32_t> clusters;
+	BYTE* vertices = vertexData + submesh.BaseVertex * format.Stride;
+
+	DXTAnalyzeVertexCache(indices->data(), indices->size(), submesh.VertexCount, DXT_VERTEX_CACHE_SIZE, &report->SourceCacheStats);
+	DXTOptimizeVertexCache(indices->data(), indices->size(), submesh.VertexCount, DXT_VERTEX_CACHE_SIZE, optimized.data(), &clusters);
+
+	// Overdraw ordering needs positions to find the outside of the mesh, decoded since they may be quantized
+	if (format.ChannelFlags & DXTVertexAttributePosition)
+	{
+		vector<float> positions(submesh.VertexCount * 3);
+		float discarded[3];
+		vector<DXTVertexOutputStream> streams(format.StreamCount);
+		for (size_t i = 0; i < format.StreamCount; ++i)
+		{
+			bool bPosition = format.StreamChannels[i] == DXTVertexAttributePosition;
+			streams[i].Data = bPosition ? positions.data() : discarded;
+			streams[i].Stride = bPosition ? 3 : 0;
+		}
+
+		format.Deinterleave(vertices, submesh.VertexCount, params, streams.data());
+		DXTOptimizeOverdraw(optimized.data(), optimized.size(), positions.data(), sizeof(float) * 3,
+			submesh.VertexCount, clusters, DXT_VERTEX_CACHE_SIZE, DXT_OVERDRAW_THRESHOLD, indices->data());
+	}
+	else
+		indices->swap(optimized);
+
+	DXTOptimizeVertexFetch(vertices, submesh.VertexCount, format.Stride, indices->data(), indices->size());
+	DXTAnalyzeVertexCache(indices->data(), indices->size(), submesh.VertexCount, DXT_VERTEX_CACHE_SIZE, &report->CookedCacheStats);
+}
+
+HRESULT DXTCookStaticMesh(const DXTStaticMeshSource* sources, const size_t sourceCount, const DXTMeshFileNode* nodes,
+	const size_t nodeCount, const char* cookedPath, const DXTVertexFormat& format, const DXTIndexType indexType,
+	DXTMeshCookReport* reportOut)
+{
+	void* data = nullptr;
+	size_t dataLength;
+	void* indexData = nullptr;
+	size_t indexDataLength;
+	size_t indexCount;
+	vector<DXTMeshFileSubmesh> submeshes;
+	DXTBounds bounds;
+	DXTMeshCookReport report = {};
+	HRESULT result = DXTPackStaticMesh(sources, sourceCount, format, indexType, &data, &dataLength, &indexData, &indexDataLength,
+		&indexCount, &submeshes, &bounds, &report.EncodeError);
+
+	if (FAILED(result))
+		return result;
+	DXTVertexEncodeParams params;
+	DXTGetVertexEncodeParams(bounds, &params);
+	vector<uint32_t> submeshIndices;
+
+	// Submeshes are optimized one by one, their ranges and bounds stay the same
+	for (auto& submesh : submeshes)
+	{
+		submeshIndices.resize(submesh.IndexCount);
+		for (size_t i = 0; i < submesh.IndexCount; ++i)
+			submeshIndices[i] = indexType == DXTIndexTypeShort ? static_cast<UINT16*>(indexData)[submesh.StartIndex + i] :
+				static_cast<UINT*>(indexData)[submesh.StartIndex + i];
+
+		DXTOptimizeSubmesh(submesh, format, params, static_cast<BYTE*>(data), &submeshIndices, &report);
+
+		for (size_t i = 0; i < submesh.IndexCount; ++i)
+			if (indexType == DXTIndexTypeShort)
+				static_cast<UINT16*>(indexData)[submesh.StartIndex + i] = static_cast<UINT16>(submeshIndices[i]);
+			else
+				static_cast<UINT*>(indexData)[submesh.StartIndex + i] = submeshIndices[i];
+	}
+
+	report.VertexBytes = dataLength;
+	report.FloatVertexBytes = dataLength / format.Stride * DXTGetFloatVertexStride(format.ChannelFlags);
+	if (reportOut)
+		*reportOut = report;
+
+	DXTMeshFileData meshData;
+	ZeroMemory(&meshData, sizeof(meshData));
+	meshData.ChannelFlags = format.ChannelFlags;
+	meshData.FormatHash = DXTGetVertexFormatHash(format);
+	meshData.VertexStride = format.Stride;
+	meshData.IndexSize = indexType == DXTIndexTypeShort ? sizeof(UINT16) : sizeof(UINT);
+	meshData.VertexCount = static_cast<uint32_t>(dataLength / meshData.VertexStride);
+	meshData.IndexCount = static_cast<uint32_t>(indexCount);
+	meshData.SubmeshCount = static_cast<uint32_t>(submeshes.size());
+	meshData.NodeCount = static_cast<uint32_t>(nodeCount);
+	meshData.Vertices = data;
+	meshData.Indices = indexData;
+	meshData.Submeshes = submeshes.data();
+	meshData.Nodes = nodes;
+	DXTSetMeshFileBounds(bounds, &meshData.Bounds);
+
+	result = DXTWriteMeshFile(cookedPath, meshData);
+
+	delete[] static_cast<BYTE*>(data);
+	if (indexType == DXTIndexTypeShort)
+		delete[] static_cast<UINT16*>(indexData);
+	else
+		delete[] static_cast<UINT*>(indexData);
+
+	return result;
+}
+
+#ifndef DXT_NO_MESH_IMPORT
+HRESULT DXTCookStaticMesh(const char* sourcePath, const char* cookedPath, const DXTVertexFormat& format, const DXTIndexType indexType,
+	DXTMeshCookReport* reportOut)
+{
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(sourcePath, aiProcessPreset_TargetRealtime_Fast);
+
+	if (!scene || scene->mNumMeshes == 0)
+		return E_FAIL;
+
+	vector<DXTStaticMeshSource> sources;
+	vector<vector<uint32_t>> sourceIndices;
+	vector<DXTMeshFileNode> nodes;
+	DXTGetStaticMeshSources(scene, &sources, &sourceIndices);
+	DXTGetMeshFileNodes(scene, &nodes);
+
+	return DXTCookStaticMesh(sources.data(), sources.size(), nodes.data(), nodes.size(), cookedPath, format, indexType, reportOut);
+}
+#endif
+
+HRESULT DXTLoadStaticMeshFromCookedFile(ID3D11Device* device, const char* path, const DXTVertexFormat& format, ID3D11Buffer** vertexBuffer,
+	ID3D11Buffer** indexBuffer, DXTIndexType* indexType, vector<DXTMeshFileSubmesh>* submeshesOut, vector<DXTMeshFileNode>* nodesOut,
+	DXTBounds* boundsOut)
+{
+	DXTMappedMeshFile file;
+	HRESULT result = file.Open(path);
+	if (FAILED(result))
+		return result;
+
+	const DXTMeshFileData& data = file.GetData();
+	if (data.FormatHash != DXTGetVertexFormatHash(format))
+		return E_INVALIDARG;
+
+	result = DXTCreateBufferFromData(device, data.Vertices, static_cast<size_t>(data.VertexCount) * data.VertexStride,
+		D3D11_BIND_VERTEX_BUFFER, 0, D3D11_USAGE_IMMUTABLE, vertexBuffer);
+	if (FAILED(result))
+		return result;
+
+	result = DXTCreateBufferFromData(device, data.Indices, static_cast<size_t>(data.IndexCount) * data.IndexSize,
+		D3D11_BIND_INDEX_BUFFER, 0, D3D11_USAGE_IMMUTABLE, indexBuffer);
+	if (FAILED(result))
+	{
+		(*vertexBuffer)->Release();
+		*vertexBuffer = nullptr;
+		return result;
+	}
+
+	*indexType = data.IndexSize == sizeof(UINT16) ? DXTIndexTypeShort : DXTIndexTypeInt;
+	submeshesOut->assign(data.Submeshes, data.Submeshes + data.SubmeshCount);
+	if (nodesOut)
+		nodesOut->assign(data.Nodes, data.Nodes + data.NodeCount);
+	DXTGetMeshFileBounds(data.Bounds, boundsOut);
+
+	return S_OK;
+}
+
 HRESULT DXTCreateBlitVertexBuffer(ID3D11Device * device, ID3D11Buffer** bufferOut)
 {
 	float blitBufferData[] =
@@ -1238,6 +2241,99 @@ HRESULT DXTCreateRenderTarget(ID3D11Device * device, const size_t width, const s
 	return result;
 }
 
+size_t DXTGetFormatSize(const DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_UINT:
+	case DXGI_FORMAT_R32G32B32A32_SINT:
+		return 16;
+	case DXGI_FORMAT_R32G32B32_TYPELESS:
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+	case DXGI_FORMAT_R32G32B32_UINT:
+	case DXGI_FORMAT_R32G32B32_SINT:
+		return 12;
+	case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_UINT:
+	case DXGI_FORMAT_R16G16B16A16_SNORM:
+	case DXGI_FORMAT_R16G16B16A16_SINT:
+	case DXGI_FORMAT_R32G32_TYPELESS:
+	case DXGI_FORMAT_R32G32_FLOAT:
+	case DXGI_FORMAT_R32G32_UINT:
+	case DXGI_FORMAT_R32G32_SINT:
+	case DXGI_FORMAT_R32G8X24_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+	case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+	case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+		return 8;
+	case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+	case DXGI_FORMAT_R10G10B10A2_UINT:
+	case DXGI_FORMAT_R11G11B10_FLOAT:
+	case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R8G8B8A8_UINT:
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+	case DXGI_FORMAT_R8G8B8A8_SINT:
+	case DXGI_FORMAT_R16G16_TYPELESS:
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_UINT:
+	case DXGI_FORMAT_R16G16_SNORM:
+	case DXGI_FORMAT_R16G16_SINT:
+	case DXGI_FORMAT_R32_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT:
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_R32_UINT:
+	case DXGI_FORMAT_R32_SINT:
+	case DXGI_FORMAT_R24G8_TYPELESS:
+	case DXGI_FORMAT_D24_UNORM_S8_UINT:
+	case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+	case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+	case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+	case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+	case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+		return 4;
+	case DXGI_FORMAT_R8G8_TYPELESS:
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_R8G8_UINT:
+	case DXGI_FORMAT_R8G8_SNORM:
+	case DXGI_FORMAT_R8G8_SINT:
+	case DXGI_FORMAT_R16_TYPELESS:
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_D16_UNORM:
+	case DXGI_FORMAT_R16_UNORM:
+	case DXGI_FORMAT_R16_UINT:
+	case DXGI_FORMAT_R16_SNORM:
+	case DXGI_FORMAT_R16_SINT:
+	case DXGI_FORMAT_B5G6R5_UNORM:
+	case DXGI_FORMAT_B5G5R5A1_UNORM:
+	case DXGI_FORMAT_B4G4R4A4_UNORM:
+		return 2;
+	case DXGI_FORMAT_R8_TYPELESS:
+	case DXGI_FORMAT_R8_UNORM:
+	case DXGI_FORMAT_R8_UINT:
+	case DXGI_FORMAT_R8_SNORM:
+	case DXGI_FORMAT_R8_SINT:
+	case DXGI_FORMAT_A8_UNORM:
+		return 1;
+	default:
+		// Block compressed, packed and video formats have no whole number of bytes per pixel
+		assert(!"DXTGetFormatSize: format without a per pixel size");
+		return 0;
+	}
+}
+
 HRESULT DXTCreateRenderTargetFromBackBuffer(IDXGISwapChain* swapChain, ID3D11Device* device, ID3D11RenderTargetView** renderTargetView)
 {
 	ID3D11Texture2D* backBuffer;
@@ -1252,52 +2348,1402 @@ void DXTBytecodeBlob::Destroy()
 	delete[] reinterpret_cast<char*>(Bytecode);
 }
 
-void DXTInputHandlerDefault::AddInputInterface(DXTInputEventInterface * obj)
+// Depth formats can't be read by shaders, the texture is created typeless and each view picks its format
+static void DXTGetDepthTargetFormats(const DXGI_FORMAT format, DXGI_FORMAT* textureFormatOut, DXGI_FORMAT* resourceFormatOut)
 {
-	inputInterfaces.push_back(obj);
+	switch (format)
+	{
+	case DXGI_FORMAT_D24_UNORM_S8_UINT:
+		*textureFormatOut = DXGI_FORMAT_R24G8_TYPELESS;
+		*resourceFormatOut = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+		break;
+	case DXGI_FORMAT_D32_FLOAT:
+		*textureFormatOut = DXGI_FORMAT_R32_TYPELESS;
+		*resourceFormatOut = DXGI_FORMAT_R32_FLOAT;
+		break;
+	default:
+		*textureFormatOut = format;
+		*resourceFormatOut = format;
+		break;
+	}
 }
 
-void DXTInputHandlerDefault::ClearInterfaces()
+DXTRenderTargetPool::DXTRenderTargetPool() :
+	device(nullptr),
+	frame(0)
 {
-	inputInterfaces.clear();
 }
 
-void DXTInputHandlerDefault::OnMouseDown(const DXTMouseEventArgs & mouseEvent)
+void DXTRenderTargetPool::Initialize(ID3D11Device* device)
 {
-	for (auto obj : inputInterfaces)
-		obj->OnMouseDown(mouseEvent);
+	this->device = device;
+	frame = 0;
 }
 
-void DXTInputHandlerDefault::OnMouseUp(const DXTMouseEventArgs & mouseEvent)
+void DXTRenderTargetPool::Release()
 {
-	for (auto obj : inputInterfaces)
-		obj->OnMouseUp(mouseEvent);
-}
+	for (auto& entry : entries)
+		DestroyTarget(&entry.Target);
 
-void DXTInputHandlerDefault::OnMouseMove(const DXTMouseMoveEventArgs & mouseEvent)
-{
-	for (auto obj : inputInterfaces)
-		obj->OnMouseMove(mouseEvent);
+	entries.clear();
 }
 
-void DXTInputHandlerDefault::OnKeyDown(const DXTKeyEventArgs & keyEvent)
+void DXTRenderTargetPool::BeginFrame()
 {
-	for (auto obj : inputInterfaces)
-		obj->OnKeyDown(keyEvent);
-}
+	++frame;
 
-void DXTInputHandlerDefault::OnKeyUp(const DXTKeyEventArgs & keyEvent)
-{
-	for (auto obj : inputInterfaces)
-		obj->OnKeyUp(keyEvent);
+	for (auto& entry : entries)
+		if (entry.Target.Texture && !entry.bAcquired && frame - entry.LastUsedFrame > DXT_RENDER_TARGET_POOL_MAX_UNUSED_FRAMES)
+			DestroyTarget(&entry.Target);
 }
 
-DXTWindowEventHandlerDefault::DXTWindowEventHandlerDefault() :
-	swapChain(nullptr)
+HRESULT DXTRenderTargetPool::AcquireTarget(const DXTRenderTargetDesc& desc, UINT* handleOut)
 {
-}
+	UINT emptySlot = static_cast<UINT>(entries.size());
 
-void DXTWindowEventHandlerDefault::SetSwapChain(IDXGISwapChain * chain)
+	for (UINT i = 0; i < entries.size(); ++i)
+	{
+		Entry& entry = entries[i];
+		if (!entry.Target.Texture)
+		{
+			emptySlot = min(emptySlot, i);
+			continue;
+		}
+
+		if (entry.bAcquired || entry.Desc.Width != desc.Width || entry.Desc.Height != desc.Height ||
+			entry.Desc.Format != desc.Format || entry.Desc.BindFlags != desc.BindFlags)
+			continue;
+
+		entry.bAcquired = true;
+		entry.LastUsedFrame = frame;
+		*handleOut = i;
+		return S_OK;
+	}
+
+	DXTRenderTarget target;
+	HRESULT result = CreateTarget(desc, &target);
+	if (FAILED(result))
+		return result;
+
+	if (emptySlot == entries.size())
+		entries.emplace_back();
+
+	Entry& entry = entries[emptySlot];
+	entry.Desc = desc;
+	entry.Target = target;
+	entry.LastUsedFrame = frame;
+	entry.bAcquired = true;
+
+	*handleOut = emptySlot;
+	return S_OK;
+}
+
+void DXTRenderTargetPool::ReleaseTarget(const UINT handle)
+{
+	entries[handle].bAcquired = false;
+}
+
+size_t DXTRenderTargetPool::GetTargetCount() const
+{
+	size_t count = 0;
+	for (auto& entry : entries)
+		count += entry.Target.Texture ? 1 : 0;
+
+	return count;
+}
+
+size_t DXTRenderTargetPool::GetTargetBytes() const
+{
+	size_t bytes = 0;
+	for (auto& entry : entries)
+		if (entry.Target.Texture)
+			bytes += static_cast<size_t>(entry.Desc.Width) * entry.Desc.Height * DXTGetFormatSize(entry.Desc.Format);
+
+	return bytes;
+}
+
+HRESULT DXTRenderTargetPool::CreateTarget(const DXTRenderTargetDesc& desc, DXTRenderTarget* targetOut)
+{
+	ZeroMemory(targetOut, sizeof(*targetOut));
+
+	bool bDepth = (desc.BindFlags & D3D11_BIND_DEPTH_STENCIL) != 0;
+	bool bResource = (desc.BindFlags & D3D11_BIND_SHADER_RESOURCE) != 0;
+	DXGI_FORMAT textureFormat = desc.Format;
+	DXGI_FORMAT resourceFormat = desc.Format;
+	if (bDepth && bResource)
+		DXTGetDepthTargetFormats(desc.Format, &textureFormat, &resourceFormat);
+
+	D3D11_TEXTURE2D_DESC textureDesc;
+	textureDesc.ArraySize = 1;
+	textureDesc.BindFlags = desc.BindFlags;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.Format = textureFormat;
+	textureDesc.Height = desc.Height;
+	textureDesc.Width = desc.Width;
+	textureDesc.MipLevels = 1;
+	textureDesc.MiscFlags = 0;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+
+	HRESULT result = device->CreateTexture2D(&textureDesc, nullptr, &targetOut->Texture);
+
+	if (SUCCEEDED(result) && (desc.BindFlags & D3D11_BIND_RENDER_TARGET))
+		result = device->CreateRenderTargetView(targetOut->Texture, nullptr, &targetOut->RenderTargetView);
+
+	if (SUCCEEDED(result) && bDepth)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC viewDesc;
+		ZeroMemory(&viewDesc, sizeof(viewDesc));
+		viewDesc.Format = desc.Format;
+		viewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+		viewDesc.Texture2D.MipSlice = 0;
+
+		result = device->CreateDepthStencilView(targetOut->Texture, &viewDesc, &targetOut->DepthStencilView);
+	}
+
+	if (SUCCEEDED(result) && bResource)
+	{
+		D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+		ZeroMemory(&viewDesc, sizeof(viewDesc));
+		viewDesc.Format = resourceFormat;
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		viewDesc.Texture2D.MipLevels = 1;
+		viewDesc.Texture2D.MostDetailedMip = 0;
+
+		result = device->CreateShaderResourceView(targetOut->Texture, &viewDesc, &targetOut->ShaderResourceView);
+	}
+
+	if (FAILED(result))
+		DestroyTarget(targetOut);
+
+	return result;
+}
+
+void DXTRenderTargetPool::DestroyTarget(DXTRenderTarget* target)
+{
+	if (target->RenderTargetView)
+		target->RenderTargetView->Release();
+	if (target->DepthStencilView)
+		target->DepthStencilView->Release();
+	if (target->ShaderResourceView)
+		target->ShaderResourceView->Release();
+	if (target->Texture)
+		target->Texture->Release();
+
+	ZeroMemory(target, sizeof(*target));
+}
+
+DXTD3D11FrameGraphBackend::DXTD3D11FrameGraphBackend() :
+	pool(nullptr),
+	stateCache(nullptr)
+{
+}
+
+void DXTD3D11FrameGraphBackend::Initialize(DXTRenderTargetPool* pool, DXTStateCache* stateCache)
+{
+	this->pool = pool;
+	this->stateCache = stateCache;
+}
+
+void DXTD3D11FrameGraphBackend::Reset()
+{
+	targets.clear();
+	handles.clear();
+}
+
+void DXTD3D11FrameGraphBackend::SetImportedTarget(const uint32_t resource, const DXTRenderTarget& target)
+{
+	ReserveResource(resource);
+	targets[resource] = target;
+	handles[resource] = DXT_FRAME_GRAPH_NULL_INDEX;
+}
+
+void DXTD3D11FrameGraphBackend::AcquireResource(const uint32_t resource, const DXTFrameGraphResourceDesc& desc)
+{
+	ReserveResource(resource);
+
+	DXTRenderTargetDesc targetDesc = { desc.Width, desc.Height, static_cast<DXGI_FORMAT>(desc.Format), desc.BindFlags };
+	UINT handle;
+	if (FAILED(pool->AcquireTarget(targetDesc, &handle)))
+	{
+		// Passes end up binding null views, which D3D11 ignores
+		ZeroMemory(&targets[resource], sizeof(targets[resource]));
+		handles[resource] = DXT_FRAME_GRAPH_NULL_INDEX;
+		return;
+	}
+
+	targets[resource] = pool->GetTarget(handle);
+	handles[resource] = handle;
+}
+
+void DXTD3D11FrameGraphBackend::ReleaseResource(const uint32_t resource)
+{
+	if (handles[resource] != DXT_FRAME_GRAPH_NULL_INDEX)
+		pool->ReleaseTarget(handles[resource]);
+
+	handles[resource] = DXT_FRAME_GRAPH_NULL_INDEX;
+}
+
+void DXTD3D11FrameGraphBackend::Barrier(const DXTFrameGraphBarrier& barrier)
+{
+	const DXTRenderTarget& target = targets[barrier.Resource];
+
+	// Whatever an earlier pass left in pooled memory is of no use to the new owner
+	if (barrier.Before == DXTFrameGraphStateUndefined && handles[barrier.Resource] != DXT_FRAME_GRAPH_NULL_INDEX)
+	{
+		stateCache->DiscardView(target.RenderTargetView);
+		stateCache->DiscardView(target.DepthStencilView);
+	}
+
+	// D3D11 refuses to bind a shader resource that is still bound as an output. The other way around
+	// is handled by the state cache when the next pass binds its outputs.
+	if (barrier.Before == DXTFrameGraphStateOutput && barrier.After == DXTFrameGraphStateInput)
+		stateCache->SetRenderTargets(0, nullptr, nullptr);
+}
+
+void DXTD3D11FrameGraphBackend::ReserveResource(const uint32_t resource)
+{
+	if (resource < targets.size())
+		return;
+
+	DXTRenderTarget emptyTarget = {};
+	targets.resize(resource + 1, emptyTarget);
+	handles.resize(resource + 1, DXT_FRAME_GRAPH_NULL_INDEX);
+}
+
+DXTStateCache::DXTStateCache() :
+	context(nullptr),
+	context1(nullptr)
+{
+	ZeroMemory(&stats, sizeof(stats));
+	ResetShadowState();
+}
+
+HRESULT DXTStateCache::Initialize(ID3D11DeviceContext* context)
+{
+	this->context = context;
+
+	// Windows of constant buffers can only be bound through the D3D11.1 interface
+	if (FAILED(context->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&context1))))
+		context1 = nullptr;
+
+	Reset();
+	return S_OK;
+}
+
+void DXTStateCache::Release()
+{
+	if (context1)
+		context1->Release();
+
+	context1 = nullptr;
+	context = nullptr;
+}
+
+void DXTStateCache::BeginFrame()
+{
+	ZeroMemory(&stats, sizeof(stats));
+}
+
+void DXTStateCache::Reset()
+{
+	context->ClearState();
+	ResetShadowState();
+}
+
+void DXTStateCache::ResetShadowState()
+{
+	// Defaults that ClearState leaves behind
+	vertexShader = nullptr;
+	pixelShader = nullptr;
+	inputLayout = nullptr;
+	topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	rasterizerState = nullptr;
+	depthStencilState = nullptr;
+	stencilRef = 0;
+	blendState = nullptr;
+	for (auto& factor : blendFactor)
+		factor = 1.0f;
+	sampleMask = 0xFFFFFFFF;
+	ZeroMemory(renderTargets, sizeof(renderTargets));
+	renderTargetCount = 0;
+	depthStencilView = nullptr;
+	viewportCount = 0;
+
+	ZeroMemory(vertexBuffers, sizeof(vertexBuffers));
+	ZeroMemory(vertexStrides, sizeof(vertexStrides));
+	ZeroMemory(vertexOffsets, sizeof(vertexOffsets));
+	vertexBufferRange.Clear();
+	indexBuffer = nullptr;
+	indexFormat = DXGI_FORMAT_UNKNOWN;
+	indexOffset = 0;
+
+	for (auto& stage : stages)
+	{
+		ZeroMemory(&stage, sizeof(stage));
+		stage.ConstantBufferRange.Clear();
+		stage.ResourceRange.Clear();
+		stage.SamplerRange.Clear();
+	}
+}
+
+bool DXTStateCache::Filter(const bool bRedundant)
+{
+	++stats.RequestedCalls;
+	if (bRedundant)
+		++stats.FilteredCalls;
+
+	return bRedundant;
+}
+
+void DXTStateCache::SetVertexShader(ID3D11VertexShader* shader)
+{
+	if (Filter(shader == vertexShader))
+		return;
+
+	vertexShader = shader;
+	context->VSSetShader(shader, nullptr, 0);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetPixelShader(ID3D11PixelShader* shader)
+{
+	if (Filter(shader == pixelShader))
+		return;
+
+	pixelShader = shader;
+	context->PSSetShader(shader, nullptr, 0);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetInputLayout(ID3D11InputLayout* inputLayout)
+{
+	if (Filter(inputLayout == this->inputLayout))
+		return;
+
+	this->inputLayout = inputLayout;
+	context->IASetInputLayout(inputLayout);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetPrimitiveTopology(const D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (Filter(topology == this->topology))
+		return;
+
+	this->topology = topology;
+	context->IASetPrimitiveTopology(topology);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetRasterizerState(ID3D11RasterizerState* state)
+{
+	if (Filter(state == rasterizerState))
+		return;
+
+	rasterizerState = state;
+	context->RSSetState(state);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetDepthStencilState(ID3D11DepthStencilState* state, const UINT stencilRef)
+{
+	if (Filter(state == depthStencilState && stencilRef == this->stencilRef))
+		return;
+
+	depthStencilState = state;
+	this->stencilRef = stencilRef;
+	context->OMSetDepthStencilState(state, stencilRef);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetBlendState(ID3D11BlendState* state, const FLOAT* blendFactor, const UINT sampleMask)
+{
+	const FLOAT defaultBlendFactor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	if (!blendFactor)
+		blendFactor = defaultBlendFactor;
+
+	if (Filter(state == blendState && sampleMask == this->sampleMask &&
+		equal(blendFactor, blendFactor + 4, this->blendFactor)))
+		return;
+
+	blendState = state;
+	copy(blendFactor, blendFactor + 4, this->blendFactor);
+	this->sampleMask = sampleMask;
+	context->OMSetBlendState(state, blendFactor, sampleMask);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetPipelineState(const DXTPipelineState& pipeline)
+{
+	SetVertexShader(pipeline.VertexShader);
+	SetPixelShader(pipeline.PixelShader);
+	SetInputLayout(pipeline.InputLayout);
+	SetPrimitiveTopology(pipeline.Topology);
+	SetRasterizerState(pipeline.RasterizerState);
+	SetDepthStencilState(pipeline.DepthStencilState, 0);
+	SetBlendState(pipeline.BlendState, nullptr, 0xFFFFFFFF);
+}
+
+void DXTStateCache::SetRenderTargets(const UINT count, ID3D11RenderTargetView* const* renderTargets,
+	ID3D11DepthStencilView* depthStencil)
+{
+	if (Filter(count == renderTargetCount && depthStencil == depthStencilView &&
+		equal(renderTargets, renderTargets + count, this->renderTargets)))
+		return;
+
+	ZeroMemory(this->renderTargets, sizeof(this->renderTargets));
+	copy(renderTargets, renderTargets + count, this->renderTargets);
+	renderTargetCount = count;
+	depthStencilView = depthStencil;
+	context->OMSetRenderTargets(count, renderTargets, depthStencil);
+	++stats.IssuedCalls;
+
+	UnbindOutputResources();
+}
+
+void DXTStateCache::UnbindOutputResources()
+{
+	// The runtime unbinds shader resources whose resource was just bound as an output, which the
+	// shadowed state has to follow or a later bind of the same view would be dropped
+	ID3D11Resource* outputs[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
+	UINT outputCount = 0;
+
+	for (UINT i = 0; i < renderTargetCount; ++i)
+	{
+		if (renderTargets[i])
+		{
+			renderTargets[i]->GetResource(&outputs[outputCount]);
+			outputs[outputCount++]->Release();
+		}
+	}
+
+	if (depthStencilView)
+	{
+		depthStencilView->GetResource(&outputs[outputCount]);
+		outputs[outputCount++]->Release();
+	}
+
+	if (outputCount == 0)
+		return;
+
+	for (auto& stage : stages)
+	{
+		for (auto& resourceView : stage.Resources)
+		{
+			if (!resourceView)
+				continue;
+
+			ID3D11Resource* resource;
+			resourceView->GetResource(&resource);
+			resource->Release();
+
+			if (find(outputs, outputs + outputCount, resource) != outputs + outputCount)
+				resourceView = nullptr;
+		}
+	}
+}
+
+void DXTStateCache::SetViewports(const UINT count, const D3D11_VIEWPORT* viewports)
+{
+	if (Filter(count == viewportCount && memcmp(viewports, this->viewports, count * sizeof(D3D11_VIEWPORT)) == 0))
+		return;
+
+	memcpy(this->viewports, viewports, count * sizeof(D3D11_VIEWPORT));
+	viewportCount = count;
+	context->RSSetViewports(count, viewports);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetVertexBuffer(const UINT slot, ID3D11Buffer* buffer, const UINT stride, const UINT offset)
+{
+	if (Filter(buffer == vertexBuffers[slot] && stride == vertexStrides[slot] && offset == vertexOffsets[slot]))
+		return;
+
+	vertexBuffers[slot] = buffer;
+	vertexStrides[slot] = stride;
+	vertexOffsets[slot] = offset;
+	vertexBufferRange.Add(slot);
+}
+
+void DXTStateCache::SetIndexBuffer(ID3D11Buffer* buffer, const DXGI_FORMAT format, const UINT offset)
+{
+	if (Filter(buffer == indexBuffer && format == indexFormat && offset == indexOffset))
+		return;
+
+	indexBuffer = buffer;
+	indexFormat = format;
+	indexOffset = offset;
+	context->IASetIndexBuffer(buffer, format, offset);
+	++stats.IssuedCalls;
+}
+
+void DXTStateCache::SetConstantBuffer(const DXTShaderStage stage, const UINT slot, ID3D11Buffer* buffer)
+{
+	// The whole buffer is bound as the largest window, which the ranged call treats the same way
+	SetConstantBuffer(stage, slot, buffer, 0, D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT);
+}
+
+void DXTStateCache::SetConstantBuffer(const DXTShaderStage stage, const UINT slot, ID3D11Buffer* buffer,
+	const UINT firstConstant, const UINT constantCount)
+{
+	StageBindings& bindings = stages[stage];
+	if (Filter(buffer == bindings.ConstantBuffers[slot] && firstConstant == bindings.FirstConstants[slot] &&
+		constantCount == bindings.ConstantCounts[slot]))
+		return;
+
+	bindings.ConstantBuffers[slot] = buffer;
+	bindings.FirstConstants[slot] = firstConstant;
+	bindings.ConstantCounts[slot] = constantCount;
+	bindings.ConstantBufferRange.Add(slot);
+}
+
+void DXTStateCache::SetShaderResource(const DXTShaderStage stage, const UINT slot, ID3D11ShaderResourceView* resource)
+{
+	StageBindings& bindings = stages[stage];
+	if (Filter(resource == bindings.Resources[slot]))
+		return;
+
+	bindings.Resources[slot] = resource;
+	bindings.ResourceRange.Add(slot);
+}
+
+void DXTStateCache::SetSampler(const DXTShaderStage stage, const UINT slot, ID3D11SamplerState* sampler)
+{
+	StageBindings& bindings = stages[stage];
+	if (Filter(sampler == bindings.Samplers[slot]))
+		return;
+
+	bindings.Samplers[slot] = sampler;
+	bindings.SamplerRange.Add(slot);
+}
+
+void DXTStateCache::FlushBindings()
+{
+	if (vertexBufferRange.First < vertexBufferRange.End)
+	{
+		UINT first = vertexBufferRange.First;
+		context->IASetVertexBuffers(first, vertexBufferRange.End - first,
+			&vertexBuffers[first], &vertexStrides[first], &vertexOffsets[first]);
+		vertexBufferRange.Clear();
+		++stats.IssuedCalls;
+	}
+
+	FlushStageBindings(DXTShaderStageVertex);
+	FlushStageBindings(DXTShaderStagePixel);
+}
+
+void DXTStateCache::FlushStageBindings(const DXTShaderStage stage)
+{
+	StageBindings& bindings = stages[stage];
+
+	if (bindings.ConstantBufferRange.First < bindings.ConstantBufferRange.End)
+	{
+		UINT first = bindings.ConstantBufferRange.First;
+		UINT count = bindings.ConstantBufferRange.End - first;
+
+		bool bWindowed = false;
+		for (UINT i = first; i < first + count; ++i)
+			bWindowed |= bindings.FirstConstants[i] != 0 || bindings.ConstantCounts[i] != D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT;
+
+		if (bWindowed && context1)
+		{
+			if (stage == DXTShaderStageVertex)
+				context1->VSSetConstantBuffers1(first, count, &bindings.ConstantBuffers[first],
+					&bindings.FirstConstants[first], &bindings.ConstantCounts[first]);
+			else
+				context1->PSSetConstantBuffers1(first, count, &bindings.ConstantBuffers[first],
+					&bindings.FirstConstants[first], &bindings.ConstantCounts[first]);
+		}
+		else
+		{
+			if (stage == DXTShaderStageVertex)
+				context->VSSetConstantBuffers(first, count, &bindings.ConstantBuffers[first]);
+			else
+				context->PSSetConstantBuffers(first, count, &bindings.ConstantBuffers[first]);
+		}
+
+		bindings.ConstantBufferRange.Clear();
+		++stats.IssuedCalls;
+	}
+
+	if (bindings.ResourceRange.First < bindings.ResourceRange.End)
+	{
+		UINT first = bindings.ResourceRange.First;
+		UINT count = bindings.ResourceRange.End - first;
+
+		if (stage == DXTShaderStageVertex)
+			context->VSSetShaderResources(first, count, &bindings.Resources[first]);
+		else
+			context->PSSetShaderResources(first, count, &bindings.Resources[first]);
+
+		bindings.ResourceRange.Clear();
+		++stats.IssuedCalls;
+	}
+
+	if (bindings.SamplerRange.First < bindings.SamplerRange.End)
+	{
+		UINT first = bindings.SamplerRange.First;
+		UINT count = bindings.SamplerRange.End - first;
+
+		if (stage == DXTShaderStageVertex)
+			context->VSSetSamplers(first, count, &bindings.Samplers[first]);
+		else
+			context->PSSetSamplers(first, count, &bindings.Samplers[first]);
+
+		bindings.SamplerRange.Clear();
+		++stats.IssuedCalls;
+	}
+}
+
+void DXTStateCache::Draw(const UINT vertexCount, const UINT startVertex)
+{
+	FlushBindings();
+	context->Draw(vertexCount, startVertex);
+}
+
+void DXTStateCache::DrawIndexed(const UINT indexCount, const UINT startIndex, const INT baseVertex)
+{
+	FlushBindings();
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void DXTStateCache::DrawIndexedInstanced(const UINT indexCount, const UINT instanceCount, const UINT startIndex,
+	const INT baseVertex, const UINT startInstance)
+{
+	FlushBindings();
+	context->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+void DXTStateCache::DiscardView(ID3D11View* view)
+{
+	if (context1 && view)
+		context1->DiscardView(view);
+}
+
+DXTD3D11CommandBackend::DXTD3D11CommandBackend(DXTStateCache* stateCache) :
+	stateCache(stateCache)
+{
+}
+
+void DXTD3D11CommandBackend::SetPipeline(const DXTSetPipelineCommand& command)
+{
+	stateCache->SetPipelineState(*static_cast<const DXTPipelineState*>(command.Pipeline));
+}
+
+void DXTD3D11CommandBackend::SetVertexBuffer(const DXTSetVertexBufferCommand& command)
+{
+	ID3D11Buffer* buffer = static_cast<ID3D11Buffer*>(const_cast<void*>(command.Buffer));
+	stateCache->SetVertexBuffer(command.Slot, buffer, command.Stride, command.Offset);
+}
+
+void DXTD3D11CommandBackend::SetIndexBuffer(const DXTSetIndexBufferCommand& command)
+{
+	ID3D11Buffer* buffer = static_cast<ID3D11Buffer*>(const_cast<void*>(command.Buffer));
+	DXGI_FORMAT format = command.IndexType == DXTIndexTypeShort ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	stateCache->SetIndexBuffer(buffer, format, command.Offset);
+}
+
+void DXTD3D11CommandBackend::SetConstantBuffer(const DXTSetConstantBufferCommand& command)
+{
+	ID3D11Buffer* buffer = static_cast<ID3D11Buffer*>(const_cast<void*>(command.Buffer));
+	stateCache->SetConstantBuffer(DXTShaderStageVertex, command.Slot, buffer, command.FirstConstant, command.ConstantCount);
+	stateCache->SetConstantBuffer(DXTShaderStagePixel, command.Slot, buffer, command.FirstConstant, command.ConstantCount);
+}
+
+void DXTD3D11CommandBackend::UpdateConstants(const DXTUpdateConstantsCommand& command, const void* data)
+{
+	ID3D11Buffer* buffer = static_cast<ID3D11Buffer*>(const_cast<void*>(command.Buffer));
+	ID3D11DeviceContext* context = stateCache->GetContext();
+
+	D3D11_MAPPED_SUBRESOURCE subres;
+	if (SUCCEEDED(context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subres)))
+	{
+		memcpy(subres.pData, data, command.DataSize);
+		context->Unmap(buffer, 0);
+	}
+}
+
+void DXTD3D11CommandBackend::DrawIndexed(const DXTDrawIndexedCommand& command)
+{
+	stateCache->DrawIndexed(command.IndexCount, command.StartIndex, command.BaseVertex);
+}
+
+void DXTD3D11CommandBackend::DrawIndexedInstanced(const DXTDrawIndexedInstancedCommand& command)
+{
+	stateCache->DrawIndexedInstanced(command.IndexCount, command.InstanceCount, command.StartIndex,
+		command.BaseVertex, command.StartInstance);
+}
+
+template<class T>
+static void DXTReleaseStateObjects(DXTStateObjectTable* table)
+{
+	for (auto object : table->GetObjects())
+		static_cast<T*>(object)->Release();
+
+	table->Clear();
+}
+
+DXTStateObjectCache::DXTStateObjectCache() :
+	device(nullptr)
+{
+}
+
+void DXTStateObjectCache::Initialize(ID3D11Device* device)
+{
+	this->device = device;
+}
+
+void DXTStateObjectCache::Release()
+{
+	DXTReleaseStateObjects<ID3D11RasterizerState>(&rasterizerStates);
+	DXTReleaseStateObjects<ID3D11DepthStencilState>(&depthStencilStates);
+	DXTReleaseStateObjects<ID3D11BlendState>(&blendStates);
+	DXTReleaseStateObjects<ID3D11SamplerState>(&samplerStates);
+	DXTReleaseStateObjects<ID3D11VertexShader>(&vertexShaders);
+	DXTReleaseStateObjects<ID3D11PixelShader>(&pixelShaders);
+	DXTReleaseStateObjects<ID3D11InputLayout>(&inputLayouts);
+
+	// Pipelines only point at objects released above
+	pipelineStates.Clear();
+	pipelines.clear();
+}
+
+HRESULT DXTStateObjectCache::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc, ID3D11RasterizerState** output)
+{
+	DXTMakeStateKey(desc, &key);
+	auto state = static_cast<ID3D11RasterizerState*>(rasterizerStates.Find(key));
+	if (!state)
+	{
+		HRESULT result = device->CreateRasterizerState(&desc, &state);
+		if (FAILED(result))
+			return result;
+
+		rasterizerStates.Insert(key, state);
+	}
+
+	state->AddRef();
+	*output = state;
+	return S_OK;
+}
+
+HRESULT DXTStateObjectCache::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc, ID3D11DepthStencilState** output)
+{
+	DXTMakeStateKey(desc, &key);
+	auto state = static_cast<ID3D11DepthStencilState*>(depthStencilStates.Find(key));
+	if (!state)
+	{
+		HRESULT result = device->CreateDepthStencilState(&desc, &state);
+		if (FAILED(result))
+			return result;
+
+		depthStencilStates.Insert(key, state);
+	}
+
+	state->AddRef();
+	*output = state;
+	return S_OK;
+}
+
+HRESULT DXTStateObjectCache::GetBlendState(const D3D11_BLEND_DESC& desc, ID3D11BlendState** output)
+{
+	DXTMakeStateKey(desc, &key);
+	auto state = static_cast<ID3D11BlendState*>(blendStates.Find(key));
+	if (!state)
+	{
+		HRESULT result = device->CreateBlendState(&desc, &state);
+		if (FAILED(result))
+			return result;
+
+		blendStates.Insert(key, state);
+	}
+
+	state->AddRef();
+	*output = state;
+	return S_OK;
+}
+
+HRESULT DXTStateObjectCache::GetSamplerState(const D3D11_SAMPLER_DESC& desc, ID3D11SamplerState** output)
+{
+	DXTMakeStateKey(desc, &key);
+	auto state = static_cast<ID3D11SamplerState*>(samplerStates.Find(key));
+	if (!state)
+	{
+		HRESULT result = device->CreateSamplerState(&desc, &state);
+		if (FAILED(result))
+			return result;
+
+		samplerStates.Insert(key, state);
+	}
+
+	state->AddRef();
+	*output = state;
+	return S_OK;
+}
+
+HRESULT DXTStateObjectCache::GetVertexShader(const DXTBytecodeBlob& bytecode, ID3D11VertexShader** output)
+{
+	DXTMakeStateKey(bytecode.Bytecode, bytecode.BytecodeLength, &key);
+	auto shader = static_cast<ID3D11VertexShader*>(vertexShaders.Find(key));
+	if (!shader)
+	{
+		HRESULT result = device->CreateVertexShader(bytecode.Bytecode, bytecode.BytecodeLength, nullptr, &shader);
+		if (FAILED(result))
+			return result;
+
+		vertexShaders.Insert(key, shader);
+	}
+
+	shader->AddRef();
+	*output = shader;
+	return S_OK;
+}
+
+HRESULT DXTStateObjectCache::GetPixelShader(const DXTBytecodeBlob& bytecode, ID3D11PixelShader** output)
+{
+	DXTMakeStateKey(bytecode.Bytecode, bytecode.BytecodeLength, &key);
+	auto shader = static_cast<ID3D11PixelShader*>(pixelShaders.Find(key));
+	if (!shader)
+	{
+		HRESULT result = device->CreatePixelShader(bytecode.Bytecode, bytecode.BytecodeLength, nullptr, &shader);
+		if (FAILED(result))
+			return result;
+
+		pixelShaders.Insert(key, shader);
+	}
+
+	shader->AddRef();
+	*output = shader;
+	return S_OK;
+}
+
+HRESULT DXTStateObjectCache::GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, const UINT elementCount,
+	const DXTBytecodeBlob& vertexShaderCode, ID3D11InputLayout** output)
+{
+	DXTMakeStateKey(elements, elementCount, vertexShaderCode.Bytecode, vertexShaderCode.BytecodeLength, &key);
+	auto inputLayout = static_cast<ID3D11InputLayout*>(inputLayouts.Find(key));
+	if (!inputLayout)
+	{
+		HRESULT result = device->CreateInputLayout(elements, elementCount, vertexShaderCode.Bytecode,
+			vertexShaderCode.BytecodeLength, &inputLayout);
+		if (FAILED(result))
+			return result;
+
+		inputLayouts.Insert(key, inputLayout);
+	}
+
+	inputLayout->AddRef();
+	*output = inputLayout;
+	return S_OK;
+}
+
+HRESULT DXTStateObjectCache::GetPipelineState(const DXTPipelineDesc& desc, const DXTPipelineState** output)
+{
+	DXTPipelineState pipeline = {};
+	pipeline.Topology = desc.Topology;
+
+	HRESULT result = GetVertexShader(*desc.VertexShader, &pipeline.VertexShader);
+	if (SUCCEEDED(result))
+		result = GetPixelShader(*desc.PixelShader, &pipeline.PixelShader);
+	if (SUCCEEDED(result))
+		result = GetInputLayout(desc.InputElements, desc.InputElementCount, *desc.VertexShader, &pipeline.InputLayout);
+	if (SUCCEEDED(result))
+		result = GetRasterizerState(desc.Rasterizer, &pipeline.RasterizerState);
+	if (SUCCEEDED(result))
+		result = GetDepthStencilState(desc.DepthStencil, &pipeline.DepthStencilState);
+	if (SUCCEEDED(result))
+		result = GetBlendState(desc.Blend, &pipeline.BlendState);
+
+	// The tables keep the objects alive, the pipeline doesn't hold references of its own
+	if (pipeline.VertexShader)
+		pipeline.VertexShader->Release();
+	if (pipeline.PixelShader)
+		pipeline.PixelShader->Release();
+	if (pipeline.InputLayout)
+		pipeline.InputLayout->Release();
+	if (pipeline.RasterizerState)
+		pipeline.RasterizerState->Release();
+	if (pipeline.DepthStencilState)
+		pipeline.DepthStencilState->Release();
+	if (pipeline.BlendState)
+		pipeline.BlendState->Release();
+
+	if (FAILED(result))
+		return result;
+
+	// Equal descriptions resolved to the same objects, so the pointers identify the pipeline
+	key.Clear();
+	key.Append(&pipeline.VertexShader, sizeof(pipeline.VertexShader));
+	key.Append(&pipeline.PixelShader, sizeof(pipeline.PixelShader));
+	key.Append(&pipeline.InputLayout, sizeof(pipeline.InputLayout));
+	key.Append(&pipeline.RasterizerState, sizeof(pipeline.RasterizerState));
+	key.Append(&pipeline.DepthStencilState, sizeof(pipeline.DepthStencilState));
+	key.Append(&pipeline.BlendState, sizeof(pipeline.BlendState));
+	key.Append(&pipeline.Topology, sizeof(pipeline.Topology));
+
+	auto cached = static_cast<const DXTPipelineState*>(pipelineStates.Find(key));
+	if (!cached)
+	{
+		pipelines.push_back(pipeline);
+		cached = &pipelines.back();
+		pipelineStates.Insert(key, const_cast<DXTPipelineState*>(cached));
+	}
+
+	*output = cached;
+	return S_OK;
+}
+
+size_t DXTStateObjectCache::GetObjectCount() const
+{
+	return rasterizerStates.GetCount() + depthStencilStates.GetCount() + blendStates.GetCount() +
+		samplerStates.GetCount() + vertexShaders.GetCount() + pixelShaders.GetCount() + inputLayouts.GetCount() +
+		pipelineStates.GetCount();
+}
+
+DXTConstantBufferRing::DXTConstantBufferRing() :
+	buffer(nullptr),
+	mappedData(nullptr),
+	frameIndex(0),
+	bNoOverwriteSupported(false)
+{
+	for (auto& query : frameQueries)
+		query = nullptr;
+}
+
+HRESULT DXTConstantBufferRing::Initialize(ID3D11Device* device, const size_t size)
+{
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	HRESULT result = device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	if (FAILED(result))
+		return result;
+
+	// Binding windows of a constant buffer needs a D3D11.1 driver
+	if (!options.ConstantBufferOffsetting)
+		return E_NOTIMPL;
+
+	bNoOverwriteSupported = options.MapNoOverwriteOnDynamicConstantBuffer != FALSE;
+
+	size_t alignedSize = (size + DXT_CONSTANT_BUFFER_ALIGNMENT - 1) / DXT_CONSTANT_BUFFER_ALIGNMENT * DXT_CONSTANT_BUFFER_ALIGNMENT;
+	result = DXTCreateBuffer(device, alignedSize, D3D11_BIND_CONSTANT_BUFFER, D3D11_CPU_ACCESS_WRITE,
+		D3D11_USAGE_DYNAMIC, &buffer);
+	if (FAILED(result))
+		return result;
+
+	D3D11_QUERY_DESC queryDesc = { D3D11_QUERY_EVENT, 0 };
+	for (auto& query : frameQueries)
+	{
+		result = device->CreateQuery(&queryDesc, &query);
+		if (FAILED(result))
+			return result;
+	}
+
+	allocator.Reset(alignedSize, DXT_CONSTANT_BUFFER_ALIGNMENT);
+	frameIndex = 0;
+
+	return S_OK;
+}
+
+void DXTConstantBufferRing::Release()
+{
+	for (auto& query : frameQueries)
+	{
+		if (query)
+			query->Release();
+		query = nullptr;
+	}
+
+	if (buffer)
+		buffer->Release();
+	buffer = nullptr;
+}
+
+HRESULT DXTConstantBufferRing::Map(ID3D11DeviceContext* context)
+{
+	D3D11_MAP mapType = D3D11_MAP_WRITE_DISCARD;
+
+	if (bNoOverwriteSupported)
+	{
+		ReleaseCompletedFrames(context);
+
+		// Every query is in use, so wait for the oldest frame to free up its slot. The first poll flushes the frame
+		// to the GPU, the thread then sleeps between polls rather than spinning a core until the GPU catches up.
+		if (allocator.GetPendingFrameCount() == DXT_MAX_FRAMES_IN_FLIGHT)
+		{
+			UINT64 oldestFrame = allocator.GetOldestPendingFrame();
+			ID3D11Query* query = frameQueries[oldestFrame % DXT_MAX_FRAMES_IN_FLIGHT];
+			HRESULT queryResult = context->GetData(query, nullptr, 0, 0);
+
+			while (queryResult == S_FALSE)
+			{
+				Sleep(DXT_FRAME_WAIT_POLL_MILLISECONDS);
+				queryResult = context->GetData(query, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+			}
+
+			// A removed device never completes the query
+			if (FAILED(queryResult))
+				return queryResult;
+
+			allocator.ReleaseFrames(oldestFrame);
+		}
+
+		// Discarding is still the cheapest way to start over once nothing is in flight
+		if (allocator.GetUsedSize() != 0)
+			mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	}
+	else
+	{
+		allocator.ReleaseAll();
+	}
+
+	D3D11_MAPPED_SUBRESOURCE subres;
+	HRESULT result = context->Map(buffer, 0, mapType, 0, &subres);
+	if (FAILED(result))
+		return result;
+
+	mappedData = static_cast<BYTE*>(subres.pData);
+	return S_OK;
+}
+
+void* DXTConstantBufferRing::Allocate(const size_t size, UINT* firstConstantOut, UINT* constantCountOut)
+{
+	size_t offset;
+	if (!mappedData || !allocator.Allocate(size, &offset))
+		return nullptr;
+
+	size_t alignedSize = (size + DXT_CONSTANT_BUFFER_ALIGNMENT - 1) / DXT_CONSTANT_BUFFER_ALIGNMENT * DXT_CONSTANT_BUFFER_ALIGNMENT;
+	*firstConstantOut = static_cast<UINT>(offset / 16);
+	*constantCountOut = static_cast<UINT>(alignedSize / 16);
+
+	return mappedData + offset;
+}
+
+void DXTConstantBufferRing::Unmap(ID3D11DeviceContext* context)
+{
+	context->Unmap(buffer, 0);
+	mappedData = nullptr;
+}
+
+void DXTConstantBufferRing::EndFrame(ID3D11DeviceContext* context)
+{
+	context->End(frameQueries[frameIndex % DXT_MAX_FRAMES_IN_FLIGHT]);
+	allocator.EndFrame(frameIndex);
+	++frameIndex;
+}
+
+void DXTConstantBufferRing::ReleaseCompletedFrames(ID3D11DeviceContext* context)
+{
+	while (allocator.GetPendingFrameCount() > 0)
+	{
+		UINT64 oldestFrame = allocator.GetOldestPendingFrame();
+		if (context->GetData(frameQueries[oldestFrame % DXT_MAX_FRAMES_IN_FLIGHT], nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			break;
+
+		allocator.ReleaseFrames(oldestFrame);
+	}
+}
+
+DXTGeometryPool::DXTGeometryPool() :
+	device(nullptr),
+	vertexStride(0),
+	indexType(DXTIndexTypeInt),
+	indexSize(sizeof(UINT)),
+	pageVertexCount(0),
+	pageIndexCount(0)
+{
+}
+
+HRESULT DXTGeometryPool::Initialize(ID3D11Device* device, const UINT vertexStride, const DXTIndexType indexType,
+	const UINT pageVertexCount, const UINT pageIndexCount)
+{
+	this->device = device;
+	this->vertexStride = vertexStride;
+	this->indexType = indexType;
+	this->pageVertexCount = pageVertexCount;
+	this->pageIndexCount = pageIndexCount;
+	indexSize = indexType == DXTIndexTypeShort ? sizeof(UINT16) : sizeof(UINT);
+
+	UINT page;
+	return AddPage(pageVertexCount, pageIndexCount, &page);
+}
+
+void DXTGeometryPool::Release()
+{
+	for (UINT i = 0; i < pages.size(); ++i)
+		ReleasePage(i);
+
+	pages.clear();
+	ranges.clear();
+	freeHandles.clear();
+}
+
+HRESULT DXTGeometryPool::Allocate(ID3D11DeviceContext* context, const void* vertices, const UINT vertexCount,
+	const void* indices, const UINT indexCount, UINT* handleOut)
+{
+	if (vertexCount == 0 || indexCount == 0)
+		return E_INVALIDARG;
+
+	Range range;
+	bool bPlaced = false;
+	for (UINT i = 0; i < pages.size() && !bPlaced; ++i)
+		bPlaced = AllocateInPage(i, vertexCount, indexCount, &range);
+
+	if (!bPlaced)
+	{
+		UINT page;
+		HRESULT result = AddPage(vertexCount, indexCount, &page);
+		if (FAILED(result))
+			return result;
+
+		AllocateInPage(page, vertexCount, indexCount, &range);
+	}
+
+	const Page& page = pages[range.Page];
+	D3D11_BOX vertexBox = { range.Vertices.Offset * vertexStride, 0, 0, (range.Vertices.Offset + vertexCount) * vertexStride, 1, 1 };
+	D3D11_BOX indexBox = { range.Indices.Offset * indexSize, 0, 0, (range.Indices.Offset + indexCount) * indexSize, 1, 1 };
+	context->UpdateSubresource(page.VertexBuffer, 0, &vertexBox, vertices, 0, 0);
+	context->UpdateSubresource(page.IndexBuffer, 0, &indexBox, indices, 0, 0);
+
+	if (freeHandles.empty())
+	{
+		*handleOut = static_cast<UINT>(ranges.size());
+		ranges.push_back(range);
+	}
+	else
+	{
+		*handleOut = freeHandles.back();
+		freeHandles.pop_back();
+		ranges[*handleOut] = range;
+	}
+
+	return S_OK;
+}
+
+void DXTGeometryPool::Free(const UINT handle)
+{
+	FreeInPage(ranges[handle]);
+	ranges[handle].Page = DXT_GEOMETRY_POOL_NULL_HANDLE;
+	freeHandles.push_back(handle);
+}
+
+size_t DXTGeometryPool::Defragment(ID3D11DeviceContext* context, const size_t maxBytes, vector<UINT>* movedHandlesOut)
+{
+	// Buffers can't be copied onto themselves, so instead of compacting a page in place the
+	// emptiest page is moved into the others until it can be released
+	UINT source = DXT_GEOMETRY_POOL_NULL_HANDLE;
+	float sourceUsage = DXT_GEOMETRY_POOL_DEFRAG_USAGE;
+	size_t livePageCount = 0;
+
+	for (UINT i = 0; i < pages.size(); ++i)
+	{
+		Page& page = pages[i];
+		if (!page.VertexBuffer)
+			continue;
+
+		++livePageCount;
+		float vertexUsage = 1.0f - (float)page.VertexAllocator.GetFreeSize() / page.VertexAllocator.GetSize();
+		float indexUsage = 1.0f - (float)page.IndexAllocator.GetFreeSize() / page.IndexAllocator.GetSize();
+		float usage = max(vertexUsage, indexUsage);
+
+		page.LowUsageFrames = usage < DXT_GEOMETRY_POOL_DEFRAG_USAGE ? page.LowUsageFrames + 1 : 0;
+		if (page.LowUsageFrames >= DXT_GEOMETRY_POOL_DEFRAG_FRAMES && usage < sourceUsage)
+		{
+			source = i;
+			sourceUsage = usage;
+		}
+	}
+
+	if (source == DXT_GEOMETRY_POOL_NULL_HANDLE || livePageCount < 2)
+		return 0;
+
+	size_t copiedBytes = 0;
+	for (UINT handle = 0; handle < ranges.size() && copiedBytes < maxBytes; ++handle)
+	{
+		Range& range = ranges[handle];
+		if (range.Page != source)
+			continue;
+
+		Range target;
+		bool bPlaced = false;
+		for (UINT i = 0; i < pages.size() && !bPlaced; ++i)
+			bPlaced = i != source && AllocateInPage(i, range.VertexCount, range.IndexCount, &target);
+
+		// The other pages are full, trying again later is all that's left
+		if (!bPlaced)
+			break;
+
+		D3D11_BOX vertexBox = { range.Vertices.Offset * vertexStride, 0, 0, (range.Vertices.Offset + range.VertexCount) * vertexStride, 1, 1 };
+		D3D11_BOX indexBox = { range.Indices.Offset * indexSize, 0, 0, (range.Indices.Offset + range.IndexCount) * indexSize, 1, 1 };
+		context->CopySubresourceRegion(pages[target.Page].VertexBuffer, 0, target.Vertices.Offset * vertexStride, 0, 0,
+			pages[source].VertexBuffer, 0, &vertexBox);
+		context->CopySubresourceRegion(pages[target.Page].IndexBuffer, 0, target.Indices.Offset * indexSize, 0, 0,
+			pages[source].IndexBuffer, 0, &indexBox);
+
+		// Commands run in order, so draws submitted earlier still read the old range before it is reused
+		FreeInPage(range);
+		range = target;
+		movedHandlesOut->push_back(handle);
+		copiedBytes += range.VertexCount * vertexStride + range.IndexCount * indexSize;
+	}
+
+	if (pages[source].RangeCount == 0)
+		ReleasePage(source);
+
+	return copiedBytes;
+}
+
+void DXTGeometryPool::GetLocation(const UINT handle, DXTGeometryLocation* locationOut) const
+{
+	const Range& range = ranges[handle];
+	const Page& page = pages[range.Page];
+
+	locationOut->VertexBuffer = page.VertexBuffer;
+	locationOut->IndexBuffer = page.IndexBuffer;
+	locationOut->StartIndex = range.Indices.Offset;
+	locationOut->BaseVertex = static_cast<INT>(range.Vertices.Offset);
+	locationOut->IndexCount = range.IndexCount;
+}
+
+size_t DXTGeometryPool::GetPageCount() const
+{
+	size_t count = 0;
+	for (auto& page : pages)
+		count += page.VertexBuffer ? 1 : 0;
+
+	return count;
+}
+
+HRESULT DXTGeometryPool::AddPage(const UINT vertexCount, const UINT indexCount, UINT* pageOut)
+{
+	// Meshes larger than a page get a page of their own size
+	UINT vertexCapacity = max(vertexCount, pageVertexCount);
+	UINT indexCapacity = max(indexCount, pageIndexCount);
+
+	ID3D11Buffer* vertexBuffer;
+	ID3D11Buffer* indexBuffer;
+	HRESULT result = DXTCreateBuffer(device, vertexCapacity * vertexStride, D3D11_BIND_VERTEX_BUFFER, 0, D3D11_USAGE_DEFAULT, &vertexBuffer);
+	if (FAILED(result))
+		return result;
+
+	result = DXTCreateBuffer(device, indexCapacity * indexSize, D3D11_BIND_INDEX_BUFFER, 0, D3D11_USAGE_DEFAULT, &indexBuffer);
+	if (FAILED(result))
+	{
+		vertexBuffer->Release();
+		return result;
+	}
+
+	UINT index = 0;
+	while (index < pages.size() && pages[index].VertexBuffer)
+		++index;
+
+	if (index == pages.size())
+		pages.emplace_back();
+
+	Page& page = pages[index];
+	page.VertexBuffer = vertexBuffer;
+	page.IndexBuffer = indexBuffer;
+	page.VertexAllocator.Reset(vertexCapacity);
+	page.IndexAllocator.Reset(indexCapacity);
+	page.RangeCount = 0;
+	page.LowUsageFrames = 0;
+
+	*pageOut = index;
+	return S_OK;
+}
+
+void DXTGeometryPool::ReleasePage(const UINT page)
+{
+	if (!pages[page].VertexBuffer)
+		return;
+
+	pages[page].VertexBuffer->Release();
+	pages[page].IndexBuffer->Release();
+	pages[page].VertexBuffer = nullptr;
+	pages[page].IndexBuffer = nullptr;
+	pages[page].VertexAllocator.Reset(0);
+	pages[page].IndexAllocator.Reset(0);
+}
+
+bool DXTGeometryPool::AllocateInPage(const UINT page, const UINT vertexCount, const UINT indexCount, Range* rangeOut)
+{
+	Page& target = pages[page];
+	if (!target.VertexBuffer)
+		return false;
+
+	DXTOffsetAllocation vertices;
+	DXTOffsetAllocation indices;
+	if (!target.VertexAllocator.Allocate(vertexCount, &vertices))
+		return false;
+
+	if (!target.IndexAllocator.Allocate(indexCount, &indices))
+	{
+		target.VertexAllocator.Free(vertices);
+		return false;
+	}
+
+	rangeOut->Page = page;
+	rangeOut->Vertices = vertices;
+	rangeOut->Indices = indices;
+	rangeOut->VertexCount = vertexCount;
+	rangeOut->IndexCount = indexCount;
+	++target.RangeCount;
+	return true;
+}
+
+void DXTGeometryPool::FreeInPage(const Range& range)
+{
+	Page& page = pages[range.Page];
+	page.VertexAllocator.Free(range.Vertices);
+	page.IndexAllocator.Free(range.Indices);
+	--page.RangeCount;
+}
+
+void DXTInputHandlerDefault::AddInputInterface(DXTInputEventInterface * obj)
+{
+	inputInterfaces.push_back(obj);
+}
+
+void DXTInputHandlerDefault::ClearInterfaces()
+{
+	inputInterfaces.clear();
+}
+
+void DXTInputHandlerDefault::OnMouseDown(const DXTMouseEventArgs & mouseEvent)
+{
+	for (auto obj : inputInterfaces)
+		obj->OnMouseDown(mouseEvent);
+}
+
+void DXTInputHandlerDefault::OnMouseUp(const DXTMouseEventArgs & mouseEvent)
+{
+	for (auto obj : inputInterfaces)
+		obj->OnMouseUp(mouseEvent);
+}
+
+void DXTInputHandlerDefault::OnMouseMove(const DXTMouseMoveEventArgs & mouseEvent)
+{
+	for (auto obj : inputInterfaces)
+		obj->OnMouseMove(mouseEvent);
+}
+
+void DXTInputHandlerDefault::OnKeyDown(const DXTKeyEventArgs & keyEvent)
+{
+	for (auto obj : inputInterfaces)
+		obj->OnKeyDown(keyEvent);
+}
+
+void DXTInputHandlerDefault::OnKeyUp(const DXTKeyEventArgs & keyEvent)
+{
+	for (auto obj : inputInterfaces)
+		obj->OnKeyUp(keyEvent);
+}
+
+DXTWindowEventHandlerDefault::DXTWindowEventHandlerDefault() :
+	swapChain(nullptr)
+{
+}
+
+void DXTWindowEventHandlerDefault::SetSwapChain(IDXGISwapChain * chain)
 {
 	swapChain = chain;
 }
@@ -1329,3 +3775,53 @@ void DXTCameraBase::GetViewProjectionMatrix(DirectX::XMFLOAT4X4 * matrixOut, con
 	XMMATRIX resultMat = XMMatrixMultiply(viewMat, projMat);
 	XMStoreFloat4x4(matrixOut, resultMat);
 }
+
+void DXTCameraBase::GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize)
+{
+	XMFLOAT4X4 viewProj;
+	GetViewProjectionMatrix(&viewProj, viewportSize);
+	DXTConstructFrustumFromMatrix(XMLoadFloat4x4(&viewProj), frustum);
+}
+
+void DXTCameraBase::GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize, const float nearPlane, const float farPlane)
+{
+	XMFLOAT4X4 view;
+	XMFLOAT4X4 proj;
+	GetViewMatrix(&view);
+	GetProjectionMatrix(&proj, viewportSize, nearPlane, farPlane);
+	XMMATRIX resultMat = XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&proj));
+	DXTConstructFrustumFromMatrix(resultMat, frustum);
+}
+
+DXTProjectionScale DXTCameraBase::GetProjectionScale(const DXTExtent2D& viewportSize)
+{
+	// The second diagonal element is 1 / tan(fov / 2) for perspective projections and 2 / view height for
+	// orthographic ones, which leave w at one
+	XMFLOAT4X4 proj;
+	GetProjectionMatrix(&proj, viewportSize);
+
+	DXTProjectionScale scale = { 0.5f * viewportSize.Height * proj._22, proj._44 != 0.0f };
+	return scale;
+}
+
+void DXTCameraBase::GetCascadeFrustums(DXTFrustum* frustumsOut, const DXTExtent2D& viewportSize)
+{
+	const DXTCameraShadowInfo* shadowInfo = GetShadowInfo();
+	size_t cascadeCount = shadowInfo->Cascades.size();
+	assert(cascadeCount <= DXT_MAX_SHADOW_CASCADES);
+
+	XMFLOAT4X4 view;
+	GetViewMatrix(&view);
+	XMMATRIX viewMat = XMLoadFloat4x4(&view);
+
+	// Called every frame, the cascade count is bounded so the matrices stay on the stack
+	XMFLOAT4X4 viewProjections[DXT_MAX_SHADOW_CASCADES];
+	for (size_t i = 0; i < cascadeCount; ++i)
+	{
+		XMFLOAT4X4 proj;
+		GetProjectionMatrix(&proj, viewportSize, shadowInfo->Cascades[i].NearPlane, shadowInfo->Cascades[i].FarPlane);
+		XMStoreFloat4x4(&viewProjections[i], XMMatrixMultiply(viewMat, XMLoadFloat4x4(&proj)));
+	}
+
+	DXTConstructFrustumsFromMatrices(viewProjections, cascadeCount, frustumsOut);
+}
@@ -1,39 +1,60 @@
 #pragma once
 
+#include <climits>
+#include <deque>
 #include <set>
 #include <string>
 #include <vector>
 
+#ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
+#endif
 #include <Windows.h>
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <DirectXMath.h>
 
+#include "CommandStream.h"
+#include "FrameGraph.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "OffsetAllocator.h"
+#include "RingAllocator.h"
+#include "StateObjectTable.h"
+#include "ToolboxTypes.h"
+#include "VertexLayout.h"
+#include "WorkerPool.h"
+
 #define DXT_BLIT_VERTEX_COUNT 6
+#define DXT_BOUNDS_MASK_WORD_COUNT(count) (((count) + 31) / 32)
+#define DXT_FRUSTUM_PLANE_MASK_ALL 0x3F
+// Must stay a multiple of the 32 bounds culled per mask word
+#define DXT_PARALLEL_CULL_CHUNK_SIZE 2048
+// Cascade membership is stored as one bit per cascade in a byte
+#define DXT_MAX_SHADOW_CASCADES 8
+#define DXT_MAX_FRAMES_IN_FLIGHT 3
+// How long the CPU sleeps between polls while it waits for the GPU to finish a frame
+#define DXT_FRAME_WAIT_POLL_MILLISECONDS 1
+// Constant buffer offsets are given in 16 byte constants and have to be multiples of 16 constants
+#define DXT_CONSTANT_BUFFER_ALIGNMENT 256
+#define DXT_GEOMETRY_POOL_NULL_HANDLE 0xFFFFFFFF
+// Defragmentation empties pages filled less than this into the other pages
+#define DXT_GEOMETRY_POOL_DEFRAG_USAGE 0.5f
+// Defragment calls a page has to stay below that usage for, so pages just added for a mesh the others had no
+// room for aren't emptied and added again while loading goes on
+#define DXT_GEOMETRY_POOL_DEFRAG_FRAMES 60
+// Frames a released render target is kept around without being acquired again
+#define DXT_RENDER_TARGET_POOL_MAX_UNUSED_FRAMES 3
 
 class DXTWindow;
 
-struct DXTExtent2D
-{
-	int Width;
-	int Height;
-};
-
-struct DXTBounds
-{
-	DirectX::XMFLOAT3 Lower;
-	DirectX::XMFLOAT3 Upper;
-};
-
-struct DXTPlane
-{
-	DirectX::XMFLOAT3 Normal;
-	float Distance;
-};
-
-struct DXTFrustum
+// Turns the size of bounds into pixels. Perspective projections divide by the distance to the camera,
+// orthographic ones don't, so their scale is simply pixels per world unit.
+struct DXTProjectionScale
 {
-	DXTPlane Planes[6];
+	// Pixels covered by one world unit, at distance one for perspective projections
+	float Scale;
+	bool bOrthographic;
 };
 
 struct DXTShadowCascadeInfo
@@ -51,13 +72,18 @@ class DXTCameraBase
 {
 public:
 	void GetViewProjectionMatrix(DirectX::XMFLOAT4X4* matrixOut, const DXTExtent2D& viewportSize);
+	// One frustum per cascade of the shadow info, which holds at most DXT_MAX_SHADOW_CASCADES
+	void GetCascadeFrustums(DXTFrustum* frustumsOut, const DXTExtent2D& viewportSize);
 	virtual void GetPosition(DirectX::XMFLOAT3* positionOut) = 0;
 	virtual void GetViewDirection(DirectX::XMFLOAT3* directionOut) = 0;
 	virtual void GetViewMatrix(DirectX::XMFLOAT4X4* matrixOut) = 0;
 	virtual void GetProjectionMatrix(DirectX::XMFLOAT4X4* matrixOut, const DXTExtent2D& viewportSize) = 0;
-	virtual void GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize) = 0;
-	virtual void GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize, const float nearPlane, const float farPlane) = 0;
+	virtual void GetProjectionMatrix(DirectX::XMFLOAT4X4* matrixOut, const DXTExtent2D& viewportSize, const float nearPlane, const float farPlane) = 0;
+	virtual void GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize);
+	virtual void GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize, const float nearPlane, const float farPlane);
 	virtual const DXTCameraShadowInfo* GetShadowInfo() const = 0;
+	// Works for perspective and orthographic projection matrices alike
+	DXTProjectionScale GetProjectionScale(const DXTExtent2D& viewportSize);
 };
 
 class DXTSphericalCamera : public DXTCameraBase
@@ -81,8 +107,7 @@ public:
 	void GetViewMatrix(DirectX::XMFLOAT4X4* matrixOut) override;
 	void GetViewDirection(DirectX::XMFLOAT3* directionOut) override;
 	void GetProjectionMatrix(DirectX::XMFLOAT4X4* matrixOut, const DXTExtent2D& viewportSize) override;
-	void GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize) override;
-	void GetFrustum(DXTFrustum* frustum, const DXTExtent2D& viewportSize, const float nearPlane, const float farPlane) override;
+	void GetProjectionMatrix(DirectX::XMFLOAT4X4* matrixOut, const DXTExtent2D& viewportSize, const float nearPlane, const float farPlane) override;
 	virtual const DXTCameraShadowInfo* GetShadowInfo() const override;
 
 	void GetForward(DirectX::XMFLOAT3* vecOut);
@@ -266,19 +291,471 @@ public:
 	void Destroy();
 };
 
-enum DXTVertexAttrubuteChannel
+// Everything a draw needs bound apart from buffers, a null blend state means the default one
+struct DXTPipelineState
+{
+	ID3D11VertexShader* VertexShader;
+	ID3D11PixelShader* PixelShader;
+	ID3D11InputLayout* InputLayout;
+	ID3D11RasterizerState* RasterizerState;
+	ID3D11DepthStencilState* DepthStencilState;
+	ID3D11BlendState* BlendState;
+	D3D11_PRIMITIVE_TOPOLOGY Topology;
+};
+
+enum DXTShaderStage
+{
+	DXTShaderStageVertex,
+	DXTShaderStagePixel,
+	DXTShaderStageCount
+};
+
+// State calls requested from the cache, the ones dropped as redundant and the ones sent to the context.
+// Binds collapsed into a ranged call count once in IssuedCalls.
+struct DXTStateCacheStats
+{
+	UINT RequestedCalls;
+	UINT FilteredCalls;
+	UINT IssuedCalls;
+};
+
+// Shadows the state bound to a context and drops calls that would not change it. Buffer, resource and
+// sampler binds are held back until the next draw, so binds to neighbouring slots go out as one ranged
+// call. Anything bound to the context behind the cache's back has to be followed by Reset.
+class DXTStateCache
+{
+public:
+	DXTStateCache();
+
+	HRESULT Initialize(ID3D11DeviceContext* context);
+	void Release();
+
+	// Starts a new set of counters
+	void BeginFrame();
+	// Clears the state of the context along with the shadowed state
+	void Reset();
+
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetInputLayout(ID3D11InputLayout* inputLayout);
+	void SetPrimitiveTopology(const D3D11_PRIMITIVE_TOPOLOGY topology);
+	void SetRasterizerState(ID3D11RasterizerState* state);
+	void SetDepthStencilState(ID3D11DepthStencilState* state, const UINT stencilRef);
+	// A null blendFactor means all ones, like OMSetBlendState
+	void SetBlendState(ID3D11BlendState* state, const FLOAT* blendFactor, const UINT sampleMask);
+	void SetPipelineState(const DXTPipelineState& pipeline);
+	void SetRenderTargets(const UINT count, ID3D11RenderTargetView* const* renderTargets, ID3D11DepthStencilView* depthStencil);
+	void SetViewports(const UINT count, const D3D11_VIEWPORT* viewports);
+
+	void SetVertexBuffer(const UINT slot, ID3D11Buffer* buffer, const UINT stride, const UINT offset);
+	void SetIndexBuffer(ID3D11Buffer* buffer, const DXGI_FORMAT format, const UINT offset);
+	void SetConstantBuffer(const DXTShaderStage stage, const UINT slot, ID3D11Buffer* buffer);
+	// Binds a window of constantCount 16 byte constants, requires D3D11.1
+	void SetConstantBuffer(const DXTShaderStage stage, const UINT slot, ID3D11Buffer* buffer,
+		const UINT firstConstant, const UINT constantCount);
+	void SetShaderResource(const DXTShaderStage stage, const UINT slot, ID3D11ShaderResourceView* resource);
+	void SetSampler(const DXTShaderStage stage, const UINT slot, ID3D11SamplerState* sampler);
+
+	void Draw(const UINT vertexCount, const UINT startVertex);
+	void DrawIndexed(const UINT indexCount, const UINT startIndex, const INT baseVertex);
+	void DrawIndexedInstanced(const UINT indexCount, const UINT instanceCount, const UINT startIndex,
+		const INT baseVertex, const UINT startInstance);
+	// Lets the driver drop the contents of the view, does nothing without D3D11.1
+	void DiscardView(ID3D11View* view);
+
+	inline ID3D11DeviceContext* GetContext() const;
+	inline const DXTStateCacheStats& GetStats() const;
+
+private:
+	// Slots that changed since the last draw lie within [First, End)
+	struct DirtyRange
+	{
+		UINT First;
+		UINT End;
+
+		inline void Add(const UINT slot);
+		inline void Clear();
+	};
+
+	struct StageBindings
+	{
+		ID3D11Buffer* ConstantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		UINT FirstConstants[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		UINT ConstantCounts[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		ID3D11ShaderResourceView* Resources[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+		ID3D11SamplerState* Samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+		DirtyRange ConstantBufferRange;
+		DirtyRange ResourceRange;
+		DirtyRange SamplerRange;
+	};
+
+	ID3D11DeviceContext* context;
+	ID3D11DeviceContext1* context1;
+	DXTStateCacheStats stats;
+
+	ID3D11VertexShader* vertexShader;
+	ID3D11PixelShader* pixelShader;
+	ID3D11InputLayout* inputLayout;
+	D3D11_PRIMITIVE_TOPOLOGY topology;
+	ID3D11RasterizerState* rasterizerState;
+	ID3D11DepthStencilState* depthStencilState;
+	UINT stencilRef;
+	ID3D11BlendState* blendState;
+	FLOAT blendFactor[4];
+	UINT sampleMask;
+	ID3D11RenderTargetView* renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+	UINT renderTargetCount;
+	ID3D11DepthStencilView* depthStencilView;
+	D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+	UINT viewportCount;
+
+	ID3D11Buffer* vertexBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+	UINT vertexStrides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+	UINT vertexOffsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+	DirtyRange vertexBufferRange;
+	ID3D11Buffer* indexBuffer;
+	DXGI_FORMAT indexFormat;
+	UINT indexOffset;
+	StageBindings stages[DXTShaderStageCount];
+
+	void ResetShadowState();
+	bool Filter(const bool bRedundant);
+	void UnbindOutputResources();
+	void FlushBindings();
+	void FlushStageBindings(const DXTShaderStage stage);
+};
+
+// Replays command lists through a state cache, pipeline handles are DXTPipelineState pointers and buffer
+// handles are ID3D11Buffer pointers
+class DXTD3D11CommandBackend : public DXTCommandBackend
+{
+public:
+	DXTD3D11CommandBackend(DXTStateCache* stateCache);
+
+	void SetPipeline(const DXTSetPipelineCommand& command) override;
+	void SetVertexBuffer(const DXTSetVertexBufferCommand& command) override;
+	void SetIndexBuffer(const DXTSetIndexBufferCommand& command) override;
+	void SetConstantBuffer(const DXTSetConstantBufferCommand& command) override;
+	void UpdateConstants(const DXTUpdateConstantsCommand& command, const void* data) override;
+	void DrawIndexed(const DXTDrawIndexedCommand& command) override;
+	void DrawIndexedInstanced(const DXTDrawIndexedInstancedCommand& command) override;
+
+private:
+	DXTStateCache* stateCache;
+};
+
+// A pipeline by value. Shaders are given as bytecode and need to stay loaded only for the call.
+struct DXTPipelineDesc
+{
+	const DXTBytecodeBlob* VertexShader;
+	const DXTBytecodeBlob* PixelShader;
+	const D3D11_INPUT_ELEMENT_DESC* InputElements;
+	UINT InputElementCount;
+	D3D11_RASTERIZER_DESC Rasterizer;
+	D3D11_DEPTH_STENCIL_DESC DepthStencil;
+	D3D11_BLEND_DESC Blend;
+	D3D11_PRIMITIVE_TOPOLOGY Topology;
+};
+
+// Creates every state object, shader and input layout once per distinct description. Objects are
+// returned with a reference added for the caller, the cache holds its own until Release. Pipelines
+// are built from shared objects, so equal pipelines come back as the same DXTPipelineState.
+class DXTStateObjectCache
+{
+public:
+	DXTStateObjectCache();
+
+	void Initialize(ID3D11Device* device);
+	void Release();
+
+	HRESULT GetRasterizerState(const D3D11_RASTERIZER_DESC& desc, ID3D11RasterizerState** output);
+	HRESULT GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc, ID3D11DepthStencilState** output);
+	HRESULT GetBlendState(const D3D11_BLEND_DESC& desc, ID3D11BlendState** output);
+	HRESULT GetSamplerState(const D3D11_SAMPLER_DESC& desc, ID3D11SamplerState** output);
+	HRESULT GetVertexShader(const DXTBytecodeBlob& bytecode, ID3D11VertexShader** output);
+	HRESULT GetPixelShader(const DXTBytecodeBlob& bytecode, ID3D11PixelShader** output);
+	HRESULT GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, const UINT elementCount,
+		const DXTBytecodeBlob& vertexShaderCode, ID3D11InputLayout** output);
+	// The pipeline belongs to the cache and stays valid until Release
+	HRESULT GetPipelineState(const DXTPipelineDesc& desc, const DXTPipelineState** output);
+
+	// Distinct objects created, pipelines included
+	size_t GetObjectCount() const;
+
+private:
+	ID3D11Device* device;
+	DXTStateKey key;
+
+	DXTStateObjectTable rasterizerStates;
+	DXTStateObjectTable depthStencilStates;
+	DXTStateObjectTable blendStates;
+	DXTStateObjectTable samplerStates;
+	DXTStateObjectTable vertexShaders;
+	DXTStateObjectTable pixelShaders;
+	DXTStateObjectTable inputLayouts;
+	DXTStateObjectTable pipelineStates;
+	// Deque so handed out pipelines never move
+	std::deque<DXTPipelineState> pipelines;
+};
+
+// Dynamic constant buffer that per draw constants are suballocated from. The whole buffer is mapped
+// once per frame and draws bind windows of it with VSSetConstantBuffers1. Event queries fence every
+// frame, so ranges the GPU may still read are never handed out again.
+class DXTConstantBufferRing
+{
+public:
+	DXTConstantBufferRing();
+
+	HRESULT Initialize(ID3D11Device* device, const size_t size);
+	void Release();
+
+	HRESULT Map(ID3D11DeviceContext* context);
+	// Returns nullptr when the ring is full
+	void* Allocate(const size_t size, UINT* firstConstantOut, UINT* constantCountOut);
+	void Unmap(ID3D11DeviceContext* context);
+	// Call after the draws using this frame's allocations were submitted
+	void EndFrame(ID3D11DeviceContext* context);
+
+	inline ID3D11Buffer* GetBuffer() const;
+
+private:
+	ID3D11Buffer* buffer;
+	ID3D11Query* frameQueries[DXT_MAX_FRAMES_IN_FLIGHT];
+	DXTRingAllocator allocator;
+	BYTE* mappedData;
+	UINT64 frameIndex;
+	// Without D3D11.1 driver support every Map has to discard, which also frees the whole ring
+	bool bNoOverwriteSupported;
+
+	void ReleaseCompletedFrames(ID3D11DeviceContext* context);
+};
+
+// Where pooled geometry lives, draws pass StartIndex and BaseVertex with the buffers bound at offset zero
+struct DXTGeometryLocation
+{
+	ID3D11Buffer* VertexBuffer;
+	ID3D11Buffer* IndexBuffer;
+	UINT StartIndex;
+	INT BaseVertex;
+	UINT IndexCount;
+};
+
+// Suballocates the vertices and indices of many meshes from a few large buffers, so draws share buffer
+// bindings and loading a mesh creates no buffers. Ranges are placed with offset allocators, one per buffer.
+// Pages that ran mostly empty are moved into the others a little at a time and then released.
+class DXTGeometryPool
+{
+public:
+	DXTGeometryPool();
+
+	HRESULT Initialize(ID3D11Device* device, const UINT vertexStride, const DXTIndexType indexType,
+		const UINT pageVertexCount, const UINT pageIndexCount);
+	void Release();
+
+	// Indices are relative to the mesh's first vertex. A page is added when none has room.
+	HRESULT Allocate(ID3D11DeviceContext* context, const void* vertices, const UINT vertexCount,
+		const void* indices, const UINT indexCount, UINT* handleOut);
+	void Free(const UINT handle);
+	// Moves geometry out of the emptiest page until maxBytes were copied, returns the bytes copied. Called once a
+	// frame, only pages that stayed below DXT_GEOMETRY_POOL_DEFRAG_USAGE for DXT_GEOMETRY_POOL_DEFRAG_FRAMES calls
+	// are emptied. Handles whose location changed are appended to movedHandlesOut.
+	size_t Defragment(ID3D11DeviceContext* context, const size_t maxBytes, std::vector<UINT>* movedHandlesOut);
+
+	void GetLocation(const UINT handle, DXTGeometryLocation* locationOut) const;
+	inline UINT GetVertexStride() const;
+	inline DXTIndexType GetIndexType() const;
+	size_t GetPageCount() const;
+
+private:
+	struct Page
+	{
+		// Both null once the page was released, the slot is reused by the next page added
+		ID3D11Buffer* VertexBuffer;
+		ID3D11Buffer* IndexBuffer;
+		DXTOffsetAllocator VertexAllocator;
+		DXTOffsetAllocator IndexAllocator;
+		size_t RangeCount;
+		// Consecutive Defragment calls that found the page below the usage threshold
+		UINT LowUsageFrames;
+	};
+
+	struct Range
+	{
+		UINT Page;
+		DXTOffsetAllocation Vertices;
+		DXTOffsetAllocation Indices;
+		UINT VertexCount;
+		UINT IndexCount;
+	};
+
+	ID3D11Device* device;
+	UINT vertexStride;
+	DXTIndexType indexType;
+	UINT indexSize;
+	UINT pageVertexCount;
+	UINT pageIndexCount;
+
+	std::vector<Page> pages;
+	std::vector<Range> ranges;
+	std::vector<UINT> freeHandles;
+
+	HRESULT AddPage(const UINT vertexCount, const UINT indexCount, UINT* pageOut);
+	void ReleasePage(const UINT page);
+	bool AllocateInPage(const UINT page, const UINT vertexCount, const UINT indexCount, Range* rangeOut);
+	void FreeInPage(const Range& range);
+};
+
+// Textures with equal descriptions are interchangeable in the render target pool
+struct DXTRenderTargetDesc
 {
-	DXTVertexAttributePosition = 1 << 0,
-	DXTVertexAttributeUV = 1 << 1,
-	DXTVertexAttributeNormal = 1 << 2,
-	DXTVertexAttributeTangent = 1 << 3,
-	DXTVertexAttributeBitangent = 1 << 4
+	UINT Width;
+	UINT Height;
+	DXGI_FORMAT Format;
+	UINT BindFlags;
 };
 
-enum DXTIndexType
+// Views are null unless the matching bind flag was given, depth targets that are also shader
+// resources get a typeless texture
+struct DXTRenderTarget
 {
-	DXTIndexTypeShort,
-	DXTIndexTypeInt
+	ID3D11Texture2D* Texture;
+	ID3D11RenderTargetView* RenderTargetView;
+	ID3D11DepthStencilView* DepthStencilView;
+	ID3D11ShaderResourceView* ShaderResourceView;
+};
+
+// Hands out transient render targets. A released target goes back to the pool right away, so passes
+// acquiring targets after an earlier pass released one of the same description get the same texture.
+// Texture memory follows the most targets alive at once rather than the number of passes.
+class DXTRenderTargetPool
+{
+public:
+	DXTRenderTargetPool();
+
+	void Initialize(ID3D11Device* device);
+	void Release();
+
+	// Destroys targets nobody acquired for DXT_RENDER_TARGET_POOL_MAX_UNUSED_FRAMES frames
+	void BeginFrame();
+	HRESULT AcquireTarget(const DXTRenderTargetDesc& desc, UINT* handleOut);
+	void ReleaseTarget(const UINT handle);
+
+	inline const DXTRenderTarget& GetTarget(const UINT handle) const;
+	size_t GetTargetCount() const;
+	// Estimated texture memory of all targets, acquired or not
+	size_t GetTargetBytes() const;
+
+private:
+	struct Entry
+	{
+		// A null texture marks a slot the next new target is created in
+		DXTRenderTargetDesc Desc;
+		DXTRenderTarget Target;
+		UINT64 LastUsedFrame;
+		bool bAcquired;
+	};
+
+	ID3D11Device* device;
+	UINT64 frame;
+	std::vector<Entry> entries;
+
+	HRESULT CreateTarget(const DXTRenderTargetDesc& desc, DXTRenderTarget* targetOut);
+	void DestroyTarget(DXTRenderTarget* target);
+};
+
+// Backs transient frame graph resources with targets from a render target pool, descriptions are
+// DXTRenderTargetDescs. Transient resources are discarded when they first become outputs and the
+// outputs are unbound whenever a resource goes from output to input.
+class DXTD3D11FrameGraphBackend : public DXTFrameGraphBackend
+{
+public:
+	DXTD3D11FrameGraphBackend();
+
+	void Initialize(DXTRenderTargetPool* pool, DXTStateCache* stateCache);
+	// Forgets the targets of the last frame, the storage is kept for the next
+	void Reset();
+	// Imported resources need their target set before the graph executes
+	void SetImportedTarget(const uint32_t resource, const DXTRenderTarget& target);
+	inline const DXTRenderTarget& GetTarget(const uint32_t resource) const;
+
+	void AcquireResource(const uint32_t resource, const DXTFrameGraphResourceDesc& desc) override;
+	void ReleaseResource(const uint32_t resource) override;
+	void Barrier(const DXTFrameGraphBarrier& barrier) override;
+
+private:
+	DXTRenderTargetPool* pool;
+	DXTStateCache* stateCache;
+	std::vector<DXTRenderTarget> targets;
+	// Pool handles of transient resources, DXT_FRAME_GRAPH_NULL_INDEX for imported ones
+	std::vector<UINT> handles;
+
+	void ReserveResource(const uint32_t resource);
+};
+
+// Largest difference between the source channels and what a vertex format stores of them
+struct DXTVertexEncodeError
+{
+	// Per component, in the units of the source
+	float Position;
+	float UV;
+	float NormalDegrees;
+	float TangentDegrees;
+	float BitangentDegrees;
+};
+
+// One mesh handed to DXTPackStaticMesh, channels without data read as zeroes. Indices are relative to the
+// first vertex of the mesh, three per triangle.
+struct DXTStaticMeshSource
+{
+	DXTVertexStream Positions;
+	DXTVertexStream UVs;
+	DXTVertexStream Normals;
+	DXTVertexStream Tangents;
+	DXTVertexStream Bitangents;
+	size_t VertexCount;
+	const uint32_t* Indices;
+	size_t IndexCount;
+	uint32_t MaterialIndex;
+};
+
+// Filled in by DXTCookStaticMesh, measured over all submeshes
+struct DXTMeshCookReport
+{
+	DXTVertexCacheStats SourceCacheStats;
+	DXTVertexCacheStats CookedCacheStats;
+	DXTVertexEncodeError EncodeError;
+	size_t VertexBytes;
+	// What the same channels take as 32 bit floats
+	size_t FloatVertexBytes;
+};
+
+enum DXTFrustumTestResult
+{
+	DXTFrustumTestOutside,
+	DXTFrustumTestIntersecting,
+	DXTFrustumTestInside
+};
+
+enum DXTSimdLevel
+{
+	DXTSimdLevelSSE2,
+	DXTSimdLevelAVX2
+};
+
+struct DXTCullChunk
+{
+	size_t ThreadIndex;
+	size_t ThreadOffset;
+	size_t VisibleCount;
+	size_t OutputOffset;
+};
+
+// Storage reused by DXTCullBoundsStreamParallel between frames
+class DXTParallelCullScratch
+{
+public:
+	std::vector<std::vector<UINT>> ThreadIndices;
+	std::vector<DXTCullChunk> Chunks;
 };
 
 void DXTConstructPlaneFromNormalAndPoint(const DirectX::XMVECTOR& point,
@@ -286,13 +763,72 @@ void DXTConstructPlaneFromNormalAndPoint(const DirectX::XMVECTOR& point,
 void DXTConstructPlaneFromPoints(const DirectX::XMVECTOR& p1, const DirectX::XMVECTOR& p2,
 	const DirectX::XMVECTOR& p3, DXTPlane* planeOut);
 bool DXTIsOutsideFrustum(const DXTBounds& bounds, const DXTFrustum& frustum);
+// planeMask selects the planes to test and receives the planes the bounds still straddle,
+// so it can be handed down to children during hierarchical traversal
+DXTFrustumTestResult DXTClassifyBounds(const DXTBounds& bounds, const DXTFrustum& frustum, UINT* planeMask);
+DXTSimdLevel DXTGetSimdLevel();
+// Caps what DXTGetSimdLevel reports, levels the CPU lacks stay unavailable. Not thread safe, meant for tests.
+void DXTLimitSimdLevel(const DXTSimdLevel level);
+void DXTCullBoundsStreamMask(const DXTBoundsStream& bounds, const DXTFrustum& frustum, UINT32* visibilityMaskOut);
+size_t DXTCullBoundsStreamIndices(const DXTBoundsStream& bounds, const DXTFrustum& frustum, UINT* visibleIndicesOut);
+// Produces the same indices in the same order as DXTCullBoundsStreamIndices
+size_t DXTCullBoundsStreamParallel(DXTWorkerPool* pool, const DXTBoundsStream& bounds, const DXTFrustum& frustum,
+	DXTParallelCullScratch* scratch, UINT* visibleIndicesOut);
+// Tests every bounds against all cascade light frustums in a single pass over the stream. lightDirection points
+// from the light into the scene. Bounds are swept extrusionDistance units along it first, the way their shadows
+// fall, so casters between the light and a cascade volume are kept.
+// cascadeCount is at most DXT_MAX_SHADOW_CASCADES, the bits of cascadeMasksOut. cascadeListsOut has to point to
+// cascadeCount lists, which are filled in stream order.
+void DXTClassifyShadowCasters(const DXTBoundsStream& bounds, const DXTFrustum* cascadeFrustums, const size_t cascadeCount,
+	const DirectX::XMFLOAT3& lightDirection, const float extrusionDistance, UINT8* cascadeMasksOut,
+	std::vector<UINT>* cascadeListsOut);
+// fieldOfView is vertical like XMMatrixPerspectiveFovLH's
+DXTProjectionScale DXTGetProjectionScale(const float fieldOfView, const DXTExtent2D& viewportSize);
+// viewHeight is the height of the view volume in world units like XMMatrixOrthographicLH's
+DXTProjectionScale DXTGetOrthographicProjectionScale(const float viewHeight, const DXTExtent2D& viewportSize);
+// Approximate on screen diameter in pixels of the bounding sphere of the bounds. Perspective projections use the
+// distance to the camera rather than the view depth, so the result doesn't change while the camera turns.
+float DXTGetProjectedSize(const DXTBounds& bounds, const DirectX::XMFLOAT3& cameraPosition, const DXTProjectionScale& projectionScale);
+void DXTComputeProjectedSizes(const DXTBoundsStream& bounds, const DirectX::XMFLOAT3& cameraPosition,
+	const DXTProjectionScale& projectionScale, float* sizesOut);
+// Keeps the candidates whose projected size reaches minPixelSize, visibleIndicesOut may alias candidates
+size_t DXTCullSmallBounds(const DXTBoundsStream& bounds, const UINT* candidates, const size_t candidateCount,
+	const DirectX::XMFLOAT3& cameraPosition, const DXTProjectionScale& projectionScale, const float minPixelSize,
+	UINT* visibleIndicesOut);
+// lodThresholds holds the minimum projected size of each level, from the most detailed level down
+UINT DXTSelectLod(const float projectedSize, const float* lodThresholds, const UINT lodCount);
 void DXTConstructFrustum(const float fieldOfView, const float farPlane, const float nearPlane,
 	const DirectX::XMFLOAT3& cameraPosition, const DirectX::XMFLOAT3& cameraTarget,
 	const DirectX::XMFLOAT3& cameraUp, const float aspectRatio, DXTFrustum* frustumOut);
+void DXTConstructFrustumFromMatrix(const DirectX::XMMATRIX& viewProjection, DXTFrustum* frustumOut);
+void DXTConstructFrustumsFromMatrices(const DirectX::XMFLOAT4X4* viewProjections, const size_t count, DXTFrustum* frustumsOut);
 void DXTTransformBounds(const DirectX::XMMATRIX& matrix, const DXTBounds& bounds, DXTBounds* boundsOut);
+void DXTTransformBoundsBatch(const DXTBounds* bounds, const DirectX::XMFLOAT4X4* matrices, const size_t count,
+	DXTBoundsStreamBuffer* boundsOut);
+// Positions are read from the start of every vertex, vertexStride is given in bytes
+void DXTComputeVertexBounds(const float* vertices, const size_t vertexStride, const size_t vertexCount, DXTBounds* boundsOut);
+void DXTGetMeshFileBounds(const DXTMeshFileBounds& bounds, DXTBounds* boundsOut);
+void DXTSetMeshFileBounds(const DXTBounds& bounds, DXTMeshFileBounds* boundsOut);
+// Quantized positions of meshes loaded by the toolbox are relative to the bounds of the whole file
+void DXTGetVertexEncodeParams(const DXTBounds& bounds, DXTVertexEncodeParams* paramsOut);
+// Identifies the attribute channels and storage formats, cooked files record it so loaders can check the layout
+uint64_t DXTGetVertexFormatHash(const DXTVertexFormat& format);
+// Bytes per vertex of the given DXTVertexAttrubuteChannel flags stored as 32 bit floats
+UINT DXTGetFloatVertexStride(const UINT channelFlags);
+// sources holds format.StreamCount streams like the ones the vertices were interleaved from, errorOut is only raised
+void DXTMeasureVertexEncodeError(const DXTVertexFormat& format, const DXTVertexStream* sources, const void* vertices,
+	const size_t vertexCount, const DXTVertexEncodeParams& params, DXTVertexEncodeError* errorOut);
 
 HRESULT DXTInitDevice(const DXTRenderParams& params, const DXTWindow* window, IDXGISwapChain** swapChainOut,
 	ID3D11Device** deviceOut, ID3D11DeviceContext** deviceContextOut);
+void DXTGetRasterizerDescSolid(D3D11_RASTERIZER_DESC* descOut);
+void DXTGetRasterizerDescWireframe(D3D11_RASTERIZER_DESC* descOut);
+void DXTGetBlendDescOpaque(D3D11_BLEND_DESC* descOut);
+void DXTGetSamplerDescLinearClamp(D3D11_SAMPLER_DESC* descOut);
+void DXTGetSamplerDescLinearWrap(D3D11_SAMPLER_DESC* descOut);
+void DXTGetSamplerDescPointClamp(D3D11_SAMPLER_DESC* descOut);
+void DXTGetDepthStencilDescDepthTestEnabled(D3D11_DEPTH_STENCIL_DESC* descOut);
+void DXTGetDepthStencilDescDepthTestDisabled(D3D11_DEPTH_STENCIL_DESC* descOut);
 HRESULT DXTCreateRasterizerStateSolid(ID3D11Device* device, ID3D11RasterizerState** output);
 HRESULT DXTCreateRasterizerStateWireframe(ID3D11Device* device, ID3D11RasterizerState** output);
 HRESULT DXTCreateSamplerStateLinearClamp(ID3D11Device* device, ID3D11SamplerState** output);
@@ -300,6 +836,7 @@ HRESULT DXTCreateSamplerStateLinearWrap(ID3D11Device* device, ID3D11SamplerState
 HRESULT DXTCreateSamplerStatePointClamp(ID3D11Device* device, ID3D11SamplerState** output);
 HRESULT DXTCreateDepthStencilStateDepthTestEnabled(ID3D11Device* device, ID3D11DepthStencilState** output);
 HRESULT DXTCreateDepthStencilStateDepthTestDisabled(ID3D11Device* device, ID3D11DepthStencilState** output);
+HRESULT DXTBytecodeFromFile(const char* path, DXTBytecodeBlob* bytecodeOutput);
 HRESULT DXTVertexShaderFromFile(ID3D11Device* device, const char* path, ID3D11VertexShader** output);
 HRESULT DXTVertexShaderFromFile(ID3D11Device* device, const char* path, ID3D11VertexShader** output, DXTBytecodeBlob* bytecodeOutput);
 HRESULT DXTPixelShaderFromFile(ID3D11Device* device, const char* path, ID3D11PixelShader** output);
@@ -310,10 +847,40 @@ HRESULT DXTCreateBuffer(ID3D11Device* device, const size_t length, const UINT bi
 	const UINT cpuAccessFlags, const D3D11_USAGE usage, ID3D11Buffer** output);
 HRESULT DXTCreateDepthStencilBuffer(ID3D11Device* device, const size_t width, const size_t height,
 	const DXGI_FORMAT format, ID3D11Texture2D** texture, ID3D11DepthStencilView** depthStencilView);
-HRESULT DXTLoadStaticMeshFromFile(const char* path, const UINT channelFlags, const DXTIndexType indexType, 
-	void** data, size_t* dataLength, void** indexData, size_t* indexDataLength, size_t* indexCount);
-HRESULT DXTLoadStaticMeshFromFile(ID3D11Device* device, const char* path, const UINT channelFlags, const DXTIndexType indexType,
-	ID3D11Buffer** vertexBuffer, ID3D11Buffer** indexBuffer, size_t* indexCount);
+// Packs every source into the same arrays, submeshesOut receives where each one went. Indices are relative to the
+// base vertex of their submesh. boundsOut receives the bounds of all sources, which quantized positions are relative
+// to. boundsOut and errorOut may be null, measuring the encoding error takes a decode of every vertex. Sources with
+// indices past their vertex count or too many vertices for short indices fail with E_INVALIDARG.
+HRESULT DXTPackStaticMesh(const DXTStaticMeshSource* sources, const size_t sourceCount, const DXTVertexFormat& format,
+	const DXTIndexType indexType, void** data, size_t* dataLength, void** indexData, size_t* indexDataLength, size_t* indexCount,
+	std::vector<DXTMeshFileSubmesh>* submeshesOut, DXTBounds* boundsOut, DXTVertexEncodeError* errorOut);
+// Writes the sources out as the submeshes of a .dxtmesh file placed by nodes. Triangles are reordered for the vertex
+// cache and overdraw and vertices for fetch locality. reportOut may be null.
+HRESULT DXTCookStaticMesh(const DXTStaticMeshSource* sources, const size_t sourceCount, const DXTMeshFileNode* nodes,
+	const size_t nodeCount, const char* cookedPath, const DXTVertexFormat& format, const DXTIndexType indexType,
+	DXTMeshCookReport* reportOut);
+// Importing source meshes needs Assimp, builds that only load cooked meshes define DXT_NO_MESH_IMPORT
+#ifndef DXT_NO_MESH_IMPORT
+// Every mesh of the file is packed into the same arrays, submeshesOut receives where each one went. Indices are
+// relative to the base vertex of their submesh. Meshes keep the space of their nodes, nodesOut receives the node
+// hierarchy placing them. boundsOut receives the bounds of the whole file, which quantized positions are relative
+// to. nodesOut, boundsOut and errorOut may be null, measuring the encoding error takes a decode of every vertex.
+HRESULT DXTLoadStaticMeshFromFile(const char* path, const DXTVertexFormat& format, const DXTIndexType indexType, 
+	void** data, size_t* dataLength, void** indexData, size_t* indexDataLength, size_t* indexCount,
+	std::vector<DXTMeshFileSubmesh>* submeshesOut, std::vector<DXTMeshFileNode>* nodesOut, DXTBounds* boundsOut,
+	DXTVertexEncodeError* errorOut);
+HRESULT DXTLoadStaticMeshFromFile(ID3D11Device* device, const char* path, const DXTVertexFormat& format, const DXTIndexType indexType,
+	ID3D11Buffer** vertexBuffer, ID3D11Buffer** indexBuffer, std::vector<DXTMeshFileSubmesh>* submeshesOut,
+	std::vector<DXTMeshFileNode>* nodesOut, DXTBounds* boundsOut);
+// Imports every mesh of the source file and cooks it like the overload above, with the node hierarchy of the file
+HRESULT DXTCookStaticMesh(const char* sourcePath, const char* cookedPath, const DXTVertexFormat& format, const DXTIndexType indexType,
+	DXTMeshCookReport* reportOut);
+#endif
+// Buffers are created straight from the mapped file, without an intermediate copy. nodesOut may be null. Files cooked
+// with another vertex format than the one given fail with E_INVALIDARG, as the input layout wouldn't match.
+HRESULT DXTLoadStaticMeshFromCookedFile(ID3D11Device* device, const char* path, const DXTVertexFormat& format, ID3D11Buffer** vertexBuffer,
+	ID3D11Buffer** indexBuffer, DXTIndexType* indexType, std::vector<DXTMeshFileSubmesh>* submeshesOut,
+	std::vector<DXTMeshFileNode>* nodesOut, DXTBounds* boundsOut);
 HRESULT DXTCreateBlitVertexBuffer(ID3D11Device* device, ID3D11Buffer** bufferOut);
 HRESULT DXTCreateBlitInputLayout(ID3D11Device* device, DXTBytecodeBlob* vertexShaderCode, ID3D11InputLayout** inputLayoutOut);
 HRESULT DXTCreateShadowMap(ID3D11Device* device, const size_t width, const size_t height, ID3D11Texture2D** texture,
@@ -321,6 +888,9 @@ HRESULT DXTCreateShadowMap(ID3D11Device* device, const size_t width, const size_
 HRESULT DXTCreateRenderTarget(ID3D11Device* device, const size_t width, const size_t height, 
 	const DXGI_FORMAT format, ID3D11Texture2D** texture, ID3D11RenderTargetView** renderTargetView,
 	ID3D11ShaderResourceView** shaderResourceView);
+// Bytes per pixel of uncompressed formats. Asserts on formats without a whole number of bytes per pixel,
+// which release builds count as 0.
+size_t DXTGetFormatSize(const DXGI_FORMAT format);
 HRESULT DXTCreateRenderTargetFromBackBuffer(IDXGISwapChain* swapChain, ID3D11Device* device, ID3D11RenderTargetView** renderTargetView);
 
 inline void DXTInputHandlerBase::GetMousePosition(LPPOINT posOut) const
@@ -386,6 +956,53 @@ inline bool DXTInputHandlerBase::IsKeyUp(const WPARAM key)
 	return pressedKeys.find(key) == pressedKeys.end();
 }
 
+inline ID3D11Buffer* DXTConstantBufferRing::GetBuffer() const
+{
+	return buffer;
+}
+
+inline UINT DXTGeometryPool::GetVertexStride() const
+{
+	return vertexStride;
+}
+
+inline DXTIndexType DXTGeometryPool::GetIndexType() const
+{
+	return indexType;
+}
+
+inline const DXTRenderTarget& DXTRenderTargetPool::GetTarget(const UINT handle) const
+{
+	return entries[handle].Target;
+}
+
+inline const DXTRenderTarget& DXTD3D11FrameGraphBackend::GetTarget(const uint32_t resource) const
+{
+	return targets[resource];
+}
+
+inline ID3D11DeviceContext* DXTStateCache::GetContext() const
+{
+	return context;
+}
+
+inline const DXTStateCacheStats& DXTStateCache::GetStats() const
+{
+	return stats;
+}
+
+inline void DXTStateCache::DirtyRange::Add(const UINT slot)
+{
+	First = slot < First ? slot : First;
+	End = slot + 1 > End ? slot + 1 : End;
+}
+
+inline void DXTStateCache::DirtyRange::Clear()
+{
+	First = UINT_MAX;
+	End = 0;
+}
+
 inline bool DXTWindow::QuitMessageReceived() const
 {
 	return bQuitReceived;
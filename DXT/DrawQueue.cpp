@@ -0,0 +1,285 @@
+#include "DrawQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <intrin.h>
+
+using namespace std;
+
+#define DXT_RADIX_DIGIT_BITS 11
+#define DXT_RADIX_MAX_DIGIT_COUNT ((64 + DXT_RADIX_DIGIT_BITS - 1) / DXT_RADIX_DIGIT_BITS)
+#define DXT_RADIX_BUCKET_COUNT (1 << DXT_RADIX_DIGIT_BITS)
+// Packed keys hold up to 32 varying bits gathered from this many runs of the full key
+#define DXT_RADIX_PACKED_MAX_RUNS 4
+#define DXT_RADIX_PACKED_MAX_DIGITS ((32 + DXT_RADIX_DIGIT_BITS - 1) / DXT_RADIX_DIGIT_BITS)
+
+// Two 32 bit scans, x86 builds have no 64 bit one
+static inline size_t DXTLowestSetBit(const uint64_t bits)
+{
+	unsigned long bit;
+	if (_BitScanForward(&bit, static_cast<unsigned long>(bits)))
+		return bit;
+
+	_BitScanForward(&bit, static_cast<unsigned long>(bits >> 32));
+	return bit + 32;
+}
+
+static inline uint64_t DXTDrawKeyField(const uint32_t value, const uint32_t bits)
+{
+	return static_cast<uint64_t>(value) & ((1ull << bits) - 1);
+}
+
+uint64_t DXTMakeDrawKey(const uint32_t pass, const DXTDrawBucket bucket, const uint32_t pipeline,
+	const uint32_t mesh, const float viewDepth)
+{
+	// A wider value would silently merge with others and break the grouping of draws
+	assert(pass < (1u << DXT_DRAW_KEY_PASS_BITS) && static_cast<uint32_t>(bucket) < (1u << DXT_DRAW_KEY_BUCKET_BITS));
+	assert(pipeline < (1u << DXT_DRAW_KEY_PIPELINE_BITS) && mesh < (1u << DXT_DRAW_KEY_MESH_BITS));
+
+	uint64_t key = DXTDrawKeyField(pass, DXT_DRAW_KEY_PASS_BITS);
+	key = (key << DXT_DRAW_KEY_BUCKET_BITS) | DXTDrawKeyField(bucket, DXT_DRAW_KEY_BUCKET_BITS);
+
+	uint32_t depth = DXTQuantizeDrawDepth(viewDepth);
+	if (bucket == DXTDrawBucketTransparent)
+	{
+		depth = ((1u << DXT_DRAW_KEY_DEPTH_BITS) - 1) - depth;
+		key = (key << DXT_DRAW_KEY_DEPTH_BITS) | depth;
+		key = (key << DXT_DRAW_KEY_PIPELINE_BITS) | DXTDrawKeyField(pipeline, DXT_DRAW_KEY_PIPELINE_BITS);
+		key = (key << DXT_DRAW_KEY_MESH_BITS) | DXTDrawKeyField(mesh, DXT_DRAW_KEY_MESH_BITS);
+	}
+	else
+	{
+		depth &= ~((1u << (DXT_DRAW_KEY_DEPTH_BITS - DXT_DRAW_KEY_OPAQUE_DEPTH_BITS)) - 1);
+		key = (key << DXT_DRAW_KEY_PIPELINE_BITS) | DXTDrawKeyField(pipeline, DXT_DRAW_KEY_PIPELINE_BITS);
+		key = (key << DXT_DRAW_KEY_MESH_BITS) | DXTDrawKeyField(mesh, DXT_DRAW_KEY_MESH_BITS);
+		key = (key << DXT_DRAW_KEY_DEPTH_BITS) | depth;
+	}
+
+	return key;
+}
+
+uint32_t DXTQuantizeDrawDepth(const float viewDepth)
+{
+	// Behind the camera and NaN both end up at zero
+	if (!(viewDepth > 0.0f))
+		return 0;
+
+	// Positive floats compare like their bit patterns, the sign bit is always clear here
+	uint32_t bits;
+	memcpy(&bits, &viewDepth, sizeof(bits));
+	return bits >> (31 - DXT_DRAW_KEY_DEPTH_BITS);
+}
+
+// Bits [Shift, Shift + width) of a key that vary between the keys, moved to Offset when packed
+struct DXTRadixKeyRun
+{
+	size_t Shift;
+	size_t Offset;
+	uint64_t Mask;
+};
+
+static inline void DXTRadixPrefixSum(uint32_t* histogram, const size_t bucketCount)
+{
+	uint32_t offset = 0;
+	for (size_t bucket = 0; bucket < bucketCount; ++bucket)
+	{
+		uint32_t bucketSize = histogram[bucket];
+		histogram[bucket] = offset;
+		offset += bucketSize;
+	}
+}
+
+// Splits the varying bits into contiguous runs, returns how many bits they cover
+static size_t DXTGetRadixKeyRuns(uint64_t varyingBits, DXTRadixKeyRun* runsOut, size_t* runCountOut)
+{
+	size_t runCount = 0;
+	size_t bitCount = 0;
+
+	while (varyingBits)
+	{
+		size_t shift = DXTLowestSetBit(varyingBits);
+		uint64_t unset = ~(varyingBits >> shift);
+		size_t width = unset ? DXTLowestSetBit(unset) : 64 - shift;
+		uint64_t mask = width < 64 ? (1ull << width) - 1 : ~0ull;
+
+		DXTRadixKeyRun run = { shift, bitCount, mask };
+		runsOut[runCount++] = run;
+		bitCount += width;
+		varyingBits &= ~(mask << shift);
+	}
+
+	*runCountOut = runCount;
+	return bitCount;
+}
+
+// The varying bits of each key are packed above its value into a single word, which moves two thirds of the
+// bytes of separate arrays and needs digits only for the packed bits. The keys are rebuilt from the packed bits
+// and the bits every key shares after the last pass.
+static void DXTRadixSortPacked(uint64_t* keys, uint32_t* values, const size_t count, uint64_t* scratch,
+	const uint64_t sharedBits, const DXTRadixKeyRun* runs, const size_t runCount, const size_t bitCount)
+{
+	// As few passes as the widest digit allows, with the bits spread evenly so each pass scatters into as few
+	// buckets as possible
+	const size_t digitCount = (bitCount + DXT_RADIX_DIGIT_BITS - 1) / DXT_RADIX_DIGIT_BITS;
+	const size_t digitBits = (bitCount + digitCount - 1) / digitCount;
+	const uint64_t digitMask = (1ull << digitBits) - 1;
+	const size_t bucketCount = static_cast<size_t>(digitMask) + 1;
+
+	// Fixed trip counts let packing and counting unroll, unused runs pack nothing and unused digits count zeroes
+	DXTRadixKeyRun packedRuns[DXT_RADIX_PACKED_MAX_RUNS] = {};
+	copy(runs, runs + runCount, packedRuns);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint64_t key = keys[i];
+		uint64_t packed = 0;
+		for (size_t r = 0; r < DXT_RADIX_PACKED_MAX_RUNS; ++r)
+			packed |= ((key >> packedRuns[r].Shift) & packedRuns[r].Mask) << packedRuns[r].Offset;
+
+		scratch[i] = (packed << 32) | values[i];
+	}
+
+	// Counted in a loop of its own, which keeps the counters apart from the stores of the packing
+	uint32_t histograms[DXT_RADIX_PACKED_MAX_DIGITS][DXT_RADIX_BUCKET_COUNT];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint64_t packed = scratch[i];
+		for (size_t digit = 0; digit < DXT_RADIX_PACKED_MAX_DIGITS; ++digit)
+			++histograms[digit][(packed >> (32 + digit * digitBits)) & digitMask];
+	}
+
+	uint64_t* source = scratch;
+	uint64_t* target = keys;
+
+	for (size_t digit = 0; digit < digitCount; ++digit)
+	{
+		const size_t shift = 32 + digit * digitBits;
+		uint32_t* histogram = histograms[digit];
+		DXTRadixPrefixSum(histogram, bucketCount);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t packed = source[i];
+			target[histogram[(packed >> shift) & digitMask]++] = packed;
+		}
+
+		swap(source, target);
+	}
+
+	// Unpacking reads and writes the same index, so it also works in place when the result ended up in keys
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint64_t packed = source[i];
+		uint64_t bits = packed >> 32;
+		uint64_t key = sharedBits;
+		for (size_t r = 0; r < DXT_RADIX_PACKED_MAX_RUNS; ++r)
+			key |= ((bits >> packedRuns[r].Offset) & packedRuns[r].Mask) << packedRuns[r].Shift;
+
+		keys[i] = key;
+		values[i] = static_cast<uint32_t>(packed);
+	}
+}
+
+// Keys and values move separately, each digit starts at the lowest varying bit above the previous one so
+// constant bits between and within fields never cost a pass
+static void DXTRadixSortWide(uint64_t* keys, uint32_t* values, const size_t count, uint64_t* scratchKeys,
+	uint32_t* scratchValues, uint64_t varyingBits)
+{
+	const uint64_t digitMask = DXT_RADIX_BUCKET_COUNT - 1;
+
+	size_t shifts[DXT_RADIX_MAX_DIGIT_COUNT];
+	size_t digitCount = 0;
+	while (varyingBits)
+	{
+		size_t shift = DXTLowestSetBit(varyingBits);
+		shifts[digitCount++] = shift;
+		varyingBits = shift + DXT_RADIX_DIGIT_BITS < 64 ? varyingBits & ~((1ull << (shift + DXT_RADIX_DIGIT_BITS)) - 1) : 0;
+	}
+
+	// One pass over the keys counts the buckets of every remaining digit
+	uint32_t histograms[DXT_RADIX_MAX_DIGIT_COUNT][DXT_RADIX_BUCKET_COUNT];
+	memset(histograms, 0, digitCount * sizeof(histograms[0]));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint64_t key = keys[i];
+		for (size_t digit = 0; digit < digitCount; ++digit)
+			++histograms[digit][(key >> shifts[digit]) & digitMask];
+	}
+
+	uint64_t* sourceKeys = keys;
+	uint32_t* sourceValues = values;
+	uint64_t* targetKeys = scratchKeys;
+	uint32_t* targetValues = scratchValues;
+
+	for (size_t digit = 0; digit < digitCount; ++digit)
+	{
+		const size_t shift = shifts[digit];
+		uint32_t* histogram = histograms[digit];
+		DXTRadixPrefixSum(histogram, DXT_RADIX_BUCKET_COUNT);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t key = sourceKeys[i];
+			uint32_t target = histogram[(key >> shift) & digitMask]++;
+			targetKeys[target] = key;
+			targetValues[target] = sourceValues[i];
+		}
+
+		swap(sourceKeys, targetKeys);
+		swap(sourceValues, targetValues);
+	}
+
+	// An odd number of passes leaves the result in the scratch arrays
+	if (sourceKeys != keys)
+	{
+		memcpy(keys, sourceKeys, count * sizeof(uint64_t));
+		memcpy(values, sourceValues, count * sizeof(uint32_t));
+	}
+}
+
+void DXTRadixSortDrawKeys(uint64_t* keys, uint32_t* values, const size_t count,
+	uint64_t* scratchKeys, uint32_t* scratchValues)
+{
+	if (count < 2)
+		return;
+
+	// Bits that are the same in every key would not move anything, find the ones that vary first
+	uint64_t anyBits = 0;
+	uint64_t allBits = ~0ull;
+	for (size_t i = 0; i < count; ++i)
+	{
+		anyBits |= keys[i];
+		allBits &= keys[i];
+	}
+
+	const uint64_t varyingBits = anyBits ^ allBits;
+	if (!varyingBits)
+		return;
+
+	// Alternating bits make the most runs
+	DXTRadixKeyRun runs[32];
+	size_t runCount;
+	size_t bitCount = DXTGetRadixKeyRuns(varyingBits, runs, &runCount);
+
+	if (bitCount <= 32 && runCount <= DXT_RADIX_PACKED_MAX_RUNS)
+		DXTRadixSortPacked(keys, values, count, scratchKeys, allBits, runs, runCount, bitCount);
+	else
+		DXTRadixSortWide(keys, values, count, scratchKeys, scratchValues, varyingBits);
+}
+
+void DXTDrawQueue::Clear()
+{
+	keys.clear();
+	values.clear();
+}
+
+void DXTDrawQueue::Sort()
+{
+	scratchKeys.resize(keys.size());
+	scratchValues.resize(values.size());
+	DXTRadixSortDrawKeys(keys.data(), values.data(), keys.size(), scratchKeys.data(), scratchValues.data());
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Field widths of a draw key, together they fill all 64 bits. Bits a field leaves unused cost the radix
+// sort nothing, it only sorts on the bits that differ between the keys.
+#define DXT_DRAW_KEY_PASS_BITS 4
+#define DXT_DRAW_KEY_BUCKET_BITS 4
+#define DXT_DRAW_KEY_PIPELINE_BITS 16
+#define DXT_DRAW_KEY_MESH_BITS 16
+#define DXT_DRAW_KEY_DEPTH_BITS 24
+// Opaque draws only need rough depth order, the remaining low depth bits are left zero
+#define DXT_DRAW_KEY_OPAQUE_DEPTH_BITS 16
+
+enum DXTDrawBucket
+{
+	DXTDrawBucketOpaque,
+	DXTDrawBucketTransparent
+};
+
+// Keys sort by pass, then bucket. Opaque draws continue with pipeline, mesh and depth, so they are grouped
+// by state and front to back within a group. Transparent draws put inverted depth ahead of pipeline and
+// mesh, so they stay strictly back to front. Pass, bucket, pipeline and mesh have to fit their fields, which
+// is asserted, release builds truncate them.
+uint64_t DXTMakeDrawKey(const uint32_t pass, const DXTDrawBucket bucket, const uint32_t pipeline,
+	const uint32_t mesh, const float viewDepth);
+// Keeps the top bits of the float, which order like the depths themselves with precision relative to depth
+uint32_t DXTQuantizeDrawDepth(const float viewDepth);
+// Stable LSD radix sort of the keys along with their values, up to eleven bits per pass. Bits that all
+// keys share are skipped. When no more than 32 bits vary, those are packed above the value so a pass moves
+// a single 64 bit word. The scratch arrays need room for count entries.
+void DXTRadixSortDrawKeys(uint64_t* keys, uint32_t* values, const size_t count,
+	uint64_t* scratchKeys, uint32_t* scratchValues);
+
+// Collects the draws of a frame as key and value pairs, the values usually index the draws
+class DXTDrawQueue
+{
+public:
+	void Clear();
+	inline void Add(const uint64_t key, const uint32_t value);
+	void Sort();
+
+	inline size_t GetCount() const;
+	inline const uint64_t* GetKeys() const;
+	inline const uint32_t* GetValues() const;
+
+private:
+	std::vector<uint64_t> keys;
+	std::vector<uint32_t> values;
+	std::vector<uint64_t> scratchKeys;
+	std::vector<uint32_t> scratchValues;
+};
+
+inline void DXTDrawQueue::Add(const uint64_t key, const uint32_t value)
+{
+	keys.push_back(key);
+	values.push_back(value);
+}
+
+inline size_t DXTDrawQueue::GetCount() const
+{
+	return keys.size();
+}
+
+inline const uint64_t* DXTDrawQueue::GetKeys() const
+{
+	return keys.data();
+}
+
+inline const uint32_t* DXTDrawQueue::GetValues() const
+{
+	return values.data();
+}
\ No newline at end of file
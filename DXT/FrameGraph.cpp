@@ -0,0 +1,224 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+
+using namespace std;
+
+DXTFrameGraph::DXTFrameGraph() :
+	passCount(0),
+	resourceCount(0)
+{
+}
+
+void DXTFrameGraph::Clear()
+{
+	passCount = 0;
+	resourceCount = 0;
+}
+
+uint32_t DXTFrameGraph::AddPass(const char* name, const DXTFrameGraphExecuteFunc& execute)
+{
+	if (passCount == passes.size())
+		passes.emplace_back();
+
+	Pass& pass = passes[passCount];
+	pass.Name = name;
+	pass.Execute = execute;
+	pass.Reads.clear();
+	pass.Writes.clear();
+	pass.Acquires.clear();
+	pass.Releases.clear();
+	pass.Barriers.clear();
+	pass.RefCount = 0;
+	pass.bSideEffects = false;
+	pass.bCulled = false;
+
+	return static_cast<uint32_t>(passCount++);
+}
+
+void DXTFrameGraph::SetSideEffects(const uint32_t pass)
+{
+	passes[pass].bSideEffects = true;
+}
+
+uint32_t DXTFrameGraph::CreateResource(const char* name, const DXTFrameGraphResourceDesc& desc)
+{
+	return AddResource(name, desc, false);
+}
+
+uint32_t DXTFrameGraph::ImportResource(const char* name)
+{
+	DXTFrameGraphResourceDesc desc = {};
+	return AddResource(name, desc, true);
+}
+
+void DXTFrameGraph::Read(const uint32_t pass, const uint32_t resource)
+{
+	passes[pass].Reads.push_back(resource);
+}
+
+void DXTFrameGraph::Write(const uint32_t pass, const uint32_t resource)
+{
+	passes[pass].Writes.push_back(resource);
+	resources[resource].Writers.push_back(pass);
+}
+
+void DXTFrameGraph::Compile()
+{
+	for (size_t i = 0; i < resourceCount; ++i)
+	{
+		Resource& resource = resources[i];
+		resource.RefCount = 0;
+		resource.FirstPass = DXT_FRAME_GRAPH_NULL_INDEX;
+		resource.LastPass = DXT_FRAME_GRAPH_NULL_INDEX;
+	}
+
+	for (size_t i = 0; i < passCount; ++i)
+	{
+		Pass& pass = passes[i];
+		pass.RefCount = static_cast<uint32_t>(pass.Writes.size());
+		pass.bCulled = false;
+		pass.Acquires.clear();
+		pass.Releases.clear();
+		pass.Barriers.clear();
+
+		for (auto resource : pass.Reads)
+			++resources[resource].RefCount;
+	}
+
+	// Walk back from everything nobody reads, culling writers left without readers along the way
+	unreferenced.clear();
+	for (size_t i = 0; i < resourceCount; ++i)
+		if (resources[i].RefCount == 0 && !resources[i].bImported)
+			unreferenced.push_back(static_cast<uint32_t>(i));
+
+	for (size_t i = 0; i < passCount; ++i)
+		if (passes[i].RefCount == 0 && !passes[i].bSideEffects)
+			CullPass(&passes[i]);
+
+	while (!unreferenced.empty())
+	{
+		Resource& resource = resources[unreferenced.back()];
+		unreferenced.pop_back();
+
+		for (auto writer : resource.Writers)
+		{
+			Pass& pass = passes[writer];
+			if (pass.bCulled || --pass.RefCount > 0 || pass.bSideEffects)
+				continue;
+
+			CullPass(&pass);
+		}
+	}
+
+	// Lifetimes and state changes in execution order
+	states.assign(resourceCount, DXTFrameGraphStateUndefined);
+	for (size_t i = 0; i < passCount; ++i)
+	{
+		Pass& pass = passes[i];
+		if (pass.bCulled)
+			continue;
+
+		uint32_t passIndex = static_cast<uint32_t>(i);
+		for (auto resource : pass.Writes)
+		{
+			Resource& written = resources[resource];
+			written.FirstPass = min(written.FirstPass, passIndex);
+			written.LastPass = passIndex;
+
+			if (states[resource] != DXTFrameGraphStateOutput)
+			{
+				DXTFrameGraphBarrier barrier = { resource, states[resource], DXTFrameGraphStateOutput };
+				pass.Barriers.push_back(barrier);
+				states[resource] = DXTFrameGraphStateOutput;
+			}
+		}
+
+		// Written resources stay outputs for the whole pass, even when the pass reads them as well
+		for (auto resource : pass.Reads)
+		{
+			Resource& read = resources[resource];
+			read.FirstPass = min(read.FirstPass, passIndex);
+			read.LastPass = passIndex;
+
+			if (states[resource] == DXTFrameGraphStateUndefined ||
+				find(pass.Writes.begin(), pass.Writes.end(), resource) != pass.Writes.end())
+				continue;
+
+			if (states[resource] != DXTFrameGraphStateInput)
+			{
+				DXTFrameGraphBarrier barrier = { resource, states[resource], DXTFrameGraphStateInput };
+				pass.Barriers.push_back(barrier);
+				states[resource] = DXTFrameGraphStateInput;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < resourceCount; ++i)
+	{
+		const Resource& resource = resources[i];
+		if (resource.bImported || resource.FirstPass == DXT_FRAME_GRAPH_NULL_INDEX)
+			continue;
+
+		passes[resource.FirstPass].Acquires.push_back(static_cast<uint32_t>(i));
+		passes[resource.LastPass].Releases.push_back(static_cast<uint32_t>(i));
+	}
+}
+
+void DXTFrameGraph::Execute(DXTFrameGraphBackend* backend) const
+{
+	for (size_t i = 0; i < passCount; ++i)
+	{
+		const Pass& pass = passes[i];
+		if (pass.bCulled)
+			continue;
+
+		for (auto resource : pass.Acquires)
+			backend->AcquireResource(resource, resources[resource].Desc);
+
+		for (auto& barrier : pass.Barriers)
+			backend->Barrier(barrier);
+
+		if (pass.Execute)
+			pass.Execute();
+
+		// Released right away, so later passes may get the same memory
+		for (auto resource : pass.Releases)
+			backend->ReleaseResource(resource);
+	}
+}
+
+size_t DXTFrameGraph::GetCulledPassCount() const
+{
+	size_t count = 0;
+	for (size_t i = 0; i < passCount; ++i)
+		count += passes[i].bCulled ? 1 : 0;
+
+	return count;
+}
+
+uint32_t DXTFrameGraph::AddResource(const char* name, const DXTFrameGraphResourceDesc& desc, const bool bImported)
+{
+	if (resourceCount == resources.size())
+		resources.emplace_back();
+
+	Resource& resource = resources[resourceCount];
+	resource.Name = name;
+	resource.Desc = desc;
+	resource.Writers.clear();
+	resource.RefCount = 0;
+	resource.FirstPass = DXT_FRAME_GRAPH_NULL_INDEX;
+	resource.LastPass = DXT_FRAME_GRAPH_NULL_INDEX;
+	resource.bImported = bImported;
+
+	return static_cast<uint32_t>(resourceCount++);
+}
+
+void DXTFrameGraph::CullPass(Pass* pass)
+{
+	pass->bCulled = true;
+
+	for (auto resource : pass->Reads)
+		if (--resources[resource].RefCount == 0 && !resources[resource].bImported)
+			unreferenced.push_back(resource);
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#define DXT_FRAME_GRAPH_NULL_INDEX 0xFFFFFFFF
+
+// Same fields as DXTRenderTargetDesc, kept free of Direct3D so graphs compile headless
+struct DXTFrameGraphResourceDesc
+{
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t Format;
+	uint32_t BindFlags;
+};
+
+enum DXTFrameGraphResourceState
+{
+	// Contents are undefined, transient resources start out like this
+	DXTFrameGraphStateUndefined,
+	DXTFrameGraphStateOutput,
+	DXTFrameGraphStateInput
+};
+
+struct DXTFrameGraphBarrier
+{
+	uint32_t Resource;
+	DXTFrameGraphResourceState Before;
+	DXTFrameGraphResourceState After;
+};
+
+typedef std::function<void()> DXTFrameGraphExecuteFunc;
+
+// Turns the compiled graph into API calls. Transient resources are acquired before their first pass
+// and released after their last, barriers come right before the pass that needs them.
+class DXTFrameGraphBackend
+{
+public:
+	virtual ~DXTFrameGraphBackend() {}
+
+	virtual void AcquireResource(const uint32_t resource, const DXTFrameGraphResourceDesc& desc) = 0;
+	virtual void ReleaseResource(const uint32_t resource) = 0;
+	virtual void Barrier(const DXTFrameGraphBarrier& barrier) = 0;
+};
+
+// Passes declare the resources they read and write and run in the order they were added. Compile culls
+// passes nothing reads from, then works out where every resource is first and last used and which
+// state changes each pass needs. Resources are identified by the index returned when declaring them.
+class DXTFrameGraph
+{
+public:
+	DXTFrameGraph();
+
+	// Starts a new graph, the storage of the previous one is kept
+	void Clear();
+	uint32_t AddPass(const char* name, const DXTFrameGraphExecuteFunc& execute);
+	// Keeps the pass even when nothing reads what it writes
+	void SetSideEffects(const uint32_t pass);
+	uint32_t CreateResource(const char* name, const DXTFrameGraphResourceDesc& desc);
+	// The resource lives outside the graph, passes writing it are never culled and it's never acquired
+	uint32_t ImportResource(const char* name);
+	void Read(const uint32_t pass, const uint32_t resource);
+	void Write(const uint32_t pass, const uint32_t resource);
+
+	void Compile();
+	void Execute(DXTFrameGraphBackend* backend) const;
+
+	inline size_t GetPassCount() const;
+	inline size_t GetResourceCount() const;
+	inline bool IsPassCulled(const uint32_t pass) const;
+	size_t GetCulledPassCount() const;
+	// Both DXT_FRAME_GRAPH_NULL_INDEX when no pass left after culling uses the resource
+	inline uint32_t GetFirstPass(const uint32_t resource) const;
+	inline uint32_t GetLastPass(const uint32_t resource) const;
+	inline const std::vector<DXTFrameGraphBarrier>& GetBarriers(const uint32_t pass) const;
+
+private:
+	struct Pass
+	{
+		const char* Name;
+		DXTFrameGraphExecuteFunc Execute;
+		std::vector<uint32_t> Reads;
+		std::vector<uint32_t> Writes;
+		std::vector<uint32_t> Acquires;
+		std::vector<uint32_t> Releases;
+		std::vector<DXTFrameGraphBarrier> Barriers;
+		// Resources written that are still read, the pass is culled when it drops to zero
+		uint32_t RefCount;
+		bool bSideEffects;
+		bool bCulled;
+	};
+
+	struct Resource
+	{
+		const char* Name;
+		DXTFrameGraphResourceDesc Desc;
+		std::vector<uint32_t> Writers;
+		// Passes reading the resource that were not culled
+		uint32_t RefCount;
+		uint32_t FirstPass;
+		uint32_t LastPass;
+		bool bImported;
+	};
+
+	// Only the first passCount passes and resourceCount resources belong to the current graph
+	std::vector<Pass> passes;
+	std::vector<Resource> resources;
+	size_t passCount;
+	size_t resourceCount;
+	std::vector<uint32_t> unreferenced;
+	std::vector<DXTFrameGraphResourceState> states;
+
+	uint32_t AddResource(const char* name, const DXTFrameGraphResourceDesc& desc, const bool bImported);
+	void CullPass(Pass* pass);
+};
+
+inline size_t DXTFrameGraph::GetPassCount() const
+{
+	return passCount;
+}
+
+inline size_t DXTFrameGraph::GetResourceCount() const
+{
+	return resourceCount;
+}
+
+inline bool DXTFrameGraph::IsPassCulled(const uint32_t pass) const
+{
+	return passes[pass].bCulled;
+}
+
+inline uint32_t DXTFrameGraph::GetFirstPass(const uint32_t resource) const
+{
+	return resources[resource].FirstPass;
+}
+
+inline uint32_t DXTFrameGraph::GetLastPass(const uint32_t resource) const
+{
+	return resources[resource].LastPass;
+}
+
+inline const std::vector<DXTFrameGraphBarrier>& DXTFrameGraph::GetBarriers(const uint32_t pass) const
+{
+	return passes[pass].Barriers;
+}
\ No newline at end of file
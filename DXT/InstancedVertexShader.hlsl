@@ -0,0 +1,18 @@
+#include "ShaderTypes.hlsli"
+
+cbuffer ViewConstants : register(b0)
+{
+	float4x4 ViewProjection;
+};
+
+VertexShaderOutput main(InstancedVertexShaderInput input)
+{
+	// Built from rows, so the matrix keeps the layout it has on the CPU and takes row vectors
+	float4x4 world = float4x4(input.world0, input.world1, input.world2, input.world3);
+
+	VertexShaderOutput output;
+	output.Position = mul(ViewProjection, mul(float4(input.pos, 1.0f), world));
+	output.Normal = mul(float4(input.normal, 0.0f), world).xyz;
+	output.UV = input.uv;
+	return output;
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "MeshFile.h"
+
+#include <fstream>
+
+using namespace std;
+
+static uint64_t DXTAlignMeshFileOffset(const uint64_t offset)
+{
+	return (offset + DXT_MESH_FILE_ALIGNMENT - 1) / DXT_MESH_FILE_ALIGNMENT * DXT_MESH_FILE_ALIGNMENT;
+}
+
+static void DXTWriteMeshFileSection(ofstream* stream, const uint64_t offset, const void* data, const size_t length)
+{
+	static const char padding[DXT_MESH_FILE_ALIGNMENT] = {};
+	uint64_t position = static_cast<uint64_t>(stream->tellp());
+	stream->write(padding, static_cast<streamsize>(offset - position));
+	stream->write(static_cast<const char*>(data), static_cast<streamsize>(length));
+}
+
+HRESULT DXTWriteMeshFile(const char* path, const DXTMeshFileData& data)
+{
+	if (data.IndexSize != sizeof(uint16_t) && data.IndexSize != sizeof(uint32_t))
+		return E_INVALIDARG;
+
+	size_t submeshLength = data.SubmeshCount * sizeof(DXTMeshFileSubmesh);
+	size_t vertexLength = static_cast<size_t>(data.VertexCount) * data.VertexStride;
+	size_t indexLength = static_cast<size_t>(data.IndexCount) * data.IndexSize;
+	size_t nodeLength = data.NodeCount * sizeof(DXTMeshFileNode);
+
+	DXTMeshFileHeader header;
+	ZeroMemory(&header, sizeof(header));
+	header.Magic = DXT_MESH_FILE_MAGIC;
+	header.Version = DXT_MESH_FILE_VERSION;
+	header.ChannelFlags = data.ChannelFlags;
+	header.VertexStride = data.VertexStride;
+	header.IndexSize = data.IndexSize;
+	header.VertexCount = data.VertexCount;
+	header.IndexCount = data.IndexCount;
+	header.SubmeshCount = data.SubmeshCount;
+	header.NodeCount = data.NodeCount;
+	header.Bounds = data.Bounds;
+	header.FormatHash = data.FormatHash;
+	header.SubmeshOffset = DXTAlignMeshFileOffset(sizeof(header));
+	header.VertexOffset = DXTAlignMeshFileOffset(header.SubmeshOffset + submeshLength);
+	header.IndexOffset = DXTAlignMeshFileOffset(header.VertexOffset + vertexLength);
+	header.NodeOffset = DXTAlignMeshFileOffset(header.IndexOffset + indexLength);
+
+	ofstream stream(path, ios::binary | ios::out | ios::trunc);
+	if (stream.fail())
+		return E_FAIL;
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	DXTWriteMeshFileSection(&stream, header.SubmeshOffset, data.Submeshes, submeshLength);
+	DXTWriteMeshFileSection(&stream, header.VertexOffset, data.Vertices, vertexLength);
+	DXTWriteMeshFileSection(&stream, header.IndexOffset, data.Indices, indexLength);
+	DXTWriteMeshFileSection(&stream, header.NodeOffset, data.Nodes, nodeLength);
+	stream.close();
+
+	return stream.fail() ? E_FAIL : S_OK;
+}
+
+// Subtracting from the size rather than adding to the offset keeps a damaged offset from wrapping around.
+// Counts and element sizes are both 32 bit, so their product always fits in 64 bits.
+static bool DXTIsMeshFileSectionValid(const uint64_t offset, const uint64_t count, const uint64_t elementSize, const uint64_t size)
+{
+	return offset % DXT_MESH_FILE_ALIGNMENT == 0 && offset <= size && count * elementSize <= size - offset;
+}
+
+bool DXTValidateMeshFile(const void* file, const uint64_t size)
+{
+	if (size < sizeof(DXTMeshFileHeader))
+		return false;
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(file);
+	const DXTMeshFileHeader* header = reinterpret_cast<const DXTMeshFileHeader*>(bytes);
+
+	bool bValid = header->Magic == DXT_MESH_FILE_MAGIC && header->Version == DXT_MESH_FILE_VERSION &&
+		header->VertexStride != 0 && (header->IndexSize == sizeof(uint16_t) || header->IndexSize == sizeof(uint32_t)) &&
+		DXTIsMeshFileSectionValid(header->SubmeshOffset, header->SubmeshCount, sizeof(DXTMeshFileSubmesh), size) &&
+		DXTIsMeshFileSectionValid(header->VertexOffset, header->VertexCount, header->VertexStride, size) &&
+		DXTIsMeshFileSectionValid(header->IndexOffset, header->IndexCount, header->IndexSize, size) &&
+		DXTIsMeshFileSectionValid(header->NodeOffset, header->NodeCount, sizeof(DXTMeshFileNode), size);
+	if (!bValid)
+		return false;
+
+	// Nodes are walked in file order, so parents have to come first and submeshes have to exist
+	const DXTMeshFileNode* nodes = reinterpret_cast<const DXTMeshFileNode*>(bytes + header->NodeOffset);
+	for (uint32_t i = 0; i < header->NodeCount; ++i)
+		if ((nodes[i].Parent != DXT_MESH_FILE_NONE && nodes[i].Parent >= i) ||
+			(nodes[i].Submesh != DXT_MESH_FILE_NONE && nodes[i].Submesh >= header->SubmeshCount))
+			return false;
+
+	return true;
+}
+
+DXTMappedMeshFile::DXTMappedMeshFile() :
+	file(INVALID_HANDLE_VALUE),
+	mapping(nullptr),
+	view(nullptr)
+{
+	ZeroMemory(&data, sizeof(data));
+}
+
+DXTMappedMeshFile::~DXTMappedMeshFile()
+{
+	Close();
+}
+
+HRESULT DXTMappedMeshFile::Open(const char* path)
+{
+	Close();
+
+	file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return E_FAIL;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || static_cast<uint64_t>(fileSize.QuadPart) < sizeof(DXTMeshFileHeader))
+	{
+		Close();
+		return E_FAIL;
+	}
+
+	mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping)
+		view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!view)
+	{
+		Close();
+		return E_FAIL;
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(view);
+	if (!DXTValidateMeshFile(bytes, static_cast<uint64_t>(fileSize.QuadPart)))
+	{
+		Close();
+		return E_FAIL;
+	}
+
+	const DXTMeshFileHeader* header = reinterpret_cast<const DXTMeshFileHeader*>(bytes);
+	data.ChannelFlags = header->ChannelFlags;
+	data.VertexStride = header->VertexStride;
+	data.IndexSize = header->IndexSize;
+	data.VertexCount = header->VertexCount;
+	data.IndexCount = header->IndexCount;
+	data.SubmeshCount = header->SubmeshCount;
+	data.NodeCount = header->NodeCount;
+	data.Bounds = header->Bounds;
+	data.FormatHash = header->FormatHash;
+	data.Vertices = bytes + header->VertexOffset;
+	data.Indices = bytes + header->IndexOffset;
+	data.Submeshes = reinterpret_cast<const DXTMeshFileSubmesh*>(bytes + header->SubmeshOffset);
+	data.Nodes = reinterpret_cast<const DXTMeshFileNode*>(bytes + header->NodeOffset);
+
+	return S_OK;
+}
+
+void DXTMappedMeshFile::Close()
+{
+	if (view)
+		UnmapViewOfFile(view);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	file = INVALID_HANDLE_VALUE;
+	mapping = nullptr;
+	view = nullptr;
+	ZeroMemory(&data, sizeof(data));
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+
+// "DXTM" read as a little endian integer
+#define DXT_MESH_FILE_MAGIC 0x4D545844
+// Files of any other version are rejected, cook the sources again after changing the format
+#define DXT_MESH_FILE_VERSION 3
+// Sections start on this boundary so mapped vertices and indices can be read in place
+#define DXT_MESH_FILE_ALIGNMENT 16
+// Parent of root nodes and submesh of nodes that only carry a transform
+#define DXT_MESH_FILE_NONE 0xFFFFFFFF
+
+struct DXTMeshFileBounds
+{
+	float Lower[3];
+	float Upper[3];
+};
+
+// Start of a .dxtmesh file. Section offsets are in bytes from the start of the file.
+struct DXTMeshFileHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	// DXTVertexAttrubuteChannel flags of the interleaved vertices
+	uint32_t ChannelFlags;
+	uint32_t VertexStride;
+	// 2 or 4
+	uint32_t IndexSize;
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t SubmeshCount;
+	uint32_t NodeCount;
+	// Quantized positions are relative to these bounds
+	DXTMeshFileBounds Bounds;
+	// DXTGetVertexFormatHash of the vertex layout
+	uint64_t FormatHash;
+	uint64_t SubmeshOffset;
+	uint64_t VertexOffset;
+	uint64_t IndexOffset;
+	uint64_t NodeOffset;
+};
+
+// Indices of a submesh are relative to its base vertex
+struct DXTMeshFileSubmesh
+{
+	uint32_t StartIndex;
+	uint32_t IndexCount;
+	int32_t BaseVertex;
+	uint32_t VertexCount;
+	uint32_t MaterialIndex;
+	DXTMeshFileBounds Bounds;
+};
+
+// Node of the transform hierarchy of the source file, submeshes are in the space of the node drawing them.
+// Parents come before their children, a node referencing several meshes is split into one node per mesh.
+struct DXTMeshFileNode
+{
+	uint32_t Parent;
+	uint32_t Submesh;
+	// Row major, relative to the parent
+	float Transform[4][4];
+};
+
+// Mesh contents as laid out in a .dxtmesh file, pointing either into a mapped file or at data to be written
+struct DXTMeshFileData
+{
+	uint32_t ChannelFlags;
+	uint32_t VertexStride;
+	uint32_t IndexSize;
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t SubmeshCount;
+	uint32_t NodeCount;
+	DXTMeshFileBounds Bounds;
+	uint64_t FormatHash;
+	const void* Vertices;
+	const void* Indices;
+	const DXTMeshFileSubmesh* Submeshes;
+	const DXTMeshFileNode* Nodes;
+};
+
+HRESULT DXTWriteMeshFile(const char* path, const DXTMeshFileData& data);
+// Checks a complete file image of the current version: aligned sections inside the file, a vertex stride,
+// 2 or 4 byte indices and nodes that reference earlier parents and existing submeshes
+bool DXTValidateMeshFile(const void* file, const uint64_t size);
+
+// Maps a .dxtmesh file read only, the data points into the mapped view until Close or destruction
+class DXTMappedMeshFile
+{
+public:
+	DXTMappedMeshFile();
+	~DXTMappedMeshFile();
+	// Copies would close the same handles twice
+	DXTMappedMeshFile(const DXTMappedMeshFile&) = delete;
+	DXTMappedMeshFile& operator=(const DXTMappedMeshFile&) = delete;
+
+	// Fails on files DXTValidateMeshFile rejects
+	HRESULT Open(const char* path);
+	void Close();
+
+	inline const DXTMeshFileData& GetData() const;
+
+private:
+	HANDLE file;
+	HANDLE mapping;
+	const void* view;
+	DXTMeshFileData data;
+};
+
+inline const DXTMeshFileData& DXTMappedMeshFile::GetData() const
+{
+	return data;
+}
\ No newline at end of file
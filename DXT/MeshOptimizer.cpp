@@ -0,0 +1,290 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+#define DXT_MESH_OPTIMIZER_NULL_VERTEX 0xFFFFFFFF
+
+struct DXTTriangleAdjacency
+{
+	// Triangles using vertex v are Triangles[Offsets[v]] up to Triangles[Offsets[v + 1]]
+	vector<uint32_t> Offsets;
+	vector<uint32_t> Triangles;
+};
+
+struct DXTOverdrawCluster
+{
+	uint32_t FirstTriangle;
+	uint32_t TriangleCount;
+	float SortKey;
+};
+
+static void DXTBuildTriangleAdjacency(const uint32_t* indices, const size_t indexCount, const size_t vertexCount,
+	DXTTriangleAdjacency* adjacencyOut)
+{
+	adjacencyOut->Offsets.assign(vertexCount + 1, 0);
+	adjacencyOut->Triangles.resize(indexCount);
+
+	for (size_t i = 0; i < indexCount; ++i)
+		adjacencyOut->Offsets[indices[i] + 1]++;
+
+	for (size_t v = 0; v < vertexCount; ++v)
+		adjacencyOut->Offsets[v + 1] += adjacencyOut->Offsets[v];
+
+	vector<uint32_t> cursors(adjacencyOut->Offsets.begin(), adjacencyOut->Offsets.end() - 1);
+	for (size_t i = 0; i < indexCount; ++i)
+		adjacencyOut->Triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+}
+
+// Pops vertices off the dead end stack and then scans the input order for one that still has live triangles
+static uint32_t DXTSkipDeadEnd(const vector<uint32_t>& liveTriangles, vector<uint32_t>* deadEnds,
+	const uint32_t* indices, const size_t indexCount, size_t* cursor)
+{
+	while (!deadEnds->empty())
+	{
+		uint32_t vertex = deadEnds->back();
+		deadEnds->pop_back();
+		if (liveTriangles[vertex] > 0)
+			return vertex;
+	}
+
+	for (; *cursor < indexCount; ++*cursor)
+		if (liveTriangles[indices[*cursor]] > 0)
+			return indices[*cursor];
+
+	return DXT_MESH_OPTIMIZER_NULL_VERTEX;
+}
+
+void DXTAnalyzeVertexCache(const uint32_t* indices, const size_t indexCount, const size_t vertexCount,
+	const uint32_t cacheSize, DXTVertexCacheStats* statsOut)
+{
+	// A vertex is cached while fewer than cacheSize misses happened since it was transformed
+	vector<uint64_t> timestamps(vertexCount, 0);
+	vector<bool> bReferenced(vertexCount, false);
+	uint64_t time = cacheSize + 1;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t vertex = indices[i];
+		if (time - timestamps[vertex] > cacheSize)
+		{
+			timestamps[vertex] = time++;
+			statsOut->TransformedVertexCount++;
+		}
+
+		if (!bReferenced[vertex])
+		{
+			bReferenced[vertex] = true;
+			statsOut->VertexCount++;
+		}
+	}
+
+	statsOut->TriangleCount += indexCount / 3;
+}
+
+void DXTOptimizeVertexCache(const uint32_t* indices, const size_t indexCount, const size_t vertexCount,
+	const uint32_t cacheSize, uint32_t* indicesOut, vector<uint32_t>* clustersOut)
+{
+	DXTTriangleAdjacency adjacency;
+	DXTBuildTriangleAdjacency(indices, indexCount, vertexCount, &adjacency);
+
+	vector<uint32_t> liveTriangles(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+		liveTriangles[v] = adjacency.Offsets[v + 1] - adjacency.Offsets[v];
+
+	vector<uint32_t> timestamps(vertexCount, 0);
+	vector<bool> bEmitted(indexCount / 3, false);
+	vector<uint32_t> deadEnds;
+	vector<uint32_t> candidates;
+	uint32_t time = cacheSize + 1;
+	size_t cursor = 0;
+	size_t outputCount = 0;
+
+	uint32_t fanning = indexCount > 0 ? indices[0] : DXT_MESH_OPTIMIZER_NULL_VERTEX;
+	bool bDeadEnd = true;
+
+	while (fanning != DXT_MESH_OPTIMIZER_NULL_VERTEX)
+	{
+		if (bDeadEnd && clustersOut)
+			clustersOut->push_back(static_cast<uint32_t>(outputCount / 3));
+
+		candidates.clear();
+		for (uint32_t a = adjacency.Offsets[fanning]; a < adjacency.Offsets[fanning + 1]; ++a)
+		{
+			uint32_t triangle = adjacency.Triangles[a];
+			if (bEmitted[triangle])
+				continue;
+
+			for (size_t c = 0; c < 3; ++c)
+			{
+				uint32_t vertex = indices[triangle * 3 + c];
+				indicesOut[outputCount++] = vertex;
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+
+				if (time - timestamps[vertex] > cacheSize)
+					timestamps[vertex] = time++;
+			}
+
+			bEmitted[triangle] = true;
+		}
+
+		// Fan next around the candidate that stays in the cache longest while its remaining triangles are emitted
+		fanning = DXT_MESH_OPTIMIZER_NULL_VERTEX;
+		int bestPriority = -1;
+		for (auto vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			int priority = 0;
+			if (time - timestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+				priority = time - timestamps[vertex];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanning = vertex;
+			}
+		}
+
+		bDeadEnd = fanning == DXT_MESH_OPTIMIZER_NULL_VERTEX;
+		if (bDeadEnd)
+			fanning = DXTSkipDeadEnd(liveTriangles, &deadEnds, indices, indexCount, &cursor);
+	}
+}
+
+void DXTOptimizeOverdraw(const uint32_t* indices, const size_t indexCount, const float* positions,
+	const size_t positionStride, const size_t vertexCount, const vector<uint32_t>& clusters,
+	const uint32_t cacheSize, const float threshold, uint32_t* indicesOut)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	DXTVertexCacheStats meshStats = {};
+	DXTAnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize, &meshStats);
+	float maxClusterACMR = meshStats.GetACMR() * threshold;
+
+	// Soft boundaries, the cache is simulated from empty at the start of every cluster
+	vector<DXTOverdrawCluster> softClusters;
+	vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+		uint32_t first = clusters[c];
+		uint32_t misses = 0;
+		time += cacheSize + 1;
+
+		for (uint32_t t = first; t < end; ++t)
+		{
+			for (size_t k = 0; k < 3; ++k)
+			{
+				uint32_t vertex = indices[t * 3 + k];
+				if (time - timestamps[vertex] > cacheSize)
+				{
+					timestamps[vertex] = time++;
+					misses++;
+				}
+			}
+
+			if (t + 1 == end || static_cast<float>(misses) / (t + 1 - first) <= maxClusterACMR)
+			{
+				DXTOverdrawCluster cluster = { first, t + 1 - first, 0.0f };
+				softClusters.push_back(cluster);
+				first = t + 1;
+				misses = 0;
+				time += cacheSize + 1;
+			}
+		}
+	}
+
+	auto position = [positions, positionStride](uint32_t vertex)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+	};
+
+	float meshCenter[3] = {};
+	for (size_t v = 0; v < vertexCount; ++v)
+		for (size_t k = 0; k < 3; ++k)
+			meshCenter[k] += position(static_cast<uint32_t>(v))[k] / vertexCount;
+
+	// Area weighted centroid and normal of every cluster
+	for (auto& cluster : softClusters)
+	{
+		float center[3] = {};
+		float normal[3] = {};
+		float area = 0.0f;
+
+		for (uint32_t t = cluster.FirstTriangle; t < cluster.FirstTriangle + cluster.TriangleCount; ++t)
+		{
+			const float* p0 = position(indices[t * 3]);
+			const float* p1 = position(indices[t * 3 + 1]);
+			const float* p2 = position(indices[t * 3 + 2]);
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float triangleArea = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				center[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * triangleArea;
+				normal[k] += n[k];
+			}
+			area += triangleArea;
+		}
+
+		float normalLength = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float normalScale = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+		float centerScale = area > 0.0f ? 1.0f / area : 0.0f;
+
+		cluster.SortKey = 0.0f;
+		for (size_t k = 0; k < 3; ++k)
+			cluster.SortKey += (center[k] * centerScale - meshCenter[k]) * normal[k] * normalScale;
+	}
+
+	stable_sort(softClusters.begin(), softClusters.end(), [](const DXTOverdrawCluster& a, const DXTOverdrawCluster& b)
+	{
+		return a.SortKey > b.SortKey;
+	});
+
+	for (auto& cluster : softClusters)
+	{
+		memcpy(indicesOut, indices + cluster.FirstTriangle * 3, cluster.TriangleCount * 3 * sizeof(uint32_t));
+		indicesOut += cluster.TriangleCount * 3;
+	}
+}
+
+size_t DXTOptimizeVertexFetch(void* vertices, const size_t vertexCount, const size_t vertexStride,
+	uint32_t* indices, const size_t indexCount)
+{
+	vector<uint32_t> remap(vertexCount, DXT_MESH_OPTIMIZER_NULL_VERTEX);
+	uint32_t nextVertex = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t& target = remap[indices[i]];
+		if (target == DXT_MESH_OPTIMIZER_NULL_VERTEX)
+			target = nextVertex++;
+		indices[i] = target;
+	}
+
+	size_t referencedCount = nextVertex;
+	for (auto& target : remap)
+		if (target == DXT_MESH_OPTIMIZER_NULL_VERTEX)
+			target = nextVertex++;
+
+	uint8_t* bytes = static_cast<uint8_t*>(vertices);
+	vector<uint8_t> source(bytes, bytes + vertexCount * vertexStride);
+	for (size_t v = 0; v < vertexCount; ++v)
+		memcpy(bytes + remap[v] * vertexStride, source.data() + v * vertexStride, vertexStride);
+
+	return referencedCount;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Entries of the FIFO post-transform cache the optimizer and the statistics assume
+#define DXT_VERTEX_CACHE_SIZE 16
+// Clusters are split while their own ACMR stays within this factor of the whole mesh's
+#define DXT_OVERDRAW_THRESHOLD 1.05f
+
+// Counts of a simulated FIFO post-transform cache, added up over any number of index buffers
+struct DXTVertexCacheStats
+{
+	uint64_t TransformedVertexCount;
+	uint64_t TriangleCount;
+	// Distinct vertices referenced by the indices
+	uint64_t VertexCount;
+
+	// Average cache miss ratio, transformed vertices per triangle, 0.5 at best for large regular meshes
+	inline float GetACMR() const;
+	// Average transform to vertex ratio, 1 at best
+	inline float GetATVR() const;
+};
+
+// Adds the counts of a triangle list to statsOut, which has to be zeroed before the first call
+void DXTAnalyzeVertexCache(const uint32_t* indices, const size_t indexCount, const size_t vertexCount,
+	const uint32_t cacheSize, DXTVertexCacheStats* statsOut);
+// Reorders triangles so their vertices are likely still in a cache of cacheSize entries, after Tipsify (Sander,
+// Nehab, Barczak 2007). The first triangle of every run that continues from a dead end is appended to
+// clustersOut, these hard boundaries are where DXTOptimizeOverdraw may reorder. indicesOut can't alias indices.
+void DXTOptimizeVertexCache(const uint32_t* indices, const size_t indexCount, const size_t vertexCount,
+	const uint32_t cacheSize, uint32_t* indicesOut, std::vector<uint32_t>* clustersOut);
+// Splits the clusters of DXTOptimizeVertexCache further wherever that costs little vertex cache efficiency and
+// sorts them to draw outward facing clusters far from the center first, which lowers overdraw from most
+// view directions. Positions are read from the start of every vertex, positionStride is given in bytes.
+void DXTOptimizeOverdraw(const uint32_t* indices, const size_t indexCount, const float* positions,
+	const size_t positionStride, const size_t vertexCount, const std::vector<uint32_t>& clusters,
+	const uint32_t cacheSize, const float threshold, uint32_t* indicesOut);
+// Renumbers vertices in the order the indices first use them and moves them accordingly, so vertex fetches
+// run through memory linearly. Unreferenced vertices end up last, their count is subtracted from the return value.
+size_t DXTOptimizeVertexFetch(void* vertices, const size_t vertexCount, const size_t vertexStride,
+	uint32_t* indices, const size_t indexCount);
+
+inline float DXTVertexCacheStats::GetACMR() const
+{
+	return TriangleCount ? static_cast<float>(TransformedVertexCount) / TriangleCount : 0.0f;
+}
+
+inline float DXTVertexCacheStats::GetATVR() const
+{
+	return VertexCount ? static_cast<float>(TransformedVertexCount) / VertexCount : 0.0f;
+}
\ No newline at end of file
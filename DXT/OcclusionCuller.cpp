@@ -0,0 +1,402 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include <emmintrin.h>
+
+using namespace std;
+using namespace DirectX;
+
+DXTOcclusionCuller::DXTOcclusionCuller() :
+	DXTOcclusionCuller(DXT_OCCLUSION_DEFAULT_WIDTH, DXT_OCCLUSION_DEFAULT_HEIGHT)
+{
+}
+
+DXTOcclusionCuller::DXTOcclusionCuller(const unsigned int width, const unsigned int height) :
+	// Rows are rasterized four pixels at a time
+	width((max(width, 4u) + 3) & ~3u),
+	height(max(height, 1u))
+{
+	XMStoreFloat4x4(&viewProjection, XMMatrixIdentity());
+	stats = {};
+
+	unsigned int levelWidth = this->width;
+	unsigned int levelHeight = this->height;
+
+	for (;;)
+	{
+		levelWidths.push_back(levelWidth);
+		levelHeights.push_back(levelHeight);
+		depthLevels.push_back(vector<float>(levelWidth * levelHeight, 1.0f));
+
+		if (levelWidth == 1 && levelHeight == 1)
+			break;
+
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+}
+
+void DXTOcclusionCuller::BeginFrame(const XMFLOAT4X4& viewProjection)
+{
+	this->viewProjection = viewProjection;
+	occluders.clear();
+	stats = {};
+}
+
+void DXTOcclusionCuller::AddOccluder(const float* vertices, const size_t vertexStride, const size_t vertexCount,
+	const void* indices, const DXTIndexType indexType, const size_t indexCount, const XMFLOAT4X4& world)
+{
+	Occluder occluder;
+	occluder.Vertices = vertices;
+	occluder.VertexStride = vertexStride;
+	occluder.VertexCount = vertexCount;
+	occluder.Indices = indices;
+	occluder.IndexType = indexType;
+	occluder.IndexCount = indexCount;
+	XMStoreFloat4x4(&occluder.WorldViewProjection, XMLoadFloat4x4(&world) * XMLoadFloat4x4(&viewProjection));
+
+	occluders.push_back(occluder);
+
+	stats.OccluderCount++;
+	stats.OccluderTriangles += indexCount / 3;
+}
+
+void DXTOcclusionCuller::RasterizeOccluders(DXTWorkerPool* pool)
+{
+	size_t threadCount = pool->GetThreadCount();
+	if (threadTriangles.size() < threadCount)
+	{
+		threadTriangles.resize(threadCount);
+		threadVertices.resize(threadCount);
+	}
+
+	for (auto& triangles : threadTriangles)
+		triangles.clear();
+
+	// Transform and set up triangles, every thread bins into its own list
+	pool->ParallelFor(occluders.size(), 1, [this](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t i = begin; i < end; ++i)
+			TransformOccluder(occluders[i], &threadVertices[threadIndex], &threadTriangles[threadIndex]);
+	});
+
+	for (auto& triangles : threadTriangles)
+		stats.RasterizedTriangles += triangles.size();
+
+	// Every band of rows is owned by exactly one thread, so no synchronization is needed
+	int bandCount = (int)((height + DXT_OCCLUSION_BAND_HEIGHT - 1) / DXT_OCCLUSION_BAND_HEIGHT);
+	pool->ParallelFor(bandCount, 1, [this](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t band = begin; band < end; ++band)
+		{
+			int firstRow = (int)band * DXT_OCCLUSION_BAND_HEIGHT;
+			int lastRow = min(firstRow + DXT_OCCLUSION_BAND_HEIGHT, (int)height) - 1;
+			RasterizeBand(firstRow, lastRow);
+		}
+	});
+
+	BuildHierarchy();
+}
+
+bool DXTOcclusionCuller::IsOccluded(const DXTBounds& bounds) const
+{
+	XMMATRIX matrix = XMLoadFloat4x4(&viewProjection);
+
+	float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+	float maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		XMVECTOR corner = XMVectorSet(
+			(i & 1) ? bounds.Upper.x : bounds.Lower.x,
+			(i & 2) ? bounds.Upper.y : bounds.Lower.y,
+			(i & 4) ? bounds.Upper.z : bounds.Lower.z, 1.0f);
+
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(corner, matrix));
+
+		// Bounds reaching behind the camera can't be tested conservatively
+		if (clip.w <= DXT_OCCLUSION_MIN_W)
+			return false;
+
+		float invW = 1.0f / clip.w;
+		float x = clip.x * invW;
+		float y = clip.y * invW;
+
+		minX = min(minX, x);
+		maxX = max(maxX, x);
+		minY = min(minY, y);
+		maxY = max(maxY, y);
+		minZ = min(minZ, clip.z * invW);
+	}
+
+	if (minZ <= 0.0f)
+		return false;
+
+	float screenMinX = (minX * 0.5f + 0.5f) * width;
+	float screenMaxX = (maxX * 0.5f + 0.5f) * width;
+	float screenMinY = (0.5f - maxY * 0.5f) * height;
+	float screenMaxY = (0.5f - minY * 0.5f) * height;
+
+	// Off screen bounds are left to the frustum test
+	if (screenMaxX < 0.0f || screenMinX >= width || screenMaxY < 0.0f || screenMinY >= height)
+		return false;
+
+	int x0 = max((int)floorf(screenMinX), 0);
+	int x1 = min((int)floorf(screenMaxX), (int)width - 1);
+	int y0 = max((int)floorf(screenMinY), 0);
+	int y1 = min((int)floorf(screenMaxY), (int)height - 1);
+
+	// Pick the finest level at which the rectangle only covers a handful of texels
+	size_t level = 0;
+	while (level + 1 < depthLevels.size() &&
+		((x1 >> level) - (x0 >> level) >= DXT_OCCLUSION_HIERARCHY_TEST_SIZE ||
+		(y1 >> level) - (y0 >> level) >= DXT_OCCLUSION_HIERARCHY_TEST_SIZE))
+		++level;
+
+	const float* depth = depthLevels[level].data();
+	unsigned int levelWidth = levelWidths[level];
+
+	for (int y = y0 >> level; y <= (y1 >> level); ++y)
+	{
+		for (int x = x0 >> level; x <= (x1 >> level); ++x)
+		{
+			if (depth[y * levelWidth + x] >= minZ)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+size_t DXTOcclusionCuller::CullOccludedBounds(DXTWorkerPool* pool, const DXTBounds* bounds, const unsigned int* candidates,
+	const size_t candidateCount, unsigned int* visibleOut)
+{
+	visibilityFlags.resize(candidateCount);
+
+	pool->ParallelFor(candidateCount, 64, [this, bounds, candidates](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t i = begin; i < end; ++i)
+			visibilityFlags[i] = IsOccluded(bounds[candidates[i]]) ? 0 : 1;
+	});
+
+	return CompactVisible(candidates, candidateCount, visibleOut);
+}
+
+size_t DXTOcclusionCuller::CullOccludedBounds(DXTWorkerPool* pool, const DXTBoundsStream& bounds, const unsigned int* candidates,
+	const size_t candidateCount, unsigned int* visibleOut)
+{
+	visibilityFlags.resize(candidateCount);
+
+	pool->ParallelFor(candidateCount, 64, [this, &bounds, candidates](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			unsigned int index = candidates[i];
+			DXTBounds candidateBounds = { { bounds.LowerX[index], bounds.LowerY[index], bounds.LowerZ[index] },
+				{ bounds.UpperX[index], bounds.UpperY[index], bounds.UpperZ[index] } };
+			visibilityFlags[i] = IsOccluded(candidateBounds) ? 0 : 1;
+		}
+	});
+
+	return CompactVisible(candidates, candidateCount, visibleOut);
+}
+
+size_t DXTOcclusionCuller::CompactVisible(const unsigned int* candidates, const size_t candidateCount, unsigned int* visibleOut)
+{
+	// Compact serially so the surviving candidates keep their order, writes never pass the candidate read
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < candidateCount; ++i)
+	{
+		if (visibilityFlags[i])
+			visibleOut[visibleCount++] = candidates[i];
+	}
+
+	stats.TestedBounds += candidateCount;
+	stats.OccludedBounds += candidateCount - visibleCount;
+
+	return visibleCount;
+}
+
+void DXTOcclusionCuller::TransformOccluder(const Occluder& occluder, vector<XMFLOAT4>* clipVertices,
+	vector<ScreenTriangle>* trianglesOut) const
+{
+	XMMATRIX matrix = XMLoadFloat4x4(&occluder.WorldViewProjection);
+
+	clipVertices->resize(occluder.VertexCount);
+	const char* vertex = (const char*)occluder.Vertices;
+	for (size_t i = 0; i < occluder.VertexCount; ++i, vertex += occluder.VertexStride)
+	{
+		XMVECTOR position = XMLoadFloat3((const XMFLOAT3*)vertex);
+		XMStoreFloat4(&(*clipVertices)[i], XMVector3Transform(position, matrix));
+	}
+
+	const unsigned short* shortIndices = (const unsigned short*)occluder.Indices;
+	const unsigned int* intIndices = (const unsigned int*)occluder.Indices;
+
+	for (size_t i = 0; i + 2 < occluder.IndexCount; i += 3)
+	{
+		const XMFLOAT4* clip[3];
+		bool bBehind = false;
+
+		for (int j = 0; j < 3; ++j)
+		{
+			size_t index = occluder.IndexType == DXTIndexTypeShort ? shortIndices[i + j] : intIndices[i + j];
+			clip[j] = &(*clipVertices)[index];
+			bBehind |= clip[j]->w <= DXT_OCCLUSION_MIN_W;
+		}
+
+		// Occluders only have to be conservative, so triangles crossing the camera plane are dropped instead of clipped
+		if (bBehind)
+			continue;
+
+		ScreenTriangle triangle;
+		for (int j = 0; j < 3; ++j)
+		{
+			float invW = 1.0f / clip[j]->w;
+			triangle.X[j] = (clip[j]->x * invW * 0.5f + 0.5f) * width;
+			triangle.Y[j] = (0.5f - clip[j]->y * invW * 0.5f) * height;
+			triangle.Z[j] = clip[j]->z * invW;
+		}
+
+		// Front faces are clockwise, which is positive area with y pointing down
+		float area = (triangle.X[1] - triangle.X[0]) * (triangle.Y[2] - triangle.Y[0]) -
+			(triangle.X[2] - triangle.X[0]) * (triangle.Y[1] - triangle.Y[0]);
+		if (area <= 0.0f)
+			continue;
+
+		if (triangle.Z[0] > 1.0f && triangle.Z[1] > 1.0f && triangle.Z[2] > 1.0f)
+			continue;
+
+		float minX = min(min(triangle.X[0], triangle.X[1]), triangle.X[2]);
+		float maxX = max(max(triangle.X[0], triangle.X[1]), triangle.X[2]);
+		float minY = min(min(triangle.Y[0], triangle.Y[1]), triangle.Y[2]);
+		float maxY = max(max(triangle.Y[0], triangle.Y[1]), triangle.Y[2]);
+
+		if (maxX < 0.0f || minX >= width || maxY < 0.0f || minY >= height)
+			continue;
+
+		triangle.MinX = max((int)floorf(minX), 0);
+		triangle.MaxX = min((int)ceilf(maxX), (int)width - 1);
+		triangle.MinY = max((int)floorf(minY), 0);
+		triangle.MaxY = min((int)ceilf(maxY), (int)height - 1);
+
+		trianglesOut->push_back(triangle);
+	}
+}
+
+void DXTOcclusionCuller::RasterizeBand(const int firstRow, const int lastRow)
+{
+	float* depth = depthLevels[0].data();
+	fill(depth + firstRow * width, depth + (lastRow + 1) * width, 1.0f);
+
+	for (auto& triangles : threadTriangles)
+	{
+		for (auto& triangle : triangles)
+		{
+			if (triangle.MaxY < firstRow || triangle.MinY > lastRow)
+				continue;
+
+			RasterizeTriangle(triangle, max(triangle.MinY, firstRow), min(triangle.MaxY, lastRow));
+		}
+	}
+}
+
+void DXTOcclusionCuller::RasterizeTriangle(const ScreenTriangle& triangle, const int firstRow, const int lastRow)
+{
+	// Edge functions E(x, y) = A * x + B * y + C, positive on the inside of each edge.
+	// Edge i is the one opposite vertex i, so normalized it is also that vertex's barycentric weight.
+	float edgeA[3], edgeB[3], edgeC[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		int a = (i + 1) % 3;
+		int b = (i + 2) % 3;
+		edgeA[i] = triangle.Y[a] - triangle.Y[b];
+		edgeB[i] = triangle.X[b] - triangle.X[a];
+		edgeC[i] = triangle.X[a] * triangle.Y[b] - triangle.X[b] * triangle.Y[a];
+	}
+
+	float area = edgeC[0] + edgeC[1] + edgeC[2];
+	if (area <= 0.0f)
+		return;
+
+	// Depth is linear in screen space after the perspective divide
+	float invArea = 1.0f / area;
+	float depthA = (triangle.Z[0] * edgeA[0] + triangle.Z[1] * edgeA[1] + triangle.Z[2] * edgeA[2]) * invArea;
+	float depthB = (triangle.Z[0] * edgeB[0] + triangle.Z[1] * edgeB[1] + triangle.Z[2] * edgeB[2]) * invArea;
+	float depthC = (triangle.Z[0] * edgeC[0] + triangle.Z[1] * edgeC[1] + triangle.Z[2] * edgeC[2]) * invArea;
+
+	__m128 a0 = _mm_set1_ps(edgeA[0]);
+	__m128 a1 = _mm_set1_ps(edgeA[1]);
+	__m128 a2 = _mm_set1_ps(edgeA[2]);
+	__m128 za = _mm_set1_ps(depthA);
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 four = _mm_set1_ps(4.0f);
+
+	int startX = triangle.MinX & ~3;
+	float* depth = depthLevels[0].data();
+
+	for (int y = firstRow; y <= lastRow; ++y)
+	{
+		// Sample at pixel centers
+		float sampleY = y + 0.5f;
+		__m128 row0 = _mm_set1_ps(edgeB[0] * sampleY + edgeC[0]);
+		__m128 row1 = _mm_set1_ps(edgeB[1] * sampleY + edgeC[1]);
+		__m128 row2 = _mm_set1_ps(edgeB[2] * sampleY + edgeC[2]);
+		__m128 rowZ = _mm_set1_ps(depthB * sampleY + depthC);
+		__m128 sampleX = _mm_add_ps(_mm_set1_ps(startX + 0.5f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+
+		float* depthRow = depth + y * width;
+
+		for (int x = startX; x <= triangle.MaxX; x += 4, sampleX = _mm_add_ps(sampleX, four))
+		{
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(a0, sampleX), row0);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(a1, sampleX), row1);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(a2, sampleX), row2);
+
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+			if (_mm_movemask_ps(inside) == 0)
+				continue;
+
+			// Occluders in front of the near plane still hide everything behind them
+			__m128 z = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(za, sampleX), rowZ), zero), one);
+			__m128 current = _mm_loadu_ps(depthRow + x);
+			__m128 closer = _mm_min_ps(current, z);
+			_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, current)));
+		}
+	}
+}
+
+void DXTOcclusionCuller::BuildHierarchy()
+{
+	for (size_t level = 1; level < depthLevels.size(); ++level)
+	{
+		const float* source = depthLevels[level - 1].data();
+		unsigned int sourceWidth = levelWidths[level - 1];
+		unsigned int sourceHeight = levelHeights[level - 1];
+
+		float* destination = depthLevels[level].data();
+		unsigned int levelWidth = levelWidths[level];
+		unsigned int levelHeight = levelHeights[level];
+
+		for (unsigned int y = 0; y < levelHeight; ++y)
+		{
+			unsigned int sourceY0 = y * 2;
+			unsigned int sourceY1 = min(sourceY0 + 1, sourceHeight - 1);
+
+			for (unsigned int x = 0; x < levelWidth; ++x)
+			{
+				unsigned int sourceX0 = x * 2;
+				unsigned int sourceX1 = min(sourceX0 + 1, sourceWidth - 1);
+
+				destination[y * levelWidth + x] = max(
+					max(source[sourceY0 * sourceWidth + sourceX0], source[sourceY0 * sourceWidth + sourceX1]),
+					max(source[sourceY1 * sourceWidth + sourceX0], source[sourceY1 * sourceWidth + sourceX1]));
+			}
+		}
+	}
+}
\ No newline at end of file
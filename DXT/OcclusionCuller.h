@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ToolboxTypes.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+#include <DirectXMath.h>
+
+#define DXT_OCCLUSION_DEFAULT_WIDTH 320
+#define DXT_OCCLUSION_DEFAULT_HEIGHT 192
+#define DXT_OCCLUSION_BAND_HEIGHT 8
+#define DXT_OCCLUSION_HIERARCHY_TEST_SIZE 4
+#define DXT_OCCLUSION_MIN_W 1e-5f
+
+struct DXTOcclusionStats
+{
+	size_t OccluderCount;
+	size_t OccluderTriangles;
+	size_t RasterizedTriangles;
+	size_t TestedBounds;
+	size_t OccludedBounds;
+};
+
+// Software occlusion culler. Occluder meshes are rasterized into a small depth buffer on the
+// CPU, which is reduced into a max depth hierarchy that candidate bounds are tested against.
+// Only depends on DirectXMath and the standard library, so it can run without a device.
+class DXTOcclusionCuller
+{
+public:
+	DXTOcclusionCuller();
+	DXTOcclusionCuller(const unsigned int width, const unsigned int height);
+
+	void BeginFrame(const DirectX::XMFLOAT4X4& viewProjection);
+
+	// Positions are read from the start of every vertex, vertexStride is given in bytes.
+	// The data has to stay alive until RasterizeOccluders returns.
+	void AddOccluder(const float* vertices, const size_t vertexStride, const size_t vertexCount,
+		const void* indices, const DXTIndexType indexType, const size_t indexCount,
+		const DirectX::XMFLOAT4X4& world);
+	void RasterizeOccluders(DXTWorkerPool* pool);
+
+	bool IsOccluded(const DXTBounds& bounds) const;
+	// Candidates index into the bounds, the visible ones keep their order. visibleOut may alias candidates.
+	size_t CullOccludedBounds(DXTWorkerPool* pool, const DXTBounds* bounds, const unsigned int* candidates,
+		const size_t candidateCount, unsigned int* visibleOut);
+	size_t CullOccludedBounds(DXTWorkerPool* pool, const DXTBoundsStream& bounds, const unsigned int* candidates,
+		const size_t candidateCount, unsigned int* visibleOut);
+
+	inline const DXTOcclusionStats& GetStats() const;
+	inline unsigned int GetWidth() const;
+	inline unsigned int GetHeight() const;
+	inline const float* GetDepthBuffer() const;
+
+private:
+	struct Occluder
+	{
+		const float* Vertices;
+		size_t VertexStride;
+		size_t VertexCount;
+		const void* Indices;
+		DXTIndexType IndexType;
+		size_t IndexCount;
+		DirectX::XMFLOAT4X4 WorldViewProjection;
+	};
+
+	struct ScreenTriangle
+	{
+		float X[3];
+		float Y[3];
+		float Z[3];
+		int MinX;
+		int MaxX;
+		int MinY;
+		int MaxY;
+	};
+
+	unsigned int width;
+	unsigned int height;
+	DirectX::XMFLOAT4X4 viewProjection;
+	DXTOcclusionStats stats;
+
+	std::vector<Occluder> occluders;
+	std::vector<std::vector<ScreenTriangle>> threadTriangles;
+	std::vector<std::vector<DirectX::XMFLOAT4>> threadVertices;
+
+	// Level 0 is the full resolution depth buffer, every following level stores the
+	// farthest depth of the 2x2 texels below it
+	std::vector<std::vector<float>> depthLevels;
+	std::vector<unsigned int> levelWidths;
+	std::vector<unsigned int> levelHeights;
+
+	std::vector<unsigned char> visibilityFlags;
+
+	void TransformOccluder(const Occluder& occluder, std::vector<DirectX::XMFLOAT4>* clipVertices,
+		std::vector<ScreenTriangle>* trianglesOut) const;
+	void RasterizeBand(const int firstRow, const int lastRow);
+	void RasterizeTriangle(const ScreenTriangle& triangle, const int firstRow, const int lastRow);
+	void BuildHierarchy();
+	size_t CompactVisible(const unsigned int* candidates, const size_t candidateCount, unsigned int* visibleOut);
+};
+
+inline const DXTOcclusionStats& DXTOcclusionCuller::GetStats() const
+{
+	return stats;
+}
+
+inline unsigned int DXTOcclusionCuller::GetWidth() const
+{
+	return width;
+}
+
+inline unsigned int DXTOcclusionCuller::GetHeight() const
+{
+	return height;
+}
+
+inline const float* DXTOcclusionCuller::GetDepthBuffer() const
+{
+	return depthLevels[0].data();
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "OffsetAllocator.h"
+
+#include <intrin.h>
+
+using namespace std;
+
+#define DXT_OFFSET_ALLOCATOR_MANTISSA_VALUE (1u << DXT_OFFSET_ALLOCATOR_MANTISSA_BITS)
+#define DXT_OFFSET_ALLOCATOR_MANTISSA_MASK (DXT_OFFSET_ALLOCATOR_MANTISSA_VALUE - 1)
+#define DXT_OFFSET_ALLOCATOR_NO_BIN 0xFFFFFFFF
+
+// Sizes are binned as floats with a few mantissa bits, small sizes map to their own bins like denormals.
+// Allocations round up so every range in the bin found fits, free ranges round down so they never
+// land in a bin promising more than they hold.
+static inline uint32_t DXTSizeToBin(const uint32_t size, const bool bRoundUp)
+{
+	if (size < DXT_OFFSET_ALLOCATOR_MANTISSA_VALUE)
+		return size;
+
+	unsigned long highestBit;
+	_BitScanReverse(&highestBit, size);
+
+	uint32_t mantissaStart = highestBit - DXT_OFFSET_ALLOCATOR_MANTISSA_BITS;
+	uint32_t exponent = mantissaStart + 1;
+	uint32_t mantissa = (size >> mantissaStart) & DXT_OFFSET_ALLOCATOR_MANTISSA_MASK;
+
+	// Overflowing the mantissa carries into the exponent, which is the next bin up as well
+	if (bRoundUp && (size & ((1u << mantissaStart) - 1)))
+		++mantissa;
+
+	return (exponent << DXT_OFFSET_ALLOCATOR_MANTISSA_BITS) + mantissa;
+}
+
+static inline uint32_t DXTFindLowestBit(const uint32_t mask, const uint32_t firstBit)
+{
+	if (firstBit >= 32)
+		return DXT_OFFSET_ALLOCATOR_NO_BIN;
+
+	unsigned long bit;
+	if (!_BitScanForward(&bit, mask & (~0u << firstBit)))
+		return DXT_OFFSET_ALLOCATOR_NO_BIN;
+
+	return bit;
+}
+
+DXTOffsetAllocator::DXTOffsetAllocator()
+{
+	Reset(0);
+}
+
+DXTOffsetAllocator::DXTOffsetAllocator(const uint32_t size)
+{
+	Reset(size);
+}
+
+void DXTOffsetAllocator::Reset(const uint32_t size)
+{
+	this->size = size;
+	freeSize = 0;
+	allocationCount = 0;
+	usedTopBins = 0;
+
+	for (auto& leafBins : usedLeafBins)
+		leafBins = 0;
+	for (auto& head : binHeads)
+		head = DXT_OFFSET_ALLOCATOR_NULL_NODE;
+
+	nodes.clear();
+	freeNodes.clear();
+
+	if (size > 0)
+		InsertFreeRange(0, size);
+}
+
+bool DXTOffsetAllocator::Allocate(const uint32_t size, DXTOffsetAllocation* allocationOut)
+{
+	if (size == 0 || size > freeSize)
+		return false;
+
+	uint32_t minBin = DXTSizeToBin(size, true);
+	uint32_t minTopBin = minBin >> DXT_OFFSET_ALLOCATOR_MANTISSA_BITS;
+	uint32_t minLeafBin = minBin & DXT_OFFSET_ALLOCATOR_MANTISSA_MASK;
+
+	// Look for a leaf bin at least as large within the same top bin first, then take the smallest
+	// leaf bin of the next top bin holding anything
+	uint32_t topBin = minTopBin;
+	uint32_t leafBin = DXT_OFFSET_ALLOCATOR_NO_BIN;
+	if (usedTopBins & (1u << topBin))
+		leafBin = DXTFindLowestBit(usedLeafBins[topBin], minLeafBin);
+
+	if (leafBin == DXT_OFFSET_ALLOCATOR_NO_BIN)
+	{
+		topBin = DXTFindLowestBit(usedTopBins, minTopBin + 1);
+		if (topBin == DXT_OFFSET_ALLOCATOR_NO_BIN)
+			return false;
+
+		leafBin = DXTFindLowestBit(usedLeafBins[topBin], 0);
+	}
+
+	uint32_t nodeIndex = binHeads[(topBin << DXT_OFFSET_ALLOCATOR_MANTISSA_BITS) | leafBin];
+	RemoveFreeRange(nodeIndex);
+
+	uint32_t offset = nodes[nodeIndex].Offset;
+	uint32_t remainder = nodes[nodeIndex].Size - size;
+	nodes[nodeIndex].Size = size;
+	nodes[nodeIndex].bUsed = true;
+
+	// The rest of the range goes back into the bins as its own node, right after the allocation
+	if (remainder > 0)
+	{
+		uint32_t remainderIndex = InsertFreeRange(offset + size, remainder);
+		uint32_t nextIndex = nodes[nodeIndex].NeighborNext;
+
+		nodes[remainderIndex].NeighborPrevious = nodeIndex;
+		nodes[remainderIndex].NeighborNext = nextIndex;
+		if (nextIndex != DXT_OFFSET_ALLOCATOR_NULL_NODE)
+			nodes[nextIndex].NeighborPrevious = remainderIndex;
+		nodes[nodeIndex].NeighborNext = remainderIndex;
+	}
+
+	++allocationCount;
+	allocationOut->Offset = offset;
+	allocationOut->Node = nodeIndex;
+	return true;
+}
+
+void DXTOffsetAllocator::Free(const DXTOffsetAllocation& allocation)
+{
+	uint32_t nodeIndex = allocation.Node;
+	uint32_t offset = nodes[nodeIndex].Offset;
+	uint32_t size = nodes[nodeIndex].Size;
+	uint32_t previousIndex = nodes[nodeIndex].NeighborPrevious;
+	uint32_t nextIndex = nodes[nodeIndex].NeighborNext;
+
+	if (previousIndex != DXT_OFFSET_ALLOCATOR_NULL_NODE && !nodes[previousIndex].bUsed)
+	{
+		offset = nodes[previousIndex].Offset;
+		size += nodes[previousIndex].Size;
+		RemoveFreeRange(previousIndex);
+		freeNodes.push_back(previousIndex);
+		previousIndex = nodes[previousIndex].NeighborPrevious;
+	}
+
+	if (nextIndex != DXT_OFFSET_ALLOCATOR_NULL_NODE && !nodes[nextIndex].bUsed)
+	{
+		size += nodes[nextIndex].Size;
+		RemoveFreeRange(nextIndex);
+		freeNodes.push_back(nextIndex);
+		nextIndex = nodes[nextIndex].NeighborNext;
+	}
+
+	freeNodes.push_back(nodeIndex);
+
+	uint32_t mergedIndex = InsertFreeRange(offset, size);
+	nodes[mergedIndex].NeighborPrevious = previousIndex;
+	nodes[mergedIndex].NeighborNext = nextIndex;
+	if (previousIndex != DXT_OFFSET_ALLOCATOR_NULL_NODE)
+		nodes[previousIndex].NeighborNext = mergedIndex;
+	if (nextIndex != DXT_OFFSET_ALLOCATOR_NULL_NODE)
+		nodes[nextIndex].NeighborPrevious = mergedIndex;
+
+	--allocationCount;
+}
+
+uint32_t DXTOffsetAllocator::GetLargestFreeRange() const
+{
+	if (usedTopBins == 0)
+		return 0;
+
+	unsigned long topBin;
+	unsigned long leafBin;
+	_BitScanReverse(&topBin, usedTopBins);
+	_BitScanReverse(&leafBin, usedLeafBins[topBin]);
+
+	// Ranges within a bin differ in size, so the largest one has to be searched for
+	uint32_t largest = 0;
+	uint32_t nodeIndex = binHeads[(topBin << DXT_OFFSET_ALLOCATOR_MANTISSA_BITS) | leafBin];
+	for (; nodeIndex != DXT_OFFSET_ALLOCATOR_NULL_NODE; nodeIndex = nodes[nodeIndex].BinNext)
+		largest = nodes[nodeIndex].Size > largest ? nodes[nodeIndex].Size : largest;
+
+	return largest;
+}
+
+uint32_t DXTOffsetAllocator::InsertFreeRange(const uint32_t offset, const uint32_t size)
+{
+	uint32_t bin = DXTSizeToBin(size, false);
+	uint32_t topBin = bin >> DXT_OFFSET_ALLOCATOR_MANTISSA_BITS;
+	uint32_t leafBin = bin & DXT_OFFSET_ALLOCATOR_MANTISSA_MASK;
+
+	uint32_t nodeIndex;
+	if (freeNodes.empty())
+	{
+		nodeIndex = static_cast<uint32_t>(nodes.size());
+		nodes.emplace_back();
+	}
+	else
+	{
+		nodeIndex = freeNodes.back();
+		freeNodes.pop_back();
+	}
+
+	Node& node = nodes[nodeIndex];
+	node.Offset = offset;
+	node.Size = size;
+	node.BinPrevious = DXT_OFFSET_ALLOCATOR_NULL_NODE;
+	node.BinNext = binHeads[bin];
+	node.NeighborPrevious = DXT_OFFSET_ALLOCATOR_NULL_NODE;
+	node.NeighborNext = DXT_OFFSET_ALLOCATOR_NULL_NODE;
+	node.bUsed = false;
+
+	if (node.BinNext != DXT_OFFSET_ALLOCATOR_NULL_NODE)
+		nodes[node.BinNext].BinPrevious = nodeIndex;
+
+	binHeads[bin] = nodeIndex;
+	usedLeafBins[topBin] |= 1u << leafBin;
+	usedTopBins |= 1u << topBin;
+	freeSize += size;
+
+	return nodeIndex;
+}
+
+void DXTOffsetAllocator::RemoveFreeRange(const uint32_t nodeIndex)
+{
+	const Node& node = nodes[nodeIndex];
+
+	if (node.BinPrevious != DXT_OFFSET_ALLOCATOR_NULL_NODE)
+	{
+		nodes[node.BinPrevious].BinNext = node.BinNext;
+	}
+	else
+	{
+		uint32_t bin = DXTSizeToBin(node.Size, false);
+		uint32_t topBin = bin >> DXT_OFFSET_ALLOCATOR_MANTISSA_BITS;
+		uint32_t leafBin = bin & DXT_OFFSET_ALLOCATOR_MANTISSA_MASK;
+
+		binHeads[bin] = node.BinNext;
+		if (node.BinNext == DXT_OFFSET_ALLOCATOR_NULL_NODE)
+		{
+			usedLeafBins[topBin] &= ~(1u << leafBin);
+			if (usedLeafBins[topBin] == 0)
+				usedTopBins &= ~(1u << topBin);
+		}
+	}
+
+	if (node.BinNext != DXT_OFFSET_ALLOCATOR_NULL_NODE)
+		nodes[node.BinNext].BinPrevious = node.BinPrevious;
+
+	freeSize -= node.Size;
+}
\ No newline at end of file
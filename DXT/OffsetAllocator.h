@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define DXT_OFFSET_ALLOCATOR_MANTISSA_BITS 3
+#define DXT_OFFSET_ALLOCATOR_TOP_BIN_COUNT 32
+#define DXT_OFFSET_ALLOCATOR_LEAF_BIN_COUNT (1 << DXT_OFFSET_ALLOCATOR_MANTISSA_BITS)
+#define DXT_OFFSET_ALLOCATOR_BIN_COUNT (DXT_OFFSET_ALLOCATOR_TOP_BIN_COUNT * DXT_OFFSET_ALLOCATOR_LEAF_BIN_COUNT)
+#define DXT_OFFSET_ALLOCATOR_NULL_NODE 0xFFFFFFFF
+
+struct DXTOffsetAllocation
+{
+	uint32_t Offset;
+	// Identifies the allocation when it is freed
+	uint32_t Node;
+};
+
+// Two level segregated fit allocator over a range of abstract units. Free ranges are binned by size on
+// a small floating point scale, so two bitmask scans find a fitting bin in constant time, and a freed
+// range is merged with its free neighbours right away. Only deals in offsets, like DXTRingAllocator.
+class DXTOffsetAllocator
+{
+public:
+	DXTOffsetAllocator();
+	DXTOffsetAllocator(const uint32_t size);
+
+	void Reset(const uint32_t size);
+
+	// Returns false when no free range is large enough, allocationOut is then left untouched
+	bool Allocate(const uint32_t size, DXTOffsetAllocation* allocationOut);
+	void Free(const DXTOffsetAllocation& allocation);
+
+	uint32_t GetLargestFreeRange() const;
+	inline uint32_t GetSize() const;
+	inline uint32_t GetFreeSize() const;
+	inline uint32_t GetAllocationSize(const DXTOffsetAllocation& allocation) const;
+	inline size_t GetAllocationCount() const;
+
+private:
+	struct Node
+	{
+		uint32_t Offset;
+		uint32_t Size;
+		uint32_t BinPrevious;
+		uint32_t BinNext;
+		uint32_t NeighborPrevious;
+		uint32_t NeighborNext;
+		bool bUsed;
+	};
+
+	uint32_t size;
+	uint32_t freeSize;
+	size_t allocationCount;
+
+	// A bit per top bin holding any free range, and a bit per leaf bin within every top bin
+	uint32_t usedTopBins;
+	uint8_t usedLeafBins[DXT_OFFSET_ALLOCATOR_TOP_BIN_COUNT];
+	uint32_t binHeads[DXT_OFFSET_ALLOCATOR_BIN_COUNT];
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> freeNodes;
+
+	uint32_t InsertFreeRange(const uint32_t offset, const uint32_t size);
+	void RemoveFreeRange(const uint32_t nodeIndex);
+};
+
+inline uint32_t DXTOffsetAllocator::GetSize() const
+{
+	return size;
+}
+
+inline uint32_t DXTOffsetAllocator::GetFreeSize() const
+{
+	return freeSize;
+}
+
+inline uint32_t DXTOffsetAllocator::GetAllocationSize(const DXTOffsetAllocation& allocation) const
+{
+	return nodes[allocation.Node].Size;
+}
+
+inline size_t DXTOffsetAllocator::GetAllocationCount() const
+{
+	return allocationCount;
+}
\ No newline at end of file
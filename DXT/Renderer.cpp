@@ -1,7 +1,147 @@
 #include "Renderer.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+
 using namespace DirectX;
 
+UINT Scene::AddMeshNode(StaticMesh* mesh, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale,
+	const UINT parent)
+{
+	UINT handle = static_cast<UINT>(Meshes.size());
+
+	StaticMeshNode node;
+	node.Mesh = mesh;
+	node.MeshIndex = meshIndices.emplace(mesh, static_cast<UINT>(meshIndices.size())).first->second;
+	node.TreeProxy = DXT_AABB_TREE_NULL_NODE;
+
+	// The local transform is filled in by the next update, the store flags new transforms
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	node.GraphNode = Graph.CreateNode(parent, identity);
+	Meshes.push_back(node);
+
+	if (graphMeshNodes.size() <= node.GraphNode)
+		graphMeshNodes.resize(node.GraphNode + 1, SCENE_NO_MESH_NODE);
+	graphMeshNodes[node.GraphNode] = handle;
+
+	Transforms.Add(position, rotation, scale);
+	WorldMatrices.push_back(identity);
+	MeshBounds.Resize(Meshes.size());
+
+	return handle;
+}
+
+void Scene::RemoveMeshNode(const UINT handle)
+{
+	if (Meshes[handle].TreeProxy != DXT_AABB_TREE_NULL_NODE)
+		MeshTree.DestroyProxy(Meshes[handle].TreeProxy);
+
+	Graph.DestroyNode(Meshes[handle].GraphNode);
+	graphMeshNodes[Meshes[handle].GraphNode] = SCENE_NO_MESH_NODE;
+
+	// The last node takes over the removed handle
+	UINT last = static_cast<UINT>(Meshes.size() - 1);
+	if (handle != last)
+	{
+		Meshes[handle] = Meshes[last];
+		WorldMatrices[handle] = WorldMatrices[last];
+		MeshBounds.SetBounds(handle, MeshBounds.GetBounds(last));
+		graphMeshNodes[Meshes[handle].GraphNode] = handle;
+
+		if (Meshes[handle].TreeProxy != DXT_AABB_TREE_NULL_NODE)
+			MeshTree.SetUserData(Meshes[handle].TreeProxy, handle);
+	}
+
+	Meshes.pop_back();
+	WorldMatrices.pop_back();
+	Transforms.Remove(handle);
+	MeshBounds.Resize(Meshes.size());
+}
+
+UINT Scene::AddModel(StaticModel* model, const XMFLOAT4X4& transform, const UINT parent, std::vector<UINT>* meshNodesOut)
+{
+	UINT root = Graph.CreateNode(parent, transform);
+
+	modelMeshes.clear();
+	DXTAddMeshFileNodes(model->Nodes.data(), model->Nodes.size(), root, &Graph, &modelMeshes);
+
+	// Files without a hierarchy have every submesh in the space of the model
+	if (model->Nodes.empty())
+		for (UINT i = 0; i < model->Meshes.size(); ++i)
+		{
+			DXTSceneGraphMesh mesh = { root, i };
+			modelMeshes.push_back(mesh);
+		}
+
+	for (auto& modelMesh : modelMeshes)
+	{
+		UINT handle = AddMeshNode(&model->Meshes[modelMesh.MeshIndex], XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f),
+			XMFLOAT3(1.0f, 1.0f, 1.0f), modelMesh.Node);
+
+		if (meshNodesOut)
+			meshNodesOut->push_back(handle);
+	}
+
+	return root;
+}
+
+void Scene::UpdateTransforms(DXTWorkerPool* pool)
+{
+	// The store composes transforms relative to the parent graph node
+	updatedNodes.clear();
+	Transforms.UpdateWorldMatrices(&updatedNodes);
+	for (auto handle : updatedNodes)
+		Graph.SetLocalTransform(Meshes[handle].GraphNode, Transforms.GetWorldMatrix(handle));
+
+	// Moving a graph node moves every mesh node below it
+	updatedGraphNodes.clear();
+	Graph.Update(pool, &updatedGraphNodes);
+
+	movedNodes.clear();
+	movedLocalBounds.clear();
+	movedMatrices.clear();
+	for (auto graphNode : updatedGraphNodes)
+	{
+		UINT handle = graphNode < graphMeshNodes.size() ? graphMeshNodes[graphNode] : SCENE_NO_MESH_NODE;
+		if (handle == SCENE_NO_MESH_NODE)
+			continue;
+
+		WorldMatrices[handle] = Graph.GetWorldTransform(graphNode);
+		movedNodes.push_back(handle);
+		movedLocalBounds.push_back(Meshes[handle].Mesh->Bounds);
+		movedMatrices.push_back(WorldMatrices[handle]);
+	}
+
+	// The bounds of every moved node are transformed in one batch, the tree is refit one node at a time
+	DXTTransformBoundsBatch(movedLocalBounds.data(), movedMatrices.data(), movedNodes.size(), &movedBounds);
+	for (size_t i = 0; i < movedNodes.size(); ++i)
+		UpdateNodeBounds(movedNodes[i], movedBounds.GetBounds(i));
+}
+
+void Scene::UpdateNodeBounds(const UINT handle, const DXTBounds& worldBounds)
+{
+	StaticMeshNode& node = Meshes[handle];
+	MeshBounds.SetBounds(handle, worldBounds);
+
+	if (node.TreeProxy == DXT_AABB_TREE_NULL_NODE)
+	{
+		node.TreeProxy = MeshTree.CreateProxy(worldBounds, handle);
+		return;
+	}
+
+	// Estimate the displacement from the center of the current fat bounds
+	const DXTBounds& fatBounds = MeshTree.GetFatBounds(node.TreeProxy);
+	XMFLOAT3 displacement(
+		0.5f * ((worldBounds.Lower.x + worldBounds.Upper.x) - (fatBounds.Lower.x + fatBounds.Upper.x)),
+		0.5f * ((worldBounds.Lower.y + worldBounds.Upper.y) - (fatBounds.Lower.y + fatBounds.Upper.y)),
+		0.5f * ((worldBounds.Lower.z + worldBounds.Upper.z) - (fatBounds.Lower.z + fatBounds.Upper.z)));
+
+	MeshTree.MoveProxy(node.TreeProxy, worldBounds, displacement);
+}
+
 HRESULT Renderer::Initialize(const DXTRenderParams & params, DXTWindow * window)
 {
 	parameters = params;
@@ -12,95 +152,428 @@ HRESULT Renderer::Initialize(const DXTRenderParams & params, DXTWindow * window)
 
 	// Create objects
 	DXTCreateRenderTargetFromBackBuffer(swapChain, device, &backBufferRenderTarget);
-	DXTCreateRenderTarget(device, params.Extent.Width, params.Extent.Height, DXGI_FORMAT_R8G8B8A8_UNORM,
-		&diffuseBuffer, &diffuseRenderTarget, &diffuseResourceView);
-	DXTCreateDepthStencilBuffer(device, params.Extent.Width, params.Extent.Height, DXGI_FORMAT_D24_UNORM_S8_UINT,
-		&depthTexture, &depthStencilView);
-	DXTCreateRasterizerStateSolid(device, &rasterizerState);
-	DXTCreateDepthStencilStateDepthTestEnabled(device, &depthStencilStateEnabled);
-	DXTCreateDepthStencilStateDepthTestDisabled(device, &depthStencilStateDisabled);
+	renderTargets.Initialize(device);
+	graphBackend.Initialize(&renderTargets, &stateCache);
 	DXTCreateBlitVertexBuffer(device, &blitVertexBuffer);
-	DXTCreateSamplerStatePointClamp(device, &blitSamplerState);
-	DXTCreateSamplerStateLinearClamp(device, &staticMeshSamplerState);
+	DXTCreateBuffer(device, INSTANCE_BUFFER_CAPACITY * STATIC_MESH_INSTANCE_STRIDE, D3D11_BIND_VERTEX_BUFFER,
+		D3D11_CPU_ACCESS_WRITE, D3D11_USAGE_DYNAMIC, &instanceBuffer);
+
+	// Create states
+	stateObjects.Initialize(device);
+
+	D3D11_SAMPLER_DESC samplerDesc;
+	DXTGetSamplerDescPointClamp(&samplerDesc);
+	stateObjects.GetSamplerState(samplerDesc, &blitSamplerState);
+	DXTGetSamplerDescLinearClamp(&samplerDesc);
+	stateObjects.GetSamplerState(samplerDesc, &staticMeshSamplerState);
 
 	// Load shaders
-	DXTBytecodeBlob blitBytecodeBlob;
-	DXTBytecodeBlob staticMeshBytecodeBlob;
-	DXTVertexShaderFromFile(device, BLIT_MESH_VERTEX_SHADER, &blitVertexShader, &blitBytecodeBlob);
-	DXTVertexShaderFromFile(device, STATIC_MESH_VERTEX_SHADER, &staticMeshVertexShader, &staticMeshBytecodeBlob);
-	DXTPixelShaderFromFile(device, BLIT_MESH_PIXEL_SHADER, &blitPixelShader);
-	DXTPixelShaderFromFile(device, STATIC_MESH_PIXEL_SHADER, &staticMeshPixelShader);
-
-	// Create input layouts
-	D3D11_INPUT_ELEMENT_DESC staticMeshInputDesc[] =
-	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, sizeof(float) * 3, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, sizeof(float) * 5, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	DXTBytecodeBlob blitVertexBytecode;
+	DXTBytecodeBlob blitPixelBytecode;
+	DXTBytecodeBlob staticMeshVertexBytecode;
+	DXTBytecodeBlob staticMeshPixelBytecode;
+	DXTBytecodeFromFile(BLIT_MESH_VERTEX_SHADER, &blitVertexBytecode);
+	DXTBytecodeFromFile(BLIT_MESH_PIXEL_SHADER, &blitPixelBytecode);
+	DXTBytecodeFromFile(STATIC_MESH_VERTEX_SHADER, &staticMeshVertexBytecode);
+	DXTBytecodeFromFile(STATIC_MESH_PIXEL_SHADER, &staticMeshPixelBytecode);
+
+	// Create pipelines
+	D3D11_INPUT_ELEMENT_DESC blitInputDesc[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, sizeof(float) * 2, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	};
-	UINT staticMeshElementCount = 3;
 
-	DXTCreateBlitInputLayout(device, &blitBytecodeBlob, &blitInputLayout);
-	device->CreateInputLayout(staticMeshInputDesc, staticMeshElementCount, 
-		staticMeshBytecodeBlob.Bytecode, staticMeshBytecodeBlob.BytecodeLength, &staticMeshInputLayout);
+	D3D11_INPUT_ELEMENT_DESC instanceInputDesc[] =
+	{
+		{ "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, sizeof(float) * 4, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, sizeof(float) * 8, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, sizeof(float) * 12, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	};
+
+	// Vertex attributes come from the layout, the instance matrix follows them from the second slot
+	D3D11_INPUT_ELEMENT_DESC staticMeshInputDesc[StaticMeshVertexLayout::AttributeCount + ARRAYSIZE(instanceInputDesc)];
+	StaticMeshVertexLayout::GetInputElements(0, staticMeshInputDesc);
+	std::copy(std::begin(instanceInputDesc), std::end(instanceInputDesc), staticMeshInputDesc + StaticMeshVertexLayout::AttributeCount);
+
+	DXTPipelineDesc staticMeshPipelineDesc;
+	staticMeshPipelineDesc.VertexShader = &staticMeshVertexBytecode;
+	staticMeshPipelineDesc.PixelShader = &staticMeshPixelBytecode;
+	staticMeshPipelineDesc.InputElements = staticMeshInputDesc;
+	staticMeshPipelineDesc.InputElementCount = ARRAYSIZE(staticMeshInputDesc);
+	DXTGetRasterizerDescSolid(&staticMeshPipelineDesc.Rasterizer);
+	DXTGetDepthStencilDescDepthTestEnabled(&staticMeshPipelineDesc.DepthStencil);
+	DXTGetBlendDescOpaque(&staticMeshPipelineDesc.Blend);
+	staticMeshPipelineDesc.Topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	HRESULT pipelineResult = stateObjects.GetPipelineState(staticMeshPipelineDesc, &staticMeshPipeline);
 
-	blitBytecodeBlob.Destroy();
-	staticMeshBytecodeBlob.Destroy();
+	DXTPipelineDesc blitPipelineDesc;
+	blitPipelineDesc.VertexShader = &blitVertexBytecode;
+	blitPipelineDesc.PixelShader = &blitPixelBytecode;
+	blitPipelineDesc.InputElements = blitInputDesc;
+	blitPipelineDesc.InputElementCount = 2;
+	DXTGetRasterizerDescSolid(&blitPipelineDesc.Rasterizer);
+	DXTGetDepthStencilDescDepthTestDisabled(&blitPipelineDesc.DepthStencil);
+	DXTGetBlendDescOpaque(&blitPipelineDesc.Blend);
+	blitPipelineDesc.Topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	if (SUCCEEDED(pipelineResult))
+		pipelineResult = stateObjects.GetPipelineState(blitPipelineDesc, &blitPipeline);
 
-	DXTCreateBuffer(device, 2 * sizeof(XMFLOAT4X4), D3D11_BIND_CONSTANT_BUFFER, D3D11_CPU_ACCESS_WRITE, 
-		D3D11_USAGE_DYNAMIC, &transformConstantBuffer);
+	blitVertexBytecode.Destroy();
+	blitPixelBytecode.Destroy();
+	staticMeshVertexBytecode.Destroy();
+	staticMeshPixelBytecode.Destroy();
+
+	if (FAILED(pipelineResult))
+		return pipelineResult;
+
+	result = stateCache.Initialize(context);
+	if (FAILED(result))
+		return result;
+
+	result = transformRing.Initialize(device, TRANSFORM_RING_SIZE);
+	if (FAILED(result))
+		return result;
+
+	result = geometryPool.Initialize(device, StaticMeshVertexLayout::Stride, DXTIndexTypeInt,
+		GEOMETRY_PAGE_VERTEX_COUNT, GEOMETRY_PAGE_INDEX_COUNT);
+	if (FAILED(result))
+		return result;
 
 	return S_OK;
 }
 
 void Renderer::Render(Scene * scene, DXTCameraBase * camera)
 {
-	FLOAT clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	stateCache.BeginFrame();
+	renderTargets.BeginFrame();
+
+	scene->UpdateTransforms(&workerPool);
+
+	// Copies issued before the draws below, so they already read the new locations
+	movedGeometry.clear();
+	geometryPool.Defragment(context, GEOMETRY_DEFRAG_BYTES_PER_FRAME, &movedGeometry);
+	for (auto handle : movedGeometry)
+	{
+		StaticModel* model = pooledModels[handle];
+		DXTGeometryLocation location;
+		geometryPool.GetLocation(handle, &location);
+
+		for (auto& mesh : model->Meshes)
+		{
+			mesh.VertexBuffer = location.VertexBuffer;
+			mesh.IndexBuffer = location.IndexBuffer;
+			mesh.StartIndex = mesh.StartIndex - model->StartIndex + location.StartIndex;
+			mesh.BaseVertex = mesh.BaseVertex - model->BaseVertex + location.BaseVertex;
+		}
+
+		model->StartIndex = location.StartIndex;
+		model->BaseVertex = location.BaseVertex;
+	}
+
+	XMFLOAT4X4 viewProjection;
+	camera->GetViewProjectionMatrix(&viewProjection, parameters.Extent);
+
+	DXTFrustum frustum;
+	camera->GetFrustum(&frustum, parameters.Extent);
+
+	if (scene->Meshes.size() >= PARALLEL_CULL_MIN_NODE_COUNT)
+	{
+		visibleMeshes.resize(scene->Meshes.size());
+		size_t visibleCount = DXTCullBoundsStreamParallel(&workerPool, scene->MeshBounds.GetStream(), frustum,
+			&cullScratch, visibleMeshes.data());
+		visibleMeshes.resize(visibleCount);
+	}
+	else if (scene->Meshes.size() >= STREAM_CULL_MIN_NODE_COUNT)
+	{
+		visibleMeshes.resize(scene->Meshes.size());
+		size_t visibleCount = DXTCullBoundsStreamIndices(scene->MeshBounds.GetStream(), frustum, visibleMeshes.data());
+		visibleMeshes.resize(visibleCount);
+	}
+	else
+	{
+		visibleMeshes.clear();
+		scene->MeshTree.Query(frustum, &visibleMeshes);
+	}
+
+	XMFLOAT3 cameraPosition;
+	camera->GetPosition(&cameraPosition);
+	DXTProjectionScale projectionScale = camera->GetProjectionScale(parameters.Extent);
+	size_t visibleCount = DXTCullSmallBounds(scene->MeshBounds.GetStream(), visibleMeshes.data(), visibleMeshes.size(),
+		cameraPosition, projectionScale, MIN_PROJECTED_SIZE, visibleMeshes.data());
+	visibleMeshes.resize(visibleCount);
+
+	// The largest of the remaining nodes go into the CPU depth buffer, the others are tested against it
+	occluderCandidates.clear();
+	for (auto handle : visibleMeshes)
+	{
+		if (!scene->Meshes[handle].Mesh->OccluderVertices)
+			continue;
+
+		float size = DXTGetProjectedSize(scene->MeshBounds.GetBounds(handle), cameraPosition, projectionScale);
+		if (size >= OCCLUDER_MIN_PROJECTED_SIZE)
+			occluderCandidates.push_back(std::make_pair(size, handle));
+	}
+
+	size_t occluderCount = std::min<size_t>(occluderCandidates.size(), OCCLUDER_MAX_COUNT);
+	std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + occluderCount, occluderCandidates.end(),
+		std::greater<std::pair<float, UINT>>());
+
+	const XMFLOAT4X4* worldMatrices = scene->WorldMatrices.data();
+	occlusionCuller.BeginFrame(viewProjection);
+	for (size_t i = 0; i < occluderCount; ++i)
+	{
+		UINT handle = occluderCandidates[i].second;
+		const StaticMesh& mesh = *scene->Meshes[handle].Mesh;
+		occlusionCuller.AddOccluder(&mesh.OccluderVertices->x, sizeof(XMFLOAT3), mesh.OccluderVertexCount,
+			mesh.OccluderIndices, DXTIndexTypeInt, mesh.IndexCount, worldMatrices[handle]);
+	}
+
+	if (occluderCount > 0)
+	{
+		occlusionCuller.RasterizeOccluders(&workerPool);
+		visibleCount = occlusionCuller.CullOccludedBounds(&workerPool, scene->MeshBounds.GetStream(), visibleMeshes.data(),
+			visibleMeshes.size(), visibleMeshes.data());
+		visibleMeshes.resize(visibleCount);
+	}
+
+	// Group the draws by state and front to back
+	XMFLOAT3 viewDirection;
+	camera->GetViewDirection(&viewDirection);
+	XMVECTOR eye = XMLoadFloat3(&cameraPosition);
+	XMVECTOR forward = XMLoadFloat3(&viewDirection);
+
+	drawQueue.Clear();
+	for (auto handle : visibleMeshes)
+	{
+		DXTBounds bounds = scene->MeshBounds.GetBounds(handle);
+		XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&bounds.Lower), XMLoadFloat3(&bounds.Upper)), 0.5f);
+		float viewDepth = XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, eye), forward));
+
+		drawQueue.Add(DXTMakeDrawKey(SCENE_PASS_INDEX, DXTDrawBucketOpaque, STATIC_MESH_PIPELINE_INDEX,
+			scene->Meshes[handle].MeshIndex, viewDepth), handle);
+	}
+
+	drawQueue.Sort();
+	std::copy(drawQueue.GetValues(), drawQueue.GetValues() + drawQueue.GetCount(), visibleMeshes.begin());
+
+	// Sorting put nodes sharing a mesh next to each other, each run becomes one instanced draw
+	instanceGroups.clear();
+
+	D3D11_MAPPED_SUBRESOURCE instanceData;
+	if (SUCCEEDED(context->Map(instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &instanceData)))
+	{
+		XMFLOAT4X4* instances = static_cast<XMFLOAT4X4*>(instanceData.pData);
+		size_t instanceCount = visibleMeshes.size();
+
+		// Whatever sorts last is left out, a scene should never get this far
+		assert(instanceCount <= INSTANCE_BUFFER_CAPACITY);
+		if (instanceCount > INSTANCE_BUFFER_CAPACITY)
+		{
+			OutputDebugString("Visible nodes exceed the instance buffer, the rest are not drawn!\n");
+			instanceCount = INSTANCE_BUFFER_CAPACITY;
+		}
+
+		for (size_t i = 0; i < instanceCount; ++i)
+		{
+			StaticMesh* mesh = scene->Meshes[visibleMeshes[i]].Mesh;
+			if (instanceGroups.empty() || instanceGroups.back().Mesh != mesh)
+			{
+				StaticMeshInstanceGroup group = { mesh, static_cast<UINT>(i), 0 };
+				instanceGroups.push_back(group);
+			}
+
+			instances[i] = worldMatrices[visibleMeshes[i]];
+			++instanceGroups.back().InstanceCount;
+		}
+
+		context->Unmap(instanceBuffer, 0);
+	}
+
+	// All groups share the view constants
+	XMFLOAT4X4* viewConstants = nullptr;
+	UINT firstConstant = 0;
+	UINT constantCount = 0;
+	if (SUCCEEDED(transformRing.Map(context)))
+	{
+		viewConstants = static_cast<XMFLOAT4X4*>(transformRing.Allocate(sizeof(XMFLOAT4X4), &firstConstant, &constantCount));
+		if (viewConstants)
+			*viewConstants = viewProjection;
+
+		transformRing.Unmap(context);
+	}
+
+	ID3D11Buffer* transformBuffer = transformRing.GetBuffer();
+	size_t groupCount = viewConstants ? instanceGroups.size() : 0;
+
+	DXTRecordCommandsParallel(&workerPool, groupCount, COMMAND_LIST_DRAW_COUNT, &commandLists,
+		[this, transformBuffer, firstConstant, constantCount](size_t begin, size_t end, DXTCommandList* list)
+	{
+		if (begin == 0)
+		{
+			list->SetPipeline(staticMeshPipeline);
+			list->SetVertexBuffer(1, instanceBuffer, STATIC_MESH_INSTANCE_STRIDE, 0);
+			list->SetConstantBuffer(0, transformBuffer, firstConstant, constantCount);
+		}
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			const StaticMeshInstanceGroup& group = instanceGroups[i];
+			const StaticMesh& mesh = *group.Mesh;
+
+			list->SetVertexBuffer(0, mesh.VertexBuffer, StaticMeshVertexLayout::Stride, mesh.VertexBufferOffset);
+			list->SetIndexBuffer(mesh.IndexBuffer, mesh.IndexType, mesh.IndexBufferOffset);
+			list->DrawIndexedInstanced(mesh.IndexCount, group.InstanceCount, mesh.StartIndex, mesh.BaseVertex, group.FirstInstance);
+		}
+	});
+
+	// Passes are declared every frame, the graph and its backend keep their storage
+	graphBackend.Reset();
+	DXTFrameGraphResourceDesc diffuseDesc = { (uint32_t)parameters.Extent.Width, (uint32_t)parameters.Extent.Height,
+		DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE };
+	DXTFrameGraphResourceDesc depthDesc = { (uint32_t)parameters.Extent.Width, (uint32_t)parameters.Extent.Height,
+		DXGI_FORMAT_D24_UNORM_S8_UINT, D3D11_BIND_DEPTH_STENCIL };
 	D3D11_VIEWPORT viewport = { 0.0f, 0.0f, (FLOAT)parameters.Extent.Width, (FLOAT)parameters.Extent.Height, 0.0f, 1.0f };
-	context->ClearRenderTargetView(diffuseRenderTarget, clearColor);
-	context->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
-	context->OMSetDepthStencilState(depthStencilStateEnabled, 0);
-	context->OMSetRenderTargets(1, &diffuseRenderTarget, depthStencilView);
-	context->RSSetState(rasterizerState);
-	context->RSSetViewports(1, &viewport);
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	context->VSSetShader(staticMeshVertexShader, nullptr, 0);
-	context->PSSetShader(staticMeshPixelShader, nullptr, 0);
-
-	for (auto& mesh : scene->Meshes)
-	{
-		D3D11_MAPPED_SUBRESOURCE subres;
-		context->Map(transformConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subres);
-
-		context->Unmap(transformConstantBuffer, 0);
+
+	frameGraph.Clear();
+	uint32_t diffuse = frameGraph.CreateResource("Diffuse", diffuseDesc);
+	uint32_t depth = frameGraph.CreateResource("Depth", depthDesc);
+	uint32_t backBuffer = frameGraph.ImportResource("BackBuffer");
+
+	uint32_t geometryPass = frameGraph.AddPass("Geometry", [&]()
+	{
+		FLOAT clearColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		ID3D11RenderTargetView* renderTarget = graphBackend.GetTarget(diffuse).RenderTargetView;
+		ID3D11DepthStencilView* depthStencil = graphBackend.GetTarget(depth).DepthStencilView;
+
+		context->ClearRenderTargetView(renderTarget, clearColor);
+		context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
+		stateCache.SetRenderTargets(1, &renderTarget, depthStencil);
+		stateCache.SetViewports(1, &viewport);
+
+		DXTD3D11CommandBackend backend(&stateCache);
+		DXTReplayCommands(commandLists.data(), commandLists.size(), &backend);
+	});
+	frameGraph.Write(geometryPass, diffuse);
+	frameGraph.Write(geometryPass, depth);
+
+	uint32_t blitPass = frameGraph.AddPass("Blit", [&]()
+	{
+		ID3D11RenderTargetView* renderTarget = graphBackend.GetTarget(backBuffer).RenderTargetView;
+
+		stateCache.SetRenderTargets(1, &renderTarget, nullptr);
+		stateCache.SetViewports(1, &viewport);
+		stateCache.SetPipelineState(*blitPipeline);
+		stateCache.SetVertexBuffer(0, blitVertexBuffer, BLIT_VERTEX_STRIDE, 0);
+		stateCache.SetShaderResource(DXTShaderStagePixel, 0, graphBackend.GetTarget(diffuse).ShaderResourceView);
+		stateCache.SetSampler(DXTShaderStagePixel, 0, blitSamplerState);
+		stateCache.Draw(DXT_BLIT_VERTEX_COUNT, 0);
+	});
+	frameGraph.Read(blitPass, diffuse);
+	frameGraph.Write(blitPass, backBuffer);
+
+	DXTRenderTarget backBufferTarget = {};
+	backBufferTarget.RenderTargetView = backBufferRenderTarget;
+	graphBackend.SetImportedTarget(backBuffer, backBufferTarget);
+
+	frameGraph.Compile();
+	frameGraph.Execute(&graphBackend);
+
+	transformRing.EndFrame(context);
+}
+
+HRESULT Renderer::LoadStaticModel(const char* path, StaticModel* modelOut)
+{
+	DXTMappedMeshFile file;
+	HRESULT result = file.Open(path);
+	if (FAILED(result))
+		return result;
+
+	// The pool only holds the layout the static mesh shaders read
+	const DXTMeshFileData& data = file.GetData();
+	if (data.FormatHash != DXTGetVertexFormatHash(StaticMeshVertexLayout::GetFormat()) || data.IndexSize != sizeof(UINT))
+		return E_INVALIDARG;
+
+	UINT handle;
+	result = geometryPool.Allocate(context, data.Vertices, data.VertexCount, data.Indices, data.IndexCount, &handle);
+	if (FAILED(result))
+		return result;
+
+	DXTGeometryLocation location;
+	geometryPool.GetLocation(handle, &location);
+
+	modelOut->GeometryHandle = handle;
+	modelOut->StartIndex = location.StartIndex;
+	modelOut->BaseVertex = location.BaseVertex;
+	modelOut->Meshes.resize(data.SubmeshCount);
+
+	// Positions lead every vertex of the layout
+	const BYTE* vertex = static_cast<const BYTE*>(data.Vertices);
+	modelOut->OccluderVertices.resize(data.VertexCount);
+	for (size_t i = 0; i < data.VertexCount; ++i, vertex += data.VertexStride)
+		memcpy(&modelOut->OccluderVertices[i], vertex, sizeof(XMFLOAT3));
+
+	const UINT* indices = static_cast<const UINT*>(data.Indices);
+	modelOut->OccluderIndices.assign(indices, indices + data.IndexCount);
+	modelOut->Nodes.assign(data.Nodes, data.Nodes + data.NodeCount);
+
+	for (size_t i = 0; i < data.SubmeshCount; ++i)
+	{
+		const DXTMeshFileSubmesh& submesh = data.Submeshes[i];
+		StaticMesh& mesh = modelOut->Meshes[i];
+
+		mesh.VertexBuffer = location.VertexBuffer;
+		mesh.IndexBuffer = location.IndexBuffer;
+		mesh.VertexBufferOffset = 0;
+		mesh.IndexBufferOffset = 0;
+		mesh.IndexCount = submesh.IndexCount;
+		mesh.IndexType = geometryPool.GetIndexType();
+		mesh.StartIndex = location.StartIndex + submesh.StartIndex;
+		mesh.BaseVertex = location.BaseVertex + submesh.BaseVertex;
+		mesh.GeometryHandle = handle;
+		mesh.MaterialIndex = submesh.MaterialIndex;
+		DXTGetMeshFileBounds(submesh.Bounds, &mesh.Bounds);
+		mesh.OccluderVertices = modelOut->OccluderVertices.data() + submesh.BaseVertex;
+		mesh.OccluderIndices = modelOut->OccluderIndices.data() + submesh.StartIndex;
+		mesh.OccluderVertexCount = submesh.VertexCount;
 	}
+
+	if (pooledModels.size() <= handle)
+		pooledModels.resize(handle + 1);
+	pooledModels[handle] = modelOut;
+
+	return S_OK;
 }
 
-void Renderer::Release()
+void Renderer::UnloadStaticModel(StaticModel* model)
 {
-	diffuseBuffer->Release();
-	diffuseRenderTarget->Release();
-	diffuseResourceView->Release();
+	if (model->GeometryHandle == DXT_GEOMETRY_POOL_NULL_HANDLE)
+		return;
 
-	depthTexture->Release();
-	depthStencilView->Release();
+	geometryPool.Free(model->GeometryHandle);
+	pooledModels[model->GeometryHandle] = nullptr;
+	model->GeometryHandle = DXT_GEOMETRY_POOL_NULL_HANDLE;
+	model->Meshes.clear();
+	model->OccluderVertices.clear();
+	model->OccluderIndices.clear();
+	model->Nodes.clear();
+}
+
+void Renderer::Release()
+{
 	backBufferRenderTarget->Release();
-	rasterizerState->Release();
-	depthStencilStateEnabled->Release();
-	depthStencilStateDisabled->Release();
 	blitSamplerState->Release();
 	staticMeshSamplerState->Release();
 
-	staticMeshVertexShader->Release();
-	staticMeshPixelShader->Release();
-	blitVertexShader->Release();
-	blitPixelShader->Release();
-
 	blitVertexBuffer->Release();
-	blitInputLayout->Release();
-	staticMeshInputLayout->Release();
+	instanceBuffer->Release();
 
-	transformConstantBuffer->Release();
+	transformRing.Release();
+	renderTargets.Release();
+	stateObjects.Release();
+	geometryPool.Release();
+	stateCache.Release();
 
 	context->Release();
 	device->Release();
@@ -1,13 +1,50 @@
 #pragma once
 
 #include "DirectXToolbox.h"
+#include "AABBTree.h"
+#include "TransformStore.h"
+#include "DrawQueue.h"
+#include "OcclusionCuller.h"
+#include "SceneGraph.h"
 
+#include <unordered_map>
 #include <vector>
 
-#define STATIC_MESH_VERTEX_SHADER "VertexShader.cso"
+#define STATIC_MESH_VERTEX_SHADER "InstancedVertexShader.cso"
 #define STATIC_MESH_PIXEL_SHADER "PixelShader.cso"
 #define BLIT_MESH_VERTEX_SHADER "BlitVertexShader.cso"
 #define BLIT_MESH_PIXEL_SHADER "BlitPixelShader.cso"
+// Position and texture coordinate of the blit quad
+#define BLIT_VERTEX_STRIDE (sizeof(float) * 4)
+// Below this many nodes the tree query beats testing the bounds of every node
+#define STREAM_CULL_MIN_NODE_COUNT 1024
+// Below this many nodes the stream is culled on the calling thread, above it across the worker pool
+#define PARALLEL_CULL_MIN_NODE_COUNT 16384
+// Nodes whose bounding sphere covers fewer pixels across are not drawn
+#define MIN_PROJECTED_SIZE 2.0f
+// The largest visible nodes at least this many pixels across are rasterized as occluders
+#define OCCLUDER_MIN_PROJECTED_SIZE 64.0f
+#define OCCLUDER_MAX_COUNT 32
+// Room for the view constants of many frames in flight
+#define TRANSFORM_RING_SIZE (256 * DXT_CONSTANT_BUFFER_ALIGNMENT)
+// A world matrix per instance
+#define STATIC_MESH_INSTANCE_STRIDE sizeof(DirectX::XMFLOAT4X4)
+// Instances that fit into the instance buffer, visible nodes past this assert and are skipped in release builds
+#define INSTANCE_BUFFER_CAPACITY 131072
+// Instanced draws recorded into each command list by one worker
+#define COMMAND_LIST_DRAW_COUNT 256
+// Meshes loaded through the renderer share vertex and index pages of this many elements
+#define GEOMETRY_PAGE_VERTEX_COUNT 1048576
+#define GEOMETRY_PAGE_INDEX_COUNT 3145728
+// Geometry moved by the incremental defragmentation each frame
+#define GEOMETRY_DEFRAG_BYTES_PER_FRAME (1024 * 1024)
+// Scene graph nodes that don't place a mesh node
+#define SCENE_NO_MESH_NODE 0xFFFFFFFF
+#define SCENE_PASS_INDEX 0
+#define STATIC_MESH_PIPELINE_INDEX 0
+
+// Vertices of static meshes, InstancedVertexShaderInput starts with the same attributes
+typedef DXTVertexLayoutPositionUVNormal StaticMeshVertexLayout;
 
 struct StaticMesh
 {
@@ -16,21 +53,90 @@ struct StaticMesh
 	UINT VertexBufferOffset;
 	UINT IndexBufferOffset;
 	UINT IndexCount;
+	DXTIndexType IndexType;
+	// Where the mesh starts within shared buffers, zero for meshes owning their buffers
+	UINT StartIndex;
+	INT BaseVertex;
+	// Pool allocation of meshes loaded through the renderer, DXT_GEOMETRY_POOL_NULL_HANDLE otherwise
+	UINT GeometryHandle;
+	UINT MaterialIndex;
+	DXTBounds Bounds;
+	// Positions and indices the occlusion culler rasterizes, null for meshes that don't occlude
+	const DirectX::XMFLOAT3* OccluderVertices;
+	const UINT* OccluderIndices;
+	UINT OccluderVertexCount;
+};
+
+// Submeshes of one mesh file, sharing a single geometry pool allocation
+struct StaticModel
+{
+	std::vector<StaticMesh> Meshes;
+	UINT GeometryHandle;
+	// Location of the allocation the submesh offsets were computed from
+	UINT StartIndex;
+	INT BaseVertex;
+	// CPU copies of the geometry, the occluder data of the submeshes points into them
+	std::vector<DirectX::XMFLOAT3> OccluderVertices;
+	std::vector<UINT> OccluderIndices;
+	// Hierarchy of the source file, the submeshes are in the space of the nodes referencing them
+	std::vector<DXTMeshFileNode> Nodes;
 };
 
 struct StaticMeshNode
 {
 	StaticMesh* Mesh;
-	DirectX::XMFLOAT3 Position;
-	DirectX::XMVECTOR RotationQuaternion;
-	DirectX::XMFLOAT3 Scale;
-	DirectX::XMMATRIX Transformation;
+	// Dense index of the mesh, draws are sorted on it. The draw key holds 2^DXT_DRAW_KEY_MESH_BITS distinct meshes.
+	UINT MeshIndex;
+	// Created on the first transform update
+	int TreeProxy;
+	// Leaf of the scene graph placing the mesh
+	UINT GraphNode;
 };
 
 class Scene
 {
 public:
+	// Nodes, their transforms, world matrices and world space bounds are all indexed by node handle. Transforms are
+	// relative to the graph node the mesh node was added below, groups of nodes are moved through the graph.
 	std::vector<StaticMeshNode> Meshes;
+	DXTTransformStore Transforms;
+	std::vector<DirectX::XMFLOAT4X4> WorldMatrices;
+	DXTSceneGraph Graph;
+	DXTAABBTree MeshTree;
+	DXTBoundsStreamBuffer MeshBounds;
+
+	UINT AddMeshNode(StaticMesh* mesh, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT4& rotation,
+		const DirectX::XMFLOAT3& scale, const UINT parent = DXT_SCENE_GRAPH_NO_PARENT);
+	void RemoveMeshNode(const UINT handle);
+	// Recreates the node hierarchy of the model file below a new graph node with the given transform and adds a mesh
+	// node wherever a submesh is placed. Returns the new graph node, meshNodesOut may be null.
+	UINT AddModel(StaticModel* model, const DirectX::XMFLOAT4X4& transform, const UINT parent, std::vector<UINT>* meshNodesOut);
+	// Recomposes the transforms that changed, propagates them through the graph and refits the bounds of every mesh
+	// node that moved
+	void UpdateTransforms(DXTWorkerPool* pool);
+
+private:
+	std::vector<UINT> updatedNodes;
+	std::vector<UINT> updatedGraphNodes;
+	// Mesh node of each graph handle, SCENE_NO_MESH_NODE for the nodes in between
+	std::vector<UINT> graphMeshNodes;
+	std::vector<DXTSceneGraphMesh> modelMeshes;
+	std::unordered_map<const StaticMesh*, UINT> meshIndices;
+	// Mesh nodes moved by the current update with their local bounds and world matrices, batched for the transform
+	std::vector<UINT> movedNodes;
+	std::vector<DXTBounds> movedLocalBounds;
+	std::vector<DirectX::XMFLOAT4X4> movedMatrices;
+	DXTBoundsStreamBuffer movedBounds;
+
+	void UpdateNodeBounds(const UINT handle, const DXTBounds& worldBounds);
+};
+
+// Consecutive sorted visible nodes that share a mesh, drawn with a single instanced draw
+struct StaticMeshInstanceGroup
+{
+	StaticMesh* Mesh;
+	UINT FirstInstance;
+	UINT InstanceCount;
 };
 
 class Renderer
@@ -40,32 +146,60 @@ public:
 	void Render(Scene* scene, DXTCameraBase* camera);
 	void Release();
 
+	// Loads a mesh file cooked with position, texture coordinate and normal channels and 32 bit indices into the
+	// shared geometry pool, a StaticMesh per submesh. The model must stay at the same address until unloaded.
+	HRESULT LoadStaticModel(const char* path, StaticModel* modelOut);
+	void UnloadStaticModel(StaticModel* model);
+
+	// State calls of the last rendered frame
+	inline const DXTStateCacheStats& GetStateStats() const;
+	inline const DXTOcclusionStats& GetOcclusionStats() const;
+
 private:
 	DXTRenderParams parameters;
 	IDXGISwapChain* swapChain;
 	ID3D11Device* device;
 	ID3D11DeviceContext* context;
 
-	ID3D11Texture2D* diffuseBuffer;
-	ID3D11RenderTargetView* diffuseRenderTarget;
-	ID3D11ShaderResourceView* diffuseResourceView;
-	ID3D11Texture2D* depthTexture;
-	ID3D11DepthStencilView* depthStencilView;
 	ID3D11RenderTargetView* backBufferRenderTarget;
-	ID3D11RasterizerState* rasterizerState;
-	ID3D11DepthStencilState* depthStencilStateEnabled;
-	ID3D11DepthStencilState* depthStencilStateDisabled;
 	ID3D11SamplerState* blitSamplerState;
 	ID3D11SamplerState* staticMeshSamplerState;
 
-	ID3D11VertexShader* staticMeshVertexShader;
-	ID3D11PixelShader* staticMeshPixelShader;
-	ID3D11VertexShader* blitVertexShader;
-	ID3D11PixelShader* blitPixelShader;
-
 	ID3D11Buffer* blitVertexBuffer;
-	ID3D11InputLayout* blitInputLayout;
-	ID3D11InputLayout* staticMeshInputLayout;
+	ID3D11Buffer* instanceBuffer;
+
+	DXTRenderTargetPool renderTargets;
+	DXTFrameGraph frameGraph;
+	DXTD3D11FrameGraphBackend graphBackend;
+	DXTStateObjectCache stateObjects;
+	const DXTPipelineState* staticMeshPipeline;
+	const DXTPipelineState* blitPipeline;
+	DXTStateCache stateCache;
+
+	DXTConstantBufferRing transformRing;
+
+	DXTGeometryPool geometryPool;
+	// Indexed by geometry handle
+	std::vector<StaticModel*> pooledModels;
+	std::vector<UINT> movedGeometry;
 
-	ID3D11Buffer* transformConstantBuffer;
-};
\ No newline at end of file
+	DXTWorkerPool workerPool;
+	DXTParallelCullScratch cullScratch;
+	std::vector<UINT> visibleMeshes;
+	DXTOcclusionCuller occlusionCuller;
+	// Projected size and node handle of the visible nodes that can occlude
+	std::vector<std::pair<float, UINT>> occluderCandidates;
+	DXTDrawQueue drawQueue;
+	std::vector<StaticMeshInstanceGroup> instanceGroups;
+	std::vector<DXTCommandList> commandLists;
+};
+
+inline const DXTStateCacheStats& Renderer::GetStateStats() const
+{
+	return stateCache.GetStats();
+}
+
+inline const DXTOcclusionStats& Renderer::GetOcclusionStats() const
+{
+	return occlusionCuller.GetStats();
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "RingAllocator.h"
+
+DXTRingAllocator::DXTRingAllocator() :
+	DXTRingAllocator(0, 1)
+{
+}
+
+DXTRingAllocator::DXTRingAllocator(const size_t capacity, const size_t alignment)
+{
+	Reset(capacity, alignment);
+}
+
+void DXTRingAllocator::Reset(const size_t capacity, const size_t alignment)
+{
+	this->capacity = capacity;
+	this->alignment = alignment > 0 ? alignment : 1;
+	ReleaseAll();
+}
+
+bool DXTRingAllocator::Allocate(const size_t size, size_t* offsetOut)
+{
+	size_t alignedSize = (size + alignment - 1) / alignment * alignment;
+	if (alignedSize == 0 || alignedSize > capacity)
+		return false;
+
+	// Nothing in flight, so start over at the front and keep the allocations contiguous
+	if (usedSize == 0 && fences.empty())
+	{
+		head = 0;
+		tail = 0;
+	}
+
+	size_t offset;
+	size_t consumed = alignedSize;
+
+	if (head >= tail && usedSize < capacity)
+	{
+		if (head + alignedSize <= capacity)
+		{
+			offset = head;
+		}
+		else if (alignedSize <= tail)
+		{
+			// Wrap around, the skipped end of the ring is freed along with this frame
+			offset = 0;
+			consumed += capacity - head;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if (head + alignedSize <= tail)
+	{
+		offset = head;
+	}
+	else
+	{
+		return false;
+	}
+
+	head = offset + alignedSize;
+	if (head == capacity)
+		head = 0;
+
+	usedSize += consumed;
+	frameSize += consumed;
+
+	*offsetOut = offset;
+	return true;
+}
+
+void DXTRingAllocator::EndFrame(const uint64_t frame)
+{
+	Fence fence = { frame, head, frameSize };
+	fences.push_back(fence);
+	frameSize = 0;
+}
+
+void DXTRingAllocator::ReleaseFrames(const uint64_t completedFrame)
+{
+	while (!fences.empty() && fences.front().Frame <= completedFrame)
+	{
+		tail = fences.front().Head;
+		usedSize -= fences.front().Size;
+		fences.pop_front();
+	}
+}
+
+void DXTRingAllocator::ReleaseAll()
+{
+	head = 0;
+	tail = 0;
+	usedSize = 0;
+	frameSize = 0;
+	fences.clear();
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Linear suballocator over a circular range of a buffer. Allocations are grouped into frames,
+// a frame's range only becomes free again once ReleaseFrames reports it as completed.
+// Only deals in offsets, so it can be driven against any buffer or none at all.
+class DXTRingAllocator
+{
+public:
+	DXTRingAllocator();
+	DXTRingAllocator(const size_t capacity, const size_t alignment);
+
+	void Reset(const size_t capacity, const size_t alignment);
+
+	// Returns false when the ring is full, offsetOut is then left untouched
+	bool Allocate(const size_t size, size_t* offsetOut);
+	// Fences everything allocated since the previous EndFrame with the given frame
+	void EndFrame(const uint64_t frame);
+	// Frees the ranges of every fenced frame up to and including completedFrame
+	void ReleaseFrames(const uint64_t completedFrame);
+	// Frees everything, for when the whole buffer was discarded
+	void ReleaseAll();
+
+	inline size_t GetCapacity() const;
+	inline size_t GetUsedSize() const;
+	inline size_t GetPendingFrameCount() const;
+	inline uint64_t GetOldestPendingFrame() const;
+
+private:
+	struct Fence
+	{
+		uint64_t Frame;
+		size_t Head;
+		size_t Size;
+	};
+
+	size_t capacity;
+	size_t alignment;
+	size_t head;
+	size_t tail;
+	size_t usedSize;
+	size_t frameSize;
+	std::deque<Fence> fences;
+};
+
+inline size_t DXTRingAllocator::GetCapacity() const
+{
+	return capacity;
+}
+
+inline size_t DXTRingAllocator::GetUsedSize() const
+{
+	return usedSize;
+}
+
+inline size_t DXTRingAllocator::GetPendingFrameCount() const
+{
+	return fences.size();
+}
+
+inline uint64_t DXTRingAllocator::GetOldestPendingFrame() const
+{
+	return fences.front().Frame;
+}
\ No newline at end of file
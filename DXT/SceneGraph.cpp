@@ -0,0 +1,234 @@
+#include "SceneGraph.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+using namespace DirectX;
+
+DXTSceneGraph::DXTSceneGraph() :
+	firstDirtyLevel(SIZE_MAX),
+	bLayoutDirty(false)
+{
+}
+
+UINT DXTSceneGraph::CreateNode(const UINT parent, const XMFLOAT4X4& localTransform)
+{
+	UINT index = static_cast<UINT>(handles.size());
+	UINT handle;
+
+	if (freeHandles.empty())
+	{
+		handle = static_cast<UINT>(handleToIndex.size());
+		handleToIndex.push_back(index);
+	}
+	else
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+		handleToIndex[handle] = index;
+	}
+
+	UINT parentIndex = parent == DXT_SCENE_GRAPH_NO_PARENT ? DXT_SCENE_GRAPH_NO_PARENT : handleToIndex[parent];
+	UINT depth = parentIndex == DXT_SCENE_GRAPH_NO_PARENT ? 0 : depths[parentIndex] + 1;
+
+	if (parentIndex != DXT_SCENE_GRAPH_NO_PARENT)
+		childCounts[parentIndex]++;
+
+	// Appended out of order for now, the next update sorts it into its level
+	parents.push_back(parentIndex);
+	depths.push_back(depth);
+	localTransforms.push_back(localTransform);
+	worldTransforms.push_back(localTransform);
+	dirtyFlags.push_back(1);
+	childCounts.push_back(0);
+	handles.push_back(handle);
+
+	firstDirtyLevel = min<size_t>(firstDirtyLevel, depth);
+	bLayoutDirty = true;
+
+	return handle;
+}
+
+void DXTSceneGraph::DestroyNode(const UINT node)
+{
+	UINT index = handleToIndex[node];
+	assert(childCounts[index] == 0);
+
+	if (parents[index] != DXT_SCENE_GRAPH_NO_PARENT)
+		childCounts[parents[index]]--;
+
+	// The slot stays in place until the next update rebuilds the layout without it
+	depths[index] = DXT_SCENE_GRAPH_DESTROYED_DEPTH;
+	dirtyFlags[index] = 0;
+	freeHandles.push_back(node);
+	bLayoutDirty = true;
+}
+
+void DXTSceneGraph::Clear()
+{
+	parents.clear();
+	depths.clear();
+	localTransforms.clear();
+	worldTransforms.clear();
+	dirtyFlags.clear();
+	childCounts.clear();
+	handles.clear();
+	handleToIndex.clear();
+	freeHandles.clear();
+	levelStarts.clear();
+	firstDirtyLevel = SIZE_MAX;
+	bLayoutDirty = false;
+}
+
+void DXTSceneGraph::SetLocalTransform(const UINT node, const XMFLOAT4X4& localTransform)
+{
+	UINT index = handleToIndex[node];
+	localTransforms[index] = localTransform;
+	dirtyFlags[index] = 1;
+	firstDirtyLevel = min<size_t>(firstDirtyLevel, depths[index]);
+}
+
+void DXTSceneGraph::Update(DXTWorkerPool* pool, vector<UINT>* updatedOut)
+{
+	if (bLayoutDirty)
+		RebuildLayout();
+
+	size_t levelCount = GetLevelCount();
+	if (firstDirtyLevel >= levelCount)
+		return;
+
+	for (size_t level = firstDirtyLevel; level < levelCount; ++level)
+	{
+		PropagateLevel(pool, level);
+
+		// The children of the previous level have seen its flags now
+		if (level > firstDirtyLevel)
+			ClearLevelFlags(level - 1, updatedOut);
+	}
+
+	ClearLevelFlags(levelCount - 1, updatedOut);
+	firstDirtyLevel = SIZE_MAX;
+}
+
+void DXTSceneGraph::ClearLevelFlags(const size_t level, vector<UINT>* updatedOut)
+{
+	size_t levelStart = levelStarts[level];
+	size_t levelEnd = levelStarts[level + 1];
+
+	if (updatedOut)
+		for (size_t i = levelStart; i < levelEnd; ++i)
+			if (dirtyFlags[i])
+				updatedOut->push_back(handles[i]);
+
+	memset(dirtyFlags.data() + levelStart, 0, levelEnd - levelStart);
+}
+
+void DXTSceneGraph::RebuildLayout()
+{
+	size_t count = handles.size();
+
+	UINT levelCount = 0;
+	for (auto depth : depths)
+		if (depth != DXT_SCENE_GRAPH_DESTROYED_DEPTH)
+			levelCount = max(levelCount, depth + 1);
+
+	// Counting sort by depth, stable so nodes keep their relative order within a level
+	levelStarts.assign(levelCount + 1, 0);
+	for (auto depth : depths)
+		if (depth != DXT_SCENE_GRAPH_DESTROYED_DEPTH)
+			levelStarts[depth + 1]++;
+	for (UINT i = 0; i < levelCount; ++i)
+		levelStarts[i + 1] += levelStarts[i];
+
+	vector<size_t> cursor(levelStarts.begin(), levelStarts.end() - 1);
+	vector<UINT> oldToNew(count);
+	for (size_t i = 0; i < count; ++i)
+		if (depths[i] != DXT_SCENE_GRAPH_DESTROYED_DEPTH)
+			oldToNew[i] = static_cast<UINT>(cursor[depths[i]]++);
+
+	size_t liveCount = levelStarts[levelCount];
+	vector<UINT> newParents(liveCount);
+	vector<UINT> newDepths(liveCount);
+	vector<XMFLOAT4X4> newLocalTransforms(liveCount);
+	vector<XMFLOAT4X4> newWorldTransforms(liveCount);
+	vector<UINT8> newDirtyFlags(liveCount);
+	vector<UINT> newChildCounts(liveCount);
+	vector<UINT> newHandles(liveCount);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (depths[i] == DXT_SCENE_GRAPH_DESTROYED_DEPTH)
+			continue;
+
+		UINT index = oldToNew[i];
+		newParents[index] = parents[i] == DXT_SCENE_GRAPH_NO_PARENT ? DXT_SCENE_GRAPH_NO_PARENT : oldToNew[parents[i]];
+		newDepths[index] = depths[i];
+		newLocalTransforms[index] = localTransforms[i];
+		newWorldTransforms[index] = worldTransforms[i];
+		newDirtyFlags[index] = dirtyFlags[i];
+		newChildCounts[index] = childCounts[i];
+		newHandles[index] = handles[i];
+		handleToIndex[handles[i]] = index;
+	}
+
+	parents.swap(newParents);
+	depths.swap(newDepths);
+	localTransforms.swap(newLocalTransforms);
+	worldTransforms.swap(newWorldTransforms);
+	dirtyFlags.swap(newDirtyFlags);
+	childCounts.swap(newChildCounts);
+	handles.swap(newHandles);
+
+	bLayoutDirty = false;
+}
+
+void DXTSceneGraph::PropagateLevel(DXTWorkerPool* pool, const size_t level)
+{
+	size_t levelStart = levelStarts[level];
+	size_t levelCount = levelStarts[level + 1] - levelStart;
+
+	pool->ParallelFor(levelCount, DXT_SCENE_GRAPH_GRAIN_SIZE, [this, levelStart](size_t begin, size_t end, size_t threadIndex)
+	{
+		for (size_t i = levelStart + begin; i < levelStart + end; ++i)
+		{
+			UINT parent = parents[i];
+
+			if (parent == DXT_SCENE_GRAPH_NO_PARENT)
+			{
+				if (dirtyFlags[i])
+					worldTransforms[i] = localTransforms[i];
+				continue;
+			}
+
+			// Parents are always on the previous level, so their flags and transforms are final
+			if (!dirtyFlags[i] && !dirtyFlags[parent])
+				continue;
+
+			dirtyFlags[i] = 1;
+			XMStoreFloat4x4(&worldTransforms[i],
+				XMMatrixMultiply(XMLoadFloat4x4(&localTransforms[i]), XMLoadFloat4x4(&worldTransforms[parent])));
+		}
+	});
+}
+
+void DXTAddMeshFileNodes(const DXTMeshFileNode* nodes, const size_t nodeCount, const UINT parent, DXTSceneGraph* graph,
+	vector<DXTSceneGraphMesh>* meshesOut)
+{
+	// Parents come first in the file, so their handles exist by the time a child is created
+	vector<UINT> nodeHandles(nodeCount);
+
+	for (size_t i = 0; i < nodeCount; ++i)
+	{
+		const DXTMeshFileNode& node = nodes[i];
+		UINT nodeParent = node.Parent == DXT_MESH_FILE_NONE ? parent : nodeHandles[node.Parent];
+		nodeHandles[i] = graph->CreateNode(nodeParent, XMFLOAT4X4(&node.Transform[0][0]));
+
+		if (node.Submesh != DXT_MESH_FILE_NONE)
+		{
+			DXTSceneGraphMesh mesh = { nodeHandles[i], node.Submesh };
+			meshesOut->push_back(mesh);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "DirectXToolbox.h"
+#include "WorkerPool.h"
+
+#include <vector>
+
+#define DXT_SCENE_GRAPH_NO_PARENT 0xFFFFFFFF
+// Depth of destroyed nodes until the next layout rebuild drops them
+#define DXT_SCENE_GRAPH_DESTROYED_DEPTH 0xFFFFFFFF
+#define DXT_SCENE_GRAPH_GRAIN_SIZE 1024
+
+struct DXTSceneGraphMesh
+{
+	UINT Node;
+	UINT MeshIndex;
+};
+
+// Transform hierarchy stored as flat arrays in breadth first order, so every parent comes before
+// its children and each depth is a contiguous range. World transforms are propagated one level at a
+// time with the nodes of a level split across the worker pool. Handles stay valid when the layout is
+// rebuilt, parents have to be created before their children. Handles of destroyed nodes are reused.
+class DXTSceneGraph
+{
+public:
+	DXTSceneGraph();
+
+	UINT CreateNode(const UINT parent, const DirectX::XMFLOAT4X4& localTransform);
+	// Only nodes without children can be destroyed
+	void DestroyNode(const UINT node);
+	void Clear();
+
+	void SetLocalTransform(const UINT node, const DirectX::XMFLOAT4X4& localTransform);
+	// Propagates world transforms through the dirty subtrees, reordering the arrays first if nodes were added or
+	// destroyed. Handles of the nodes whose world transform was recomputed are appended to updatedOut when it is given.
+	void Update(DXTWorkerPool* pool, std::vector<UINT>* updatedOut = nullptr);
+
+	inline const DirectX::XMFLOAT4X4& GetLocalTransform(const UINT node) const;
+	inline const DirectX::XMFLOAT4X4& GetWorldTransform(const UINT node) const;
+	inline UINT GetParent(const UINT node) const;
+	inline UINT GetChildCount(const UINT node) const;
+	inline size_t GetNodeCount() const;
+	inline size_t GetLevelCount() const;
+
+private:
+	// Indexed by position in breadth first order
+	std::vector<UINT> parents;
+	std::vector<UINT> depths;
+	std::vector<DirectX::XMFLOAT4X4> localTransforms;
+	std::vector<DirectX::XMFLOAT4X4> worldTransforms;
+	// Bytes rather than bits so workers can flag nodes of the same level without racing
+	std::vector<UINT8> dirtyFlags;
+	std::vector<UINT> childCounts;
+	std::vector<UINT> handles;
+
+	std::vector<UINT> handleToIndex;
+	std::vector<UINT> freeHandles;
+	// Level i covers [levelStarts[i], levelStarts[i + 1])
+	std::vector<size_t> levelStarts;
+	size_t firstDirtyLevel;
+	bool bLayoutDirty;
+
+	void RebuildLayout();
+	void PropagateLevel(DXTWorkerPool* pool, const size_t level);
+	void ClearLevelFlags(const size_t level, std::vector<UINT>* updatedOut);
+};
+
+// Creates a node per mesh file node below parent, meshesOut receives the nodes drawing a submesh
+void DXTAddMeshFileNodes(const DXTMeshFileNode* nodes, const size_t nodeCount, const UINT parent, DXTSceneGraph* graph,
+	std::vector<DXTSceneGraphMesh>* meshesOut);
+
+inline const DirectX::XMFLOAT4X4& DXTSceneGraph::GetLocalTransform(const UINT node) const
+{
+	return localTransforms[handleToIndex[node]];
+}
+
+inline const DirectX::XMFLOAT4X4& DXTSceneGraph::GetWorldTransform(const UINT node) const
+{
+	return worldTransforms[handleToIndex[node]];
+}
+
+inline UINT DXTSceneGraph::GetParent(const UINT node) const
+{
+	UINT parent = parents[handleToIndex[node]];
+	return parent == DXT_SCENE_GRAPH_NO_PARENT ? parent : handles[parent];
+}
+
+inline UINT DXTSceneGraph::GetChildCount(const UINT node) const
+{
+	return childCounts[handleToIndex[node]];
+}
+
+inline size_t DXTSceneGraph::GetNodeCount() const
+{
+	return handleToIndex.size() - freeHandles.size();
+}
+
+inline size_t DXTSceneGraph::GetLevelCount() const
+{
+	return levelStarts.empty() ? 0 : levelStarts.size() - 1;
+}
\ No newline at end of file
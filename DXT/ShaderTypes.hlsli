@@ -1,8 +1,22 @@
+// Attributes of DXTVertexLayoutPositionUVNormalQuantized, in the same order. The position is normalized within
+// the mesh bounds and the normal octahedral encoded, the vertex shader decodes both.
 struct VertexShaderInput
+{
+	float4 pos : POSITION;
+	float2 uv : TEXCOORD;
+	float2 normal : NORMAL;
+};
+
+// Per instance attributes follow the vertex of StaticMeshVertexLayout, the world matrix arrives one row per element
+struct InstancedVertexShaderInput
 {
 	float3 pos : POSITION;
 	float2 uv : TEXCOORD;
 	float3 normal : NORMAL;
+	float4 world0 : WORLD0;
+	float4 world1 : WORLD1;
+	float4 world2 : WORLD2;
+	float4 world3 : WORLD3;
 };
 
 struct VertexShaderOutput
@@ -0,0 +1,170 @@
+#include "StateObjectTable.h"
+
+#include <cstring>
+
+using namespace std;
+
+#define DXT_APPEND_FIELD(key, field) (key)->Append(&(field), sizeof(field))
+
+uint64_t DXTHashBytes(const void* data, const size_t length, const uint64_t seed)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= DXT_STATE_KEY_FNV_PRIME;
+	}
+
+	return hash;
+}
+
+DXTStateKey::DXTStateKey() :
+	hash(DXT_STATE_KEY_FNV_OFFSET_BASIS)
+{
+}
+
+void DXTStateKey::Clear()
+{
+	bytes.clear();
+	hash = DXT_STATE_KEY_FNV_OFFSET_BASIS;
+}
+
+void DXTStateKey::Append(const void* data, const size_t length)
+{
+	const uint8_t* source = static_cast<const uint8_t*>(data);
+	bytes.insert(bytes.end(), source, source + length);
+	hash = DXTHashBytes(data, length, hash);
+}
+
+void DXTStateKey::AppendString(const char* string)
+{
+	if (!string)
+		string = "";
+
+	Append(string, strlen(string) + 1);
+}
+
+void DXTMakeStateKey(const D3D11_RASTERIZER_DESC& desc, DXTStateKey* keyOut)
+{
+	keyOut->Clear();
+	DXT_APPEND_FIELD(keyOut, desc.FillMode);
+	DXT_APPEND_FIELD(keyOut, desc.CullMode);
+	DXT_APPEND_FIELD(keyOut, desc.FrontCounterClockwise);
+	DXT_APPEND_FIELD(keyOut, desc.DepthBias);
+	DXT_APPEND_FIELD(keyOut, desc.DepthBiasClamp);
+	DXT_APPEND_FIELD(keyOut, desc.SlopeScaledDepthBias);
+	DXT_APPEND_FIELD(keyOut, desc.DepthClipEnable);
+	DXT_APPEND_FIELD(keyOut, desc.ScissorEnable);
+	DXT_APPEND_FIELD(keyOut, desc.MultisampleEnable);
+	DXT_APPEND_FIELD(keyOut, desc.AntialiasedLineEnable);
+}
+
+static void DXTAppendStencilOpDesc(const D3D11_DEPTH_STENCILOP_DESC& desc, DXTStateKey* keyOut)
+{
+	DXT_APPEND_FIELD(keyOut, desc.StencilFailOp);
+	DXT_APPEND_FIELD(keyOut, desc.StencilDepthFailOp);
+	DXT_APPEND_FIELD(keyOut, desc.StencilPassOp);
+	DXT_APPEND_FIELD(keyOut, desc.StencilFunc);
+}
+
+void DXTMakeStateKey(const D3D11_DEPTH_STENCIL_DESC& desc, DXTStateKey* keyOut)
+{
+	keyOut->Clear();
+	DXT_APPEND_FIELD(keyOut, desc.DepthEnable);
+	DXT_APPEND_FIELD(keyOut, desc.DepthWriteMask);
+	DXT_APPEND_FIELD(keyOut, desc.DepthFunc);
+	DXT_APPEND_FIELD(keyOut, desc.StencilEnable);
+	DXT_APPEND_FIELD(keyOut, desc.StencilReadMask);
+	DXT_APPEND_FIELD(keyOut, desc.StencilWriteMask);
+	DXTAppendStencilOpDesc(desc.FrontFace, keyOut);
+	DXTAppendStencilOpDesc(desc.BackFace, keyOut);
+}
+
+void DXTMakeStateKey(const D3D11_BLEND_DESC& desc, DXTStateKey* keyOut)
+{
+	keyOut->Clear();
+	DXT_APPEND_FIELD(keyOut, desc.AlphaToCoverageEnable);
+	DXT_APPEND_FIELD(keyOut, desc.IndependentBlendEnable);
+
+	// Without independent blending the other targets are ignored and may hold anything
+	UINT targetCount = desc.IndependentBlendEnable ? D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT : 1;
+	for (UINT i = 0; i < targetCount; ++i)
+	{
+		const D3D11_RENDER_TARGET_BLEND_DESC& target = desc.RenderTarget[i];
+		DXT_APPEND_FIELD(keyOut, target.BlendEnable);
+		DXT_APPEND_FIELD(keyOut, target.SrcBlend);
+		DXT_APPEND_FIELD(keyOut, target.DestBlend);
+		DXT_APPEND_FIELD(keyOut, target.BlendOp);
+		DXT_APPEND_FIELD(keyOut, target.SrcBlendAlpha);
+		DXT_APPEND_FIELD(keyOut, target.DestBlendAlpha);
+		DXT_APPEND_FIELD(keyOut, target.BlendOpAlpha);
+		DXT_APPEND_FIELD(keyOut, target.RenderTargetWriteMask);
+	}
+}
+
+void DXTMakeStateKey(const D3D11_SAMPLER_DESC& desc, DXTStateKey* keyOut)
+{
+	keyOut->Clear();
+	DXT_APPEND_FIELD(keyOut, desc.Filter);
+	DXT_APPEND_FIELD(keyOut, desc.AddressU);
+	DXT_APPEND_FIELD(keyOut, desc.AddressV);
+	DXT_APPEND_FIELD(keyOut, desc.AddressW);
+	DXT_APPEND_FIELD(keyOut, desc.MipLODBias);
+	DXT_APPEND_FIELD(keyOut, desc.MaxAnisotropy);
+	DXT_APPEND_FIELD(keyOut, desc.ComparisonFunc);
+	DXT_APPEND_FIELD(keyOut, desc.BorderColor);
+	DXT_APPEND_FIELD(keyOut, desc.MinLOD);
+	DXT_APPEND_FIELD(keyOut, desc.MaxLOD);
+}
+
+void DXTMakeStateKey(const void* bytecode, const size_t bytecodeLength, DXTStateKey* keyOut)
+{
+	keyOut->Clear();
+	keyOut->Append(bytecode, bytecodeLength);
+}
+
+void DXTMakeStateKey(const D3D11_INPUT_ELEMENT_DESC* elements, const UINT elementCount, const void* bytecode,
+	const size_t bytecodeLength, DXTStateKey* keyOut)
+{
+	keyOut->Clear();
+	keyOut->Append(&elementCount, sizeof(elementCount));
+
+	for (UINT i = 0; i < elementCount; ++i)
+	{
+		const D3D11_INPUT_ELEMENT_DESC& element = elements[i];
+		keyOut->AppendString(element.SemanticName);
+		DXT_APPEND_FIELD(keyOut, element.SemanticIndex);
+		DXT_APPEND_FIELD(keyOut, element.Format);
+		DXT_APPEND_FIELD(keyOut, element.InputSlot);
+		DXT_APPEND_FIELD(keyOut, element.AlignedByteOffset);
+		DXT_APPEND_FIELD(keyOut, element.InputSlotClass);
+		DXT_APPEND_FIELD(keyOut, element.InstanceDataStepRate);
+	}
+
+	keyOut->Append(bytecode, bytecodeLength);
+}
+
+void* DXTStateObjectTable::Find(const DXTStateKey& key) const
+{
+	auto range = entries.equal_range(key.GetHash());
+	for (auto entry = range.first; entry != range.second; ++entry)
+		if (entry->second.Key == key.GetBytes())
+			return entry->second.Object;
+
+	return nullptr;
+}
+
+void DXTStateObjectTable::Insert(const DXTStateKey& key, void* object)
+{
+	Entry entry = { key.GetBytes(), object };
+	entries.emplace(key.GetHash(), entry);
+	objects.push_back(object);
+}
+
+void DXTStateObjectTable::Clear()
+{
+	entries.clear();
+	objects.clear();
+}
\ No newline at end of file
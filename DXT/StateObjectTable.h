@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <d3d11.h>
+
+#define DXT_STATE_KEY_FNV_OFFSET_BASIS 14695981039346656037ULL
+#define DXT_STATE_KEY_FNV_PRIME 1099511628211ULL
+
+uint64_t DXTHashBytes(const void* data, const size_t length, const uint64_t seed = DXT_STATE_KEY_FNV_OFFSET_BASIS);
+
+// Byte image of a state description with its FNV-1a hash, built up field by field so struct padding
+// and unused members never make two equal descriptions look different
+class DXTStateKey
+{
+public:
+	DXTStateKey();
+
+	void Clear();
+	void Append(const void* data, const size_t length);
+	// Appends the characters including the terminator, a null string counts as an empty one
+	void AppendString(const char* string);
+
+	inline uint64_t GetHash() const;
+	inline const std::vector<uint8_t>& GetBytes() const;
+
+private:
+	std::vector<uint8_t> bytes;
+	uint64_t hash;
+};
+
+void DXTMakeStateKey(const D3D11_RASTERIZER_DESC& desc, DXTStateKey* keyOut);
+void DXTMakeStateKey(const D3D11_DEPTH_STENCIL_DESC& desc, DXTStateKey* keyOut);
+void DXTMakeStateKey(const D3D11_BLEND_DESC& desc, DXTStateKey* keyOut);
+void DXTMakeStateKey(const D3D11_SAMPLER_DESC& desc, DXTStateKey* keyOut);
+// Shaders are keyed on their bytecode, input layouts additionally on the elements they declare
+void DXTMakeStateKey(const void* bytecode, const size_t bytecodeLength, DXTStateKey* keyOut);
+void DXTMakeStateKey(const D3D11_INPUT_ELEMENT_DESC* elements, const UINT elementCount, const void* bytecode,
+	const size_t bytecodeLength, DXTStateKey* keyOut);
+
+// Maps state keys to the objects created from them. Objects are opaque to the table and not owned by it,
+// whoever fills the table releases what GetObjects returns.
+class DXTStateObjectTable
+{
+public:
+	// Returns null when no object was created from an equal key yet
+	void* Find(const DXTStateKey& key) const;
+	void Insert(const DXTStateKey& key, void* object);
+	void Clear();
+
+	inline const std::vector<void*>& GetObjects() const;
+	inline size_t GetCount() const;
+
+private:
+	struct Entry
+	{
+		std::vector<uint8_t> Key;
+		void* Object;
+	};
+
+	// Keys are compared in full, so hash collisions only cost a comparison
+	std::unordered_multimap<uint64_t, Entry> entries;
+	std::vector<void*> objects;
+};
+
+inline uint64_t DXTStateKey::GetHash() const
+{
+	return hash;
+}
+
+inline const std::vector<uint8_t>& DXTStateKey::GetBytes() const
+{
+	return bytes;
+}
+
+inline const std::vector<void*>& DXTStateObjectTable::GetObjects() const
+{
+	return objects;
+}
+
+inline size_t DXTStateObjectTable::GetCount() const
+{
+	return objects.size();
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+// Types shared by the toolbox that don't depend on Windows or Direct3D, so that
+// CPU side systems like the occlusion culler can be built and run headless
+
+#include <vector>
+
+#include <DirectXMath.h>
+
+struct DXTExtent2D
+{
+	int Width;
+	int Height;
+};
+
+struct DXTBounds
+{
+	DirectX::XMFLOAT3 Lower;
+	DirectX::XMFLOAT3 Upper;
+};
+
+struct DXTPlane
+{
+	DirectX::XMFLOAT3 Normal;
+	float Distance;
+};
+
+struct DXTFrustum
+{
+	DXTPlane Planes[6];
+};
+
+// Structure-of-arrays view over a set of bounds, one stream per component
+struct DXTBoundsStream
+{
+	const float* LowerX;
+	const float* LowerY;
+	const float* LowerZ;
+	const float* UpperX;
+	const float* UpperY;
+	const float* UpperZ;
+	size_t Count;
+};
+
+// Owning storage for a DXTBoundsStream
+class DXTBoundsStreamBuffer
+{
+public:
+	std::vector<float> LowerX;
+	std::vector<float> LowerY;
+	std::vector<float> LowerZ;
+	std::vector<float> UpperX;
+	std::vector<float> UpperY;
+	std::vector<float> UpperZ;
+
+	inline void Resize(const size_t count);
+	inline void SetBounds(const size_t index, const DXTBounds& bounds);
+	inline DXTBounds GetBounds(const size_t index) const;
+	inline size_t GetCount() const;
+	inline DXTBoundsStream GetStream() const;
+};
+
+enum DXTIndexType
+{
+	DXTIndexTypeShort,
+	DXTIndexTypeInt
+};
+
+inline void DXTBoundsStreamBuffer::Resize(const size_t count)
+{
+	LowerX.resize(count);
+	LowerY.resize(count);
+	LowerZ.resize(count);
+	UpperX.resize(count);
+	UpperY.resize(count);
+	UpperZ.resize(count);
+}
+
+inline void DXTBoundsStreamBuffer::SetBounds(const size_t index, const DXTBounds& bounds)
+{
+	LowerX[index] = bounds.Lower.x;
+	LowerY[index] = bounds.Lower.y;
+	LowerZ[index] = bounds.Lower.z;
+	UpperX[index] = bounds.Upper.x;
+	UpperY[index] = bounds.Upper.y;
+	UpperZ[index] = bounds.Upper.z;
+}
+
+inline DXTBounds DXTBoundsStreamBuffer::GetBounds(const size_t index) const
+{
+	DXTBounds bounds = { { LowerX[index], LowerY[index], LowerZ[index] },
+		{ UpperX[index], UpperY[index], UpperZ[index] } };
+	return bounds;
+}
+
+inline size_t DXTBoundsStreamBuffer::GetCount() const
+{
+	return LowerX.size();
+}
+
+inline DXTBoundsStream DXTBoundsStreamBuffer::GetStream() const
+{
+	DXTBoundsStream stream = { LowerX.data(), LowerY.data(), LowerZ.data(),
+		UpperX.data(), UpperY.data(), UpperZ.data(), LowerX.size() };
+	return stream;
+}
\ No newline at end of file
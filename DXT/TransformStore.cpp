@@ -0,0 +1,176 @@
+#include "TransformStore.h"
+
+#include <intrin.h>
+#include <xmmintrin.h>
+
+using namespace std;
+using namespace DirectX;
+
+#define DXT_TRANSFORM_BATCH_SIZE 4
+
+UINT DXTTransformStore::Add(const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale)
+{
+	UINT index = static_cast<UINT>(positions.size());
+
+	positions.push_back(position);
+	rotations.push_back(rotation);
+	scales.push_back(scale);
+	worldMatrices.push_back(XMFLOAT4X4());
+	dirtyMask.resize(DXT_BOUNDS_MASK_WORD_COUNT(positions.size()));
+
+	MarkDirty(index);
+	return index;
+}
+
+void DXTTransformStore::Remove(const UINT index)
+{
+	UINT last = static_cast<UINT>(positions.size() - 1);
+	if (index != last)
+	{
+		positions[index] = positions[last];
+		rotations[index] = rotations[last];
+		scales[index] = scales[last];
+		worldMatrices[index] = worldMatrices[last];
+
+		if (IsDirty(last))
+			MarkDirty(index);
+		else
+			ClearDirty(index);
+	}
+
+	ClearDirty(last);
+
+	positions.pop_back();
+	rotations.pop_back();
+	scales.pop_back();
+	worldMatrices.pop_back();
+	dirtyMask.resize(DXT_BOUNDS_MASK_WORD_COUNT(positions.size()));
+}
+
+void DXTTransformStore::Clear()
+{
+	positions.clear();
+	rotations.clear();
+	scales.clear();
+	worldMatrices.clear();
+	dirtyMask.clear();
+}
+
+size_t DXTTransformStore::UpdateWorldMatrices(vector<UINT>* updatedOut)
+{
+	UINT batch[DXT_TRANSFORM_BATCH_SIZE];
+	size_t batchCount = 0;
+	size_t updatedCount = 0;
+
+	for (size_t i = 0; i < dirtyMask.size(); ++i)
+	{
+		UINT32 word = dirtyMask[i];
+		dirtyMask[i] = 0;
+
+		unsigned long bit;
+		while (_BitScanForward(&bit, word))
+		{
+			batch[batchCount++] = static_cast<UINT>(i * 32 + bit);
+			word &= word - 1;
+
+			if (batchCount == DXT_TRANSFORM_BATCH_SIZE)
+			{
+				ComposeBatch(batch, batchCount);
+				if (updatedOut)
+					updatedOut->insert(updatedOut->end(), batch, batch + batchCount);
+
+				updatedCount += batchCount;
+				batchCount = 0;
+			}
+		}
+	}
+
+	if (batchCount > 0)
+	{
+		ComposeBatch(batch, batchCount);
+		if (updatedOut)
+			updatedOut->insert(updatedOut->end(), batch, batch + batchCount);
+
+		updatedCount += batchCount;
+	}
+
+	return updatedCount;
+}
+
+// Builds scale * rotation * translation for four transforms at once, with one transform per lane
+void DXTTransformStore::ComposeBatch(const UINT* indices, const size_t count)
+{
+	// Short batches repeat their last transform, which just writes the same matrix twice
+	UINT lanes[DXT_TRANSFORM_BATCH_SIZE];
+	for (size_t i = 0; i < DXT_TRANSFORM_BATCH_SIZE; ++i)
+		lanes[i] = indices[i < count ? i : count - 1];
+
+	const XMFLOAT4* q[4] = { &rotations[lanes[0]], &rotations[lanes[1]], &rotations[lanes[2]], &rotations[lanes[3]] };
+	const XMFLOAT3* s[4] = { &scales[lanes[0]], &scales[lanes[1]], &scales[lanes[2]], &scales[lanes[3]] };
+	const XMFLOAT3* t[4] = { &positions[lanes[0]], &positions[lanes[1]], &positions[lanes[2]], &positions[lanes[3]] };
+
+	__m128 qx = _mm_setr_ps(q[0]->x, q[1]->x, q[2]->x, q[3]->x);
+	__m128 qy = _mm_setr_ps(q[0]->y, q[1]->y, q[2]->y, q[3]->y);
+	__m128 qz = _mm_setr_ps(q[0]->z, q[1]->z, q[2]->z, q[3]->z);
+	__m128 qw = _mm_setr_ps(q[0]->w, q[1]->w, q[2]->w, q[3]->w);
+
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 two = _mm_set1_ps(2.0f);
+
+	__m128 xx = _mm_mul_ps(qx, qx);
+	__m128 yy = _mm_mul_ps(qy, qy);
+	__m128 zz = _mm_mul_ps(qz, qz);
+	__m128 xy = _mm_mul_ps(qx, qy);
+	__m128 xz = _mm_mul_ps(qx, qz);
+	__m128 yz = _mm_mul_ps(qy, qz);
+	__m128 wx = _mm_mul_ps(qw, qx);
+	__m128 wy = _mm_mul_ps(qw, qy);
+	__m128 wz = _mm_mul_ps(qw, qz);
+
+	// Same layout as XMMatrixRotationQuaternion, each row scaled by its axis
+	__m128 sx = _mm_setr_ps(s[0]->x, s[1]->x, s[2]->x, s[3]->x);
+	__m128 sy = _mm_setr_ps(s[0]->y, s[1]->y, s[2]->y, s[3]->y);
+	__m128 sz = _mm_setr_ps(s[0]->z, s[1]->z, s[2]->z, s[3]->z);
+
+	__m128 m00 = _mm_mul_ps(sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))));
+	__m128 m01 = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(xy, wz)));
+	__m128 m02 = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(xz, wy)));
+
+	__m128 m10 = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(xy, wz)));
+	__m128 m11 = _mm_mul_ps(sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))));
+	__m128 m12 = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(yz, wx)));
+
+	__m128 m20 = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(xz, wy)));
+	__m128 m21 = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(yz, wx)));
+	__m128 m22 = _mm_mul_ps(sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+
+	__m128 m30 = _mm_setr_ps(t[0]->x, t[1]->x, t[2]->x, t[3]->x);
+	__m128 m31 = _mm_setr_ps(t[0]->y, t[1]->y, t[2]->y, t[3]->y);
+	__m128 m32 = _mm_setr_ps(t[0]->z, t[1]->z, t[2]->z, t[3]->z);
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 row0w = zero, row1w = zero, row2w = zero, row3w = one;
+
+	// Transposing turns the per lane components back into one row per transform
+	_MM_TRANSPOSE4_PS(m00, m01, m02, row0w);
+	_MM_TRANSPOSE4_PS(m10, m11, m12, row1w);
+	_MM_TRANSPOSE4_PS(m20, m21, m22, row2w);
+	_MM_TRANSPOSE4_PS(m30, m31, m32, row3w);
+
+	__m128 rows[4][4] =
+	{
+		{ m00, m10, m20, m30 },
+		{ m01, m11, m21, m31 },
+		{ m02, m12, m22, m32 },
+		{ row0w, row1w, row2w, row3w },
+	};
+
+	for (size_t i = 0; i < DXT_TRANSFORM_BATCH_SIZE; ++i)
+	{
+		float* matrix = &worldMatrices[lanes[i]].m[0][0];
+		_mm_storeu_ps(matrix, rows[i][0]);
+		_mm_storeu_ps(matrix + 4, rows[i][1]);
+		_mm_storeu_ps(matrix + 8, rows[i][2]);
+		_mm_storeu_ps(matrix + 12, rows[i][3]);
+	}
+}
\ No newline at end of file
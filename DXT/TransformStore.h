@@ -0,0 +1,107 @@
+#pragma once
+
+#include "DirectXToolbox.h"
+
+#include <vector>
+
+// Transforms split into separate position, rotation and scale streams. Setters only flag a
+// transform as dirty, UpdateWorldMatrices then recomposes the flagged ones four at a time.
+class DXTTransformStore
+{
+public:
+	UINT Add(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT4& rotation, const DirectX::XMFLOAT3& scale);
+	// The last transform takes over the removed index
+	void Remove(const UINT index);
+	void Clear();
+
+	// Indices of the recomposed transforms are appended to updatedOut in ascending order when it is given
+	size_t UpdateWorldMatrices(std::vector<UINT>* updatedOut);
+
+	inline void SetPosition(const UINT index, const DirectX::XMFLOAT3& position);
+	inline void SetRotation(const UINT index, const DirectX::XMFLOAT4& rotation);
+	inline void SetScale(const UINT index, const DirectX::XMFLOAT3& scale);
+	inline const DirectX::XMFLOAT3& GetPosition(const UINT index) const;
+	inline const DirectX::XMFLOAT4& GetRotation(const UINT index) const;
+	inline const DirectX::XMFLOAT3& GetScale(const UINT index) const;
+
+	inline const DirectX::XMFLOAT4X4& GetWorldMatrix(const UINT index) const;
+	inline const DirectX::XMFLOAT4X4* GetWorldMatrices() const;
+	inline bool IsDirty(const UINT index) const;
+	inline size_t GetCount() const;
+
+private:
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<DirectX::XMFLOAT4> rotations;
+	std::vector<DirectX::XMFLOAT3> scales;
+	std::vector<DirectX::XMFLOAT4X4> worldMatrices;
+
+	// One bit per transform
+	std::vector<UINT32> dirtyMask;
+
+	void ComposeBatch(const UINT* indices, const size_t count);
+	inline void MarkDirty(const UINT index);
+	inline void ClearDirty(const UINT index);
+};
+
+inline void DXTTransformStore::SetPosition(const UINT index, const DirectX::XMFLOAT3& position)
+{
+	positions[index] = position;
+	MarkDirty(index);
+}
+
+inline void DXTTransformStore::SetRotation(const UINT index, const DirectX::XMFLOAT4& rotation)
+{
+	rotations[index] = rotation;
+	MarkDirty(index);
+}
+
+inline void DXTTransformStore::SetScale(const UINT index, const DirectX::XMFLOAT3& scale)
+{
+	scales[index] = scale;
+	MarkDirty(index);
+}
+
+inline const DirectX::XMFLOAT3& DXTTransformStore::GetPosition(const UINT index) const
+{
+	return positions[index];
+}
+
+inline const DirectX::XMFLOAT4& DXTTransformStore::GetRotation(const UINT index) const
+{
+	return rotations[index];
+}
+
+inline const DirectX::XMFLOAT3& DXTTransformStore::GetScale(const UINT index) const
+{
+	return scales[index];
+}
+
+inline const DirectX::XMFLOAT4X4& DXTTransformStore::GetWorldMatrix(const UINT index) const
+{
+	return worldMatrices[index];
+}
+
+inline const DirectX::XMFLOAT4X4* DXTTransformStore::GetWorldMatrices() const
+{
+	return worldMatrices.data();
+}
+
+inline bool DXTTransformStore::IsDirty(const UINT index) const
+{
+	return (dirtyMask[index / 32] & (1u << (index % 32))) != 0;
+}
+
+inline size_t DXTTransformStore::GetCount() const
+{
+	return positions.size();
+}
+
+inline void DXTTransformStore::MarkDirty(const UINT index)
+{
+	dirtyMask[index / 32] |= 1u << (index % 32);
+}
+
+inline void DXTTransformStore::ClearDirty(const UINT index)
+{
+	dirtyMask[index / 32] &= ~(1u << (index % 32));
+}
\ No newline at end of file
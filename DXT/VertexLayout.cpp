@@ -0,0 +1,196 @@
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace std;
+
+// Smallest magnitude of the quaternion scalar part, one snorm step, so its sign survives quantization
+#define DXT_TANGENT_FRAME_MIN_SCALAR (1.0f / 32767.0f)
+
+static float DXTSignNotZero(const float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+static void DXTNormalize(float* vector)
+{
+	float length = sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+	float scale = length > 0.0f ? 1.0f / length : 0.0f;
+	for (size_t i = 0; i < 3; ++i)
+		vector[i] *= scale;
+}
+
+static void DXTCross(const float* a, const float* b, float* crossOut)
+{
+	crossOut[0] = a[1] * b[2] - a[2] * b[1];
+	crossOut[1] = a[2] * b[0] - a[0] * b[2];
+	crossOut[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static float DXTDot(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+uint16_t DXTEncodeUnorm16(const float value)
+{
+	return static_cast<uint16_t>(min<float>(max<float>(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+}
+
+int16_t DXTEncodeSnorm16(const float value)
+{
+	float scaled = min<float>(max<float>(value, -1.0f), 1.0f) * 32767.0f;
+	return static_cast<int16_t>(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+}
+
+void DXTEncodeOctahedral(const float* direction, int16_t* encodedOut)
+{
+	float length = fabs(direction[0]) + fabs(direction[1]) + fabs(direction[2]);
+	if (length == 0.0f)
+	{
+		encodedOut[0] = 0;
+		encodedOut[1] = 0;
+		return;
+	}
+
+	float x = direction[0] / length;
+	float y = direction[1] / length;
+
+	// The lower hemisphere is folded over the diagonals
+	if (direction[2] < 0.0f)
+	{
+		float foldedX = (1.0f - fabs(y)) * DXTSignNotZero(x);
+		y = (1.0f - fabs(x)) * DXTSignNotZero(y);
+		x = foldedX;
+	}
+
+	encodedOut[0] = DXTEncodeSnorm16(x);
+	encodedOut[1] = DXTEncodeSnorm16(y);
+}
+
+void DXTDecodeOctahedral(const int16_t* encoded, float* directionOut)
+{
+	float x = max<float>(encoded[0] / 32767.0f, -1.0f);
+	float y = max<float>(encoded[1] / 32767.0f, -1.0f);
+	float z = 1.0f - fabs(x) - fabs(y);
+
+	if (z < 0.0f)
+	{
+		float unfoldedX = (1.0f - fabs(y)) * DXTSignNotZero(x);
+		y = (1.0f - fabs(x)) * DXTSignNotZero(y);
+		x = unfoldedX;
+	}
+
+	directionOut[0] = x;
+	directionOut[1] = y;
+	directionOut[2] = z;
+	DXTNormalize(directionOut);
+}
+
+void DXTEncodeTangentFrame(const float* normal, const float* tangent, const float* bitangent, int16_t* encodedOut)
+{
+	float n[3] = { normal[0], normal[1], normal[2] };
+	DXTNormalize(n);
+	if (DXTDot(n, n) == 0.0f)
+		n[2] = 1.0f;
+
+	// Gram-Schmidt, a missing or parallel tangent is replaced by any direction perpendicular to the normal
+	float t[3];
+	float d = DXTDot(n, tangent);
+	for (size_t i = 0; i < 3; ++i)
+		t[i] = tangent[i] - n[i] * d;
+	DXTNormalize(t);
+	if (DXTDot(t, t) == 0.0f)
+	{
+		float axis[3] = { fabs(n[0]) < 0.9f ? 1.0f : 0.0f, fabs(n[0]) < 0.9f ? 0.0f : 1.0f, 0.0f };
+		DXTCross(axis, n, t);
+		DXTNormalize(t);
+	}
+
+	float b[3];
+	DXTCross(n, t, b);
+	float handedness = DXTDot(b, bitangent) < 0.0f ? -1.0f : 1.0f;
+
+	// Columns t, b and n form the rotation matrix m[row][column]
+	float m00 = t[0], m10 = t[1], m20 = t[2];
+	float m01 = b[0], m11 = b[1], m21 = b[2];
+	float m02 = n[0], m12 = n[1], m22 = n[2];
+	float q[4];
+	float trace = m00 + m11 + m22;
+
+	if (trace > 0.0f)
+	{
+		float s = sqrt(trace + 1.0f) * 2.0f;
+		q[3] = 0.25f * s;
+		q[0] = (m21 - m12) / s;
+		q[1] = (m02 - m20) / s;
+		q[2] = (m10 - m01) / s;
+	}
+	else if (m00 > m11 && m00 > m22)
+	{
+		float s = sqrt(1.0f + m00 - m11 - m22) * 2.0f;
+		q[3] = (m21 - m12) / s;
+		q[0] = 0.25f * s;
+		q[1] = (m01 + m10) / s;
+		q[2] = (m02 + m20) / s;
+	}
+	else if (m11 > m22)
+	{
+		float s = sqrt(1.0f + m11 - m00 - m22) * 2.0f;
+		q[3] = (m02 - m20) / s;
+		q[0] = (m01 + m10) / s;
+		q[1] = 0.25f * s;
+		q[2] = (m12 + m21) / s;
+	}
+	else
+	{
+		float s = sqrt(1.0f + m22 - m00 - m11) * 2.0f;
+		q[3] = (m10 - m01) / s;
+		q[0] = (m02 + m20) / s;
+		q[1] = (m12 + m21) / s;
+		q[2] = 0.25f * s;
+	}
+
+	// q and -q are the same rotation, so the scalar part is made positive and then signed with the handedness
+	float sign = q[3] < 0.0f ? -1.0f : 1.0f;
+	for (size_t i = 0; i < 4; ++i)
+		q[i] *= sign;
+
+	if (q[3] < DXT_TANGENT_FRAME_MIN_SCALAR)
+	{
+		float scale = sqrt(1.0f - DXT_TANGENT_FRAME_MIN_SCALAR * DXT_TANGENT_FRAME_MIN_SCALAR) /
+			max<float>(sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]), FLT_MIN);
+		for (size_t i = 0; i < 3; ++i)
+			q[i] *= scale;
+		q[3] = DXT_TANGENT_FRAME_MIN_SCALAR;
+	}
+
+	for (size_t i = 0; i < 4; ++i)
+		encodedOut[i] = DXTEncodeSnorm16(q[i] * handedness);
+}
+
+void DXTDecodeTangentFrame(const int16_t* encoded, float* normalOut, float* tangentOut, float* bitangentOut)
+{
+	float q[4];
+	for (size_t i = 0; i < 4; ++i)
+		q[i] = max<float>(encoded[i] / 32767.0f, -1.0f);
+
+	float length = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for (size_t i = 0; i < 4; ++i)
+		q[i] /= length;
+
+	float x = q[0], y = q[1], z = q[2], w = q[3];
+	tangentOut[0] = 1.0f - 2.0f * (y * y + z * z);
+	tangentOut[1] = 2.0f * (x * y + w * z);
+	tangentOut[2] = 2.0f * (x * z - w * y);
+	normalOut[0] = 2.0f * (x * z + w * y);
+	normalOut[1] = 2.0f * (y * z - w * x);
+	normalOut[2] = 1.0f - 2.0f * (x * x + y * y);
+
+	DXTCross(normalOut, tangentOut, bitangentOut);
+	float handedness = DXTSignNotZero(w);
+	for (size_t i = 0; i < 3; ++i)
+		bitangentOut[i] *= handedness;
+}
\ No newline at end of file
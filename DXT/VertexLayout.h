@@ -0,0 +1,423 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#include <d3d11.h>
+#include <DirectXPackedVector.h>
+
+enum DXTVertexAttrubuteChannel
+{
+	DXTVertexAttributePosition = 1 << 0,
+	DXTVertexAttributeUV = 1 << 1,
+	DXTVertexAttributeNormal = 1 << 2,
+	DXTVertexAttributeTangent = 1 << 3,
+	DXTVertexAttributeBitangent = 1 << 4
+};
+
+// Source of one channel, the floats of vertex v start at Data[v * Stride]. A stride of zero repeats the
+// same value for every vertex, which is how missing channels are filled.
+struct DXTVertexStream
+{
+	const float* Data;
+	size_t Stride;
+};
+
+// Destination of one decoded channel, laid out like DXTVertexStream
+struct DXTVertexOutputStream
+{
+	float* Data;
+	size_t Stride;
+};
+
+// Quantized positions are stored relative to the bounds of the mesh, PositionLower + value * PositionExtent
+struct DXTVertexEncodeParams
+{
+	float PositionLower[3];
+	float PositionExtent[3];
+};
+
+typedef void (*DXTInterleaveVerticesFunc)(const DXTVertexStream* streams, const size_t vertexCount,
+	const DXTVertexEncodeParams& params, void* verticesOut);
+typedef void (*DXTDeinterleaveVerticesFunc)(const void* vertices, const size_t vertexCount,
+	const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streamsOut);
+
+// Runtime view of a DXTVertexLayout, for code that is compiled once for every layout
+struct DXTVertexFormat
+{
+	UINT ChannelFlags;
+	UINT Stride;
+	UINT AttributeCount;
+	// Channels and storage format of every attribute in vertex order
+	const UINT* AttributeChannels;
+	const DXGI_FORMAT* AttributeFormats;
+	// An attribute takes a stream for each of its channels, in ascending channel order
+	UINT StreamCount;
+	const UINT* StreamChannels;
+	DXTInterleaveVerticesFunc Interleave;
+	DXTDeinterleaveVerticesFunc Deinterleave;
+};
+
+uint16_t DXTEncodeUnorm16(const float value);
+int16_t DXTEncodeSnorm16(const float value);
+// Octahedral mapping of a direction onto two snorm values, zero vectors come out as +Z
+void DXTEncodeOctahedral(const float* direction, int16_t* encodedOut);
+void DXTDecodeOctahedral(const int16_t* encoded, float* directionOut);
+// The tangent frame as a quaternion rotating +X, +Y and +Z onto tangent, bitangent and normal. The sign of the
+// scalar part carries the handedness, so it is kept away from zero.
+void DXTEncodeTangentFrame(const float* normal, const float* tangent, const float* bitangent, int16_t* encodedOut);
+void DXTDecodeTangentFrame(const int16_t* encoded, float* normalOut, float* tangentOut, float* bitangentOut);
+
+// Number of channels, and so of streams, an attribute takes
+template <UINT channels>
+struct DXTVertexChannelCount
+{
+	static const UINT Value = (channels & 1) + DXTVertexChannelCount<(channels >> 1)>::Value;
+};
+
+template <>
+struct DXTVertexChannelCount<0>
+{
+	static const UINT Value = 0;
+};
+
+// An attribute stored as floatCount 32 bit floats
+template <UINT channel, UINT floatCount, DXGI_FORMAT format>
+struct DXTVertexAttributeFloat
+{
+	static const UINT Channels = channel;
+	static const DXGI_FORMAT Format = format;
+	static const UINT Size = floatCount * sizeof(float);
+
+	static inline void Write(const DXTVertexStream* streams, const size_t vertex, const DXTVertexEncodeParams& params, BYTE* vertexOut)
+	{
+		memcpy(vertexOut, streams->Data + vertex * streams->Stride, Size);
+	}
+
+	static inline void Read(const BYTE* vertex, const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streams, const size_t index)
+	{
+		memcpy(streams->Data + index * streams->Stride, vertex, Size);
+	}
+};
+
+struct DXTVertexPosition : DXTVertexAttributeFloat<DXTVertexAttributePosition, 3, DXGI_FORMAT_R32G32B32_FLOAT>
+{
+	static inline const char* GetSemanticName() { return "POSITION"; }
+};
+
+struct DXTVertexUV : DXTVertexAttributeFloat<DXTVertexAttributeUV, 2, DXGI_FORMAT_R32G32_FLOAT>
+{
+	static inline const char* GetSemanticName() { return "TEXCOORD"; }
+};
+
+struct DXTVertexNormal : DXTVertexAttributeFloat<DXTVertexAttributeNormal, 3, DXGI_FORMAT_R32G32B32_FLOAT>
+{
+	static inline const char* GetSemanticName() { return "NORMAL"; }
+};
+
+struct DXTVertexTangent : DXTVertexAttributeFloat<DXTVertexAttributeTangent, 3, DXGI_FORMAT_R32G32B32_FLOAT>
+{
+	static inline const char* GetSemanticName() { return "TANGENT"; }
+};
+
+struct DXTVertexBitangent : DXTVertexAttributeFloat<DXTVertexAttributeBitangent, 3, DXGI_FORMAT_R32G32B32_FLOAT>
+{
+	static inline const char* GetSemanticName() { return "BINORMAL"; }
+};
+
+// 16 bit normalized position within the mesh bounds, the fourth component only pads the vertex
+struct DXTVertexPositionUnorm16
+{
+	static const UINT Channels = DXTVertexAttributePosition;
+	static const DXGI_FORMAT Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+	static const UINT Size = 4 * sizeof(uint16_t);
+
+	static inline const char* GetSemanticName() { return "POSITION"; }
+
+	static inline void Write(const DXTVertexStream* streams, const size_t vertex, const DXTVertexEncodeParams& params, BYTE* vertexOut)
+	{
+		const float* position = streams->Data + vertex * streams->Stride;
+		uint16_t encoded[4] = {};
+		for (size_t i = 0; i < 3; ++i)
+			encoded[i] = DXTEncodeUnorm16(params.PositionExtent[i] > 0.0f ?
+				(position[i] - params.PositionLower[i]) / params.PositionExtent[i] : 0.0f);
+		memcpy(vertexOut, encoded, Size);
+	}
+
+	static inline void Read(const BYTE* vertex, const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streams, const size_t index)
+	{
+		uint16_t encoded[4];
+		memcpy(encoded, vertex, Size);
+		float* position = streams->Data + index * streams->Stride;
+		for (size_t i = 0; i < 3; ++i)
+			position[i] = params.PositionLower[i] + encoded[i] / 65535.0f * params.PositionExtent[i];
+	}
+};
+
+struct DXTVertexUVHalf
+{
+	static const UINT Channels = DXTVertexAttributeUV;
+	static const DXGI_FORMAT Format = DXGI_FORMAT_R16G16_FLOAT;
+	static const UINT Size = 2 * sizeof(uint16_t);
+
+	static inline const char* GetSemanticName() { return "TEXCOORD"; }
+
+	static inline void Write(const DXTVertexStream* streams, const size_t vertex, const DXTVertexEncodeParams& params, BYTE* vertexOut)
+	{
+		const float* uv = streams->Data + vertex * streams->Stride;
+		uint16_t encoded[2] =
+		{
+			DirectX::PackedVector::XMConvertFloatToHalf(uv[0]),
+			DirectX::PackedVector::XMConvertFloatToHalf(uv[1])
+		};
+		memcpy(vertexOut, encoded, Size);
+	}
+
+	static inline void Read(const BYTE* vertex, const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streams, const size_t index)
+	{
+		uint16_t encoded[2];
+		memcpy(encoded, vertex, Size);
+		float* uv = streams->Data + index * streams->Stride;
+		uv[0] = DirectX::PackedVector::XMConvertHalfToFloat(encoded[0]);
+		uv[1] = DirectX::PackedVector::XMConvertHalfToFloat(encoded[1]);
+	}
+};
+
+// A unit direction in two snorm values, decoded by DecodeOctahedral in the vertex shader
+template <UINT channel>
+struct DXTVertexAttributeOctahedral
+{
+	static const UINT Channels = channel;
+	static const DXGI_FORMAT Format = DXGI_FORMAT_R16G16_SNORM;
+	static const UINT Size = 2 * sizeof(int16_t);
+
+	static inline void Write(const DXTVertexStream* streams, const size_t vertex, const DXTVertexEncodeParams& params, BYTE* vertexOut)
+	{
+		int16_t encoded[2];
+		DXTEncodeOctahedral(streams->Data + vertex * streams->Stride, encoded);
+		memcpy(vertexOut, encoded, Size);
+	}
+
+	static inline void Read(const BYTE* vertex, const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streams, const size_t index)
+	{
+		int16_t encoded[2];
+		memcpy(encoded, vertex, Size);
+		DXTDecodeOctahedral(encoded, streams->Data + index * streams->Stride);
+	}
+};
+
+struct DXTVertexNormalOctahedral : DXTVertexAttributeOctahedral<DXTVertexAttributeNormal>
+{
+	static inline const char* GetSemanticName() { return "NORMAL"; }
+};
+
+struct DXTVertexTangentOctahedral : DXTVertexAttributeOctahedral<DXTVertexAttributeTangent>
+{
+	static inline const char* GetSemanticName() { return "TANGENT"; }
+};
+
+// Normal, tangent and bitangent in one quaternion, shaders reading it rebuild the frame like DXTDecodeTangentFrame
+struct DXTVertexTangentFrame
+{
+	static const UINT Channels = DXTVertexAttributeNormal | DXTVertexAttributeTangent | DXTVertexAttributeBitangent;
+	static const DXGI_FORMAT Format = DXGI_FORMAT_R16G16B16A16_SNORM;
+	static const UINT Size = 4 * sizeof(int16_t);
+
+	static inline const char* GetSemanticName() { return "TANGENT"; }
+
+	static inline void Write(const DXTVertexStream* streams, const size_t vertex, const DXTVertexEncodeParams& params, BYTE* vertexOut)
+	{
+		int16_t encoded[4];
+		DXTEncodeTangentFrame(streams[0].Data + vertex * streams[0].Stride, streams[1].Data + vertex * streams[1].Stride,
+			streams[2].Data + vertex * streams[2].Stride, encoded);
+		memcpy(vertexOut, encoded, Size);
+	}
+
+	static inline void Read(const BYTE* vertex, const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streams, const size_t index)
+	{
+		int16_t encoded[4];
+		memcpy(encoded, vertex, Size);
+		DXTDecodeTangentFrame(encoded, streams[0].Data + index * streams[0].Stride, streams[1].Data + index * streams[1].Stride,
+			streams[2].Data + index * streams[2].Stride);
+	}
+};
+
+// Recursion over the attribute list, every step is resolved at compile time
+template <typename... Attributes>
+struct DXTVertexAttributeList;
+
+template <>
+struct DXTVertexAttributeList<>
+{
+	static const UINT Size = 0;
+	static const UINT ChannelFlags = 0;
+	static const UINT StreamCount = 0;
+
+	static inline void GetInputElements(const UINT slot, const UINT offset, D3D11_INPUT_ELEMENT_DESC* elementsOut) {}
+	static inline void Write(const DXTVertexStream* streams, const size_t vertex, const DXTVertexEncodeParams& params, BYTE* vertexOut) {}
+	static inline void Read(const BYTE* vertex, const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streams, const size_t index) {}
+};
+
+template <typename Attribute, typename... Rest>
+struct DXTVertexAttributeList<Attribute, Rest...>
+{
+	static const UINT Size = Attribute::Size + DXTVertexAttributeList<Rest...>::Size;
+	static const UINT ChannelFlags = Attribute::Channels | DXTVertexAttributeList<Rest...>::ChannelFlags;
+	static const UINT AttributeStreamCount = DXTVertexChannelCount<Attribute::Channels>::Value;
+	static const UINT StreamCount = AttributeStreamCount + DXTVertexAttributeList<Rest...>::StreamCount;
+
+	static inline void GetInputElements(const UINT slot, const UINT offset, D3D11_INPUT_ELEMENT_DESC* elementsOut)
+	{
+		elementsOut->SemanticName = Attribute::GetSemanticName();
+		elementsOut->SemanticIndex = 0;
+		elementsOut->Format = Attribute::Format;
+		elementsOut->InputSlot = slot;
+		elementsOut->AlignedByteOffset = offset;
+		elementsOut->InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+		elementsOut->InstanceDataStepRate = 0;
+		DXTVertexAttributeList<Rest...>::GetInputElements(slot, offset + Attribute::Size, elementsOut + 1);
+	}
+
+	static inline void Write(const DXTVertexStream* streams, const size_t vertex, const DXTVertexEncodeParams& params, BYTE* vertexOut)
+	{
+		Attribute::Write(streams, vertex, params, vertexOut);
+		DXTVertexAttributeList<Rest...>::Write(streams + AttributeStreamCount, vertex, params, vertexOut + Attribute::Size);
+	}
+
+	static inline void Read(const BYTE* vertex, const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streams, const size_t index)
+	{
+		Attribute::Read(vertex, params, streams, index);
+		DXTVertexAttributeList<Rest...>::Read(vertex + Attribute::Size, params, streams + AttributeStreamCount, index);
+	}
+};
+
+// Byte offset of the attribute at index within a vertex
+template <UINT index, typename... Attributes>
+struct DXTVertexAttributeOffset;
+
+template <typename Attribute, typename... Rest>
+struct DXTVertexAttributeOffset<0, Attribute, Rest...>
+{
+	static const UINT Value = 0;
+};
+
+template <UINT index, typename Attribute, typename... Rest>
+struct DXTVertexAttributeOffset<index, Attribute, Rest...>
+{
+	static const UINT Value = Attribute::Size + DXTVertexAttributeOffset<index - 1, Rest...>::Value;
+};
+
+// Vertex format given by its attributes in memory order. The stride, the input elements, the interleave routine
+// and its inverse all follow from the same list, so they can't disagree. Describe VertexShaderInput with the
+// same attributes.
+template <typename... Attributes>
+class DXTVertexLayout
+{
+public:
+	static const UINT Stride = DXTVertexAttributeList<Attributes...>::Size;
+	static const UINT ChannelFlags = DXTVertexAttributeList<Attributes...>::ChannelFlags;
+	static const UINT AttributeCount = sizeof...(Attributes);
+	static const UINT StreamCount = DXTVertexAttributeList<Attributes...>::StreamCount;
+
+	static_assert(AttributeCount > 0, "A vertex layout needs at least one attribute");
+	static_assert(StreamCount == DXTVertexChannelCount<ChannelFlags>::Value, "Every channel can only be stored once");
+
+	// Byte offset of the attribute at index, known at compile time
+	template <UINT index>
+	struct Offset
+	{
+		static_assert(index < AttributeCount, "The layout has no attribute at this index");
+		static const UINT Value = DXTVertexAttributeOffset<index, Attributes...>::Value;
+	};
+
+	// Fills AttributeCount elements reading from the given input slot
+	static inline void GetInputElements(const UINT slot, D3D11_INPUT_ELEMENT_DESC* elementsOut);
+	// streams holds StreamCount streams, ordered like DXTVertexFormat::StreamChannels
+	static inline void Interleave(const DXTVertexStream* streams, const size_t vertexCount,
+		const DXTVertexEncodeParams& params, void* verticesOut);
+	static inline void Deinterleave(const void* vertices, const size_t vertexCount,
+		const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streamsOut);
+	static inline const DXTVertexFormat& GetFormat();
+};
+
+typedef DXTVertexLayout<DXTVertexPosition, DXTVertexUV, DXTVertexNormal> DXTVertexLayoutPositionUVNormal;
+// 16 bytes against the 32 of DXTVertexLayoutPositionUVNormal
+typedef DXTVertexLayout<DXTVertexPositionUnorm16, DXTVertexUVHalf, DXTVertexNormalOctahedral> DXTVertexLayoutPositionUVNormalQuantized;
+// 20 bytes against the 56 of all five channels as floats
+typedef DXTVertexLayout<DXTVertexPositionUnorm16, DXTVertexUVHalf, DXTVertexTangentFrame> DXTVertexLayoutTangentFrameQuantized;
+
+template <typename... Attributes>
+const UINT DXTVertexLayout<Attributes...>::Stride;
+
+template <typename... Attributes>
+const UINT DXTVertexLayout<Attributes...>::ChannelFlags;
+
+template <typename... Attributes>
+const UINT DXTVertexLayout<Attributes...>::AttributeCount;
+
+template <typename... Attributes>
+const UINT DXTVertexLayout<Attributes...>::StreamCount;
+
+template <typename... Attributes>
+inline void DXTVertexLayout<Attributes...>::GetInputElements(const UINT slot, D3D11_INPUT_ELEMENT_DESC* elementsOut)
+{
+	DXTVertexAttributeList<Attributes...>::GetInputElements(slot, 0, elementsOut);
+}
+
+template <typename... Attributes>
+inline void DXTVertexLayout<Attributes...>::Interleave(const DXTVertexStream* streams, const size_t vertexCount,
+	const DXTVertexEncodeParams& params, void* verticesOut)
+{
+	BYTE* vertex = static_cast<BYTE*>(verticesOut);
+	for (size_t i = 0; i < vertexCount; ++i, vertex += Stride)
+		DXTVertexAttributeList<Attributes...>::Write(streams, i, params, vertex);
+}
+
+template <typename... Attributes>
+inline void DXTVertexLayout<Attributes...>::Deinterleave(const void* vertices, const size_t vertexCount,
+	const DXTVertexEncodeParams& params, const DXTVertexOutputStream* streamsOut)
+{
+	const BYTE* vertex = static_cast<const BYTE*>(vertices);
+	for (size_t i = 0; i < vertexCount; ++i, vertex += Stride)
+		DXTVertexAttributeList<Attributes...>::Read(vertex, params, streamsOut, i);
+}
+
+template <typename... Attributes>
+inline const DXTVertexFormat& DXTVertexLayout<Attributes...>::GetFormat()
+{
+	struct StreamChannelList
+	{
+		UINT Channels[StreamCount];
+
+		StreamChannelList()
+		{
+			const UINT attributeChannels[] = { Attributes::Channels... };
+			UINT stream = 0;
+			for (auto channels : attributeChannels)
+				for (UINT channel = 1; channel <= channels; channel <<= 1)
+					if (channels & channel)
+						Channels[stream++] = channel;
+		}
+	};
+
+	static const UINT attributeChannels[] = { Attributes::Channels... };
+	static const DXGI_FORMAT attributeFormats[] = { Attributes::Format... };
+	static const StreamChannelList streamChannels;
+	static const DXTVertexFormat format = { ChannelFlags, Stride, AttributeCount, attributeChannels, attributeFormats,
+		StreamCount, streamChannels.Channels, &Interleave, &Deinterleave };
+	return format;
+}
+
+// Shader inputs and cooked files rely on these, a change here has to go along with ShaderTypes.hlsli and cooking
+// the meshes again
+static_assert(DXTVertexLayoutPositionUVNormal::Stride == 32 && DXTVertexLayoutPositionUVNormal::Offset<1>::Value == 12 &&
+	DXTVertexLayoutPositionUVNormal::Offset<2>::Value == 20, "Unexpected DXTVertexLayoutPositionUVNormal layout");
+static_assert(DXTVertexLayoutPositionUVNormalQuantized::Stride == 16 && DXTVertexLayoutPositionUVNormalQuantized::Offset<1>::Value == 8 &&
+	DXTVertexLayoutPositionUVNormalQuantized::Offset<2>::Value == 12, "Unexpected DXTVertexLayoutPositionUVNormalQuantized layout");
+static_assert(DXTVertexLayoutTangentFrameQuantized::Stride == 20 && DXTVertexLayoutTangentFrameQuantized::Offset<1>::Value == 8 &&
+	DXTVertexLayoutTangentFrameQuantized::Offset<2>::Value == 12, "Unexpected DXTVertexLayoutTangentFrameQuantized layout");
\ No newline at end of file
@@ -4,13 +4,30 @@ cbuffer TransformConstants : register(b0)
 {
 	float4x4 World;
 	float4x4 ViewProjection;
+	// Lower corner and extent of the mesh bounds
+	float4 PositionLower;
+	float4 PositionExtent;
 };
 
+float3 DecodePosition(float3 normalized)
+{
+	return PositionLower.xyz + normalized * PositionExtent.xyz;
+}
+
+// Inverse of DXTEncodeOctahedral, the lower hemisphere is unfolded across the diagonals
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float2 signs = float2(direction.x >= 0.0f ? 1.0f : -1.0f, direction.y >= 0.0f ? 1.0f : -1.0f);
+	direction.xy = direction.z < 0.0f ? (1.0f - abs(direction.yx)) * signs : direction.xy;
+	return normalize(direction);
+}
+
 VertexShaderOutput main(VertexShaderInput input)
 {
 	VertexShaderOutput output;
-	output.Position = mul(ViewProjection, mul(World, float4(input.pos, 1.0f)));
-	output.Normal = mul(World, float4(input.normal, 0.0f)).xyz;
+	output.Position = mul(ViewProjection, mul(World, float4(DecodePosition(input.pos.xyz), 1.0f)));
+	output.Normal = mul(World, float4(DecodeOctahedral(input.normal), 0.0f)).xyz;
 	output.UV = input.uv;
 	return output;
 }
\ No newline at end of file
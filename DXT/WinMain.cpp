@@ -1,4 +1,5 @@
 #include "DirectXToolbox.h"
+#include "SceneGraph.h"
 
 using namespace DirectX;
 
@@ -28,16 +29,17 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR cmdLine,
 			eventHandler.SetSwapChain(swapChain);
 
 			FLOAT clearColor[] = { 0.5f, 0.5f, 1.0f, 1.0f };
-			D3D11_INPUT_ELEMENT_DESC inputDesc[] =
-			{
-				{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-				{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, sizeof(float) * 3, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-				{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, sizeof(float) * 5, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			};
-			UINT elementCount = 3;
-			UINT stride = 8 * sizeof(FLOAT);
+			D3D11_INPUT_ELEMENT_DESC inputDesc[DXTVertexLayoutPositionUVNormalQuantized::AttributeCount];
+			DXTVertexLayoutPositionUVNormalQuantized::GetInputElements(0, inputDesc);
+			UINT elementCount = DXTVertexLayoutPositionUVNormalQuantized::AttributeCount;
+			UINT stride = DXTVertexLayoutPositionUVNormalQuantized::Stride;
 			UINT offset = 0;
-			UINT indexCount = 0;
+			std::vector<DXTMeshFileSubmesh> submeshes;
+			std::vector<DXTMeshFileNode> meshNodes;
+			DXTBounds meshBounds;
+			DXTWorkerPool workerPool;
+			DXTSceneGraph sceneGraph;
+			std::vector<DXTSceneGraphMesh> sceneMeshes;
 			FLOAT deltaTime = 0.016f;
 
 			DXTSphericalCamera camera;
@@ -58,6 +60,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR cmdLine,
 			ID3D11RasterizerState* rasterizerState;
 			ID3D11Buffer* vertexBuffer;
 			ID3D11Buffer* indexBuffer;
+			DXTIndexType indexType;
 			ID3D11InputLayout* inputLayout;
 			ID3D11Buffer* transformBuffer;
 
@@ -67,16 +70,28 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR cmdLine,
 			DXTPixelShaderFromFile(device, "PixelShader.cso", &pixelShader);
 			DXTCreateDepthStencilStateDepthTestEnabled(device, &depthState);
 			DXTCreateRasterizerStateSolid(device, &rasterizerState);
-			DXTLoadStaticMeshFromFile(device, "mesh.ase", DXTVertexAttributePosition | DXTVertexAttributeUV | DXTVertexAttributeNormal,
-				DXTIndexTypeShort, &vertexBuffer, &indexBuffer, &indexCount);
-			DXTCreateBuffer(device, sizeof(DirectX::XMFLOAT4X4) * 2, D3D11_BIND_CONSTANT_BUFFER, D3D11_CPU_ACCESS_WRITE, D3D11_USAGE_DYNAMIC, &transformBuffer);
+			// Cooked from mesh.ase by DXTCook before the build, with the quantized layout the shaders read
+			result = DXTLoadStaticMeshFromCookedFile(device, "mesh.dxtmesh", DXTVertexLayoutPositionUVNormalQuantized::GetFormat(),
+				&vertexBuffer, &indexBuffer, &indexType, &submeshes, &meshNodes, &meshBounds);
+			if (FAILED(result))
+			{
+				OutputDebugString("Failed to load mesh.dxtmesh, it has to be cooked with the quantized position, UV and normal layout!\n");
+				vertexBuffer = nullptr;
+				indexBuffer = nullptr;
+			}
+			DXTAddMeshFileNodes(meshNodes.data(), meshNodes.size(), DXT_SCENE_GRAPH_NO_PARENT, &sceneGraph, &sceneMeshes);
+			sceneGraph.Update(&workerPool);
+			DXTCreateBuffer(device, sizeof(DirectX::XMFLOAT4X4) * 2 + sizeof(DirectX::XMFLOAT4) * 2, D3D11_BIND_CONSTANT_BUFFER, D3D11_CPU_ACCESS_WRITE, D3D11_USAGE_DYNAMIC, &transformBuffer);
 
 			device->CreateInputLayout(inputDesc, elementCount, vertexBytecode.Bytecode, vertexBytecode.BytecodeLength, &inputLayout);
 			vertexBytecode.Destroy();
 
+			DXTStateCache stateCache;
+			stateCache.Initialize(context);
+
 			window.Present(false);
 
-			while (!window.QuitMessageReceived())
+			while (SUCCEEDED(result) && !window.QuitMessageReceived())
 			{
 				window.MessagePump();
 
@@ -86,45 +101,57 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR cmdLine,
 				cameraController.Update(deltaTime);
 
 				XMFLOAT4X4 ViewProj;
-				XMFLOAT4X4 World;
 				camera.GetViewProjectionMatrix(&ViewProj, params.Extent);
-				XMStoreFloat4x4(&World, XMMatrixIdentity());
-
-				D3D11_MAPPED_SUBRESOURCE subres;
-				context->Map(transformBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subres);
-				XMFLOAT4X4* ptr = (XMFLOAT4X4*)subres.pData;
-				ptr[0] = World;
-				ptr[1] = ViewProj;
-				context->Unmap(transformBuffer, 0);
 
 				D3D11_VIEWPORT viewport = { 0.0f, 0.0f, (FLOAT)params.Extent.Width, (FLOAT)params.Extent.Height, 0.0f, 1.0f };
 				context->ClearRenderTargetView(renderTargetView, clearColor);
 				context->ClearDepthStencilView(depthBufferView, D3D11_CLEAR_DEPTH, 1.0f, 0);
-				context->OMSetDepthStencilState(depthState, 0);
-				context->OMSetRenderTargets(1, &renderTargetView, depthBufferView);
-				context->RSSetState(rasterizerState);
-				context->RSSetViewports(1, &viewport);
-				context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-				context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-				context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R16_UINT, 0);
-				context->IASetInputLayout(inputLayout);
-				context->VSSetShader(vertexShader, nullptr, 0);
-				context->PSSetShader(pixelShader, nullptr, 0);
-				context->VSSetConstantBuffers(0, 1, &transformBuffer);
-				
-				context->DrawIndexed(indexCount, 0, 0);
+				stateCache.BeginFrame();
+				stateCache.SetDepthStencilState(depthState, 0);
+				stateCache.SetRenderTargets(1, &renderTargetView, depthBufferView);
+				stateCache.SetRasterizerState(rasterizerState);
+				stateCache.SetViewports(1, &viewport);
+				stateCache.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+				stateCache.SetVertexBuffer(0, vertexBuffer, stride, offset);
+				stateCache.SetIndexBuffer(indexBuffer, indexType == DXTIndexTypeShort ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
+				stateCache.SetInputLayout(inputLayout);
+				stateCache.SetVertexShader(vertexShader);
+				stateCache.SetPixelShader(pixelShader);
+				stateCache.SetConstantBuffer(DXTShaderStageVertex, 0, transformBuffer);
+
+				// Every submesh is drawn with the world transform of the node placing it
+				for (auto& sceneMesh : sceneMeshes)
+				{
+					D3D11_MAPPED_SUBRESOURCE subres;
+					context->Map(transformBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subres);
+					XMFLOAT4X4* ptr = (XMFLOAT4X4*)subres.pData;
+					ptr[0] = sceneGraph.GetWorldTransform(sceneMesh.Node);
+					ptr[1] = ViewProj;
+					// Positions are stored normalized within the mesh bounds
+					XMFLOAT4* positionDecode = (XMFLOAT4*)(ptr + 2);
+					positionDecode[0] = XMFLOAT4(meshBounds.Lower.x, meshBounds.Lower.y, meshBounds.Lower.z, 0.0f);
+					positionDecode[1] = XMFLOAT4(meshBounds.Upper.x - meshBounds.Lower.x, meshBounds.Upper.y - meshBounds.Lower.y,
+						meshBounds.Upper.z - meshBounds.Lower.z, 0.0f);
+					context->Unmap(transformBuffer, 0);
+
+					const DXTMeshFileSubmesh& submesh = submeshes[sceneMesh.MeshIndex];
+					stateCache.DrawIndexed(submesh.IndexCount, submesh.StartIndex, submesh.BaseVertex);
+				}
 
 				swapChain->Present(1, 0);
 			}
 
 			swapChain->SetFullscreenState(false, nullptr);
 			
+			stateCache.Release();
 			transformBuffer->Release();
 			depthBufferView->Release();
 			depthBuffer->Release();
 			inputLayout->Release();
-			vertexBuffer->Release();
-			indexBuffer->Release();
+			if (vertexBuffer)
+				vertexBuffer->Release();
+			if (indexBuffer)
+				indexBuffer->Release();
 			depthState->Release();
 			rasterizerState->Release();
 			vertexShader->Release();
@@ -0,0 +1,122 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static size_t DXTGetDefaultWorkerCount()
+{
+	unsigned int hardwareThreads = thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+DXTWorkerPool::DXTWorkerPool() :
+	DXTWorkerPool(DXTGetDefaultWorkerCount())
+{
+}
+
+DXTWorkerPool::DXTWorkerPool(const size_t workerCount) :
+	jobFunc(nullptr),
+	jobCount(0),
+	jobGrainSize(1),
+	jobChunkCount(0),
+	nextChunk(0),
+	generation(0),
+	busyWorkers(0),
+	bShutdown(false)
+{
+	workers.reserve(workerCount);
+	for (size_t i = 0; i < workerCount; ++i)
+		workers.push_back(thread(&DXTWorkerPool::WorkerMain, this, i + 1));
+}
+
+DXTWorkerPool::~DXTWorkerPool()
+{
+	{
+		lock_guard<mutex> lock(poolMutex);
+		bShutdown = true;
+	}
+
+	wakeCondition.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+void DXTWorkerPool::ParallelFor(const size_t count, const size_t grainSize, const DXTParallelForFunc& func)
+{
+	if (count == 0)
+		return;
+
+	size_t grain = max<size_t>(grainSize, 1);
+	size_t chunkCount = (count + grain - 1) / grain;
+
+	// Not worth waking anybody up for a single chunk
+	if (chunkCount == 1 || workers.empty())
+	{
+		for (size_t begin = 0; begin < count; begin += grain)
+			func(begin, min(begin + grain, count), 0);
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock(poolMutex);
+		jobFunc = &func;
+		jobCount = count;
+		jobGrainSize = grain;
+		jobChunkCount = chunkCount;
+		nextChunk.store(0);
+		busyWorkers = workers.size();
+		++generation;
+	}
+
+	wakeCondition.notify_all();
+
+	RunChunks(0);
+
+	// Every worker has to check in before the job can be released
+	unique_lock<mutex> lock(poolMutex);
+	doneCondition.wait(lock, [this]() { return busyWorkers == 0; });
+	jobFunc = nullptr;
+}
+
+void DXTWorkerPool::WorkerMain(const size_t threadIndex)
+{
+	size_t seenGeneration = 0;
+
+	for (;;)
+	{
+		{
+			unique_lock<mutex> lock(poolMutex);
+			wakeCondition.wait(lock, [this, seenGeneration]() { return bShutdown || generation != seenGeneration; });
+
+			if (bShutdown)
+				return;
+
+			seenGeneration = generation;
+		}
+
+		RunChunks(threadIndex);
+
+		{
+			lock_guard<mutex> lock(poolMutex);
+			--busyWorkers;
+		}
+
+		doneCondition.notify_one();
+	}
+}
+
+void DXTWorkerPool::RunChunks(const size_t threadIndex)
+{
+	for (;;)
+	{
+		size_t chunk = nextChunk.fetch_add(1);
+		if (chunk >= jobChunkCount)
+			break;
+
+		size_t begin = chunk * jobGrainSize;
+		size_t end = min(begin + jobGrainSize, jobCount);
+		(*jobFunc)(begin, end, threadIndex);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Called with a half open range of items and the index of the thread running it,
+// thread 0 is always the thread that called ParallelFor
+typedef std::function<void(size_t begin, size_t end, size_t threadIndex)> DXTParallelForFunc;
+
+// Persistent set of worker threads that split ranges of work into fixed size chunks.
+// The calling thread takes part in the work and ParallelFor returns once every chunk is done.
+class DXTWorkerPool
+{
+public:
+	DXTWorkerPool();
+	DXTWorkerPool(const size_t workerCount);
+	~DXTWorkerPool();
+
+	void ParallelFor(const size_t count, const size_t grainSize, const DXTParallelForFunc& func);
+	inline size_t GetThreadCount() const;
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex poolMutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	const DXTParallelForFunc* jobFunc;
+	size_t jobCount;
+	size_t jobGrainSize;
+	size_t jobChunkCount;
+	std::atomic<size_t> nextChunk;
+
+	size_t generation;
+	size_t busyWorkers;
+	bool bShutdown;
+
+	void WorkerMain(const size_t threadIndex);
+	void RunChunks(const size_t threadIndex);
+};
+
+inline size_t DXTWorkerPool::GetThreadCount() const
+{
+	return workers.size() + 1;
+}
\ No newline at end of file
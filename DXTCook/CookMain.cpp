@@ -0,0 +1,88 @@
+#include "DirectXToolbox.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+struct DXTCookLayout
+{
+	const char* Name;
+	const DXTVertexFormat& (*GetFormat)();
+};
+
+// The sample draws the quantized layout, the renderer's geometry pool holds the float one
+static const DXTCookLayout cookLayouts[] =
+{
+	{ "quantized", &DXTVertexLayoutPositionUVNormalQuantized::GetFormat },
+	{ "tangent", &DXTVertexLayoutTangentFrameQuantized::GetFormat },
+	{ "float", &DXTVertexLayoutPositionUVNormal::GetFormat }
+};
+
+static void PrintUsage()
+{
+	printf("DXTCook [--layout quantized|tangent|float] [--index32] source cooked\n");
+}
+
+// Imports a source mesh with Assimp and writes it as a .dxtmesh file, runtime builds only load those
+int main(int argc, char** argv)
+{
+	const DXTCookLayout* layout = &cookLayouts[0];
+	DXTIndexType indexType = DXTIndexTypeShort;
+	const char* paths[2] = {};
+	int pathCount = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--index32") == 0)
+		{
+			indexType = DXTIndexTypeInt;
+		}
+		else if (strcmp(argv[i], "--layout") == 0 && i + 1 < argc)
+		{
+			layout = nullptr;
+			++i;
+			for (auto& cookLayout : cookLayouts)
+				if (strcmp(argv[i], cookLayout.Name) == 0)
+					layout = &cookLayout;
+
+			if (!layout)
+			{
+				printf("Unknown layout %s\n", argv[i]);
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (pathCount < 2)
+		{
+			paths[pathCount++] = argv[i];
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (pathCount != 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	DXTMeshCookReport report;
+	HRESULT result = DXTCookStaticMesh(paths[0], paths[1], layout->GetFormat(), indexType, &report);
+	if (FAILED(result))
+	{
+		printf("Cooking %s failed (0x%08lX)\n", paths[0], static_cast<unsigned long>(result));
+		return 1;
+	}
+
+	printf("Cooked %s to %s\n", paths[0], paths[1]);
+	printf("  ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", report.SourceCacheStats.GetACMR(), report.CookedCacheStats.GetACMR(),
+		report.SourceCacheStats.GetATVR(), report.CookedCacheStats.GetATVR());
+	printf("  %zu vertex bytes, %zu as floats\n", report.VertexBytes, report.FloatVertexBytes);
+	printf("  Largest error: position %g, UV %g, normal %g, tangent %g, bitangent %g degrees\n", report.EncodeError.Position,
+		report.EncodeError.UV, report.EncodeError.NormalDegrees, report.EncodeError.TangentDegrees, report.EncodeError.BitangentDegrees);
+	return 0;
+}
\ No newline at end of file
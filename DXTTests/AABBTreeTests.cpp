@@ -0,0 +1,144 @@
+#include "TestFramework.h"
+
+#include "AABBTree.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+// Side of the cube the test proxies are scattered over
+#define TEST_WORLD_SIZE 200.0f
+
+static float GetRandomFloat(unsigned int* seed, const float lower, const float upper)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return lower + (upper - lower) * static_cast<float>(*seed >> 8) / static_cast<float>(1 << 24);
+}
+
+static DXTBounds GetRandomBounds(unsigned int* seed)
+{
+	const float half = TEST_WORLD_SIZE * 0.5f;
+	XMFLOAT3 lower(GetRandomFloat(seed, -half, half), GetRandomFloat(seed, -half, half), GetRandomFloat(seed, -half, half));
+	DXTBounds bounds = { lower, XMFLOAT3(lower.x + GetRandomFloat(seed, 0.1f, 5.0f), lower.y + GetRandomFloat(seed, 0.1f, 5.0f),
+		lower.z + GetRandomFloat(seed, 0.1f, 5.0f)) };
+	return bounds;
+}
+
+static bool DoBoundsOverlap(const DXTBounds& a, const DXTBounds& b)
+{
+	return a.Lower.x <= b.Upper.x && a.Lower.y <= b.Upper.y && a.Lower.z <= b.Upper.z &&
+		a.Upper.x >= b.Lower.x && a.Upper.y >= b.Lower.y && a.Upper.z >= b.Lower.z;
+}
+
+// Live proxies of the test tree by user data, NULL_NODE once destroyed
+struct TestProxies
+{
+	vector<int> Proxies;
+	vector<DXTBounds> Bounds;
+};
+
+// Queries the tree and compares it with testing every live proxy on its own. The tree has to return exactly the
+// proxies whose fat bounds pass, which includes every proxy whose tight bounds pass.
+static void CheckQueries(DXTAABBTree* tree, const TestProxies& proxies, const DXTFrustum& frustum, const DXTBounds& box)
+{
+	vector<UINT> frustumResult;
+	vector<UINT> boxResult;
+	tree->Query(frustum, &frustumResult);
+	tree->Query(box, &boxResult);
+	sort(frustumResult.begin(), frustumResult.end());
+	sort(boxResult.begin(), boxResult.end());
+
+	vector<UINT> frustumExpected;
+	vector<UINT> boxExpected;
+	bool bTightIncluded = true;
+	for (UINT i = 0; i < proxies.Proxies.size(); ++i)
+	{
+		int proxy = proxies.Proxies[i];
+		if (proxy == DXT_AABB_TREE_NULL_NODE)
+			continue;
+
+		const DXTBounds& fatBounds = tree->GetFatBounds(proxy);
+		if (!DXTIsOutsideFrustum(fatBounds, frustum))
+			frustumExpected.push_back(i);
+		if (DoBoundsOverlap(fatBounds, box))
+			boxExpected.push_back(i);
+
+		if (!DXTIsOutsideFrustum(proxies.Bounds[i], frustum))
+			bTightIncluded &= binary_search(frustumResult.begin(), frustumResult.end(), i);
+		if (DoBoundsOverlap(proxies.Bounds[i], box))
+			bTightIncluded &= binary_search(boxResult.begin(), boxResult.end(), i);
+	}
+
+	DXT_CHECK(frustumResult == frustumExpected);
+	DXT_CHECK(boxResult == boxExpected);
+	DXT_CHECK(bTightIncluded);
+	DXT_CHECK(!frustumResult.empty() && frustumResult.size() < tree->GetProxyCount());
+}
+
+DXT_TEST(AABBTreeQueriesMatchBruteForce)
+{
+	const size_t proxyCount = 2000;
+	unsigned int seed = 11;
+
+	DXTFrustum frustum;
+	DXTConstructFrustum(XM_PI / 3.0f, 120.0f, 0.5f, XMFLOAT3(0.0f, 0.0f, -60.0f), XMFLOAT3(0.0f, 0.0f, 0.0f),
+		XMFLOAT3(0.0f, 1.0f, 0.0f), 16.0f / 9.0f, &frustum);
+	DXTBounds box = { XMFLOAT3(-30.0f, -30.0f, -30.0f), XMFLOAT3(20.0f, 40.0f, 10.0f) };
+
+	DXTAABBTree tree;
+	TestProxies proxies;
+	for (size_t i = 0; i < proxyCount; ++i)
+	{
+		proxies.Bounds.push_back(GetRandomBounds(&seed));
+		proxies.Proxies.push_back(tree.CreateProxy(proxies.Bounds[i], static_cast<UINT>(i)));
+	}
+
+	DXT_CHECK(tree.GetProxyCount() == proxyCount);
+	CheckQueries(&tree, proxies, frustum, box);
+
+	// Small moves stay within the fat bounds, large ones reinsert the proxy
+	bool bFatBoundsContain = true;
+	for (size_t i = 0; i < proxyCount; i += 2)
+	{
+		float step = i % 4 == 0 ? 0.1f : 20.0f;
+		DXTBounds& bounds = proxies.Bounds[i];
+		XMFLOAT3 displacement(step, 0.0f, -step);
+		bounds.Lower = XMFLOAT3(bounds.Lower.x + step, bounds.Lower.y, bounds.Lower.z - step);
+		bounds.Upper = XMFLOAT3(bounds.Upper.x + step, bounds.Upper.y, bounds.Upper.z - step);
+
+		bool bReinserted = tree.MoveProxy(proxies.Proxies[i], bounds, displacement);
+		bFatBoundsContain &= bReinserted == (step > tree.FatMargin);
+
+		const DXTBounds& fatBounds = tree.GetFatBounds(proxies.Proxies[i]);
+		bFatBoundsContain &= fatBounds.Lower.x <= bounds.Lower.x && fatBounds.Lower.z <= bounds.Lower.z &&
+			fatBounds.Upper.x >= bounds.Upper.x && fatBounds.Upper.z >= bounds.Upper.z;
+	}
+	DXT_CHECK(bFatBoundsContain);
+	CheckQueries(&tree, proxies, frustum, box);
+
+	// Destroyed proxies leave the results, their nodes are reused by new ones
+	for (size_t i = 0; i < proxyCount; i += 3)
+	{
+		tree.DestroyProxy(proxies.Proxies[i]);
+		proxies.Proxies[i] = DXT_AABB_TREE_NULL_NODE;
+	}
+	for (size_t i = 0; i < proxyCount / 10; ++i)
+	{
+		proxies.Bounds.push_back(GetRandomBounds(&seed));
+		proxies.Proxies.push_back(tree.CreateProxy(proxies.Bounds.back(), static_cast<UINT>(proxies.Proxies.size())));
+	}
+
+	size_t liveCount = count_if(proxies.Proxies.begin(), proxies.Proxies.end(), [](int proxy) { return proxy != DXT_AABB_TREE_NULL_NODE; });
+	DXT_CHECK(tree.GetProxyCount() == liveCount);
+	CheckQueries(&tree, proxies, frustum, box);
+
+	// Rotations keep the tree balanced, an AVL tree of this size is at most 1.44 log2 n high
+	DXT_CHECK(tree.GetHeight() <= 16);
+
+	tree.Clear();
+	vector<UINT> result;
+	tree.Query(frustum, &result);
+	DXT_CHECK(tree.GetProxyCount() == 0 && result.empty());
+}
\ No newline at end of file
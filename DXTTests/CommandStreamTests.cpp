@@ -0,0 +1,210 @@
+#include "TestFramework.h"
+
+#include "CommandStream.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+// Keeps what it is given so the tests can compare it with what was recorded
+class RecordingBackend : public DXTNullCommandBackend
+{
+public:
+	vector<DXTSetVertexBufferCommand> VertexBuffers;
+	vector<DXTSetIndexBufferCommand> IndexBuffers;
+	vector<DXTSetConstantBufferCommand> ConstantBuffers;
+	vector<uint8_t> Constants;
+	vector<DXTDrawIndexedCommand> Draws;
+	vector<DXTDrawIndexedInstancedCommand> InstancedDraws;
+	vector<DXTCommandHandle> Pipelines;
+
+	void SetPipeline(const DXTSetPipelineCommand& command) override
+	{
+		DXTNullCommandBackend::SetPipeline(command);
+		Pipelines.push_back(command.Pipeline);
+	}
+
+	void SetVertexBuffer(const DXTSetVertexBufferCommand& command) override
+	{
+		DXTNullCommandBackend::SetVertexBuffer(command);
+		VertexBuffers.push_back(command);
+	}
+
+	void SetIndexBuffer(const DXTSetIndexBufferCommand& command) override
+	{
+		DXTNullCommandBackend::SetIndexBuffer(command);
+		IndexBuffers.push_back(command);
+	}
+
+	void SetConstantBuffer(const DXTSetConstantBufferCommand& command) override
+	{
+		DXTNullCommandBackend::SetConstantBuffer(command);
+		ConstantBuffers.push_back(command);
+	}
+
+	void UpdateConstants(const DXTUpdateConstantsCommand& command, const void* data) override
+	{
+		DXTNullCommandBackend::UpdateConstants(command, data);
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		Constants.insert(Constants.end(), bytes, bytes + command.DataSize);
+	}
+
+	void DrawIndexed(const DXTDrawIndexedCommand& command) override
+	{
+		DXTNullCommandBackend::DrawIndexed(command);
+		Draws.push_back(command);
+	}
+
+	void DrawIndexedInstanced(const DXTDrawIndexedInstancedCommand& command) override
+	{
+		DXTNullCommandBackend::DrawIndexedInstanced(command);
+		InstancedDraws.push_back(command);
+	}
+};
+
+DXT_TEST(CommandListRoundTripsPayloads)
+{
+	int pipeline = 0;
+	int vertexBuffer = 0;
+	int indexBuffer = 0;
+	int constantBuffer = 0;
+
+	// An odd constant size pads its command, the ones after it have to decode all the same
+	const uint8_t constants[13] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 };
+
+	DXTCommandList list;
+	list.SetPipeline(&pipeline);
+	list.SetVertexBuffer(1, &vertexBuffer, 32, 64);
+	list.SetIndexBuffer(&indexBuffer, DXTIndexTypeInt, 128);
+	list.UpdateConstants(&constantBuffer, constants, sizeof(constants));
+	list.SetConstantBuffer(2, &constantBuffer, 16, 4);
+	list.DrawIndexed(36, 6, -3);
+	list.DrawIndexedInstanced(12, 5, 24, 7, 100);
+	DXT_CHECK(list.GetCommandCount() == 7);
+
+	// Every header starts 8 byte aligned and the sizes add up to the list
+	size_t offset = 0;
+	size_t commandCount = 0;
+	bool bAligned = true;
+	while (offset < list.GetSize())
+	{
+		const DXTCommandHeader* header = reinterpret_cast<const DXTCommandHeader*>(list.GetData() + offset);
+		bAligned &= offset % 8 == 0 && header->Size % 8 == 0;
+		offset += sizeof(DXTCommandHeader) + header->Size;
+		++commandCount;
+	}
+	DXT_CHECK(bAligned);
+	DXT_CHECK(offset == list.GetSize() && commandCount == 7);
+
+	RecordingBackend backend;
+	DXTReplayCommands(&list, 1, &backend);
+	DXT_CHECK(backend.Pipelines.size() == 1 && backend.Pipelines[0] == &pipeline);
+	DXT_CHECK(backend.VertexBuffers.size() == 1 && backend.VertexBuffers[0].Buffer == &vertexBuffer &&
+		backend.VertexBuffers[0].Slot == 1 && backend.VertexBuffers[0].Stride == 32 && backend.VertexBuffers[0].Offset == 64);
+	DXT_CHECK(backend.IndexBuffers.size() == 1 && backend.IndexBuffers[0].Buffer == &indexBuffer &&
+		backend.IndexBuffers[0].IndexType == DXTIndexTypeInt && backend.IndexBuffers[0].Offset == 128);
+	DXT_CHECK(backend.Constants.size() == sizeof(constants) && memcmp(backend.Constants.data(), constants, sizeof(constants)) == 0);
+	DXT_CHECK(backend.ConstantBuffers.size() == 1 && backend.ConstantBuffers[0].Buffer == &constantBuffer &&
+		backend.ConstantBuffers[0].Slot == 2 && backend.ConstantBuffers[0].FirstConstant == 16 && backend.ConstantBuffers[0].ConstantCount == 4);
+	DXT_CHECK(backend.Draws.size() == 1 && backend.Draws[0].IndexCount == 36 && backend.Draws[0].StartIndex == 6 &&
+		backend.Draws[0].BaseVertex == -3);
+	DXT_CHECK(backend.InstancedDraws.size() == 1 && backend.InstancedDraws[0].IndexCount == 12 &&
+		backend.InstancedDraws[0].InstanceCount == 5 && backend.InstancedDraws[0].StartIndex == 24 &&
+		backend.InstancedDraws[0].BaseVertex == 7 && backend.InstancedDraws[0].StartInstance == 100);
+	DXT_CHECK(backend.IndexCount == 36 + 12 * 5 && backend.InstanceCount == 6 && backend.ConstantBytes == sizeof(constants));
+
+	// Clearing keeps nothing to replay
+	list.Clear();
+	backend.Reset();
+	DXTReplayCommands(&list, 1, &backend);
+	DXT_CHECK(list.GetSize() == 0 && backend.CommandCounts[DXTCommandDrawIndexed] == 0);
+}
+
+DXT_TEST(CommandListsReplayInItemOrder)
+{
+	DXTWorkerPool pool;
+	vector<DXTCommandList> lists;
+	const DXTRecordCommandsFunc record = [](size_t begin, size_t end, DXTCommandList* list)
+	{
+		for (size_t i = begin; i < end; ++i)
+			list->DrawIndexed(static_cast<uint32_t>(i), 0, 0);
+	};
+
+	// The second round records fewer items into the lists kept from the first
+	const size_t itemCounts[] = { 1000, 100, 0 };
+	for (size_t itemCount : itemCounts)
+	{
+		DXTRecordCommandsParallel(&pool, itemCount, 7, &lists, record);
+		DXT_CHECK(lists.size() >= (itemCount + 6) / 7);
+
+		RecordingBackend backend;
+		DXTReplayCommands(lists.data(), lists.size(), &backend);
+
+		bool bOrdered = backend.Draws.size() == itemCount;
+		for (size_t i = 0; bOrdered && i < itemCount; ++i)
+			bOrdered = backend.Draws[i].IndexCount == i;
+		DXT_CHECK(bOrdered);
+	}
+}
+
+DXT_BENCHMARK(RecordAndReplayCommands)
+{
+	const size_t drawCount = 100000;
+	const uint32_t drawsPerPipeline = 64;
+	int pipelines[8] = {};
+	int buffer = 0;
+	float constants[16] = {};
+
+	// A draw with its own constants and a pipeline change every few draws, like the renderer records
+	const DXTRecordCommandsFunc record = [&](size_t begin, size_t end, DXTCommandList* list)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (i == begin || i % drawsPerPipeline == 0)
+			{
+				list->SetPipeline(&pipelines[i / drawsPerPipeline % 8]);
+				list->SetVertexBuffer(0, &buffer, 32, 0);
+				list->SetIndexBuffer(&buffer, DXTIndexTypeInt, 0);
+			}
+
+			list->UpdateConstants(&buffer, constants, sizeof(constants));
+			list->SetConstantBuffer(1, &buffer, 0, 4);
+			list->DrawIndexed(36, static_cast<uint32_t>(i), 0);
+		}
+	};
+
+	DXTWorkerPool pool;
+	vector<DXTCommandList> lists;
+	double parallelTime = DXTMeasureMilliseconds(20, [&]()
+	{
+		DXTRecordCommandsParallel(&pool, drawCount, 1024, &lists, record);
+	});
+
+	DXTCommandList serial;
+	double serialTime = DXTMeasureMilliseconds(20, [&]()
+	{
+		serial.Clear();
+		record(0, drawCount, &serial);
+	});
+
+	DXTNullCommandBackend backend;
+	double replayTime = DXTMeasureMilliseconds(20, [&]()
+	{
+		backend.Reset();
+		DXTReplayCommands(lists.data(), lists.size(), &backend);
+	});
+
+	DXT_CHECK(backend.CommandCounts[DXTCommandDrawIndexed] == drawCount);
+	DXT_CHECK(backend.ConstantBytes == drawCount * sizeof(constants));
+
+	size_t commandCount = 0;
+	for (auto& list : lists)
+		commandCount += list.GetCommandCount();
+
+	DXTReportMeasurement("threads", static_cast<double>(pool.GetThreadCount()), "");
+	DXTReportMeasurement("record 100k draws, serial", serialTime, "ms");
+	DXTReportMeasurement("record 100k draws, parallel", parallelTime, "ms");
+	DXTReportMeasurement("replay through the null backend", replayTime, "ms");
+	DXTReportMeasurement("parallel recording", commandCount / parallelTime / 1000.0, "M commands/s");
+}
\ No newline at end of file
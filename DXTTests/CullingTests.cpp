@@ -0,0 +1,473 @@
+#include "TestFramework.h"
+
+#include "DirectXToolbox.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+// Axis aligned box volume with outward plane normals, bounds are outside when their nearest corner lies beyond a plane
+static void GetBoxFrustum(const DXTBounds& box, DXTFrustum* frustumOut)
+{
+	DXTPlane planes[6] =
+	{
+		{ XMFLOAT3(1.0f, 0.0f, 0.0f), box.Upper.x },
+		{ XMFLOAT3(-1.0f, 0.0f, 0.0f), -box.Lower.x },
+		{ XMFLOAT3(0.0f, 1.0f, 0.0f), box.Upper.y },
+		{ XMFLOAT3(0.0f, -1.0f, 0.0f), -box.Lower.y },
+		{ XMFLOAT3(0.0f, 0.0f, 1.0f), box.Upper.z },
+		{ XMFLOAT3(0.0f, 0.0f, -1.0f), -box.Lower.z }
+	};
+
+	for (int i = 0; i < 6; ++i)
+		frustumOut->Planes[i] = planes[i];
+}
+
+DXT_TEST(ShadowCastersSweptAlongLightDirection)
+{
+	// Two cascades side by side, lit straight from above
+	DXTBounds cascadeBoxes[2] = { { { -10.0f, -10.0f, -10.0f }, { 10.0f, 10.0f, 10.0f } },
+		{ { 10.0f, -10.0f, -10.0f }, { 30.0f, 10.0f, 10.0f } } };
+	DXTFrustum cascades[2];
+	GetBoxFrustum(cascadeBoxes[0], &cascades[0]);
+	GetBoxFrustum(cascadeBoxes[1], &cascades[1]);
+	XMFLOAT3 lightDirection(0.0f, -1.0f, 0.0f);
+
+	enum { Inside, BetweenLight, Behind, Beside, TooFar, KnownCount };
+	DXTBounds known[KnownCount] =
+	{
+		{ { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } },
+		{ { -1.0f, 20.0f, -1.0f }, { 1.0f, 22.0f, 1.0f } },
+		{ { -1.0f, -22.0f, -1.0f }, { 1.0f, -20.0f, 1.0f } },
+		{ { -50.0f, 20.0f, -1.0f }, { -48.0f, 22.0f, 1.0f } },
+		{ { -1.0f, 80.0f, -1.0f }, { 1.0f, 82.0f, 1.0f } }
+	};
+
+	// Enough far away filler for the known bounds to go through the SIMD path as well as the scalar tail
+	DXTBoundsStreamBuffer buffer;
+	buffer.Resize(70);
+	for (size_t i = 0; i < buffer.GetCount(); ++i)
+	{
+		DXTBounds filler = { { 500.0f, 500.0f, 500.0f }, { 501.0f, 501.0f, 501.0f } };
+		buffer.SetBounds(i, filler);
+	}
+
+	const size_t offsets[] = { 0, 64 };
+	for (auto offset : offsets)
+	{
+		for (size_t i = 0; i < KnownCount; ++i)
+			buffer.SetBounds(offset + i, known[i]);
+
+		vector<UINT8> masks(buffer.GetCount());
+		vector<UINT> lists[2];
+		DXTClassifyShadowCasters(buffer.GetStream(), cascades, 2, lightDirection, 50.0f, masks.data(), lists);
+
+		DXT_CHECK(masks[offset + Inside] == 1);
+		DXT_CHECK(masks[offset + BetweenLight] == 1);
+		DXT_CHECK(masks[offset + Behind] == 0);
+		DXT_CHECK(masks[offset + Beside] == 0);
+		DXT_CHECK(masks[offset + TooFar] == 0);
+		DXT_CHECK(lists[0].size() == 2 && lists[1].empty());
+
+		for (size_t i = 0; i < KnownCount; ++i)
+		{
+			DXTBounds filler = { { 500.0f, 500.0f, 500.0f }, { 501.0f, 501.0f, 501.0f } };
+			buffer.SetBounds(offset + i, filler);
+		}
+	}
+}
+
+DXT_TEST(ShadowCastersFollowSlantedLight)
+{
+	DXTBounds cascadeBox = { { -10.0f, -10.0f, -10.0f }, { 10.0f, 10.0f, 10.0f } };
+	DXTFrustum cascade;
+	GetBoxFrustum(cascadeBox, &cascade);
+
+	// Light falling down and towards +x, a caster up and to the -x side shadows the cascade, one to the +x side doesn't
+	XMFLOAT3 lightDirection;
+	XMStoreFloat3(&lightDirection, XMVector3Normalize(XMVectorSet(1.0f, -1.0f, 0.0f, 0.0f)));
+
+	DXTBoundsStreamBuffer buffer;
+	buffer.Resize(2);
+	DXTBounds upwind = { { -31.0f, 20.0f, -1.0f }, { -29.0f, 22.0f, 1.0f } };
+	DXTBounds downwind = { { 29.0f, 20.0f, -1.0f }, { 31.0f, 22.0f, 1.0f } };
+	buffer.SetBounds(0, upwind);
+	buffer.SetBounds(1, downwind);
+
+	UINT8 masks[2];
+	vector<UINT> list;
+	DXTClassifyShadowCasters(buffer.GetStream(), &cascade, 1, lightDirection, 100.0f, masks, &list);
+
+	DXT_CHECK(masks[0] == 1);
+	DXT_CHECK(masks[1] == 0);
+	DXT_CHECK(list.size() == 1 && list[0] == 0);
+}
+
+// Camera looking down +z through an orthographic projection of the given view height
+class DXTTestOrthographicCamera : public DXTCameraBase
+{
+public:
+	DXTCameraShadowInfo CascadeInfo;
+	float ViewHeight;
+
+	void GetPosition(XMFLOAT3* positionOut) override
+	{
+		*positionOut = XMFLOAT3(0.0f, 0.0f, -10.0f);
+	}
+
+	void GetViewDirection(XMFLOAT3* directionOut) override
+	{
+		*directionOut = XMFLOAT3(0.0f, 0.0f, 1.0f);
+	}
+
+	void GetViewMatrix(XMFLOAT4X4* matrixOut) override
+	{
+		XMStoreFloat4x4(matrixOut, XMMatrixTranslation(0.0f, 0.0f, 10.0f));
+	}
+
+	void GetProjectionMatrix(XMFLOAT4X4* matrixOut, const DXTExtent2D& viewportSize) override
+	{
+		GetProjectionMatrix(matrixOut, viewportSize, 0.1f, 100.0f);
+	}
+
+	void GetProjectionMatrix(XMFLOAT4X4* matrixOut, const DXTExtent2D& viewportSize, const float nearPlane, const float farPlane) override
+	{
+		float aspectRatio = (float)viewportSize.Width / (float)viewportSize.Height;
+		XMStoreFloat4x4(matrixOut, XMMatrixOrthographicLH(ViewHeight * aspectRatio, ViewHeight, nearPlane, farPlane));
+	}
+
+	const DXTCameraShadowInfo* GetShadowInfo() const override
+	{
+		return &CascadeInfo;
+	}
+};
+
+static bool IsNear(const float value, const float expected)
+{
+	return fabsf(value - expected) <= 1e-3f * fabsf(expected);
+}
+
+DXT_TEST(ProjectionScaleFromCameras)
+{
+	DXTExtent2D viewport = { 1280, 720 };
+
+	DXTSphericalCamera perspective(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f, XM_PI / 2.0f, 0.1f, 100.0f, XM_PI / 3.0f);
+	DXTProjectionScale perspectiveScale = perspective.GetProjectionScale(viewport);
+	DXT_CHECK(!perspectiveScale.bOrthographic);
+	DXT_CHECK(IsNear(perspectiveScale.Scale, DXTGetProjectionScale(XM_PI / 3.0f, viewport).Scale));
+
+	DXTTestOrthographicCamera orthographic;
+	orthographic.ViewHeight = 36.0f;
+	DXTProjectionScale orthographicScale = orthographic.GetProjectionScale(viewport);
+	DXT_CHECK(orthographicScale.bOrthographic);
+	DXT_CHECK(IsNear(orthographicScale.Scale, 20.0f));
+	DXT_CHECK(IsNear(orthographicScale.Scale, DXTGetOrthographicProjectionScale(36.0f, viewport).Scale));
+}
+
+DXT_TEST(ProjectedSizeDependsOnDistanceOnlyInPerspective)
+{
+	DXTExtent2D viewport = { 1280, 720 };
+	DXTProjectionScale perspective = DXTGetProjectionScale(XM_PI / 3.0f, viewport);
+	DXTProjectionScale orthographic = DXTGetOrthographicProjectionScale(36.0f, viewport);
+	XMFLOAT3 camera(0.0f, 0.0f, 0.0f);
+
+	// The same unit cube at increasing distances, the last one around the camera
+	const float distances[] = { 10.0f, 20.0f, 40.0f, 80.0f, 160.0f, 0.0f };
+	const size_t count = ARRAYSIZE(distances);
+
+	DXTBoundsStreamBuffer buffer;
+	buffer.Resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		DXTBounds box = { { -0.5f, -0.5f, distances[i] - 0.5f }, { 0.5f, 0.5f, distances[i] + 0.5f } };
+		buffer.SetBounds(i, box);
+	}
+
+	float perspectiveSizes[count];
+	float orthographicSizes[count];
+	DXTComputeProjectedSizes(buffer.GetStream(), camera, perspective, perspectiveSizes);
+	DXTComputeProjectedSizes(buffer.GetStream(), camera, orthographic, orthographicSizes);
+
+	// The stream is sized four at a time and the tail one by one, both have to agree with the scalar function
+	bool bAgree = true;
+	for (size_t i = 0; i < count; ++i)
+	{
+		bAgree &= perspectiveSizes[i] == DXTGetProjectedSize(buffer.GetBounds(i), camera, perspective);
+		bAgree &= orthographicSizes[i] == DXTGetProjectedSize(buffer.GetBounds(i), camera, orthographic);
+	}
+	DXT_CHECK(bAgree);
+
+	DXT_CHECK(IsNear(perspectiveSizes[0], 2.0f * perspectiveSizes[1]));
+	DXT_CHECK(IsNear(perspectiveSizes[2], 2.0f * perspectiveSizes[3]));
+	DXT_CHECK(perspectiveSizes[5] == FLT_MAX);
+
+	// Orthographic sizes are the sphere diameter in pixels wherever the cube is
+	float diameter = 2.0f * orthographic.Scale * sqrtf(0.75f);
+	for (size_t i = 0; i < count; ++i)
+		DXT_CHECK(IsNear(orthographicSizes[i], diameter));
+
+	// Culling small bounds keeps every orthographic cube and drops the distant perspective ones
+	UINT candidates[count] = { 0, 1, 2, 3, 4, 5 };
+	UINT visible[count];
+	float minSize = 0.5f * (perspectiveSizes[1] + perspectiveSizes[2]);
+	DXT_CHECK(DXTCullSmallBounds(buffer.GetStream(), candidates, count, camera, orthographic, minSize, visible) ==
+		(diameter >= minSize ? count : 0));
+	DXT_CHECK(DXTCullSmallBounds(buffer.GetStream(), candidates, count, camera, perspective, minSize, visible) == 3);
+}
+
+// Uniform in [lower, upper) from a linear congruential sequence
+static float GetRandomFloat(unsigned int* seed, const float lower, const float upper)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return lower + (upper - lower) * static_cast<float>(*seed >> 8) / static_cast<float>(1 << 24);
+}
+
+// Boxes of random size scattered over a cube of the given half size
+static void GetRandomBounds(unsigned int seed, const size_t count, const float halfSize, vector<DXTBounds>* boundsOut)
+{
+	boundsOut->resize(count);
+	for (auto& bounds : *boundsOut)
+	{
+		XMFLOAT3 center(GetRandomFloat(&seed, -halfSize, halfSize), GetRandomFloat(&seed, -halfSize, halfSize),
+			GetRandomFloat(&seed, -halfSize, halfSize));
+		XMFLOAT3 extent(GetRandomFloat(&seed, 0.0f, 4.0f), GetRandomFloat(&seed, 0.0f, 4.0f), GetRandomFloat(&seed, 0.0f, 4.0f));
+		bounds.Lower = XMFLOAT3(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+		bounds.Upper = XMFLOAT3(center.x + extent.x, center.y + extent.y, center.z + extent.z);
+	}
+}
+
+DXT_TEST(TransformBoundsBatchMatchesScalar)
+{
+	unsigned int seed = 3;
+	DXTBoundsStreamBuffer batch;
+
+	// Whole groups of four, tails of every length and a shorter batch after a longer one
+	const size_t counts[] = { 0, 1, 3, 4, 5, 7, 8, 17, 2 };
+	for (size_t count : counts)
+	{
+		vector<DXTBounds> bounds;
+		GetRandomBounds(seed++, count, 50.0f, &bounds);
+
+		vector<XMFLOAT4X4> matrices(count);
+		for (auto& matrix : matrices)
+		{
+			XMMATRIX world = XMMatrixScaling(GetRandomFloat(&seed, 0.5f, 2.0f), GetRandomFloat(&seed, 0.5f, 2.0f), 1.0f) *
+				XMMatrixRotationRollPitchYaw(GetRandomFloat(&seed, -XM_PI, XM_PI), GetRandomFloat(&seed, -XM_PI, XM_PI), 0.0f) *
+				XMMatrixTranslation(GetRandomFloat(&seed, -10.0f, 10.0f), 0.0f, GetRandomFloat(&seed, -10.0f, 10.0f));
+			XMStoreFloat4x4(&matrix, world);
+		}
+
+		DXTTransformBoundsBatch(bounds.data(), matrices.data(), count, &batch);
+		DXT_CHECK(batch.GetCount() == count);
+
+		bool bAgree = true;
+		for (size_t i = 0; i < count; ++i)
+		{
+			DXTBounds scalar;
+			DXTTransformBounds(XMLoadFloat4x4(&matrices[i]), bounds[i], &scalar);
+			DXTBounds batched = batch.GetBounds(i);
+			bAgree &= batched.Lower.x == scalar.Lower.x && batched.Lower.y == scalar.Lower.y && batched.Lower.z == scalar.Lower.z &&
+				batched.Upper.x == scalar.Upper.x && batched.Upper.y == scalar.Upper.y && batched.Upper.z == scalar.Upper.z;
+		}
+		DXT_CHECK(bAgree);
+	}
+}
+
+DXT_TEST(StreamCullingMatchesScalar)
+{
+	DXTFrustum frustum;
+	DXTConstructFrustum(XM_PI / 3.0f, 60.0f, 0.5f, XMFLOAT3(0.0f, 0.0f, -20.0f), XMFLOAT3(0.0f, 0.0f, 0.0f),
+		XMFLOAT3(0.0f, 1.0f, 0.0f), 16.0f / 9.0f, &frustum);
+
+	DXTWorkerPool pool;
+	DXTParallelCullScratch scratch;
+
+	// Tails shorter and longer than a SIMD group, whole words and more than a parallel chunk
+	const size_t counts[] = { 0, 1, 7, 8, 31, 33, 16385 };
+	const DXTSimdLevel levels[] = { DXTSimdLevelSSE2, DXTSimdLevelAVX2 };
+	for (DXTSimdLevel level : levels)
+	{
+		DXTLimitSimdLevel(level);
+		if (DXTGetSimdLevel() != level)
+			continue;
+
+		for (size_t count : counts)
+		{
+			vector<DXTBounds> bounds;
+			GetRandomBounds(static_cast<unsigned int>(count), count, 50.0f, &bounds);
+
+			DXTBoundsStreamBuffer buffer;
+			buffer.Resize(count);
+			vector<UINT> expected;
+			for (size_t i = 0; i < count; ++i)
+			{
+				buffer.SetBounds(i, bounds[i]);
+				if (!DXTIsOutsideFrustum(bounds[i], frustum))
+					expected.push_back(static_cast<UINT>(i));
+			}
+
+			// Bits past the last bounds stay clear
+			vector<UINT32> mask(DXT_BOUNDS_MASK_WORD_COUNT(count));
+			DXTCullBoundsStreamMask(buffer.GetStream(), frustum, mask.data());
+			vector<UINT> maskIndices;
+			for (size_t i = 0; i < mask.size() * 32; ++i)
+				if (mask[i / 32] & (1u << (i % 32)))
+					maskIndices.push_back(static_cast<UINT>(i));
+			DXT_CHECK(maskIndices == expected);
+
+			vector<UINT> indices(count);
+			indices.resize(DXTCullBoundsStreamIndices(buffer.GetStream(), frustum, indices.data()));
+			DXT_CHECK(indices == expected);
+
+			vector<UINT> parallelIndices(count);
+			parallelIndices.resize(DXTCullBoundsStreamParallel(&pool, buffer.GetStream(), frustum, &scratch, parallelIndices.data()));
+			DXT_CHECK(parallelIndices == expected);
+		}
+	}
+
+	DXTLimitSimdLevel(DXTSimdLevelAVX2);
+}
+
+// Frustums built in different ways may list their planes in another order and differ by rounding
+static bool AreFrustumsNear(const DXTFrustum& a, const DXTFrustum& b)
+{
+	for (const DXTPlane& planeA : a.Planes)
+	{
+		bool bFound = false;
+		for (const DXTPlane& planeB : b.Planes)
+		{
+			float facing = planeA.Normal.x * planeB.Normal.x + planeA.Normal.y * planeB.Normal.y + planeA.Normal.z * planeB.Normal.z;
+			bFound |= facing > 0.9999f && fabsf(planeA.Distance - planeB.Distance) <= 1e-3f * max(1.0f, fabsf(planeA.Distance));
+		}
+
+		if (!bFound)
+			return false;
+	}
+
+	return true;
+}
+
+DXT_TEST(CascadeFrustumsMatchConstructedFrustums)
+{
+	DXTExtent2D viewport = { 1280, 720 };
+	const float aspectRatio = 1280.0f / 720.0f;
+
+	DXTSphericalCamera perspective(XMFLOAT3(2.0f, 3.0f, -15.0f), 1.2f, 1.4f, 0.1f, 100.0f, XM_PI / 3.0f);
+	DXTShadowCascadeInfo perspectiveCascades[] = { { 0.5f, 10.0f }, { 10.0f, 40.0f }, { 40.0f, 100.0f } };
+	perspective.CascadeInfo.Cascades.assign(begin(perspectiveCascades), end(perspectiveCascades));
+
+	DXTFrustum frustums[DXT_MAX_SHADOW_CASCADES];
+	perspective.GetCascadeFrustums(frustums, viewport);
+
+	XMFLOAT3 position;
+	XMFLOAT3 direction;
+	perspective.GetPosition(&position);
+	perspective.GetViewDirection(&direction);
+	XMFLOAT3 target(position.x + direction.x, position.y + direction.y, position.z + direction.z);
+
+	bool bPerspectiveNear = true;
+	for (size_t i = 0; i < ARRAYSIZE(perspectiveCascades); ++i)
+	{
+		DXTFrustum expected;
+		DXTConstructFrustum(perspective.FieldOfView, perspectiveCascades[i].FarPlane, perspectiveCascades[i].NearPlane, position,
+			target, XMFLOAT3(0.0f, 1.0f, 0.0f), aspectRatio, &expected);
+		bPerspectiveNear &= AreFrustumsNear(frustums[i], expected);
+	}
+	DXT_CHECK(bPerspectiveNear);
+
+	// The orthographic camera sits at z = -10 looking down +z, every cascade is a box
+	DXTTestOrthographicCamera orthographic;
+	orthographic.ViewHeight = 36.0f;
+	DXTShadowCascadeInfo orthographicCascades[] = { { 0.1f, 30.0f }, { 30.0f, 100.0f } };
+	orthographic.CascadeInfo.Cascades.assign(begin(orthographicCascades), end(orthographicCascades));
+	orthographic.GetCascadeFrustums(frustums, viewport);
+
+	bool bOrthographicNear = true;
+	for (size_t i = 0; i < ARRAYSIZE(orthographicCascades); ++i)
+	{
+		DXTBounds box = { XMFLOAT3(-18.0f * aspectRatio, -18.0f, orthographicCascades[i].NearPlane - 10.0f),
+			XMFLOAT3(18.0f * aspectRatio, 18.0f, orthographicCascades[i].FarPlane - 10.0f) };
+		DXTFrustum expected;
+		GetBoxFrustum(box, &expected);
+		bOrthographicNear &= AreFrustumsNear(frustums[i], expected);
+	}
+	DXT_CHECK(bOrthographicNear);
+	DXT_CHECK(!AreFrustumsNear(frustums[0], frustums[1]));
+}
+
+// Bounds of a scene large enough to split into many parallel chunks, with the camera looking into it
+static void GetLargeCullScene(const size_t count, DXTBoundsStreamBuffer* bufferOut, DXTFrustum* frustumOut)
+{
+	vector<DXTBounds> bounds;
+	GetRandomBounds(17, count, 500.0f, &bounds);
+	bufferOut->Resize(count);
+	for (size_t i = 0; i < count; ++i)
+		bufferOut->SetBounds(i, bounds[i]);
+
+	DXTConstructFrustum(XM_PI / 3.0f, 600.0f, 0.5f, XMFLOAT3(0.0f, 0.0f, -200.0f), XMFLOAT3(0.0f, 0.0f, 0.0f),
+		XMFLOAT3(0.0f, 1.0f, 0.0f), 16.0f / 9.0f, frustumOut);
+}
+
+DXT_TEST(ParallelCullingIsDeterministic)
+{
+	const size_t count = DXT_PARALLEL_CULL_CHUNK_SIZE * 20 + 5;
+	DXTBoundsStreamBuffer buffer;
+	DXTFrustum frustum;
+	GetLargeCullScene(count, &buffer, &frustum);
+
+	vector<UINT> expected(count);
+	expected.resize(DXTCullBoundsStreamIndices(buffer.GetStream(), frustum, expected.data()));
+
+	// Every worker count, and repeated runs on the same scratch, give the serial order
+	const size_t workerCounts[] = { 0, 1, 3, 7 };
+	for (size_t workerCount : workerCounts)
+	{
+		DXTWorkerPool pool(workerCount);
+		DXTParallelCullScratch scratch;
+
+		bool bSame = true;
+		for (int run = 0; run < 4; ++run)
+		{
+			vector<UINT> indices(count);
+			indices.resize(DXTCullBoundsStreamParallel(&pool, buffer.GetStream(), frustum, &scratch, indices.data()));
+			bSame &= indices == expected;
+		}
+		DXT_CHECK(bSame);
+	}
+}
+
+DXT_BENCHMARK(ParallelCullingScales)
+{
+	const size_t count = 1000000;
+	DXTBoundsStreamBuffer buffer;
+	DXTFrustum frustum;
+	GetLargeCullScene(count, &buffer, &frustum);
+	vector<UINT> indices(count);
+
+	double serialTime = DXTMeasureMilliseconds(20, [&]()
+	{
+		DXTCullBoundsStreamIndices(buffer.GetStream(), frustum, indices.data());
+	});
+	DXTReportMeasurement("cull 1M bounds, serial", serialTime, "ms");
+
+	const size_t threadCounts[] = { 1, 2, 4, 8 };
+	for (size_t threadCount : threadCounts)
+	{
+		DXTWorkerPool pool(threadCount - 1);
+		DXTParallelCullScratch scratch;
+		double parallelTime = DXTMeasureMilliseconds(20, [&]()
+		{
+			DXTCullBoundsStreamParallel(&pool, buffer.GetStream(), frustum, &scratch, indices.data());
+		});
+
+		char label[64];
+		snprintf(label, sizeof(label), "cull 1M bounds, %zu threads", threadCount);
+		DXTReportMeasurement(label, parallelTime, "ms");
+	}
+}
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "TestFramework.h"
+
+#include "FrameGraph.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Records what the graph asks for and hands out slots the way the render target pool does, a released
+// slot of the same description is reused by the next acquire
+class DXTTestFrameGraphBackend : public DXTFrameGraphBackend
+{
+public:
+	vector<string> Events;
+	// Slot each resource was last acquired in
+	vector<uint32_t> ResourceSlots;
+	size_t SlotCount;
+
+	DXTTestFrameGraphBackend() :
+		SlotCount(0)
+	{
+	}
+
+	void AcquireResource(const uint32_t resource, const DXTFrameGraphResourceDesc& desc) override
+	{
+		uint32_t slot = static_cast<uint32_t>(slots.size());
+		for (uint32_t i = 0; i < slots.size(); ++i)
+		{
+			const Slot& candidate = slots[i];
+			if (!candidate.bAcquired && candidate.Desc.Width == desc.Width && candidate.Desc.Height == desc.Height &&
+				candidate.Desc.Format == desc.Format && candidate.Desc.BindFlags == desc.BindFlags)
+			{
+				slot = i;
+				break;
+			}
+		}
+
+		if (slot == slots.size())
+		{
+			Slot created = { desc, false };
+			slots.push_back(created);
+			SlotCount = slots.size();
+		}
+
+		slots[slot].bAcquired = true;
+		if (ResourceSlots.size() <= resource)
+			ResourceSlots.resize(resource + 1, DXT_FRAME_GRAPH_NULL_INDEX);
+		ResourceSlots[resource] = slot;
+
+		Events.push_back("acquire " + to_string(resource));
+	}
+
+	void ReleaseResource(const uint32_t resource) override
+	{
+		slots[ResourceSlots[resource]].bAcquired = false;
+		Events.push_back("release " + to_string(resource));
+	}
+
+	void Barrier(const DXTFrameGraphBarrier& barrier) override
+	{
+		Events.push_back("barrier " + to_string(barrier.Resource) + " " + to_string(barrier.Before) + ">" + to_string(barrier.After));
+	}
+
+private:
+	struct Slot
+	{
+		DXTFrameGraphResourceDesc Desc;
+		bool bAcquired;
+	};
+
+	vector<Slot> slots;
+};
+
+static bool HasBarrier(const vector<DXTFrameGraphBarrier>& barriers, const size_t index, const uint32_t resource,
+	const DXTFrameGraphResourceState before, const DXTFrameGraphResourceState after)
+{
+	return index < barriers.size() && barriers[index].Resource == resource && barriers[index].Before == before &&
+		barriers[index].After == after;
+}
+
+DXT_TEST(FrameGraphCullsPassesNothingReads)
+{
+	DXTFrameGraphResourceDesc colorDesc = { 1280, 720, 28, 0x28 };
+	DXTFrameGraph graph;
+
+	uint32_t scene = graph.CreateResource("Scene", colorDesc);
+	uint32_t debugSource = graph.CreateResource("DebugSource", colorDesc);
+	uint32_t debug = graph.CreateResource("Debug", colorDesc);
+	uint32_t readback = graph.CreateResource("Readback", colorDesc);
+	uint32_t backBuffer = graph.ImportResource("BackBuffer");
+
+	uint32_t geometry = graph.AddPass("Geometry", nullptr);
+	graph.Write(geometry, scene);
+
+	// A chain ending in a resource nobody reads goes away as a whole
+	uint32_t debugFeed = graph.AddPass("DebugFeed", nullptr);
+	graph.Write(debugFeed, debugSource);
+	uint32_t debugView = graph.AddPass("DebugView", nullptr);
+	graph.Read(debugView, debugSource);
+	graph.Read(debugView, scene);
+	graph.Write(debugView, debug);
+
+	// Unread as well, but it has side effects
+	uint32_t capture = graph.AddPass("Capture", nullptr);
+	graph.Read(capture, scene);
+	graph.Write(capture, readback);
+	graph.SetSideEffects(capture);
+
+	uint32_t present = graph.AddPass("Present", nullptr);
+	graph.Read(present, scene);
+	graph.Write(present, backBuffer);
+
+	graph.Compile();
+
+	DXT_CHECK(!graph.IsPassCulled(geometry));
+	DXT_CHECK(graph.IsPassCulled(debugFeed));
+	DXT_CHECK(graph.IsPassCulled(debugView));
+	DXT_CHECK(!graph.IsPassCulled(capture));
+	DXT_CHECK(!graph.IsPassCulled(present));
+	DXT_CHECK(graph.GetCulledPassCount() == 2);
+
+	DXT_CHECK(graph.GetFirstPass(scene) == geometry && graph.GetLastPass(scene) == present);
+	DXT_CHECK(graph.GetFirstPass(debug) == DXT_FRAME_GRAPH_NULL_INDEX && graph.GetLastPass(debug) == DXT_FRAME_GRAPH_NULL_INDEX);
+	DXT_CHECK(graph.GetFirstPass(readback) == capture && graph.GetLastPass(readback) == capture);
+
+	// Culled passes never run and their resources are never acquired
+	vector<uint32_t> executed;
+	graph.Clear();
+	scene = graph.CreateResource("Scene", colorDesc);
+	debug = graph.CreateResource("Debug", colorDesc);
+	backBuffer = graph.ImportResource("BackBuffer");
+	geometry = graph.AddPass("Geometry", [&]() { executed.push_back(0); });
+	graph.Write(geometry, scene);
+	debugView = graph.AddPass("DebugView", [&]() { executed.push_back(1); });
+	graph.Read(debugView, scene);
+	graph.Write(debugView, debug);
+	present = graph.AddPass("Present", [&]() { executed.push_back(2); });
+	graph.Read(present, scene);
+	graph.Write(present, backBuffer);
+
+	graph.Compile();
+	DXTTestFrameGraphBackend backend;
+	graph.Execute(&backend);
+
+	DXT_CHECK(graph.GetPassCount() == 3 && graph.GetResourceCount() == 3);
+	DXT_CHECK(executed.size() == 2 && executed[0] == 0 && executed[1] == 2);
+	DXT_CHECK(backend.SlotCount == 1);
+}
+
+DXT_TEST(FrameGraphOrdersBarriersAndLifetimes)
+{
+	DXTFrameGraphResourceDesc colorDesc = { 1280, 720, 28, 0x28 };
+	DXTFrameGraphResourceDesc depthDesc = { 1280, 720, 45, 0x40 };
+	DXTFrameGraph graph;
+	DXTTestFrameGraphBackend backend;
+	vector<string>* events = &backend.Events;
+
+	uint32_t albedo = graph.CreateResource("Albedo", colorDesc);
+	uint32_t depth = graph.CreateResource("Depth", depthDesc);
+	uint32_t lighting = graph.CreateResource("Lighting", colorDesc);
+	uint32_t backBuffer = graph.ImportResource("BackBuffer");
+
+	uint32_t geometry = graph.AddPass("Geometry", [=]() { events->push_back("run Geometry"); });
+	graph.Write(geometry, albedo);
+	graph.Write(geometry, depth);
+
+	// Reads the depth it also tests against, it has to stay an output
+	uint32_t shade = graph.AddPass("Shade", [=]() { events->push_back("run Shade"); });
+	graph.Read(shade, albedo);
+	graph.Read(shade, depth);
+	graph.Write(shade, depth);
+	graph.Write(shade, lighting);
+
+	uint32_t present = graph.AddPass("Present", [=]() { events->push_back("run Present"); });
+	graph.Read(present, lighting);
+	graph.Read(present, depth);
+	graph.Write(present, backBuffer);
+
+	graph.Compile();
+
+	const vector<DXTFrameGraphBarrier>& geometryBarriers = graph.GetBarriers(geometry);
+	DXT_CHECK(geometryBarriers.size() == 2);
+	DXT_CHECK(HasBarrier(geometryBarriers, 0, albedo, DXTFrameGraphStateUndefined, DXTFrameGraphStateOutput));
+	DXT_CHECK(HasBarrier(geometryBarriers, 1, depth, DXTFrameGraphStateUndefined, DXTFrameGraphStateOutput));
+
+	// Writes come first, the depth written and read in one pass needs no transition
+	const vector<DXTFrameGraphBarrier>& shadeBarriers = graph.GetBarriers(shade);
+	DXT_CHECK(shadeBarriers.size() == 2);
+	DXT_CHECK(HasBarrier(shadeBarriers, 0, lighting, DXTFrameGraphStateUndefined, DXTFrameGraphStateOutput));
+	DXT_CHECK(HasBarrier(shadeBarriers, 1, albedo, DXTFrameGraphStateOutput, DXTFrameGraphStateInput));
+
+	// The imported back buffer starts undefined like everything else
+	const vector<DXTFrameGraphBarrier>& presentBarriers = graph.GetBarriers(present);
+	DXT_CHECK(presentBarriers.size() == 3);
+	DXT_CHECK(HasBarrier(presentBarriers, 0, backBuffer, DXTFrameGraphStateUndefined, DXTFrameGraphStateOutput));
+	DXT_CHECK(HasBarrier(presentBarriers, 1, lighting, DXTFrameGraphStateOutput, DXTFrameGraphStateInput));
+	DXT_CHECK(HasBarrier(presentBarriers, 2, depth, DXTFrameGraphStateOutput, DXTFrameGraphStateInput));
+
+	DXT_CHECK(graph.GetFirstPass(albedo) == geometry && graph.GetLastPass(albedo) == shade);
+	DXT_CHECK(graph.GetFirstPass(depth) == geometry && graph.GetLastPass(depth) == present);
+	DXT_CHECK(graph.GetFirstPass(backBuffer) == present);
+
+	// Acquires, then barriers, then the pass, then releases. Imported resources are never acquired.
+	graph.Execute(&backend);
+	vector<string> expected =
+	{
+		"acquire 0", "acquire 1", "barrier 0 0>1", "barrier 1 0>1", "run Geometry",
+		"acquire 2", "barrier 2 0>1", "barrier 0 1>2", "run Shade", "release 0",
+		"barrier 3 0>1", "barrier 2 1>2", "barrier 1 1>2", "run Present", "release 1", "release 2"
+	};
+
+	DXT_CHECK(*events == expected);
+}
+
+DXT_TEST(FrameGraphReusesReleasedTargets)
+{
+	DXTFrameGraphResourceDesc colorDesc = { 1280, 720, 28, 0x28 };
+	DXTFrameGraphResourceDesc halfDesc = { 640, 360, 28, 0x28 };
+	DXTFrameGraph graph;
+
+	// Ping pong through a blur chain, only two full size targets are ever alive at once
+	uint32_t scene = graph.CreateResource("Scene", colorDesc);
+	uint32_t bright = graph.CreateResource("Bright", halfDesc);
+	uint32_t blurX = graph.CreateResource("BlurX", halfDesc);
+	uint32_t blurY = graph.CreateResource("BlurY", halfDesc);
+	uint32_t composite = graph.CreateResource("Composite", colorDesc);
+	uint32_t tonemapped = graph.CreateResource("Tonemapped", colorDesc);
+	uint32_t backBuffer = graph.ImportResource("BackBuffer");
+
+	uint32_t pass = graph.AddPass("Scene", nullptr);
+	graph.Write(pass, scene);
+	pass = graph.AddPass("Bright", nullptr);
+	graph.Read(pass, scene);
+	graph.Write(pass, bright);
+	pass = graph.AddPass("BlurX", nullptr);
+	graph.Read(pass, bright);
+	graph.Write(pass, blurX);
+	pass = graph.AddPass("BlurY", nullptr);
+	graph.Read(pass, blurX);
+	graph.Write(pass, blurY);
+	pass = graph.AddPass("Composite", nullptr);
+	graph.Read(pass, scene);
+	graph.Read(pass, blurY);
+	graph.Write(pass, composite);
+	pass = graph.AddPass("Tonemap", nullptr);
+	graph.Read(pass, composite);
+	graph.Write(pass, tonemapped);
+	pass = graph.AddPass("Present", nullptr);
+	graph.Read(pass, tonemapped);
+	graph.Write(pass, backBuffer);
+
+	graph.Compile();
+	DXTTestFrameGraphBackend backend;
+	graph.Execute(&backend);
+
+	// Bright is released before BlurY is acquired, Scene before Tonemapped
+	DXT_CHECK(backend.ResourceSlots[blurY] == backend.ResourceSlots[bright]);
+	DXT_CHECK(backend.ResourceSlots[blurX] != backend.ResourceSlots[bright]);
+	DXT_CHECK(backend.ResourceSlots[tonemapped] == backend.ResourceSlots[scene]);
+	DXT_CHECK(backend.ResourceSlots[composite] != backend.ResourceSlots[scene]);
+	DXT_CHECK(backend.SlotCount == 4);
+
+	// Compiling again gives the same schedule
+	backend.Events.clear();
+	graph.Compile();
+	vector<string> firstEvents;
+	graph.Execute(&backend);
+	firstEvents.swap(backend.Events);
+	graph.Execute(&backend);
+	DXT_CHECK(firstEvents == backend.Events);
+	DXT_CHECK(backend.SlotCount == 4);
+}
+
+// Rebuilds and compiles a graph the size of a heavy frame, lots of short lived targets and a few dead branches
+DXT_BENCHMARK(FrameGraphCompile)
+{
+	const uint32_t passCount = 1000;
+	DXTFrameGraphResourceDesc descs[3] = { { 1920, 1080, 28, 0x28 }, { 960, 540, 10, 0x28 }, { 1920, 1080, 45, 0x40 } };
+	DXTFrameGraph graph;
+	DXTTestFrameGraphBackend backend;
+
+	auto buildGraph = [&]()
+	{
+		graph.Clear();
+		uint32_t backBuffer = graph.ImportResource("BackBuffer");
+		uint32_t previous[2] = { graph.CreateResource("Start", descs[0]), DXT_FRAME_GRAPH_NULL_INDEX };
+
+		uint32_t start = graph.AddPass("Start", nullptr);
+		graph.Write(start, previous[0]);
+
+		for (uint32_t i = 1; i < passCount; ++i)
+		{
+			uint32_t output = graph.CreateResource("Target", descs[i % 3]);
+			uint32_t pass = graph.AddPass("Pass", nullptr);
+			graph.Read(pass, previous[0]);
+			if (previous[1] != DXT_FRAME_GRAPH_NULL_INDEX)
+				graph.Read(pass, previous[1]);
+			graph.Write(pass, output);
+
+			// Every tenth pass starts a branch nothing reads
+			if (i % 10 == 0)
+				continue;
+
+			previous[1] = previous[0];
+			previous[0] = output;
+		}
+
+		uint32_t present = graph.AddPass("Present", nullptr);
+		graph.Read(present, previous[0]);
+		graph.Write(present, backBuffer);
+	};
+
+	double buildTime = DXTMeasureMilliseconds(20, [&]()
+	{
+		buildGraph();
+	});
+
+	double compileTime = DXTMeasureMilliseconds(20, [&]()
+	{
+		buildGraph();
+		graph.Compile();
+	});
+
+	graph.Execute(&backend);
+
+	DXTReportMeasurement("passes", (double)graph.GetPassCount(), "");
+	DXTReportMeasurement("culled passes", (double)graph.GetCulledPassCount(), "");
+	DXTReportMeasurement("targets after aliasing", (double)backend.SlotCount, "");
+	DXTReportMeasurement("declare graph", buildTime, "ms");
+	DXTReportMeasurement("declare and compile graph", compileTime, "ms");
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "TestFramework.h"
+
+#include "DirectXToolbox.h"
+
+#include <vector>
+
+using namespace std;
+
+// Vertices and indices per page of the test pool, each test mesh fills a quarter of a page
+#define TEST_PAGE_VERTEX_COUNT 1024
+#define TEST_PAGE_INDEX_COUNT 3072
+#define TEST_MESH_VERTEX_COUNT (TEST_PAGE_VERTEX_COUNT / 4)
+#define TEST_MESH_INDEX_COUNT (TEST_PAGE_INDEX_COUNT / 4)
+
+static UINT AllocateTestMesh(DXTGeometryPool* pool, ID3D11DeviceContext* context, const UINT vertexCount)
+{
+	vector<float> vertices(vertexCount * 3, 1.0f);
+	vector<UINT> indices(TEST_MESH_INDEX_COUNT, 0);
+
+	UINT handle = DXT_GEOMETRY_POOL_NULL_HANDLE;
+	DXT_CHECK(SUCCEEDED(pool->Allocate(context, vertices.data(), vertexCount, indices.data(), TEST_MESH_INDEX_COUNT, &handle)));
+	return handle;
+}
+
+DXT_TEST(GeometryPoolPlacesMeshesInPages)
+{
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	if (!DXTCreateTestDevice(&device, &context))
+		return;
+
+	DXTGeometryPool pool;
+	DXT_CHECK(SUCCEEDED(pool.Initialize(device, sizeof(float) * 3, DXTIndexTypeInt, TEST_PAGE_VERTEX_COUNT, TEST_PAGE_INDEX_COUNT)));
+
+	// Four meshes share the first page without overlapping, the fifth adds a page
+	UINT handles[5];
+	DXTGeometryLocation locations[5];
+	for (int i = 0; i < 5; ++i)
+	{
+		handles[i] = AllocateTestMesh(&pool, context, TEST_MESH_VERTEX_COUNT);
+		pool.GetLocation(handles[i], &locations[i]);
+	}
+
+	bool bShared = true;
+	for (int i = 1; i < 4; ++i)
+		bShared &= locations[i].VertexBuffer == locations[0].VertexBuffer && locations[i].BaseVertex == i * TEST_MESH_VERTEX_COUNT &&
+			locations[i].StartIndex == i * TEST_MESH_INDEX_COUNT;
+
+	DXT_CHECK(bShared);
+	DXT_CHECK(locations[4].VertexBuffer != locations[0].VertexBuffer && pool.GetPageCount() == 2);
+	DXT_CHECK(locations[4].IndexCount == TEST_MESH_INDEX_COUNT);
+
+	// Meshes larger than a page get a page of their own, freed handles are reused
+	UINT large = AllocateTestMesh(&pool, context, TEST_PAGE_VERTEX_COUNT * 2);
+	DXT_CHECK(pool.GetPageCount() == 3);
+
+	pool.Free(handles[1]);
+	UINT reused = AllocateTestMesh(&pool, context, TEST_MESH_VERTEX_COUNT);
+	DXTGeometryLocation reusedLocation;
+	pool.GetLocation(reused, &reusedLocation);
+	DXT_CHECK(reused == handles[1] && reusedLocation.BaseVertex == locations[1].BaseVertex);
+
+	DXT_CHECK(FAILED(pool.Allocate(context, nullptr, 0, nullptr, 0, &reused)));
+	pool.Free(large);
+
+	pool.Release();
+	context->Release();
+	device->Release();
+}
+
+DXT_TEST(GeometryPoolDefragmentsPagesThatStayEmpty)
+{
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	if (!DXTCreateTestDevice(&device, &context))
+		return;
+
+	DXTGeometryPool pool;
+	pool.Initialize(device, sizeof(float) * 3, DXTIndexTypeInt, TEST_PAGE_VERTEX_COUNT, TEST_PAGE_INDEX_COUNT);
+
+	// A full first page and a second one added for the mesh that didn't fit
+	UINT handles[5];
+	for (auto& handle : handles)
+		handle = AllocateTestMesh(&pool, context, TEST_MESH_VERTEX_COUNT);
+
+	DXTGeometryLocation firstPage;
+	pool.GetLocation(handles[0], &firstPage);
+	pool.Free(handles[1]);
+	pool.Free(handles[2]);
+
+	// The new page runs at a quarter of its size, which is left alone until it stayed that way long enough
+	vector<UINT> moved;
+	size_t copiedBytes = 0;
+	for (int frame = 0; frame + 1 < DXT_GEOMETRY_POOL_DEFRAG_FRAMES; ++frame)
+		copiedBytes += pool.Defragment(context, 1024 * 1024, &moved);
+
+	DXT_CHECK(copiedBytes == 0 && moved.empty() && pool.GetPageCount() == 2);
+
+	copiedBytes = pool.Defragment(context, 1024 * 1024, &moved);
+	DXT_CHECK(copiedBytes == TEST_MESH_VERTEX_COUNT * sizeof(float) * 3 + TEST_MESH_INDEX_COUNT * sizeof(UINT));
+	DXT_CHECK(moved.size() == 1 && moved[0] == handles[4]);
+	DXT_CHECK(pool.GetPageCount() == 1);
+
+	DXTGeometryLocation location;
+	pool.GetLocation(handles[4], &location);
+	DXT_CHECK(location.VertexBuffer == firstPage.VertexBuffer && location.IndexCount == TEST_MESH_INDEX_COUNT);
+
+	// A single page has nowhere to move to
+	moved.clear();
+	for (int frame = 0; frame < DXT_GEOMETRY_POOL_DEFRAG_FRAMES; ++frame)
+		pool.Defragment(context, 1024 * 1024, &moved);
+	DXT_CHECK(moved.empty());
+
+	pool.Release();
+	context->Release();
+	device->Release();
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "TestFramework.h"
+
+#include "DirectXToolbox.h"
+
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Side of the test grid in vertices
+#define TEST_GRID_SIZE 64
+// Extent of the test grid in source units
+#define TEST_GRID_EXTENT 10.0f
+
+struct TestGrid
+{
+	vector<float> Positions;
+	vector<float> UVs;
+	vector<float> Normals;
+	vector<uint32_t> Indices;
+	DXTStaticMeshSource Source;
+};
+
+// A rolling grid with its triangles in random order, as bad for the vertex cache as a source mesh gets
+static void GetTestGrid(TestGrid* grid)
+{
+	const size_t vertexCount = TEST_GRID_SIZE * TEST_GRID_SIZE;
+	grid->Positions.resize(vertexCount * 3);
+	grid->UVs.resize(vertexCount * 2);
+	grid->Normals.resize(vertexCount * 3);
+
+	for (size_t z = 0; z < TEST_GRID_SIZE; ++z)
+	{
+		for (size_t x = 0; x < TEST_GRID_SIZE; ++x)
+		{
+			const size_t v = z * TEST_GRID_SIZE + x;
+			const float u = static_cast<float>(x) / (TEST_GRID_SIZE - 1);
+			const float w = static_cast<float>(z) / (TEST_GRID_SIZE - 1);
+			const float slope = cosf(u * 6.0f);
+
+			grid->Positions[v * 3] = u * TEST_GRID_EXTENT;
+			grid->Positions[v * 3 + 1] = sinf(u * 6.0f) * TEST_GRID_EXTENT / 6.0f;
+			grid->Positions[v * 3 + 2] = w * TEST_GRID_EXTENT;
+			grid->UVs[v * 2] = u;
+			grid->UVs[v * 2 + 1] = w;
+
+			const float length = sqrtf(slope * slope + 1.0f);
+			grid->Normals[v * 3] = -slope / length;
+			grid->Normals[v * 3 + 1] = 1.0f / length;
+			grid->Normals[v * 3 + 2] = 0.0f;
+		}
+	}
+
+	vector<uint32_t> quads;
+	for (uint32_t z = 0; z + 1 < TEST_GRID_SIZE; ++z)
+		for (uint32_t x = 0; x + 1 < TEST_GRID_SIZE; ++x)
+			quads.push_back(z * TEST_GRID_SIZE + x);
+
+	unsigned int seed = 7;
+	for (size_t i = quads.size() - 1; i > 0; --i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		swap(quads[i], quads[(seed >> 8) % (i + 1)]);
+	}
+
+	for (uint32_t quad : quads)
+	{
+		const uint32_t corners[6] = { quad, quad + TEST_GRID_SIZE, quad + 1, quad + 1, quad + TEST_GRID_SIZE, quad + TEST_GRID_SIZE + 1 };
+		grid->Indices.insert(grid->Indices.end(), corners, corners + 6);
+	}
+
+	DXTStaticMeshSource& source = grid->Source;
+	ZeroMemory(&source, sizeof(source));
+	source.Positions.Data = grid->Positions.data();
+	source.Positions.Stride = 3;
+	source.UVs.Data = grid->UVs.data();
+	source.UVs.Stride = 2;
+	source.Normals.Data = grid->Normals.data();
+	source.Normals.Stride = 3;
+	source.VertexCount = vertexCount;
+	source.Indices = grid->Indices.data();
+	source.IndexCount = grid->Indices.size();
+}
+
+static HRESULT CookTestGrid(const TestGrid& grid, const DXTVertexFormat& format, DXTMeshCookReport* report)
+{
+	DXTMeshFileNode node = { DXT_MESH_FILE_NONE, 0, { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } };
+
+	const char* path = "MeshCookTests.dxtmesh";
+	HRESULT result = DXTCookStaticMesh(&grid.Source, 1, &node, 1, path, format, DXTIndexTypeShort, report);
+	remove(path);
+	return result;
+}
+
+DXT_TEST(MeshCookReducesVertexCacheMisses)
+{
+	TestGrid grid;
+	GetTestGrid(&grid);
+
+	DXTMeshCookReport report;
+	DXT_CHECK(SUCCEEDED(CookTestGrid(grid, DXTVertexLayoutPositionUVNormalQuantized::GetFormat(), &report)));
+
+	const DXTVertexCacheStats& source = report.SourceCacheStats;
+	const DXTVertexCacheStats& cooked = report.CookedCacheStats;
+	DXT_CHECK(source.TriangleCount == grid.Indices.size() / 3 && cooked.TriangleCount == source.TriangleCount);
+
+	// Shuffled quads miss on nearly every vertex they don't share, a cooked grid gets close to one miss per vertex
+	DXT_CHECK(source.GetACMR() > 1.5f);
+	DXT_CHECK(cooked.GetACMR() < source.GetACMR() * 0.5f);
+	DXT_CHECK(cooked.GetATVR() < source.GetATVR() * 0.5f);
+	DXT_CHECK(cooked.GetATVR() < 1.5f);
+
+	DXTReportMeasurement("source ACMR", source.GetACMR(), "");
+	DXTReportMeasurement("cooked ACMR", cooked.GetACMR(), "");
+}
+
+DXT_TEST(MeshCookRejectsOversizedShortIndices)
+{
+	TestGrid grid;
+	GetTestGrid(&grid);
+	grid.Source.VertexCount = USHRT_MAX + 2;
+
+	DXTMeshCookReport report;
+	DXT_CHECK(FAILED(CookTestGrid(grid, DXTVertexLayoutPositionUVNormalQuantized::GetFormat(), &report)));
+}
+
+DXT_TEST(MeshCookRejectsIndicesPastTheVertices)
+{
+	TestGrid grid;
+	GetTestGrid(&grid);
+	grid.Indices[grid.Indices.size() / 2] = static_cast<uint32_t>(grid.Source.VertexCount);
+
+	DXTMeshCookReport report;
+	DXT_CHECK(FAILED(CookTestGrid(grid, DXTVertexLayoutPositionUVNormalQuantized::GetFormat(), &report)));
+
+	// The last vertex is still in range
+	grid.Indices[grid.Indices.size() / 2] = static_cast<uint32_t>(grid.Source.VertexCount - 1);
+	DXT_CHECK(SUCCEEDED(CookTestGrid(grid, DXTVertexLayoutPositionUVNormalQuantized::GetFormat(), &report)));
+}
+
+DXT_TEST(MeshCookEncodeErrorStaysInPrecision)
+{
+	TestGrid grid;
+	GetTestGrid(&grid);
+
+	DXTMeshCookReport report;
+	DXT_CHECK(SUCCEEDED(CookTestGrid(grid, DXTVertexLayoutPositionUVNormalQuantized::GetFormat(), &report)));
+
+	// Positions are 16 bit steps of the bounds, UVs in [0, 1] are halves with 11 bits of mantissa
+	const DXTVertexEncodeError& error = report.EncodeError;
+	DXT_CHECK(error.Position > 0.0f && error.Position <= TEST_GRID_EXTENT / 65535.0f);
+	DXT_CHECK(error.UV <= 1.0f / 2048.0f);
+	DXT_CHECK(error.NormalDegrees < 0.05f);
+	DXT_CHECK(report.VertexBytes == grid.Source.VertexCount * DXTVertexLayoutPositionUVNormalQuantized::GetFormat().Stride);
+	DXT_CHECK(report.VertexBytes * 2 <= report.FloatVertexBytes);
+
+	DXTReportMeasurement("normal error", error.NormalDegrees, "degrees");
+
+	// Floats are stored as they come
+	DXT_CHECK(SUCCEEDED(CookTestGrid(grid, DXTVertexLayoutPositionUVNormal::GetFormat(), &report)));
+	DXT_CHECK(report.EncodeError.Position == 0.0f && report.EncodeError.UV == 0.0f && report.EncodeError.NormalDegrees == 0.0f);
+	DXT_CHECK(report.VertexBytes == report.FloatVertexBytes);
+}
\ No newline at end of file
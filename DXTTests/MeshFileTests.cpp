@@ -0,0 +1,173 @@
+#include "TestFramework.h"
+
+#include "MeshFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+// Writes a small mesh with two nodes
+static bool WriteTestMeshFile(const char* path)
+{
+	const float vertices[] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+	const uint16_t indices[] = { 0, 1, 2 };
+	DXTMeshFileSubmesh submesh = { 0, 3, 0, 3, 0, { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f } } };
+	DXTMeshFileNode nodes[2] = {};
+	nodes[0].Parent = DXT_MESH_FILE_NONE;
+	nodes[0].Submesh = DXT_MESH_FILE_NONE;
+	nodes[1].Parent = 0;
+	nodes[1].Submesh = 0;
+	for (int i = 0; i < 4; ++i)
+		nodes[0].Transform[i][i] = nodes[1].Transform[i][i] = 1.0f;
+
+	DXTMeshFileData data = {};
+	data.VertexStride = sizeof(float) * 3;
+	data.IndexSize = sizeof(uint16_t);
+	data.VertexCount = 3;
+	data.IndexCount = 3;
+	data.SubmeshCount = 1;
+	data.NodeCount = 2;
+	data.Bounds = submesh.Bounds;
+	data.Vertices = vertices;
+	data.Indices = indices;
+	data.Submeshes = &submesh;
+	data.Nodes = nodes;
+
+	return SUCCEEDED(DXTWriteMeshFile(path, data));
+}
+
+// Writes the test mesh and reads the file back as bytes
+static vector<uint8_t> GetTestMeshFile()
+{
+	const char* path = "MeshFileTests.dxtmesh";
+	vector<uint8_t> bytes;
+	if (WriteTestMeshFile(path))
+	{
+		ifstream stream(path, ios::binary);
+		bytes.assign(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+	}
+
+	remove(path);
+	return bytes;
+}
+
+static DXTMeshFileHeader* GetHeader(vector<uint8_t>* file)
+{
+	return reinterpret_cast<DXTMeshFileHeader*>(file->data());
+}
+
+static DXTMeshFileNode* GetNodes(vector<uint8_t>* file)
+{
+	return reinterpret_cast<DXTMeshFileNode*>(file->data() + GetHeader(file)->NodeOffset);
+}
+
+DXT_TEST(MeshFileValidatesWrittenFiles)
+{
+	vector<uint8_t> file = GetTestMeshFile();
+	DXT_CHECK(file.size() > sizeof(DXTMeshFileHeader));
+	DXT_CHECK(DXTValidateMeshFile(file.data(), file.size()));
+
+	// The node section ends the file, every byte of it has to be there
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size() - 1));
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), sizeof(DXTMeshFileHeader) - 1));
+
+	const DXTMeshFileHeader* header = GetHeader(&file);
+	DXT_CHECK(header->SubmeshOffset % DXT_MESH_FILE_ALIGNMENT == 0 && header->VertexOffset % DXT_MESH_FILE_ALIGNMENT == 0 &&
+		header->IndexOffset % DXT_MESH_FILE_ALIGNMENT == 0 && header->NodeOffset % DXT_MESH_FILE_ALIGNMENT == 0);
+}
+
+DXT_TEST(MeshFileRejectsDamagedHeaders)
+{
+	const vector<uint8_t> valid = GetTestMeshFile();
+	vector<uint8_t> file;
+
+	// Offsets that wrap around when the section length is added to them
+	file = valid;
+	GetHeader(&file)->NodeOffset = 0ULL - DXT_MESH_FILE_ALIGNMENT;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	file = valid;
+	GetHeader(&file)->VertexOffset = 0ULL - DXT_MESH_FILE_ALIGNMENT * 2;
+	GetHeader(&file)->VertexCount = 1;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	// Largest counts and stride the header can hold
+	file = valid;
+	GetHeader(&file)->VertexCount = 0xFFFFFFFF;
+	GetHeader(&file)->VertexStride = 0xFFFFFFFF;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	file = valid;
+	GetHeader(&file)->IndexOffset += 2;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	file = valid;
+	GetHeader(&file)->VertexStride = 0;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	file = valid;
+	GetHeader(&file)->IndexSize = 3;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	file = valid;
+	GetHeader(&file)->Version = DXT_MESH_FILE_VERSION - 1;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	// Empty sections may sit right at the end of the file
+	file = valid;
+	GetHeader(&file)->NodeCount = 0;
+	GetHeader(&file)->NodeOffset = file.size() / DXT_MESH_FILE_ALIGNMENT * DXT_MESH_FILE_ALIGNMENT;
+	DXT_CHECK(DXTValidateMeshFile(file.data(), file.size()));
+}
+
+DXT_TEST(MeshFileRejectsDamagedNodes)
+{
+	const vector<uint8_t> valid = GetTestMeshFile();
+	vector<uint8_t> file;
+
+	file = valid;
+	GetNodes(&file)[0].Parent = 1;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	file = valid;
+	GetNodes(&file)[1].Parent = 1;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	file = valid;
+	GetNodes(&file)[1].Submesh = 1;
+	DXT_CHECK(!DXTValidateMeshFile(file.data(), file.size()));
+
+	file = valid;
+	GetNodes(&file)[1].Submesh = DXT_MESH_FILE_NONE;
+	DXT_CHECK(DXTValidateMeshFile(file.data(), file.size()));
+}
+
+DXT_TEST(MappedMeshFileReleasesTheFile)
+{
+	const char* path = "MeshFileTests.dxtmesh";
+	DXT_CHECK(WriteTestMeshFile(path));
+
+	// Both views go out of scope each round, the second file reopens after closing
+	for (int i = 0; i < 4; ++i)
+	{
+		DXTMappedMeshFile first;
+		DXTMappedMeshFile second;
+		DXT_CHECK(SUCCEEDED(first.Open(path)) && SUCCEEDED(second.Open(path)));
+		DXT_CHECK(first.GetData().NodeCount == 2 && second.GetData().IndexCount == 3);
+
+		second.Close();
+		DXT_CHECK(second.GetData().Vertices == nullptr);
+		DXT_CHECK(SUCCEEDED(second.Open(path)));
+	}
+
+	// Windows refuses to rewrite or delete a file that still has a view or handle open
+	DXT_CHECK(WriteTestMeshFile(path));
+	DXT_CHECK(remove(path) == 0);
+
+	DXTMappedMeshFile missing;
+	DXT_CHECK(FAILED(missing.Open(path)));
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "TestFramework.h"
+
+#include "OcclusionCuller.h"
+
+#include <vector>
+
+using namespace std;
+using namespace DirectX;
+
+// A camera at z = -10 looking down +z
+static void GetTestViewProjection(XMFLOAT4X4* viewProjectionOut)
+{
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -10.0f, 1.0f), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX projection = XMMatrixPerspectiveFovLH(1.0f, (float)DXT_OCCLUSION_DEFAULT_WIDTH / DXT_OCCLUSION_DEFAULT_HEIGHT, 0.1f, 1000.0f);
+	XMStoreFloat4x4(viewProjectionOut, view * projection);
+}
+
+// A 40 by 40 quad in the z = 0 plane, clockwise as seen from the test camera
+static const float wallVertices[] = { -20.0f, -20.0f, 0.0f, -20.0f, 20.0f, 0.0f, 20.0f, 20.0f, 0.0f, 20.0f, -20.0f, 0.0f };
+static const unsigned short wallIndices[] = { 0, 1, 2, 0, 2, 3 };
+static const unsigned short wallBackIndices[] = { 0, 2, 1, 0, 3, 2 };
+
+static void RasterizeWall(DXTWorkerPool* pool, const unsigned short* indices, DXTOcclusionCuller* culler)
+{
+	XMFLOAT4X4 viewProjection;
+	XMFLOAT4X4 world;
+	GetTestViewProjection(&viewProjection);
+	XMStoreFloat4x4(&world, XMMatrixIdentity());
+
+	culler->BeginFrame(viewProjection);
+	culler->AddOccluder(wallVertices, sizeof(float) * 3, 4, indices, DXTIndexTypeShort, 6, world);
+	culler->RasterizeOccluders(pool);
+}
+
+DXT_TEST(OcclusionCullerHidesBoundsBehindOccluder)
+{
+	DXTWorkerPool pool;
+	DXTOcclusionCuller culler;
+	RasterizeWall(&pool, wallIndices, &culler);
+
+	DXTBounds behind = { { -1.0f, -1.0f, 5.0f }, { 1.0f, 1.0f, 6.0f } };
+	DXTBounds inFront = { { -1.0f, -1.0f, -5.0f }, { 1.0f, 1.0f, -4.0f } };
+	DXTBounds straddling = { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+	DXTBounds besideBehind = { { 40.0f, -1.0f, 5.0f }, { 42.0f, 1.0f, 6.0f } };
+
+	DXT_CHECK(culler.IsOccluded(behind));
+	DXT_CHECK(!culler.IsOccluded(inFront));
+	DXT_CHECK(!culler.IsOccluded(straddling));
+	DXT_CHECK(!culler.IsOccluded(besideBehind));
+	DXT_CHECK(culler.GetStats().RasterizedTriangles == 2);
+}
+
+DXT_TEST(OcclusionCullerSkipsBackFacingOccluders)
+{
+	DXTWorkerPool pool;
+	DXTOcclusionCuller culler;
+	RasterizeWall(&pool, wallBackIndices, &culler);
+
+	DXTBounds behind = { { -1.0f, -1.0f, 5.0f }, { 1.0f, 1.0f, 6.0f } };
+	DXT_CHECK(!culler.IsOccluded(behind));
+	DXT_CHECK(culler.GetStats().RasterizedTriangles == 0);
+}
+
+DXT_TEST(OcclusionCullerStreamMatchesArray)
+{
+	DXTWorkerPool pool;
+	DXTOcclusionCuller culler;
+	RasterizeWall(&pool, wallIndices, &culler);
+
+	// Alternating rows in front of and behind the wall
+	vector<DXTBounds> bounds;
+	DXTBoundsStreamBuffer stream;
+	for (int i = 0; i < 1000; ++i)
+	{
+		float x = (float)(i % 20) - 10.0f;
+		float z = (i & 1) ? 5.0f : -5.0f;
+		DXTBounds box = { { x, -1.0f, z }, { x + 0.5f, 1.0f, z + 1.0f } };
+		bounds.push_back(box);
+	}
+
+	stream.Resize(bounds.size());
+	for (size_t i = 0; i < bounds.size(); ++i)
+		stream.SetBounds(i, bounds[i]);
+
+	vector<unsigned int> candidates(bounds.size());
+	for (unsigned int i = 0; i < candidates.size(); ++i)
+		candidates[i] = i;
+
+	vector<unsigned int> arrayVisible(candidates.size());
+	size_t arrayCount = culler.CullOccludedBounds(&pool, bounds.data(), candidates.data(), candidates.size(), arrayVisible.data());
+
+	// The stream variant compacts in place
+	vector<unsigned int> streamVisible = candidates;
+	size_t streamCount = culler.CullOccludedBounds(&pool, stream.GetStream(), streamVisible.data(), streamVisible.size(), streamVisible.data());
+
+	DXT_CHECK(arrayCount == 500);
+	DXT_CHECK(streamCount == arrayCount);
+
+	bool bSame = true;
+	bool bOnlyFront = true;
+	for (size_t i = 0; i < arrayCount && i < streamCount; ++i)
+	{
+		bSame &= arrayVisible[i] == streamVisible[i];
+		bOnlyFront &= (arrayVisible[i] & 1) == 0;
+	}
+
+	DXT_CHECK(bSame);
+	DXT_CHECK(bOnlyFront);
+}
+
+// A city block layout, rows of building boxes as occluders and a large set of small props behind and between them
+DXT_BENCHMARK(OcclusionCullerCityBlock)
+{
+	const int buildingRows = 8;
+	const int buildingsPerRow = 16;
+	const size_t propCount = 100000;
+
+	// Unit box, clockwise faces seen from outside
+	const float boxVertices[] =
+	{
+		-0.5f, -0.5f, -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f, -0.5f, -0.5f,
+		-0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, -0.5f, 0.5f
+	};
+	const unsigned short boxIndices[] =
+	{
+		0, 1, 2, 0, 2, 3, 7, 6, 5, 7, 5, 4, 4, 5, 1, 4, 1, 0,
+		3, 2, 6, 3, 6, 7, 1, 5, 6, 1, 6, 2, 4, 0, 3, 4, 3, 7
+	};
+
+	XMFLOAT4X4 viewProjection;
+	GetTestViewProjection(&viewProjection);
+
+	vector<XMFLOAT4X4> buildings;
+	for (int row = 0; row < buildingRows; ++row)
+	{
+		for (int i = 0; i < buildingsPerRow; ++i)
+		{
+			XMFLOAT4X4 world;
+			XMStoreFloat4x4(&world, XMMatrixScaling(4.0f, 12.0f, 4.0f) *
+				XMMatrixTranslation((i - buildingsPerRow / 2) * 5.0f, 0.0f, 10.0f + row * 12.0f));
+			buildings.push_back(world);
+		}
+	}
+
+	DXTBoundsStreamBuffer props;
+	props.Resize(propCount);
+	unsigned int seed = 1;
+	for (size_t i = 0; i < propCount; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		float x = (float)(seed >> 8 & 0xFFFF) / 0xFFFF * 80.0f - 40.0f;
+		seed = seed * 1664525u + 1013904223u;
+		float z = (float)(seed >> 8 & 0xFFFF) / 0xFFFF * 100.0f + 5.0f;
+		DXTBounds box = { { x, -1.0f, z }, { x + 0.5f, 0.5f, z + 0.5f } };
+		props.SetBounds(i, box);
+	}
+
+	vector<unsigned int> candidates(propCount);
+	vector<unsigned int> visible(propCount);
+	for (unsigned int i = 0; i < propCount; ++i)
+		candidates[i] = i;
+
+	DXTWorkerPool pool;
+	DXTOcclusionCuller culler;
+
+	double rasterizeTime = DXTMeasureMilliseconds(20, [&]()
+	{
+		culler.BeginFrame(viewProjection);
+		for (auto& world : buildings)
+			culler.AddOccluder(boxVertices, sizeof(float) * 3, 8, boxIndices, DXTIndexTypeShort, 36, world);
+		culler.RasterizeOccluders(&pool);
+	});
+
+	size_t visibleCount = 0;
+	double testTime = DXTMeasureMilliseconds(20, [&]()
+	{
+		visibleCount = culler.CullOccludedBounds(&pool, props.GetStream(), candidates.data(), propCount, visible.data());
+	});
+
+	DXTReportMeasurement("occluder triangles", (double)buildings.size() * 12, "");
+	DXTReportMeasurement("rasterize occluders", rasterizeTime, "ms");
+	DXTReportMeasurement("test 100k bounds", testTime, "ms");
+	DXTReportMeasurement("bounds occluded", 100.0 * (propCount - visibleCount) / propCount, "%");
+}
\ No newline at end of file
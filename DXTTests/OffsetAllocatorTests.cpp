@@ -0,0 +1,140 @@
+#include "TestFramework.h"
+
+#include "OffsetAllocator.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Live allocations sorted by offset have to follow each other without overlapping
+static bool AreDisjoint(const DXTOffsetAllocator& allocator, vector<DXTOffsetAllocation> allocations)
+{
+	sort(allocations.begin(), allocations.end(), [](const DXTOffsetAllocation& a, const DXTOffsetAllocation& b)
+	{
+		return a.Offset < b.Offset;
+	});
+
+	uint32_t end = 0;
+	for (auto& allocation : allocations)
+	{
+		if (allocation.Offset < end)
+			return false;
+
+		end = allocation.Offset + allocator.GetAllocationSize(allocation);
+	}
+
+	return end <= allocator.GetSize();
+}
+
+DXT_TEST(OffsetAllocatorAllocatesAndFrees)
+{
+	DXTOffsetAllocator allocator(1024);
+	DXTOffsetAllocation allocations[3];
+
+	DXT_CHECK(allocator.Allocate(128, &allocations[0]) && allocations[0].Offset == 0);
+	DXT_CHECK(allocator.Allocate(256, &allocations[1]) && allocations[1].Offset == 128);
+	DXT_CHECK(allocator.Allocate(384, &allocations[2]) && allocations[2].Offset == 384);
+	DXT_CHECK(allocator.GetAllocationCount() == 3 && allocator.GetFreeSize() == 256);
+	DXT_CHECK(allocator.GetAllocationSize(allocations[1]) == 256);
+
+	// Sizes of nothing or past what is free are refused and leave the allocation alone
+	DXTOffsetAllocation untouched = { 12345, 678 };
+	DXT_CHECK(!allocator.Allocate(0, &untouched));
+	DXT_CHECK(!allocator.Allocate(257, &untouched));
+	DXT_CHECK(untouched.Offset == 12345 && untouched.Node == 678);
+
+	// A freed range is handed out again. Requests round up to the next bin, so this only holds for sizes that
+	// fall right on a bin, a 200 unit range would not be found for a 200 unit request.
+	allocator.Free(allocations[1]);
+	DXT_CHECK(allocator.GetAllocationCount() == 2 && allocator.GetFreeSize() == 512);
+
+	DXTOffsetAllocation reused;
+	DXT_CHECK(allocator.Allocate(256, &reused) && reused.Offset == 128);
+
+	allocator.Reset(64);
+	DXT_CHECK(allocator.GetSize() == 64 && allocator.GetFreeSize() == 64 && allocator.GetAllocationCount() == 0);
+	DXT_CHECK(allocator.Allocate(64, &reused) && reused.Offset == 0 && allocator.GetFreeSize() == 0);
+}
+
+DXT_TEST(OffsetAllocatorCoalescesFreedNeighbors)
+{
+	DXTOffsetAllocator allocator(1024);
+	DXTOffsetAllocation allocations[4];
+	for (auto& allocation : allocations)
+		allocator.Allocate(256, &allocation);
+
+	DXT_CHECK(allocator.GetFreeSize() == 0 && allocator.GetLargestFreeRange() == 0);
+
+	// Freeing the middle two merges them, then each end joins the range next to it
+	allocator.Free(allocations[1]);
+	allocator.Free(allocations[2]);
+	DXT_CHECK(allocator.GetLargestFreeRange() == 512);
+
+	allocator.Free(allocations[0]);
+	DXT_CHECK(allocator.GetLargestFreeRange() == 768);
+
+	allocator.Free(allocations[3]);
+	DXT_CHECK(allocator.GetLargestFreeRange() == 1024 && allocator.GetAllocationCount() == 0);
+
+	DXTOffsetAllocation whole;
+	DXT_CHECK(allocator.Allocate(1024, &whole) && whole.Offset == 0);
+}
+
+DXT_TEST(OffsetAllocatorHandlesFragmentation)
+{
+	// Every other small range freed leaves half the space free but no room for anything larger
+	DXTOffsetAllocator allocator(1024);
+	vector<DXTOffsetAllocation> allocations(64);
+	for (auto& allocation : allocations)
+		allocator.Allocate(16, &allocation);
+
+	for (size_t i = 0; i < allocations.size(); i += 2)
+		allocator.Free(allocations[i]);
+
+	DXTOffsetAllocation allocation;
+	DXT_CHECK(allocator.GetFreeSize() == 512 && allocator.GetLargestFreeRange() == 16);
+	DXT_CHECK(!allocator.Allocate(17, &allocation));
+	DXT_CHECK(allocator.Allocate(16, &allocation) && allocation.Offset % 32 == 0);
+	allocator.Free(allocation);
+
+	// Random sizes allocated and freed in random order never overlap and add back up to the whole range
+	const uint32_t size = 1 << 20;
+	allocator.Reset(size);
+	allocations.clear();
+
+	unsigned int seed = 5;
+	uint32_t usedSize = 0;
+	bool bConsistent = true;
+	for (int step = 0; step < 20000; ++step)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		bool bFree = !allocations.empty() && (seed >> 8) % 3 == 0;
+		seed = seed * 1664525u + 1013904223u;
+
+		if (bFree)
+		{
+			size_t index = (seed >> 8) % allocations.size();
+			usedSize -= allocator.GetAllocationSize(allocations[index]);
+			allocator.Free(allocations[index]);
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+		}
+		else if (allocator.Allocate(1 + (seed >> 8) % 4096, &allocation))
+		{
+			usedSize += allocator.GetAllocationSize(allocation);
+			allocations.push_back(allocation);
+		}
+
+		bConsistent &= allocator.GetFreeSize() == size - usedSize && allocator.GetAllocationCount() == allocations.size();
+	}
+
+	DXT_CHECK(bConsistent);
+	DXT_CHECK(AreDisjoint(allocator, allocations));
+
+	for (auto& live : allocations)
+		allocator.Free(live);
+
+	DXT_CHECK(allocator.GetFreeSize() == size && allocator.GetLargestFreeRange() == size);
+}
\ No newline at end of file
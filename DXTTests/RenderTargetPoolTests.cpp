@@ -0,0 +1,140 @@
+#include "TestFramework.h"
+
+#include "DirectXToolbox.h"
+#include "FrameGraph.h"
+
+using namespace std;
+
+static DXTRenderTargetDesc GetTestTargetDesc(const UINT width, const DXGI_FORMAT format, const UINT bindFlags)
+{
+	DXTRenderTargetDesc desc = { width, 64, format, bindFlags };
+	return desc;
+}
+
+DXT_TEST(RenderTargetPoolReusesEqualDescriptions)
+{
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	if (!DXTCreateTestDevice(&device, &context))
+		return;
+
+	DXTRenderTargetPool pool;
+	pool.Initialize(device);
+
+	const UINT colorFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	DXTRenderTargetDesc color = GetTestTargetDesc(64, DXGI_FORMAT_R8G8B8A8_UNORM, colorFlags);
+
+	// A released target comes back for the next acquire of the same description
+	UINT first;
+	UINT second;
+	DXT_CHECK(SUCCEEDED(pool.AcquireTarget(color, &first)));
+	ID3D11Texture2D* texture = pool.GetTarget(first).Texture;
+	DXT_CHECK(texture && pool.GetTarget(first).RenderTargetView && pool.GetTarget(first).ShaderResourceView);
+	DXT_CHECK(!pool.GetTarget(first).DepthStencilView);
+	pool.ReleaseTarget(first);
+
+	DXT_CHECK(SUCCEEDED(pool.AcquireTarget(color, &second)));
+	DXT_CHECK(second == first && pool.GetTarget(second).Texture == texture);
+	DXT_CHECK(pool.GetTargetCount() == 1 && pool.GetTargetBytes() == 64 * 64 * 4);
+	pool.ReleaseTarget(second);
+
+	// Any difference in size, format or bind flags gets a texture of its own
+	const DXTRenderTargetDesc others[] =
+	{
+		GetTestTargetDesc(128, DXGI_FORMAT_R8G8B8A8_UNORM, colorFlags),
+		GetTestTargetDesc(64, DXGI_FORMAT_R16G16B16A16_FLOAT, colorFlags),
+		GetTestTargetDesc(64, DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_BIND_RENDER_TARGET)
+	};
+
+	bool bDistinct = true;
+	for (auto& desc : others)
+	{
+		UINT handle;
+		bDistinct &= SUCCEEDED(pool.AcquireTarget(desc, &handle)) && pool.GetTarget(handle).Texture != texture;
+		pool.ReleaseTarget(handle);
+	}
+
+	DXT_CHECK(bDistinct);
+	DXT_CHECK(pool.GetTargetCount() == 4);
+
+	// Targets nobody acquired for a few frames are destroyed, the ones in use stay
+	UINT kept;
+	pool.AcquireTarget(color, &kept);
+	for (int frame = 0; frame <= DXT_RENDER_TARGET_POOL_MAX_UNUSED_FRAMES; ++frame)
+		pool.BeginFrame();
+
+	DXT_CHECK(pool.GetTargetCount() == 1 && pool.GetTarget(kept).Texture == texture);
+
+	pool.ReleaseTarget(kept);
+	pool.Release();
+	context->Release();
+	device->Release();
+}
+
+DXT_TEST(RenderTargetPoolNeverSharesOverlappingTargets)
+{
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	if (!DXTCreateTestDevice(&device, &context))
+		return;
+
+	DXTRenderTargetPool pool;
+	pool.Initialize(device);
+	DXTStateCache stateCache;
+	stateCache.Initialize(context);
+
+	// Targets acquired at the same time are different textures even with equal descriptions
+	DXTRenderTargetDesc color = GetTestTargetDesc(64, DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE);
+	UINT handles[3];
+	for (auto& handle : handles)
+		pool.AcquireTarget(color, &handle);
+
+	DXT_CHECK(pool.GetTarget(handles[0]).Texture != pool.GetTarget(handles[1]).Texture);
+	DXT_CHECK(pool.GetTarget(handles[1]).Texture != pool.GetTarget(handles[2]).Texture);
+	DXT_CHECK(pool.GetTarget(handles[0]).Texture != pool.GetTarget(handles[2]).Texture);
+	for (auto handle : handles)
+		pool.ReleaseTarget(handle);
+
+	// A chain of passes through the frame graph: the first and second targets overlap in the second pass, the
+	// third starts after the first was released and can take its texture
+	DXTD3D11FrameGraphBackend backend;
+	backend.Initialize(&pool, &stateCache);
+
+	DXTFrameGraph graph;
+	DXTFrameGraphResourceDesc desc = { color.Width, color.Height, color.Format, color.BindFlags };
+	uint32_t resources[3];
+	ID3D11Texture2D* textures[3][2] = {};
+	for (uint32_t i = 0; i < 3; ++i)
+		resources[i] = graph.CreateResource("Target", desc);
+
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		uint32_t pass = graph.AddPass("Pass", [&, i]()
+		{
+			if (i > 0)
+				textures[i][0] = backend.GetTarget(resources[i - 1]).Texture;
+			textures[i][1] = backend.GetTarget(resources[i]).Texture;
+		});
+
+		if (i > 0)
+			graph.Read(pass, resources[i - 1]);
+		graph.Write(pass, resources[i]);
+		if (i == 2)
+			graph.SetSideEffects(pass);
+	}
+
+	graph.Compile();
+	graph.Execute(&backend);
+
+	bool bApartWhileOverlapping = true;
+	for (int i = 1; i < 3; ++i)
+		bApartWhileOverlapping &= textures[i][0] && textures[i][1] && textures[i][0] != textures[i][1];
+
+	DXT_CHECK(bApartWhileOverlapping);
+	DXT_CHECK(textures[2][1] == textures[0][1]);
+
+	stateCache.Release();
+	pool.Release();
+	context->Release();
+	device->Release();
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "TestFramework.h"
+
+#include "RingAllocator.h"
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+DXT_TEST(RingAllocatorAlignsAndFillsUp)
+{
+	DXTRingAllocator allocator(1024, 256);
+	size_t offsets[3];
+
+	DXT_CHECK(allocator.Allocate(1, &offsets[0]) && offsets[0] == 0);
+	DXT_CHECK(allocator.Allocate(256, &offsets[1]) && offsets[1] == 256);
+	DXT_CHECK(allocator.Allocate(257, &offsets[2]) && offsets[2] == 512);
+	DXT_CHECK(allocator.GetUsedSize() == 1024);
+
+	// A full ring refuses and leaves the offset alone
+	size_t untouched = 12345;
+	DXT_CHECK(!allocator.Allocate(1, &untouched));
+	DXT_CHECK(untouched == 12345);
+
+	allocator.EndFrame(1);
+	allocator.ReleaseFrames(0);
+	DXT_CHECK(allocator.GetUsedSize() == 1024 && allocator.GetPendingFrameCount() == 1);
+
+	allocator.ReleaseFrames(1);
+	DXT_CHECK(allocator.GetUsedSize() == 0 && allocator.GetPendingFrameCount() == 0);
+
+	// Sizes that round to nothing or past the capacity never fit
+	DXT_CHECK(!allocator.Allocate(0, &untouched));
+	DXT_CHECK(!allocator.Allocate(1025, &untouched));
+
+	size_t offset;
+	DXT_CHECK(allocator.Allocate(16, &offset) && offset == 0);
+}
+
+DXT_TEST(RingAllocatorWrapsPastPendingFrames)
+{
+	DXTRingAllocator allocator(1024, 256);
+	size_t offset;
+
+	DXT_CHECK(allocator.Allocate(512, &offset) && offset == 0);
+	allocator.EndFrame(1);
+	DXT_CHECK(allocator.Allocate(256, &offset) && offset == 512);
+	allocator.EndFrame(2);
+	allocator.ReleaseFrames(1);
+
+	// The end of the ring is too short, the allocation wraps and the skipped 256 bytes count as used
+	DXT_CHECK(allocator.Allocate(512, &offset) && offset == 0);
+	DXT_CHECK(allocator.GetUsedSize() == 1024);
+	DXT_CHECK(!allocator.Allocate(256, &offset));
+	allocator.EndFrame(3);
+
+	allocator.ReleaseFrames(2);
+	DXT_CHECK(allocator.GetUsedSize() == 768);
+	DXT_CHECK(allocator.Allocate(256, &offset) && offset == 512);
+	DXT_CHECK(!allocator.Allocate(256, &offset));
+	allocator.EndFrame(4);
+
+	// The skipped end is freed with the frame that wrapped
+	allocator.ReleaseFrames(3);
+	DXT_CHECK(allocator.GetUsedSize() == 256);
+	allocator.ReleaseFrames(4);
+	DXT_CHECK(allocator.GetUsedSize() == 0);
+}
+
+DXT_TEST(RingAllocatorNeverHandsOutPendingRanges)
+{
+	const size_t capacity = 64 * 256;
+	const uint64_t framesInFlight = 3;
+	DXTRingAllocator allocator(capacity, 256);
+
+	// Ranges handed out per frame that hasn't been released yet
+	deque<pair<uint64_t, vector<pair<size_t, size_t>>>> pending;
+	unsigned int seed = 7;
+	bool bAligned = true;
+	bool bInside = true;
+	bool bDisjoint = true;
+	size_t allocationCount = 0;
+
+	for (uint64_t frame = 1; frame <= 2000; ++frame)
+	{
+		// The GPU finishes frames a few behind the CPU
+		if (frame > framesInFlight)
+		{
+			allocator.ReleaseFrames(frame - framesInFlight - 1);
+			while (!pending.empty() && pending.front().first <= frame - framesInFlight - 1)
+				pending.pop_front();
+		}
+
+		pending.push_back(make_pair(frame, vector<pair<size_t, size_t>>()));
+
+		seed = seed * 1664525u + 1013904223u;
+		size_t count = seed >> 28;
+		for (size_t i = 0; i < count; ++i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			size_t size = 1 + (seed >> 8) % 1500;
+			size_t alignedSize = (size + 255) / 256 * 256;
+
+			size_t offset;
+			if (!allocator.Allocate(size, &offset))
+				continue;
+
+			++allocationCount;
+			bAligned &= offset % 256 == 0;
+			bInside &= offset + alignedSize <= capacity;
+
+			for (auto& frameRanges : pending)
+				for (auto& range : frameRanges.second)
+					bDisjoint &= offset + alignedSize <= range.first || range.first + range.second <= offset;
+
+			pending.back().second.push_back(make_pair(offset, alignedSize));
+		}
+
+		allocator.EndFrame(frame);
+	}
+
+	DXT_CHECK(allocationCount > 5000);
+	DXT_CHECK(bAligned);
+	DXT_CHECK(bInside);
+	DXT_CHECK(bDisjoint);
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "TestFramework.h"
+
+#include "StateObjectTable.h"
+
+#include <cstring>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+static D3D11_BLEND_DESC GetAlphaBlendDesc()
+{
+	D3D11_BLEND_DESC desc;
+	memset(&desc, 0, sizeof(desc));
+	desc.RenderTarget[0].BlendEnable = TRUE;
+	desc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	desc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	desc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+	desc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+	desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+	desc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	desc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	return desc;
+}
+
+static bool AreKeysEqual(const DXTStateKey& a, const DXTStateKey& b)
+{
+	return a.GetHash() == b.GetHash() && a.GetBytes() == b.GetBytes();
+}
+
+DXT_TEST(StateKeysHashTheirBytes)
+{
+	D3D11_SAMPLER_DESC sampler;
+	memset(&sampler, 0, sizeof(sampler));
+	sampler.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	sampler.AddressU = sampler.AddressV = sampler.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	sampler.MaxLOD = 1000.0f;
+
+	DXTStateKey key;
+	DXTMakeStateKey(sampler, &key);
+	DXT_CHECK(!key.GetBytes().empty());
+	DXT_CHECK(key.GetHash() == DXTHashBytes(key.GetBytes().data(), key.GetBytes().size()));
+
+	// Appending in pieces hashes the same as hashing the whole
+	DXTStateKey pieces;
+	pieces.Append(key.GetBytes().data(), 5);
+	pieces.Append(key.GetBytes().data() + 5, key.GetBytes().size() - 5);
+	DXT_CHECK(AreKeysEqual(key, pieces));
+
+	// Making a key starts over
+	DXTMakeStateKey(sampler, &pieces);
+	DXT_CHECK(AreKeysEqual(key, pieces));
+
+	DXTStateKey nullString;
+	DXTStateKey emptyString;
+	nullString.AppendString(nullptr);
+	emptyString.AppendString("");
+	DXT_CHECK(AreKeysEqual(nullString, emptyString));
+}
+
+DXT_TEST(StateKeysIgnoreUnusedMembers)
+{
+	D3D11_BLEND_DESC blend = GetAlphaBlendDesc();
+	D3D11_BLEND_DESC garbageTargets = blend;
+	memset(&garbageTargets.RenderTarget[1], 0xCD, sizeof(garbageTargets.RenderTarget) - sizeof(garbageTargets.RenderTarget[0]));
+
+	DXTStateKey blendKey;
+	DXTStateKey garbageKey;
+	DXTMakeStateKey(blend, &blendKey);
+	DXTMakeStateKey(garbageTargets, &garbageKey);
+	DXT_CHECK(AreKeysEqual(blendKey, garbageKey));
+
+	// Once the other targets are used they count
+	blend.IndependentBlendEnable = TRUE;
+	garbageTargets.IndependentBlendEnable = TRUE;
+	DXTMakeStateKey(blend, &blendKey);
+	DXTMakeStateKey(garbageTargets, &garbageKey);
+	DXT_CHECK(!AreKeysEqual(blendKey, garbageKey));
+
+	// Semantic names are compared by their characters, not their address
+	char positionA[] = "POSITION";
+	char positionB[] = "POSITION";
+	D3D11_INPUT_ELEMENT_DESC elementA = { positionA, 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	D3D11_INPUT_ELEMENT_DESC elementB = elementA;
+	elementB.SemanticName = positionB;
+	const uint8_t bytecode[] = { 1, 2, 3, 4 };
+
+	DXTStateKey layoutA;
+	DXTStateKey layoutB;
+	DXTMakeStateKey(&elementA, 1, bytecode, sizeof(bytecode), &layoutA);
+	DXTMakeStateKey(&elementB, 1, bytecode, sizeof(bytecode), &layoutB);
+	DXT_CHECK(AreKeysEqual(layoutA, layoutB));
+
+	elementB.AlignedByteOffset = 12;
+	DXTMakeStateKey(&elementB, 1, bytecode, sizeof(bytecode), &layoutB);
+	DXT_CHECK(!AreKeysEqual(layoutA, layoutB));
+}
+
+DXT_TEST(StateObjectTableDeduplicatesEqualKeys)
+{
+	DXTStateObjectTable table;
+	int first = 0;
+	int second = 0;
+
+	D3D11_BLEND_DESC blend = GetAlphaBlendDesc();
+	DXTStateKey key;
+	DXTMakeStateKey(blend, &key);
+	DXT_CHECK(table.Find(key) == nullptr);
+	table.Insert(key, &first);
+
+	// An equal description built separately finds the object, a different one doesn't
+	D3D11_BLEND_DESC equal = GetAlphaBlendDesc();
+	DXTStateKey equalKey;
+	DXTMakeStateKey(equal, &equalKey);
+	DXT_CHECK(table.Find(equalKey) == &first);
+
+	equal.AlphaToCoverageEnable = TRUE;
+	DXTMakeStateKey(equal, &equalKey);
+	DXT_CHECK(table.Find(equalKey) == nullptr);
+	table.Insert(equalKey, &second);
+
+	DXT_CHECK(table.Find(key) == &first);
+	DXT_CHECK(table.Find(equalKey) == &second);
+	DXT_CHECK(table.GetCount() == 2);
+	DXT_CHECK(table.GetObjects()[0] == &first && table.GetObjects()[1] == &second);
+
+	table.Clear();
+	DXT_CHECK(table.Find(key) == nullptr && table.GetCount() == 0);
+}
+
+DXT_TEST(StateObjectTableKeepsPointersWhileGrowing)
+{
+	// Objects kept in a deque like the cache keeps its pipelines, enough of them to rehash the table many times
+	const int count = 5000;
+	DXTStateObjectTable table;
+	deque<int> objects;
+	DXTStateKey key;
+
+	for (int i = 0; i < count; ++i)
+	{
+		key.Clear();
+		key.Append(&i, sizeof(i));
+		if (!table.Find(key))
+		{
+			objects.push_back(i);
+			table.Insert(key, &objects.back());
+		}
+	}
+
+	// A second round only finds what the first one inserted
+	for (int i = 0; i < count; ++i)
+	{
+		key.Clear();
+		key.Append(&i, sizeof(i));
+		if (!table.Find(key))
+		{
+			objects.push_back(i);
+			table.Insert(key, &objects.back());
+		}
+	}
+
+	DXT_CHECK(table.GetCount() == count && objects.size() == count);
+
+	bool bStable = true;
+	for (int i = 0; i < count; ++i)
+	{
+		key.Clear();
+		key.Append(&i, sizeof(i));
+		int* object = static_cast<int*>(table.Find(key));
+		bStable &= object == &objects[i] && *object == i;
+	}
+	DXT_CHECK(bStable);
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+// Minimal runner for the parts of the toolbox that work without a GPU, the ones that need a device get a
+// WARP device. Tests and benchmarks register themselves before main, DXTTests runs every test and with
+// --bench every benchmark afterwards.
+
+#include <chrono>
+#include <vector>
+
+struct ID3D11Device;
+struct ID3D11DeviceContext;
+
+typedef void (*DXTTestFunc)();
+
+struct DXTTestCase
+{
+	const char* Name;
+	DXTTestFunc Func;
+	bool bBenchmark;
+};
+
+std::vector<DXTTestCase>& DXTGetTestCases();
+void DXTReportCheck(const bool bPassed, const char* expression, const char* file, const int line);
+// Prints a measurement of the running benchmark
+void DXTReportMeasurement(const char* label, const double value, const char* unit);
+// Software device for the tests that need one, both are released by the caller
+bool DXTCreateTestDevice(ID3D11Device** deviceOut, ID3D11DeviceContext** contextOut);
+
+class DXTTestRegistrar
+{
+public:
+	DXTTestRegistrar(const char* name, DXTTestFunc func, const bool bBenchmark);
+};
+
+#define DXT_TEST(name) \
+	static void name(); \
+	static DXTTestRegistrar name##Registrar(#name, &name, false); \
+	static void name()
+
+#define DXT_BENCHMARK(name) \
+	static void name(); \
+	static DXTTestRegistrar name##Registrar(#name, &name, true); \
+	static void name()
+
+#define DXT_CHECK(expression) DXTReportCheck((expression) ? true : false, #expression, __FILE__, __LINE__)
+
+// Fastest of runCount calls in milliseconds, the first call is a warm up that isn't counted
+template<typename Func>
+double DXTMeasureMilliseconds(const int runCount, const Func& func);
+
+template<typename Func>
+double DXTMeasureMilliseconds(const int runCount, const Func& func)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	func();
+
+	double fastest = 0.0;
+	for (int i = 0; i < runCount; ++i)
+	{
+		Clock::time_point start = Clock::now();
+		func();
+		double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		if (i == 0 || elapsed < fastest)
+			fastest = elapsed;
+	}
+
+	return fastest;
+}
\ No newline at end of file
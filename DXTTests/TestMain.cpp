@@ -0,0 +1,89 @@
+#include "TestFramework.h"
+
+#include <d3d11.h>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+static int checkCount = 0;
+static int failedCheckCount = 0;
+
+vector<DXTTestCase>& DXTGetTestCases()
+{
+	// Function local so registration doesn't depend on the order translation units are initialized in
+	static vector<DXTTestCase> testCases;
+	return testCases;
+}
+
+DXTTestRegistrar::DXTTestRegistrar(const char* name, DXTTestFunc func, const bool bBenchmark)
+{
+	DXTTestCase testCase = { name, func, bBenchmark };
+	DXTGetTestCases().push_back(testCase);
+}
+
+void DXTReportCheck(const bool bPassed, const char* expression, const char* file, const int line)
+{
+	++checkCount;
+
+	if (!bPassed)
+	{
+		++failedCheckCount;
+		printf("  %s(%d): check failed: %s\n", file, line, expression);
+	}
+}
+
+void DXTReportMeasurement(const char* label, const double value, const char* unit)
+{
+	printf("  %-48s %12.3f %s\n", label, value, unit);
+}
+
+bool DXTCreateTestDevice(ID3D11Device** deviceOut, ID3D11DeviceContext** contextOut)
+{
+	D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_0;
+	HRESULT result = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, &featureLevel, 1, D3D11_SDK_VERSION,
+		deviceOut, nullptr, contextOut);
+
+	if (FAILED(result))
+		printf("  could not create a WARP device\n");
+
+	return SUCCEEDED(result);
+}
+
+// DXTTests [--bench] [name filter]
+int main(int argc, char** argv)
+{
+	bool bRunBenchmarks = false;
+	const char* filter = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--bench") == 0)
+			bRunBenchmarks = true;
+		else
+			filter = argv[i];
+	}
+
+	int failedTestCount = 0;
+	int testCount = 0;
+
+	for (auto& testCase : DXTGetTestCases())
+	{
+		if (testCase.bBenchmark && !bRunBenchmarks)
+			continue;
+		if (filter && !strstr(testCase.Name, filter))
+			continue;
+
+		printf("%s %s\n", testCase.bBenchmark ? "[bench]" : "[test] ", testCase.Name);
+
+		int failedBefore = failedCheckCount;
+		testCase.Func();
+
+		++testCount;
+		if (failedCheckCount != failedBefore)
+			++failedTestCount;
+	}
+
+	printf("%d tests run, %d failed, %d of %d checks failed\n", testCount, failedTestCount, failedCheckCount, checkCount);
+	return failedTestCount == 0 ? 0 : 1;
+}
\ No newline at end of file
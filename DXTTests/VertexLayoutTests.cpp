@@ -0,0 +1,191 @@
+#include "TestFramework.h"
+
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+#define TEST_VERTEX_COUNT 1000
+// Channels are indexed by the position of their bit
+#define TEST_CHANNEL_COUNT 5
+
+// Source channels of the test vertices, indexed like DXTVertexAttrubuteChannel bits
+struct TestVertices
+{
+	vector<float> Channels[TEST_CHANNEL_COUNT];
+	DXTVertexEncodeParams Params;
+};
+
+static size_t GetChannelIndex(const UINT channel)
+{
+	size_t index = 0;
+	while ((1u << index) != channel)
+		++index;
+
+	return index;
+}
+
+static size_t GetChannelWidth(const UINT channel)
+{
+	return channel == DXTVertexAttributeUV ? 2 : 3;
+}
+
+static float GetRandomFloat(unsigned int* seed, const float lower, const float upper)
+{
+	*seed = *seed * 1664525u + 1013904223u;
+	return lower + (upper - lower) * static_cast<float>(*seed >> 8) / static_cast<float>(1 << 24);
+}
+
+static void Normalize(float* vector)
+{
+	float length = sqrtf(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+	for (size_t i = 0; i < 3; ++i)
+		vector[i] /= length;
+}
+
+static void Cross(const float* a, const float* b, float* out)
+{
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static float Dot(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Positions within a box, UVs in [0, 1] and orthonormal tangent frames of either handedness
+static void GetTestVertices(TestVertices* vertices)
+{
+	unsigned int seed = 3;
+	for (size_t c = 0; c < TEST_CHANNEL_COUNT; ++c)
+		vertices->Channels[c].resize(TEST_VERTEX_COUNT * GetChannelWidth(1u << c));
+
+	for (size_t v = 0; v < TEST_VERTEX_COUNT; ++v)
+	{
+		float* position = &vertices->Channels[0][v * 3];
+		float* uv = &vertices->Channels[1][v * 2];
+		float* normal = &vertices->Channels[2][v * 3];
+		float* tangent = &vertices->Channels[3][v * 3];
+		float* bitangent = &vertices->Channels[4][v * 3];
+
+		for (size_t i = 0; i < 3; ++i)
+			position[i] = GetRandomFloat(&seed, -5.0f, 20.0f);
+		for (size_t i = 0; i < 2; ++i)
+			uv[i] = GetRandomFloat(&seed, 0.0f, 1.0f);
+
+		float other[3];
+		for (size_t i = 0; i < 3; ++i)
+		{
+			normal[i] = GetRandomFloat(&seed, -1.0f, 1.0f);
+			other[i] = GetRandomFloat(&seed, -1.0f, 1.0f);
+		}
+		Normalize(normal);
+		Cross(normal, other, tangent);
+		Normalize(tangent);
+		Cross(normal, tangent, bitangent);
+
+		if (GetRandomFloat(&seed, 0.0f, 1.0f) < 0.5f)
+			for (size_t i = 0; i < 3; ++i)
+				bitangent[i] = -bitangent[i];
+	}
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		vertices->Params.PositionLower[i] = -5.0f;
+		vertices->Params.PositionExtent[i] = 25.0f;
+	}
+}
+
+// Interleaves the vertices into the format and back, decodedOut receives the channels the format stores
+static void RoundTrip(const TestVertices& vertices, const DXTVertexFormat& format, TestVertices* decodedOut,
+	vector<BYTE>* interleavedOut)
+{
+	vector<DXTVertexStream> streams(format.StreamCount);
+	vector<DXTVertexOutputStream> outputStreams(format.StreamCount);
+	*decodedOut = vertices;
+
+	for (UINT s = 0; s < format.StreamCount; ++s)
+	{
+		const UINT channel = format.StreamChannels[s];
+		const size_t index = GetChannelIndex(channel);
+		DXTVertexStream stream = { vertices.Channels[index].data(), GetChannelWidth(channel) };
+		DXTVertexOutputStream outputStream = { decodedOut->Channels[index].data(), GetChannelWidth(channel) };
+		streams[s] = stream;
+		outputStreams[s] = outputStream;
+	}
+
+	interleavedOut->resize(TEST_VERTEX_COUNT * format.Stride);
+	format.Interleave(streams.data(), TEST_VERTEX_COUNT, vertices.Params, interleavedOut->data());
+	format.Deinterleave(interleavedOut->data(), TEST_VERTEX_COUNT, vertices.Params, outputStreams.data());
+}
+
+// Largest difference of a channel by component
+static float GetChannelError(const TestVertices& a, const TestVertices& b, const UINT channel)
+{
+	const vector<float>& valuesA = a.Channels[GetChannelIndex(channel)];
+	const vector<float>& valuesB = b.Channels[GetChannelIndex(channel)];
+
+	float error = 0.0f;
+	for (size_t i = 0; i < valuesA.size(); ++i)
+		error = max(error, fabsf(valuesA[i] - valuesB[i]));
+
+	return error;
+}
+
+// Largest angle between the directions of a channel, in degrees
+static float GetChannelDegrees(const TestVertices& a, const TestVertices& b, const UINT channel)
+{
+	const vector<float>& valuesA = a.Channels[GetChannelIndex(channel)];
+	const vector<float>& valuesB = b.Channels[GetChannelIndex(channel)];
+
+	float cosine = 1.0f;
+	for (size_t i = 0; i < valuesA.size(); i += 3)
+		cosine = min(cosine, Dot(&valuesA[i], &valuesB[i]) / sqrtf(Dot(&valuesB[i], &valuesB[i])));
+
+	return acosf(min(cosine, 1.0f)) * 180.0f / 3.14159265f;
+}
+
+DXT_TEST(VertexLayoutsRoundTrip)
+{
+	TestVertices vertices;
+	GetTestVertices(&vertices);
+
+	TestVertices decoded;
+	vector<BYTE> interleaved;
+
+	// Floats come back as they went in, each attribute at its offset
+	RoundTrip(vertices, DXTVertexLayoutPositionUVNormal::GetFormat(), &decoded, &interleaved);
+	DXT_CHECK(decoded.Channels[0] == vertices.Channels[0] && decoded.Channels[1] == vertices.Channels[1] &&
+		decoded.Channels[2] == vertices.Channels[2]);
+	DXT_CHECK(memcmp(&interleaved[DXTVertexLayoutPositionUVNormal::Offset<1>::Value], vertices.Channels[1].data(), sizeof(float) * 2) == 0);
+
+	// Quantized positions are within a 16 bit step of the box, UVs within a half step below one
+	const float positionStep = 25.0f / 65535.0f;
+	const float uvStep = 1.0f / 2048.0f;
+
+	RoundTrip(vertices, DXTVertexLayoutPositionUVNormalQuantized::GetFormat(), &decoded, &interleaved);
+	DXT_CHECK(GetChannelError(vertices, decoded, DXTVertexAttributePosition) <= positionStep);
+	DXT_CHECK(GetChannelError(vertices, decoded, DXTVertexAttributeUV) <= uvStep);
+	DXT_CHECK(GetChannelDegrees(vertices, decoded, DXTVertexAttributeNormal) < 0.05f);
+
+	// Interleaving what was decoded gives the same bytes again
+	TestVertices decodedAgain;
+	vector<BYTE> interleavedAgain;
+	RoundTrip(decoded, DXTVertexLayoutPositionUVNormalQuantized::GetFormat(), &decodedAgain, &interleavedAgain);
+	DXT_CHECK(interleavedAgain == interleaved);
+
+	// The tangent frame keeps every direction, including the handedness of the bitangent
+	RoundTrip(vertices, DXTVertexLayoutTangentFrameQuantized::GetFormat(), &decoded, &interleaved);
+	DXT_CHECK(GetChannelError(vertices, decoded, DXTVertexAttributePosition) <= positionStep);
+	DXT_CHECK(GetChannelDegrees(vertices, decoded, DXTVertexAttributeNormal) < 0.1f);
+	DXT_CHECK(GetChannelDegrees(vertices, decoded, DXTVertexAttributeTangent) < 0.1f);
+	DXT_CHECK(GetChannelDegrees(vertices, decoded, DXTVertexAttributeBitangent) < 0.1f);
+
+	DXTReportMeasurement("tangent frame error", GetChannelDegrees(vertices, decoded, DXTVertexAttributeBitangent), "degrees");
+}
\ No newline at end of file